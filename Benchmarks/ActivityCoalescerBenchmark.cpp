@@ -0,0 +1,37 @@
+#include "BenchmarkHarness.h"
+#include "HeadlessEngine.h"
+
+#define EVENTS_PERMILLISEC	8		// 8 kHz mouse
+#define ITERATIONS			(EVENTS_PERMILLISEC * 60 * 1000)		// A minute of moving
+
+
+// Per event cost of a synthetic 8 kHz mouse stream through the engine, with and without coalescing
+// NOTE: Mouse moves 20 pixels per event, so every event is activity for 'RestoreWhen::mousedMoved'
+int main()
+{
+	static const uint32_t s_quanta[] = { 0, 10, 50 };
+	char szName[64];
+
+	for (auto quantum : s_quanta)
+	{
+		HeadlessEngine headless;
+		headless.getEngine().setTuning(0, 0, quantum);
+		headless.Start();
+
+		snprintf(szName, sizeof(szName), "OnMouseMove at 8 kHz, quantum %u ms", quantum);
+		Benchmark::Run(szName, ITERATIONS, [&](size_t i)
+		{
+			if (i % EVENTS_PERMILLISEC == 0)
+				headless.Advance(1);
+			DoNotOptimize(headless.getEngine().OnMouseMove(static_cast<int>(i * 20 % HEADLESSENGINE_CLIENTWIDTH), 500, headless.getSettings()));
+		});
+
+		auto& coalescer = headless.getEngine().getActivityCoalescer();
+		printf("  %llu of %llu events acted on, %.1f per second\n",
+			static_cast<unsigned long long>(coalescer.getActedCount()),
+			static_cast<unsigned long long>(coalescer.getEventCount()),
+			coalescer.getActedCount() * 1000.0 * EVENTS_PERMILLISEC / coalescer.getEventCount());
+	}
+
+	return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "AllocationTracker.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+
+// Times an operation over many iterations and prints nanoseconds and allocations per iteration
+// NOTE: Operation is run once before timing, so lazy setup isn't counted
+class Benchmark
+{
+public:
+	struct Result
+	{
+		double nanosecsPerIteration;
+		double allocationsPerIteration;
+	};
+
+	template<typename F>
+	static Result Run(const char *pszName, size_t cIterations, F operation)
+	{
+		operation(0);
+
+		auto cAllocations = AllocationTracker::getAllocationCount();
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < cIterations; ++i)
+			operation(i);
+		auto elapsed = std::chrono::steady_clock::now() - start;
+
+		Result result;
+		result.nanosecsPerIteration = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / cIterations;
+		result.allocationsPerIteration = static_cast<double>(AllocationTracker::getAllocationCount() - cAllocations) / cIterations;
+		Print(pszName, result);
+
+		return result;
+	}
+
+	static void Print(const char *pszName, const Result& result)
+	{
+		printf("%-56s %12.1f ns/op %10.3f allocs/op\n", pszName, result.nanosecsPerIteration, result.allocationsPerIteration);
+	}
+};
+
+// Keeps compiler from optimizing away a result that is otherwise unused
+template<typename T>
+inline void DoNotOptimize(const T& value)
+{
+	static volatile T s_sink;
+	s_sink = value;
+	(void)s_sink;
+}
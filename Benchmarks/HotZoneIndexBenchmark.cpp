@@ -0,0 +1,56 @@
+#include "BenchmarkHarness.h"
+#include "HotZoneIndex.h"
+#include <cstdlib>
+
+#define ITERATIONS		10000000
+#define BOUNDS_WIDTH	1920
+#define BOUNDS_HEIGHT	1080
+
+
+// Per mouse move cost of hit testing hot zones through grid, against testing each zone in turn
+// NOTE: Index holds at most 'HOTZONEINDEX_MAXZONES' zones, so that is the largest count measured
+int main()
+{
+	static const size_t s_counts[] = { 1, 16, HOTZONEINDEX_MAXZONES };
+	Rect bounds = { 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT };
+	Rect zones[HOTZONEINDEX_MAXZONES];
+	char szName[64];
+
+	srand(1);
+	for (auto& zone : zones)
+	{
+		int left = rand() % BOUNDS_WIDTH, top = rand() % BOUNDS_HEIGHT;
+		zone = Rect{ left, top, left + 16 + rand() % 200, top + 16 + rand() % 150 };
+	}
+
+	for (auto count : s_counts)
+	{
+		HotZoneIndex index;
+		index.Build(bounds, zones, count, 8);
+
+		// NOTE: Mouse sweeps the whole desktop
+		snprintf(szName, sizeof(szName), "HotZoneIndex::HitTest, %zu zones", count);
+		Benchmark::Run(szName, ITERATIONS, [&](size_t i)
+		{
+			DoNotOptimize(index.HitTest(static_cast<int>(i * 7 % BOUNDS_WIDTH), static_cast<int>(i * 13 % BOUNDS_HEIGHT), true));
+		});
+
+		snprintf(szName, sizeof(szName), "Linear scan, %zu zones", count);
+		Benchmark::Run(szName, ITERATIONS, [&](size_t i)
+		{
+			int x = static_cast<int>(i * 7 % BOUNDS_WIDTH), y = static_cast<int>(i * 13 % BOUNDS_HEIGHT);
+			int hit = -1;
+			for (size_t j = 0; j < count; ++j)
+			{
+				if (zones[j].inflate(8).contains(x, y))
+				{
+					hit = static_cast<int>(j);
+					break;
+				}
+			}
+			DoNotOptimize(hit);
+		});
+	}
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include "BenchmarkHarness.h"
+#include "HoverReveal.h"
+#include <vector>
+
+#define ITERATIONS		100000
+#define ICONSIZE		80
+#define ICONSPACING		100
+
+
+// Per mouse move cost of finding items to reveal through grid, against testing each item in turn
+// NOTE: Desktop grows with its items, so each is measured at the same density
+int main()
+{
+	static const int s_counts[] = { 100, 1000, 10000 };
+	char szName[64];
+
+	for (auto count : s_counts)
+	{
+		int cColumns = 10;
+		while (cColumns * cColumns < count)
+			++cColumns;
+		int width = cColumns * ICONSPACING, height = (count + cColumns - 1) / cColumns * ICONSPACING;
+
+		ItemGrid grid;
+		std::vector<Rect> items;
+		grid.Reset(Rect{ 0, 0, width, height });
+		for (int i = 0; i < count; ++i)
+		{
+			int left = (i % cColumns) * ICONSPACING, top = (i / cColumns) * ICONSPACING;
+			items.push_back(Rect{ left, top, left + ICONSIZE, top + ICONSIZE });
+			grid.Insert(i, items.back());
+		}
+
+		// NOTE: Mouse sweeps the whole desktop
+		HoverReveal hoverReveal;
+		HoverReveal::Change changes[HOVERREVEAL_MAXCHANGES];
+		snprintf(szName, sizeof(szName), "HoverReveal::Update, %d items", count);
+		Benchmark::Run(szName, ITERATIONS, [&](size_t i)
+		{
+			DoNotOptimize(hoverReveal.Update(grid, static_cast<int>(i * 7 % width), static_cast<int>(i * 13 % height), changes));
+		});
+
+		snprintf(szName, sizeof(szName), "Linear scan, %d items", count);
+		Benchmark::Run(szName, ITERATIONS, [&](size_t i)
+		{
+			int x = static_cast<int>(i * 7 % width), y = static_cast<int>(i * 13 % height);
+			size_t cRevealed = 0;
+			for (auto& item : items)
+				cRevealed += (HoverReveal::getAlpha(item, x, y, HOVERREVEAL_DEFAULTRADIUS) != 0 ? 1 : 0);
+			DoNotOptimize(cRevealed);
+		});
+
+		// NOTE: Dragging an icon, which moves it between cells
+		snprintf(szName, sizeof(szName), "ItemGrid::Move, %d items", count);
+		Benchmark::Run(szName, ITERATIONS, [&](size_t i)
+		{
+			int left = static_cast<int>(i * 7 % width), top = static_cast<int>(i * 13 % height);
+			grid.Move(0, Rect{ left, top, left + ICONSIZE, top + ICONSIZE });
+		});
+	}
+
+	return 0;
+}
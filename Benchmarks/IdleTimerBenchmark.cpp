@@ -0,0 +1,95 @@
+#include "BenchmarkHarness.h"
+#include "FakePlatform.h"
+#include "IdleTimer.h"
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#define INTERVALMILLISECS	5000
+#define EVENTSPERSEC		1000		// As from a 1000 Hz mouse
+#define SIMULATEDSECS		600
+
+
+// One-shot kernel timer, kept open
+class TimerFdBackend : public TimerBackend
+{
+public:
+	TimerFdBackend() : m_fd(timerfd_create(CLOCK_MONOTONIC, 0)) {}
+	virtual ~TimerFdBackend() { close(m_fd); }
+
+	virtual void Arm(uint32_t dueMillisecs)
+	{
+		itimerspec spec = {};
+		spec.it_value.tv_sec = dueMillisecs / 1000;
+		spec.it_value.tv_nsec = (dueMillisecs % 1000) * 1000000 + 1;	// NOTE: Zero would disarm
+		timerfd_settime(m_fd, 0, &spec, nullptr);
+	}
+
+	virtual void Disarm()
+	{
+		itimerspec spec = {};
+		timerfd_settime(m_fd, 0, &spec, nullptr);
+	}
+
+private:
+	int m_fd;
+};
+
+// Re-arms per second of continuous activity, counted on a virtual clock
+static double getRearmsPerSec(bool bOldPath)
+{
+	struct Context
+	{
+		FakeClock clock;
+		IdleTimer *pIdleTimer;
+	} context;
+	FakeTimer timer(context.clock, [](void *pContext)
+	{
+		auto pThis = static_cast<Context *>(pContext);
+		pThis->pIdleTimer->OnFired(pThis->clock.Now());
+	}, &context);
+	IdleTimer idleTimer(timer);
+	context.pIdleTimer = &idleTimer;
+
+	idleTimer.Start(context.clock.Now(), INTERVALMILLISECS);
+	for (int i = 0; i < SIMULATEDSECS * EVENTSPERSEC; ++i)
+	{
+		context.clock.Advance(1000 / EVENTSPERSEC);
+		if (bOldPath)
+			idleTimer.Start(context.clock.Now(), INTERVALMILLISECS);	// Torn down and made again on every event
+		else
+			idleTimer.Bump(context.clock.Now());
+	}
+
+	return static_cast<double>(timer.getArmCount()) / SIMULATEDSECS;
+}
+
+// Idle timer for input at 1000 Hz, old path of a new kernel timer per event versus deadline bumps
+int main()
+{
+	printf("Re-arms per second, old path: %.1f\n", getRearmsPerSec(true));
+	printf("Re-arms per second, new path: %.3f\n", getRearmsPerSec(false));
+
+	Benchmark::Run("Old path, kernel timer created and closed per event", 100000, [](size_t i)
+	{
+		auto fd = timerfd_create(CLOCK_MONOTONIC, 0);
+		itimerspec spec = {};
+		spec.it_value.tv_sec = INTERVALMILLISECS / 1000;
+		timerfd_settime(fd, 0, &spec, nullptr);
+		close(fd);
+	});
+
+	TimerFdBackend backend;
+	IdleTimer idleTimer(backend);
+	idleTimer.Start(0, INTERVALMILLISECS);
+	Benchmark::Run("New path, 'IdleTimer::Bump()'", 10000000, [&](size_t i)
+	{
+		idleTimer.Bump(i);
+	});
+	Benchmark::Run("New path, re-arm on firing early", 100000, [&](size_t i)
+	{
+		idleTimer.Bump(i);
+		DoNotOptimize(idleTimer.OnFired(i));
+	});
+
+	return 0;
+}
@@ -0,0 +1,55 @@
+#include "BenchmarkHarness.h"
+#include "MotionAccumulator.h"
+#include <cstdlib>
+
+#define ITERATIONS		2000000
+
+
+// Per-event cost of the running distance, against walking the whole history, for each depth
+template<size_t Depth>
+static void runDepth()
+{
+	char szName[64];
+
+	MotionAccumulator<Depth> accumulator;
+	snprintf(szName, sizeof(szName), "MotionAccumulator, depth %zu", Depth);
+	Benchmark::Run(szName, ITERATIONS, [&](size_t i)
+	{
+		accumulator.push(static_cast<int>(i * 7 % 3840), static_cast<int>(i * 13 % 2160));
+		DoNotOptimize(accumulator.getDistanceX() + accumulator.getDistanceY());
+	});
+
+	// NOTE: As the mouse moved policy did before, walking all positions on every event
+	struct Position
+	{
+		int x;
+		int y;
+	};
+	ring_buffer<Position, Depth> history;
+	snprintf(szName, sizeof(szName), "History walk, depth %zu", Depth);
+	Benchmark::Run(szName, ITERATIONS, [&](size_t i)
+	{
+		history.push(Position{ static_cast<int>(i * 7 % 3840), static_cast<int>(i * 13 % 2160) });
+
+		int distanceX = 0, distanceY = 0;
+		for (size_t j = 1; j < history.size(); ++j)
+		{
+			distanceX += abs(history[j].x - history[j - 1].x);
+			distanceY += abs(history[j].y - history[j - 1].y);
+		}
+		DoNotOptimize(distanceX + distanceY);
+	});
+}
+
+int main()
+{
+	runDepth<4>();
+	runDepth<8>();
+	runDepth<16>();
+	runDepth<32>();
+	runDepth<64>();
+	runDepth<128>();
+	runDepth<256>();
+
+	return 0;
+}
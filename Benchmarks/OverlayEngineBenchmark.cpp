@@ -0,0 +1,53 @@
+#include "BenchmarkHarness.h"
+#include "HeadlessEngine.h"
+
+#define ITERATIONS		1000000
+
+
+// CPU and allocations per input event of the engine, with every platform call faked
+int main()
+{
+	static const struct
+	{
+		const char *pszName;
+		Settings::RestoreWhen restoreWhen;
+	} s_restoreWhens[] =
+	{
+		{ "OnMouseMove, mouse moved", Settings::RestoreWhen::mousedMoved },
+		{ "OnMouseMove, quarter region on left", Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft },
+		{ "OnMouseMove, hot zone", Settings::RestoreWhen::mousedEntersHotZone },
+		{ "OnMouseMove, double clicked", Settings::RestoreWhen::doubleClicked }
+	};
+
+	for (const auto& restoreWhen : s_restoreWhens)
+	{
+		HeadlessEngine headless;
+		auto settings = HeadlessEngine::getDefaultSettings();
+		settings.restoreWhen = restoreWhen.restoreWhen;
+		headless.setSettings(settings);
+
+		uint32_t packedZone = 0x40400000;	// Left quarter of top quarter
+		headless.getEngine().setHotZones(&packedZone, 1);
+		headless.Start();
+
+		// NOTE: Mouse sweeps the whole desktop, one event per millisecond as from a 1000 Hz mouse
+		Benchmark::Run(restoreWhen.pszName, ITERATIONS, [&](size_t i)
+		{
+			headless.Advance(1);
+			DoNotOptimize(headless.getEngine().OnMouseMove(static_cast<int>(i % HEADLESSENGINE_CLIENTWIDTH), static_cast<int>((i / 8) % HEADLESSENGINE_CLIENTHEIGHT), settings));
+		});
+	}
+
+	HeadlessEngine headless;
+	headless.Start();
+	Benchmark::Run("OnRightButtonDown, icons visible", ITERATIONS, [&](size_t i)
+	{
+		DoNotOptimize(headless.getEngine().OnRightButtonDown());
+	});
+	Benchmark::Run("ResetTimer", ITERATIONS, [&](size_t i)
+	{
+		headless.getEngine().ResetTimer();
+	});
+
+	return 0;
+}
@@ -0,0 +1,37 @@
+#include "BenchmarkHarness.h"
+#include "PixelKernels.h"
+#include <vector>
+
+#define PIXELS_PERRUN		(4 * 1024 * 1024)
+
+
+// Premultiplying menu icons at the sizes per-DPI cache rasterizes, against the scalar reference
+int main()
+{
+	static const int s_iconSizes[] = { 16, 24, 32, 48, 64 };
+	char szName[64];
+
+	for (auto size : s_iconSizes)
+	{
+		std::vector<uint32_t> pixels(static_cast<size_t>(size) * size);
+		for (size_t i = 0; i < pixels.size(); ++i)
+			pixels[i] = static_cast<uint32_t>(i * 2654435761u);
+		auto cIterations = PIXELS_PERRUN / pixels.size();
+
+		snprintf(szName, sizeof(szName), "PremultiplyAlpha, %dx%d", size, size);
+		Benchmark::Run(szName, cIterations, [&](size_t i)
+		{
+			PixelKernels::PremultiplyAlpha(pixels.data(), pixels.size());
+			DoNotOptimize(pixels[0]);
+		});
+
+		snprintf(szName, sizeof(szName), "PremultiplyAlpha_Scalar, %dx%d", size, size);
+		Benchmark::Run(szName, cIterations, [&](size_t i)
+		{
+			PixelKernels::PremultiplyAlpha_Scalar(pixels.data(), pixels.size());
+			DoNotOptimize(pixels[0]);
+		});
+	}
+
+	return 0;
+}
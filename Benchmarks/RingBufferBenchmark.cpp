@@ -0,0 +1,81 @@
+#include "BenchmarkHarness.h"
+#include "OverlayEngine.h"
+#include "ring_buffer.h"
+#include <deque>
+#include <stdexcept>
+
+#define ITERATIONS		10000000
+
+
+// Mouse position history as it was kept before 'ring_buffer', for comparison only
+template<typename T>
+class sized_queue : public std::deque<T>
+{
+private:
+	size_t m_maxSize;
+
+public:
+	sized_queue(size_t maxSize)
+		: std::deque<T>(),
+		m_maxSize(maxSize) {}
+	virtual ~sized_queue() {}
+
+	void push(const T& value)
+	{
+		if (std::deque<T>::size() == m_maxSize)
+			std::deque<T>::pop_front();
+
+		std::deque<T>::push_back(value);
+	}
+
+	T& back()
+	{
+		if (std::deque<T>::empty())
+			throw std::out_of_range("sized_queue is empty");
+
+		return std::deque<T>::back();
+	}
+};
+
+struct Position
+{
+	int x;
+	int y;
+};
+
+
+// Push of one mouse position and a walk over the history, as each mouse move did
+int main()
+{
+	sized_queue<Position> queue(MOUSEPOS_HISTORYDEPTH);
+	Benchmark::Run("sized_queue (std::deque), push", ITERATIONS, [&](size_t i)
+	{
+		queue.push(Position{ static_cast<int>(i), static_cast<int>(i) });
+	});
+	Benchmark::Run("sized_queue (std::deque), push and iterate", ITERATIONS, [&](size_t i)
+	{
+		queue.push(Position{ static_cast<int>(i), static_cast<int>(i) });
+
+		int sum = 0;
+		for (auto it = queue.cbegin(); it != queue.cend(); ++it)
+			sum += it->x;
+		DoNotOptimize(sum);
+	});
+
+	ring_buffer<Position, MOUSEPOS_HISTORYDEPTH> buffer;
+	Benchmark::Run("ring_buffer, push", ITERATIONS, [&](size_t i)
+	{
+		buffer.push(Position{ static_cast<int>(i), static_cast<int>(i) });
+	});
+	Benchmark::Run("ring_buffer, push and iterate", ITERATIONS, [&](size_t i)
+	{
+		buffer.push(Position{ static_cast<int>(i), static_cast<int>(i) });
+
+		int sum = 0;
+		for (size_t j = 0; j < buffer.size(); ++j)
+			sum += buffer[j].x;
+		DoNotOptimize(sum);
+	});
+
+	return 0;
+}
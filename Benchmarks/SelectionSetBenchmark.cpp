@@ -0,0 +1,68 @@
+#include "BenchmarkHarness.h"
+#include "SelectionSet.h"
+#include <vector>
+
+#define ITEMS			10000
+#define ITERATIONS		100000
+
+
+// Following selection changes of a 10k item desktop, against walking every item for selected
+// count as was done per right click before
+int main()
+{
+	static const size_t s_selectedCounts[] = { 1, 100, ITEMS };
+	char szName[64];
+
+	for (auto cSelected : s_selectedCounts)
+	{
+		SelectionSet selection;
+		std::vector<bool> selected(ITEMS, false);
+		selection.Clear();
+		for (size_t i = 0; i < cSelected; ++i)
+		{
+			auto index = static_cast<int>(i * ITEMS / cSelected);
+			selection.Select(index);
+			selected[index] = true;
+		}
+
+		snprintf(szName, sizeof(szName), "getCount, %zu of %d selected", cSelected, ITEMS);
+		Benchmark::Run(szName, ITERATIONS * 100, [&](size_t i)
+		{
+			DoNotOptimize(selection.getCount());
+		});
+
+		snprintf(szName, sizeof(szName), "Walk every item, %zu of %d selected", cSelected, ITEMS);
+		Benchmark::Run(szName, ITERATIONS / 10, [&](size_t i)
+		{
+			size_t count = 0;
+			for (size_t j = 0; j < selected.size(); ++j)
+				count += (selected[j] ? 1 : 0);
+			DoNotOptimize(count);
+		});
+
+		// NOTE: Clicking an icon deselects one and selects another
+		snprintf(szName, sizeof(szName), "Deselect and Select, %zu of %d selected", cSelected, ITEMS);
+		Benchmark::Run(szName, ITERATIONS, [&](size_t i)
+		{
+			auto index = static_cast<int>(i * 7919 % ITEMS);
+			selection.Deselect(index);
+			selection.Select(index);
+		});
+
+		snprintf(szName, sizeof(szName), "Contains, %zu of %d selected", cSelected, ITEMS);
+		Benchmark::Run(szName, ITERATIONS * 10, [&](size_t i)
+		{
+			DoNotOptimize(selection.Contains(static_cast<int>(i * 7919 % ITEMS)));
+		});
+
+		// NOTE: Worst case, where every selected item moves
+		snprintf(szName, sizeof(szName), "OnInserted and OnDeleted at 0, %zu of %d selected", cSelected, ITEMS);
+		Benchmark::Run(szName, ITERATIONS / 10, [&](size_t i)
+		{
+			selection.OnInserted(0);
+			selection.OnDeleted(0);
+		});
+	}
+
+	return 0;
+}
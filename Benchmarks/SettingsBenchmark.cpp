@@ -0,0 +1,35 @@
+#include "BenchmarkHarness.h"
+#include "IniSettingsStore.h"
+#include "Settings.h"
+
+#define ITERATIONS		10000000
+#define STOREITERATIONS	1000000
+
+
+// Reading all settings from the published snapshot, against reading them from store
+int main()
+{
+	Settings::ForceSettingsRefreshFromRegistry();
+	Benchmark::Run("Settings::getSnapshot", ITERATIONS, [](size_t i)
+	{
+		DoNotOptimize(Settings::getSnapshot().pack());
+	});
+
+	// NOTE: In memory store, so this is the least a store read can cost, a registry read costs far more
+	IniSettingsStore store("");
+	static const wchar_t *const s_names[] = { L"In", L"RestoreWhen", L"To", L"Enabled" };
+	uint32_t values[] = { 1, 2, 1, 1 };
+	store.WriteValues(s_names, values, 4);
+	Benchmark::Run("SettingsStore::ReadValues", STOREITERATIONS, [&](size_t i)
+	{
+		store.ReadValues(s_names, values, 4);
+		DoNotOptimize(values[0] + values[1] + values[2] + values[3]);
+	});
+
+	Benchmark::Run("Settings::ForceSettingsRefreshFromRegistry", STOREITERATIONS, [](size_t i)
+	{
+		Settings::ForceSettingsRefreshFromRegistry();
+	});
+
+	return 0;
+}
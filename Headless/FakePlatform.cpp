@@ -0,0 +1,549 @@
+#include "FakePlatform.h"
+#include <cassert>
+
+
+#pragma region FakeClock
+
+FakeClock::FakeClock(uint64_t start)
+	: m_now(start),
+	m_pTimers(),
+	m_cTimers(0)
+{
+}
+
+void FakeClock::AdvanceTo(uint64_t time)
+{
+	// NOTE: A callback may arm its own or another timer again, so look again after each one
+	FakeTimer *pTimer;
+	while ((pTimer = getNextDue(time)) != nullptr)
+	{
+		if (pTimer->getDue() > m_now)
+			m_now = pTimer->getDue();
+		pTimer->Fire();
+	}
+
+	if (time > m_now)
+		m_now = time;
+}
+
+void FakeClock::Advance(uint64_t millisecs)
+{
+	AdvanceTo(m_now + millisecs);
+}
+
+uint64_t FakeClock::Now()
+{
+	return m_now;
+}
+
+void FakeClock::add(FakeTimer *pTimer)
+{
+	assert(m_cTimers < FAKECLOCK_MAXTIMERS && "Too many fake timers");
+	m_pTimers[m_cTimers++] = pTimer;
+}
+
+void FakeClock::remove(FakeTimer *pTimer)
+{
+	for (size_t i = 0; i < m_cTimers; ++i)
+	{
+		if (m_pTimers[i] == pTimer)
+		{
+			m_pTimers[i] = m_pTimers[--m_cTimers];
+			return;
+		}
+	}
+}
+
+// Earliest armed timer due by 'limit', first added wins a tie
+FakeTimer *FakeClock::getNextDue(uint64_t limit) const
+{
+	FakeTimer *pNext = nullptr;
+	for (size_t i = 0; i < m_cTimers; ++i)
+	{
+		auto pTimer = m_pTimers[i];
+		if (pTimer->IsArmed() && pTimer->getDue() <= limit && (!pNext || pTimer->getDue() < pNext->getDue()))
+			pNext = pTimer;
+	}
+
+	return pNext;
+}
+
+#pragma endregion
+
+
+#pragma region FakeTimer
+
+FakeTimer::FakeTimer(FakeClock& clock, Callback callback, void *pContext)
+	: m_clock(clock),
+	m_callback(callback),
+	m_pContext(pContext),
+	m_bArmed(false),
+	m_due(0),
+	m_cArms(0),
+	m_cDisarms(0),
+	m_cFires(0)
+{
+	m_clock.add(this);
+}
+
+FakeTimer::~FakeTimer()
+{
+	m_clock.remove(this);
+}
+
+void FakeTimer::Fire()
+{
+	m_bArmed = false;
+	++m_cFires;
+
+	if (m_callback)
+		m_callback(m_pContext);
+}
+
+bool FakeTimer::IsArmed() const
+{
+	return m_bArmed;
+}
+
+uint64_t FakeTimer::getDue() const
+{
+	return m_due;
+}
+
+uint64_t FakeTimer::getArmCount() const
+{
+	return m_cArms;
+}
+
+uint64_t FakeTimer::getDisarmCount() const
+{
+	return m_cDisarms;
+}
+
+uint64_t FakeTimer::getFireCount() const
+{
+	return m_cFires;
+}
+
+void FakeTimer::Arm(uint32_t dueMillisecs)
+{
+	m_bArmed = true;
+	m_due = m_clock.Now() + dueMillisecs;
+	++m_cArms;
+}
+
+void FakeTimer::Disarm()
+{
+	m_bArmed = false;
+	++m_cDisarms;
+}
+
+#pragma endregion
+
+
+#pragma region FakePlatform
+
+FakePlatform::FakePlatform()
+	: m_bounds(),
+	m_cSelected(0),
+	m_cCalls(0),
+	m_cClearSelections(0)
+{
+}
+
+void FakePlatform::setClientBounds(const Rect& bounds)
+{
+	m_bounds = bounds;
+}
+
+void FakePlatform::setMonitors(const Rect monitors[], size_t count)
+{
+	m_monitors.assign(monitors, monitors + count);
+}
+
+void FakePlatform::setSelectedCount(size_t count)
+{
+	m_cSelected = count;
+}
+
+std::vector<Rect>& FakePlatform::getItems()
+{
+	return m_items;
+}
+
+uint64_t FakePlatform::getCallCount() const
+{
+	return m_cCalls;
+}
+
+uint64_t FakePlatform::getClearSelectionCount() const
+{
+	return m_cClearSelections;
+}
+
+bool FakePlatform::getClientBounds(Rect& bounds)
+{
+	++m_cCalls;
+	bounds = m_bounds;
+	return !m_bounds.isEmpty();
+}
+
+size_t FakePlatform::getMonitorBounds(Rect monitors[], size_t maxCount)
+{
+	++m_cCalls;
+
+	size_t count = (m_monitors.size() < maxCount ? m_monitors.size() : maxCount);
+	for (size_t i = 0; i < count; ++i)
+		monitors[i] = m_monitors[i];
+
+	return count;
+}
+
+size_t FakePlatform::getSelectedCount()
+{
+	++m_cCalls;
+	return m_cSelected;
+}
+
+void FakePlatform::ClearSelection()
+{
+	++m_cCalls;
+	++m_cClearSelections;
+	m_cSelected = 0;
+}
+
+size_t FakePlatform::getItemCount()
+{
+	++m_cCalls;
+	return m_items.size();
+}
+
+bool FakePlatform::getItemBounds(int index, Rect& bounds)
+{
+	++m_cCalls;
+	if (index < 0 || static_cast<size_t>(index) >= m_items.size())
+		return false;
+
+	bounds = m_items[index];
+	return true;
+}
+
+#pragma endregion
+
+
+#pragma region FakeOpacity
+
+FakeOpacity::FakeOpacity()
+	: m_opacity(OPACITY_OPAQUE),
+	m_cSets(0),
+	m_cGets(0),
+	m_cFades(0)
+{
+}
+
+uint8_t FakeOpacity::getOpacity() const
+{
+	return m_opacity;
+}
+
+void FakeOpacity::setExternalOpacity(uint8_t opacity)
+{
+	m_opacity = opacity;
+}
+
+uint64_t FakeOpacity::getSetCount() const
+{
+	return m_cSets;
+}
+
+uint64_t FakeOpacity::getGetCount() const
+{
+	return m_cGets;
+}
+
+uint64_t FakeOpacity::getFadeCount() const
+{
+	return m_cFades;
+}
+
+bool FakeOpacity::SetOpacity(uint8_t opacity)
+{
+	++m_cSets;
+	m_opacity = opacity;
+	return true;
+}
+
+bool FakeOpacity::GetOpacity(uint8_t& opacity)
+{
+	++m_cGets;
+	opacity = m_opacity;
+	return true;
+}
+
+void FakeOpacity::BeginFade(uint8_t opacity)
+{
+	++m_cFades;
+}
+
+void FakeOpacity::EndFade(uint8_t opacity)
+{
+}
+
+#pragma endregion
+
+
+#pragma region FakeSurface
+
+FakeSurface::FakeSurface(size_t cbSurface)
+	: m_bDeferred(false),
+	m_cbSurface(cbSurface),
+	m_bLayered(false),
+	m_alpha(OPACITY_OPAQUE),
+	m_bSnapshotShown(false),
+	m_snapshotAlpha(0),
+	m_cStyleChanges(0),
+	m_cCalls(0)
+{
+}
+
+void FakeSurface::setExternalLayered(bool bLayered, uint8_t alpha)
+{
+	m_bLayered = bLayered;
+	m_alpha = alpha;
+}
+
+void FakeSurface::setDeferred(bool bDeferred)
+{
+	m_bDeferred = bDeferred;
+}
+
+void FakeSurface::ApplyPending()
+{
+	auto bDeferred = m_bDeferred;
+	m_bDeferred = false;
+	for (const auto& change : m_pending)
+	{
+		switch (change.operation)
+		{
+			case operationSetLayered: SetLayered(true, change.alpha); break;
+			case operationSetUnlayered: SetLayered(false, change.alpha); break;
+			case operationSetAlpha: SetAlpha(change.alpha); break;
+			case operationShowSnapshot: ShowSnapshot(change.alpha); break;
+			case operationSetSnapshotAlpha: SetSnapshotAlpha(change.alpha); break;
+			case operationHideSnapshot: HideSnapshot(change.alpha); break;
+		}
+	}
+	m_pending.clear();
+	m_bDeferred = bDeferred;
+}
+
+bool FakeSurface::IsSnapshotShown() const
+{
+	return m_bSnapshotShown;
+}
+
+uint8_t FakeSurface::getAlpha() const
+{
+	return (m_bLayered ? m_alpha : OPACITY_OPAQUE);
+}
+
+uint8_t FakeSurface::getSnapshotAlpha() const
+{
+	return m_snapshotAlpha;
+}
+
+uint64_t FakeSurface::getStyleChangeCount() const
+{
+	return m_cStyleChanges;
+}
+
+uint64_t FakeSurface::getCallCount() const
+{
+	return m_cCalls;
+}
+
+bool FakeSurface::IsLayered()
+{
+	++m_cCalls;
+	return m_bLayered;
+}
+
+bool FakeSurface::SetLayered(bool bLayered, uint8_t alpha)
+{
+	if (m_bDeferred)
+		return defer(bLayered ? operationSetLayered : operationSetUnlayered, alpha);
+
+	++m_cCalls;
+	if (bLayered != m_bLayered)
+		++m_cStyleChanges;
+
+	m_bLayered = bLayered;
+	if (bLayered)
+		m_alpha = alpha;
+	return true;
+}
+
+bool FakeSurface::SetAlpha(uint8_t alpha)
+{
+	if (m_bDeferred)
+		return defer(operationSetAlpha, alpha);
+
+	++m_cCalls;
+	if (!m_bLayered)
+		return false;
+
+	m_alpha = alpha;
+	return true;
+}
+
+bool FakeSurface::GetAlpha(uint8_t& alpha)
+{
+	++m_cCalls;
+	alpha = getAlpha();
+	return true;
+}
+
+size_t FakeSurface::getSurfaceBytes()
+{
+	++m_cCalls;
+	return m_cbSurface;
+}
+
+bool FakeSurface::ShowSnapshot(uint8_t alpha)
+{
+	if (m_bDeferred)
+		return defer(operationShowSnapshot, alpha);
+
+	++m_cCalls;
+	m_bSnapshotShown = true;
+	m_snapshotAlpha = alpha;
+
+	// NOTE: Window itself is nearly hidden underneath
+	if (!m_bLayered)
+		++m_cStyleChanges;
+	m_bLayered = true;
+	m_alpha = OPACITY_HIDDEN;
+	return true;
+}
+
+bool FakeSurface::SetSnapshotAlpha(uint8_t alpha)
+{
+	if (m_bDeferred)
+		return defer(operationSetSnapshotAlpha, alpha);
+
+	++m_cCalls;
+	m_snapshotAlpha = alpha;
+	return m_bSnapshotShown;
+}
+
+bool FakeSurface::HideSnapshot(uint8_t alpha)
+{
+	if (m_bDeferred)
+		return defer(operationHideSnapshot, alpha);
+
+	++m_cCalls;
+	m_bSnapshotShown = false;
+	return SetLayered(alpha != OPACITY_OPAQUE, alpha);
+}
+
+bool FakeSurface::HasPendingChanges()
+{
+	return !m_pending.empty();
+}
+
+// NOTE: Counted as a call once applied
+bool FakeSurface::defer(Operation operation, uint8_t alpha)
+{
+	Change change = { operation, alpha };
+	m_pending.push_back(change);
+	return true;
+}
+
+#pragma endregion
+
+
+#pragma region FakeRevealBackend
+
+FakeRevealBackend::FakeRevealBackend()
+	: m_cApplies(0),
+	m_cChanges(0),
+	m_cEnds(0)
+{
+}
+
+uint64_t FakeRevealBackend::getApplyCount() const
+{
+	return m_cApplies;
+}
+
+uint64_t FakeRevealBackend::getChangeCount() const
+{
+	return m_cChanges;
+}
+
+uint64_t FakeRevealBackend::getEndCount() const
+{
+	return m_cEnds;
+}
+
+void FakeRevealBackend::ApplyReveal(const HoverReveal::Change changes[], size_t count)
+{
+	++m_cApplies;
+	m_cChanges += count;
+}
+
+void FakeRevealBackend::EndReveal()
+{
+	++m_cEnds;
+}
+
+#pragma endregion
+
+
+#pragma region FakeLocator
+
+FakeLocator::FakeLocator()
+	: m_pWindow(nullptr),
+	m_answer(Answer::inTime),
+	m_cFinds(0),
+	m_cCalls(0)
+{
+}
+
+void FakeLocator::setWindow(void *pWindow)
+{
+	m_pWindow = pWindow;
+}
+
+void FakeLocator::setAnswer(Answer answer)
+{
+	m_answer = answer;
+}
+
+uint64_t FakeLocator::getFindCount() const
+{
+	return m_cFinds;
+}
+
+uint64_t FakeLocator::getCallCount() const
+{
+	return m_cCalls;
+}
+
+void *FakeLocator::FindShellWindow()
+{
+	++m_cFinds;
+	return m_pWindow;
+}
+
+bool FakeLocator::CallOnWindowThread(void *pWindow, WindowFunction function, void *pContext)
+{
+	if (m_answer == Answer::never)
+		return false;
+
+	++m_cCalls;
+	bool bResult = function(pWindow, pContext);
+	return (m_answer == Answer::inTime && bResult);
+}
+
+#pragma endregion
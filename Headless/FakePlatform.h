@@ -0,0 +1,240 @@
+#pragma once
+#include "FadeEngine.h"
+#include "Geometry.h"
+#include "HoverReveal.h"
+#include "OpacityLayering.h"
+#include "Platform.h"
+#include "ShellAttacher.h"
+#include "Timing.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define FAKECLOCK_MAXTIMERS		16
+
+
+class FakeTimer;
+
+// Virtual millisecond clock, which fires fake timers as it is moved forward
+// NOTE: Nothing happens on its own, so whatever runs on it is deterministic and runs as fast as
+//		 the code under it. Everything is expected to be called from one thread.
+class FakeClock : public Clock
+{
+public:
+	explicit FakeClock(uint64_t start = 0);
+
+	void AdvanceTo(uint64_t time);		// Fires each due timer at its own due time, in order
+	void Advance(uint64_t millisecs);
+
+	// Clock
+	virtual uint64_t Now();
+
+private:
+	friend class FakeTimer;
+
+	void add(FakeTimer *pTimer);
+	void remove(FakeTimer *pTimer);
+	FakeTimer *getNextDue(uint64_t limit) const;
+
+	uint64_t m_now;
+	FakeTimer *m_pTimers[FAKECLOCK_MAXTIMERS];
+	size_t m_cTimers;
+};
+
+// One-shot timer on a 'FakeClock'
+class FakeTimer : public TimerBackend
+{
+public:
+	typedef void(*Callback)(void *pContext);
+
+	FakeTimer(FakeClock& clock, Callback callback = nullptr, void *pContext = nullptr);
+	virtual ~FakeTimer();
+
+	void Fire();						// As if due time came now
+
+	bool IsArmed() const;
+	uint64_t getDue() const;
+	uint64_t getArmCount() const;
+	uint64_t getDisarmCount() const;
+	uint64_t getFireCount() const;
+
+	// TimerBackend
+	virtual void Arm(uint32_t dueMillisecs);
+	virtual void Disarm();
+
+private:
+	FakeClock& m_clock;
+	Callback m_callback;
+	void *m_pContext;
+	bool m_bArmed;
+	uint64_t m_due;
+	uint64_t m_cArms;
+	uint64_t m_cDisarms;
+	uint64_t m_cFires;
+};
+
+// Window and list-view, as set up by test
+class FakePlatform : public Platform
+{
+public:
+	FakePlatform();
+
+	void setClientBounds(const Rect& bounds);
+	void setMonitors(const Rect monitors[], size_t count);
+	void setSelectedCount(size_t count);
+	std::vector<Rect>& getItems();		// NOTE: Engine must be told of changes, as shell would
+
+	uint64_t getCallCount() const;		// All platform calls made
+	uint64_t getClearSelectionCount() const;
+
+	// Platform
+	virtual bool getClientBounds(Rect& bounds);
+	virtual size_t getMonitorBounds(Rect monitors[], size_t maxCount);
+	virtual size_t getSelectedCount();
+	virtual void ClearSelection();
+	virtual size_t getItemCount();
+	virtual bool getItemBounds(int index, Rect& bounds);
+
+private:
+	Rect m_bounds;
+	std::vector<Rect> m_monitors;
+	std::vector<Rect> m_items;
+	size_t m_cSelected;
+	uint64_t m_cCalls;
+	uint64_t m_cClearSelections;
+};
+
+// Opacity of window, straight as set
+class FakeOpacity : public FadeEngine::Backend
+{
+public:
+	FakeOpacity();
+
+	uint8_t getOpacity() const;
+	void setExternalOpacity(uint8_t opacity);	// As if someone else changed it
+
+	uint64_t getSetCount() const;
+	uint64_t getGetCount() const;
+	uint64_t getFadeCount() const;		// Fades begun
+
+	// FadeEngine::Backend
+	virtual bool SetOpacity(uint8_t opacity);
+	virtual bool GetOpacity(uint8_t& opacity);
+	virtual void BeginFade(uint8_t opacity);
+	virtual void EndFade(uint8_t opacity);
+
+private:
+	uint8_t m_opacity;
+	uint64_t m_cSets;
+	uint64_t m_cGets;
+	uint64_t m_cFades;
+};
+
+// Layerable window, for 'OpacityLayering'
+class FakeSurface : public OpacityLayering::Surface
+{
+public:
+	explicit FakeSurface(size_t cbSurface = 0);
+
+	void setExternalLayered(bool bLayered, uint8_t alpha);	// As if someone else changed it
+	void setDeferred(bool bDeferred);	// Changes are only applied by 'ApplyPending()', as if posted to window
+	void ApplyPending();
+
+	bool IsSnapshotShown() const;
+	uint8_t getAlpha() const;			// Of window itself
+	uint8_t getSnapshotAlpha() const;
+	uint64_t getStyleChangeCount() const;	// Layering added or removed
+	uint64_t getCallCount() const;
+
+	// OpacityLayering::Surface
+	virtual bool IsLayered();
+	virtual bool SetLayered(bool bLayered, uint8_t alpha);
+	virtual bool SetAlpha(uint8_t alpha);
+	virtual bool GetAlpha(uint8_t& alpha);
+	virtual size_t getSurfaceBytes();
+	virtual bool ShowSnapshot(uint8_t alpha);
+	virtual bool SetSnapshotAlpha(uint8_t alpha);
+	virtual bool HideSnapshot(uint8_t alpha);
+	virtual bool HasPendingChanges();
+
+private:
+	enum Operation
+	{
+		operationSetLayered,
+		operationSetUnlayered,
+		operationSetAlpha,
+		operationShowSnapshot,
+		operationSetSnapshotAlpha,
+		operationHideSnapshot
+	};
+
+	struct Change
+	{
+		Operation operation;
+		uint8_t alpha;
+	};
+
+	bool defer(Operation operation, uint8_t alpha);
+
+	bool m_bDeferred;
+	std::vector<Change> m_pending;
+	size_t m_cbSurface;
+	bool m_bLayered;
+	uint8_t m_alpha;
+	bool m_bSnapshotShown;
+	uint8_t m_snapshotAlpha;
+	uint64_t m_cStyleChanges;
+	uint64_t m_cCalls;
+};
+
+// Counts what would be drawn by a reveal backend
+class FakeRevealBackend : public HoverReveal::Backend
+{
+public:
+	FakeRevealBackend();
+
+	uint64_t getApplyCount() const;
+	uint64_t getChangeCount() const;	// Of all applies
+	uint64_t getEndCount() const;
+
+	// HoverReveal::Backend
+	virtual void ApplyReveal(const HoverReveal::Change changes[], size_t count);
+	virtual void EndReveal();
+
+private:
+	uint64_t m_cApplies;
+	uint64_t m_cChanges;
+	uint64_t m_cEnds;
+};
+
+// Desktop list-view that comes and goes as test says, for 'ShellAttacher'
+// NOTE: Calls on window's thread are run on caller's thread
+class FakeLocator : public ShellAttacher::Locator
+{
+public:
+	// How window's thread answers calls
+	enum class Answer
+	{
+		inTime,
+		never,							// Hung
+		late							// Runs call, but only after caller stopped waiting
+	};
+
+	FakeLocator();
+
+	void setWindow(void *pWindow);		// NULL while shell has none
+	void setAnswer(Answer answer);
+
+	uint64_t getFindCount() const;
+	uint64_t getCallCount() const;		// Calls that ran
+
+	// ShellAttacher::Locator
+	virtual void *FindShellWindow();
+	virtual bool CallOnWindowThread(void *pWindow, WindowFunction function, void *pContext);
+
+private:
+	void *m_pWindow;
+	Answer m_answer;
+	uint64_t m_cFinds;
+	uint64_t m_cCalls;
+};
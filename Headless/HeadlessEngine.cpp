@@ -0,0 +1,91 @@
+#include "HeadlessEngine.h"
+
+
+HeadlessEngine::HeadlessEngine(uint64_t start)
+	: m_clock(start),
+	m_timerIdle(m_clock, &IdleTimer_Callback, this),
+	m_timerFrame(m_clock, &FrameTimer_Callback, this),
+	m_engine(m_platform, m_clock, m_timerIdle, m_timerFrame),
+	m_settings(getDefaultSettings())
+{
+	// One monitor, which desktop window covers
+	Rect bounds = { 0, 0, HEADLESSENGINE_CLIENTWIDTH, HEADLESSENGINE_CLIENTHEIGHT };
+	m_platform.setClientBounds(bounds);
+	m_platform.setMonitors(&bounds, 1);
+
+	m_engine.setOpacityBackend(&m_opacity);
+	m_engine.UpdateGeometry();
+}
+
+void HeadlessEngine::setSettings(const Settings::Snapshot& settings)
+{
+	m_settings = settings;
+}
+
+const Settings::Snapshot& HeadlessEngine::getSettings() const
+{
+	return m_settings;
+}
+
+void HeadlessEngine::Start()
+{
+	m_engine.Start(Settings::convertInToMillisecs(m_settings.in));
+}
+
+void HeadlessEngine::AdvanceTo(uint64_t time)
+{
+	m_clock.AdvanceTo(time);
+}
+
+void HeadlessEngine::Advance(uint64_t millisecs)
+{
+	m_clock.Advance(millisecs);
+}
+
+FakeClock& HeadlessEngine::getClock()
+{
+	return m_clock;
+}
+
+FakeTimer& HeadlessEngine::getIdleTimer()
+{
+	return m_timerIdle;
+}
+
+FakeTimer& HeadlessEngine::getFrameTimer()
+{
+	return m_timerFrame;
+}
+
+FakePlatform& HeadlessEngine::getPlatform()
+{
+	return m_platform;
+}
+
+FakeOpacity& HeadlessEngine::getOpacity()
+{
+	return m_opacity;
+}
+
+OverlayEngine& HeadlessEngine::getEngine()
+{
+	return m_engine;
+}
+
+// Same as settings of a fresh install
+Settings::Snapshot HeadlessEngine::getDefaultSettings()
+{
+	Settings::Snapshot settings = { Settings::In::secs5, Settings::RestoreWhen::mousedMoved, Settings::To::fullTransparency, true };
+	return settings;
+}
+
+void HeadlessEngine::IdleTimer_Callback(void *pContext)
+{
+	auto pThis = static_cast<HeadlessEngine *>(pContext);
+	pThis->m_engine.OnIdleTimer(pThis->m_settings);
+}
+
+void HeadlessEngine::FrameTimer_Callback(void *pContext)
+{
+	static_cast<HeadlessEngine *>(pContext)->m_engine.OnFrameTimer();
+}
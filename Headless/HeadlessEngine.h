@@ -0,0 +1,47 @@
+#pragma once
+#include "FakePlatform.h"
+#include "OverlayEngine.h"
+#include "Settings.h"
+#include <cstdint>
+
+#define HEADLESSENGINE_CLIENTWIDTH		1920
+#define HEADLESSENGINE_CLIENTHEIGHT		1080
+
+
+// Overlay engine wired to a fake platform, fake opacity and fake timers on a virtual clock
+// NOTE: Timer callbacks are forwarded from 'FakeClock::AdvanceTo()' on the caller's thread, as the
+//		 Win32 adapter forwards them from thread pool. Settings are given here rather than read
+//		 from 'Settings', so nothing is shared between instances.
+class HeadlessEngine
+{
+public:
+	explicit HeadlessEngine(uint64_t start = 0);
+
+	void setSettings(const Settings::Snapshot& settings);
+	const Settings::Snapshot& getSettings() const;
+
+	void Start();								// Idle timer with interval of settings, as adapter does when enabled
+	void AdvanceTo(uint64_t time);
+	void Advance(uint64_t millisecs);
+
+	FakeClock& getClock();
+	FakeTimer& getIdleTimer();
+	FakeTimer& getFrameTimer();
+	FakePlatform& getPlatform();
+	FakeOpacity& getOpacity();
+	OverlayEngine& getEngine();
+
+	static Settings::Snapshot getDefaultSettings();
+
+private:
+	static void IdleTimer_Callback(void *pContext);
+	static void FrameTimer_Callback(void *pContext);
+
+	FakeClock m_clock;
+	FakeTimer m_timerIdle;
+	FakeTimer m_timerFrame;
+	FakePlatform m_platform;
+	FakeOpacity m_opacity;
+	OverlayEngine m_engine;
+	Settings::Snapshot m_settings;
+};
@@ -0,0 +1,51 @@
+#include "ActivityCoalescer.h"
+
+
+ActivityCoalescer::ActivityCoalescer(uint32_t quantumMillisecs)
+	: m_quantum(quantumMillisecs),
+	m_bActed(false),
+	m_lastActed(0),
+	m_cEvents(0),
+	m_cActed(0)
+{
+}
+
+bool ActivityCoalescer::OnActivity(uint64_t now)
+{
+	++m_cEvents;
+
+	if (m_bActed && now - m_lastActed < m_quantum)
+		return false;	// Within quantum of last action
+
+	m_bActed = true;
+	m_lastActed = now;
+	++m_cActed;
+
+	return true;
+}
+
+// NOTE: Statistics are kept
+void ActivityCoalescer::Reset()
+{
+	m_bActed = false;
+}
+
+void ActivityCoalescer::setQuantum(uint32_t quantumMillisecs)
+{
+	m_quantum = quantumMillisecs;
+}
+
+uint32_t ActivityCoalescer::getQuantum() const
+{
+	return m_quantum;
+}
+
+uint64_t ActivityCoalescer::getEventCount() const
+{
+	return m_cEvents;
+}
+
+uint64_t ActivityCoalescer::getActedCount() const
+{
+	return m_cActed;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+#define ACTIVITYCOALESCER_DEFAULTQUANTUMMILLISECS		50
+
+
+// Collapses bursts of input activity into at most one action per quantum
+// NOTE: High rate mice and pens send thousands of moves a second, while idle interval is
+//		 seconds long. The first event after a quiet quantum is acted on straight away, so
+//		 restoring icons isn't delayed, and the rest of the burst within that quantum is dropped.
+class ActivityCoalescer
+{
+public:
+	explicit ActivityCoalescer(uint32_t quantumMillisecs = ACTIVITYCOALESCER_DEFAULTQUANTUMMILLISECS);
+
+	bool OnActivity(uint64_t now);		// Returns true if event should be acted on
+	void Reset();
+
+	void setQuantum(uint32_t quantumMillisecs);
+	uint32_t getQuantum() const;
+
+	uint64_t getEventCount() const;		// Events seen
+	uint64_t getActedCount() const;		// Events acted on
+
+private:
+	uint32_t m_quantum;
+	bool m_bActed;						// Has any event been acted on since reset?
+	uint64_t m_lastActed;
+	uint64_t m_cEvents;
+	uint64_t m_cActed;
+};
@@ -0,0 +1,94 @@
+#include "AllocationTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+// Static variables
+// NOTE: Trivial thread local, so it needs no allocation or constructor of its own
+static thread_local uint64_t t_cAllocations = 0;
+static std::atomic<uint64_t> s_cTotalAllocations(0);
+
+
+uint64_t AllocationTracker::getAllocationCount()
+{
+	return t_cAllocations;
+}
+
+uint64_t AllocationTracker::getTotalAllocationCount()
+{
+	return s_cTotalAllocations.load(std::memory_order_relaxed);
+}
+
+void AllocationTracker::OnAllocation()
+{
+	++t_cAllocations;
+	s_cTotalAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+#ifdef PELLUCIDICONS_TRACKALLOCATIONS
+
+#pragma region Replaced global allocation functions
+
+void *operator new(size_t cbSize)
+{
+	AllocationTracker::OnAllocation();
+
+	auto p = malloc(cbSize ? cbSize : 1);
+	if (!p)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void *operator new[](size_t cbSize)
+{
+	return operator new(cbSize);
+}
+
+void *operator new(size_t cbSize, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::OnAllocation();
+
+	return malloc(cbSize ? cbSize : 1);
+}
+
+void *operator new[](size_t cbSize, const std::nothrow_t& tag) noexcept
+{
+	return operator new(cbSize, tag);
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+#pragma endregion
+
+#endif
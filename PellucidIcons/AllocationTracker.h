@@ -0,0 +1,56 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+
+// NOTE: Debug builds track allocations by default, define this to track in other builds too
+#if defined(_DEBUG) && !defined(PELLUCIDICONS_TRACKALLOCATIONS)
+#define PELLUCIDICONS_TRACKALLOCATIONS
+#endif
+
+
+// Counts heap allocations made through 'operator new' by this module, per thread
+// NOTE: Counting replaces global 'operator new' and 'operator delete', and is only compiled in
+//		 when 'PELLUCIDICONS_TRACKALLOCATIONS' is defined. Otherwise counts stay at zero.
+class AllocationTracker
+{
+public:
+	static uint64_t getAllocationCount();	// Of calling thread
+	static uint64_t getTotalAllocationCount();
+
+	static void OnAllocation();
+};
+
+// Allocations made by calling thread while this is in scope
+class AllocationScope
+{
+public:
+	AllocationScope()
+		: m_start(AllocationTracker::getAllocationCount()) {}
+
+	uint64_t getAllocationCount() const
+	{
+		return AllocationTracker::getAllocationCount() - m_start;
+	}
+
+private:
+	uint64_t m_start;
+};
+
+// Asserts that nothing in scope allocates, for hot paths that must stay allocation-free
+class AllocationFreeScope
+{
+public:
+	~AllocationFreeScope()
+	{
+		assert(m_scope.getAllocationCount() == 0 && "Hot path allocated from heap");
+	}
+
+private:
+	AllocationScope m_scope;
+};
+
+#ifdef PELLUCIDICONS_TRACKALLOCATIONS
+#define ALLOCATION_FREE_SCOPE()		AllocationFreeScope allocationFreeScope
+#else
+#define ALLOCATION_FREE_SCOPE()		((void)0)
+#endif
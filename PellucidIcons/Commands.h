@@ -0,0 +1,115 @@
+#pragma once
+#include "Settings.h"
+#include "resource.h"
+#include <Windows.h>
+#include <cstddef>
+
+#define COMMAND_VALUE_TOGGLE		0xFFFFFFFF
+#define COMMAND_FIRSTRESOURCEID		ID_PELLUCIDICONS_IN
+#define COMMAND_LASTRESOURCEID		ID_TO_HOVERREVEAL	// NOTE: Update when adding menu items
+
+
+// What to do with the idle timer after a command changed a setting
+enum class PostAction
+{
+	resetTimer,
+	restartTimer,		// Interval changed
+	enableTimer			// Start or stop timer depending on new setting
+};
+
+// Context menu command
+struct CommandDescriptor
+{
+	UINT resourceId;
+	Settings::Field field;
+	uint32_t value;		// Value to set, or 'COMMAND_VALUE_TOGGLE'
+	PostAction postAction;
+};
+
+// All context menu commands in order of their command offset
+// NOTE: Command offset is an index into this table, so dispatch needs no lookup structure
+constexpr CommandDescriptor g_commands[] =
+{
+	// 'are Enabled' submenu item
+	{ ID_PELLUCIDICONS_AREENABLED, Settings::fieldEnabled, COMMAND_VALUE_TOGGLE, PostAction::enableTimer },
+
+	// 'In' submenu items
+	{ ID_IN_5SECS, Settings::fieldIn, static_cast<uint32_t>(Settings::In::secs5), PostAction::restartTimer },
+	{ ID_IN_10SECS, Settings::fieldIn, static_cast<uint32_t>(Settings::In::secs10), PostAction::restartTimer },
+	{ ID_IN_20SECS, Settings::fieldIn, static_cast<uint32_t>(Settings::In::secs20), PostAction::restartTimer },
+	{ ID_IN_30SECS, Settings::fieldIn, static_cast<uint32_t>(Settings::In::secs30), PostAction::restartTimer },
+	{ ID_IN_1MIN, Settings::fieldIn, static_cast<uint32_t>(Settings::In::min1), PostAction::restartTimer },
+	{ ID_IN_2MINS, Settings::fieldIn, static_cast<uint32_t>(Settings::In::mins2), PostAction::restartTimer },
+
+	// 'Get restored when' submenu items
+	{ ID_GET_RESTORED_WHEN_MOUSEMOVED, Settings::fieldRestoreWhen, static_cast<uint32_t>(Settings::RestoreWhen::mousedMoved), PostAction::resetTimer },
+	{ ID_GET_RESTORED_WHEN_MOUSEENTERSQUARTERREGIONONLEFT, Settings::fieldRestoreWhen, static_cast<uint32_t>(Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft), PostAction::resetTimer },
+	{ ID_GET_RESTORED_WHEN_DOUBLECLICKED, Settings::fieldRestoreWhen, static_cast<uint32_t>(Settings::RestoreWhen::doubleClicked), PostAction::resetTimer },
+	{ ID_GET_RESTORED_WHEN_MOUSEENTERSHOTZONE, Settings::fieldRestoreWhen, static_cast<uint32_t>(Settings::RestoreWhen::mousedEntersHotZone), PostAction::resetTimer },
+
+	// 'To' submenu items
+	{ ID_TO_FULLTRANSPARENCY, Settings::fieldTo, static_cast<uint32_t>(Settings::To::fullTransparency), PostAction::resetTimer },
+	{ ID_TO_SEMITRANSPARENCY, Settings::fieldTo, static_cast<uint32_t>(Settings::To::semiTransparency), PostAction::resetTimer },
+	{ ID_TO_HOVERREVEAL, Settings::fieldTo, static_cast<uint32_t>(Settings::To::hoverReveal), PostAction::resetTimer }
+};
+
+constexpr size_t COMMAND_COUNT = sizeof(g_commands) / sizeof(g_commands[0]);
+
+#pragma region Consistency checks
+namespace CommandChecks
+{
+	// Number of radio items each setting needs, toggles need one
+	constexpr uint32_t getValueCount(Settings::Field field)
+	{
+		return (field == Settings::fieldIn ? static_cast<uint32_t>(Settings::In::mins2) + 1 :
+				field == Settings::fieldRestoreWhen ? static_cast<uint32_t>(Settings::RestoreWhen::mousedEntersHotZone) + 1 :
+				field == Settings::fieldTo ? static_cast<uint32_t>(Settings::To::hoverReveal) + 1 :
+				1);
+	}
+
+	// Every command has a distinct menu item from 'resource.h'
+	constexpr bool AreResourceIdsValid()
+	{
+		for (size_t i = 0; i < COMMAND_COUNT; ++i)
+		{
+			if (g_commands[i].resourceId < COMMAND_FIRSTRESOURCEID || g_commands[i].resourceId > COMMAND_LASTRESOURCEID)
+				return false;
+
+			for (size_t j = i + 1; j < COMMAND_COUNT; ++j)
+			{
+				if (g_commands[i].resourceId == g_commands[j].resourceId)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Every value of every setting is reachable from exactly one command
+	constexpr bool AreSettingsCovered()
+	{
+		for (int field = 0; field < Settings::fieldCount; ++field)
+		{
+			auto valueCount = getValueCount(static_cast<Settings::Field>(field));
+			for (uint32_t value = 0; value < valueCount; ++value)
+			{
+				int cCommands = 0;
+				for (size_t i = 0; i < COMMAND_COUNT; ++i)
+				{
+					if (g_commands[i].field == field &&
+						(g_commands[i].value == value || (valueCount == 1 && g_commands[i].value == COMMAND_VALUE_TOGGLE)))
+						++cCommands;
+				}
+
+				if (cCommands != 1)
+					return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+static_assert(CommandChecks::AreResourceIdsValid(), "Command table doesn't match menu item IDs in 'resource.h'");
+static_assert(CommandChecks::AreSettingsCovered(), "Command table doesn't cover every setting value exactly once");
+#pragma endregion
@@ -0,0 +1,253 @@
+#include "FadeEngine.h"
+#include "Metrics.h"
+#include <cmath>
+
+
+FadeEngine::FadeEngine(Clock& clock, TimerBackend& frameTimer)
+	: m_clock(clock),
+	m_frameTimer(frameTimer),
+	m_pBackend(nullptr),
+	m_opacity(OPACITY_OPAQUE),
+	m_cSetCalls(0),
+	m_cQueryCalls(0),
+	m_state(State::idle),
+	m_alphaTable(),
+	m_startTime(0),
+	m_startFrame(0),
+	m_frame(0),
+	m_bInFade(false)
+{
+}
+
+void FadeEngine::setBackend(Backend *pBackend)
+{
+	m_pBackend.store(pBackend);
+	Reconcile();
+}
+
+void FadeEngine::Reconcile()
+{
+	auto pBackend = m_pBackend.load();
+	if (!pBackend)
+		return;
+
+	uint8_t opacity;
+	m_cQueryCalls.fetch_add(1, std::memory_order_relaxed);
+	if (pBackend->GetOpacity(opacity))
+		m_opacity.store(opacity, std::memory_order_relaxed);
+}
+
+uint8_t FadeEngine::getOpacity() const
+{
+	return m_opacity.load(std::memory_order_relaxed);
+}
+
+bool FadeEngine::IsHidden() const
+{
+	return (getOpacity() == OPACITY_HIDDEN);
+}
+
+bool FadeEngine::IsFading() const
+{
+	return (m_state.load(std::memory_order_relaxed) != State::idle);
+}
+
+bool FadeEngine::setOpacity(uint8_t opacity)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return setOpacityUnlocked(opacity);
+}
+
+void FadeEngine::FadeOut(uint8_t targetOpacity, Easing easing)
+{
+	if (targetOpacity < OPACITY_HIDDEN)
+		targetOpacity = OPACITY_HIDDEN;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Precompute opacity for every frame
+	auto pProgress = getProgressTable(easing);
+	for (int i = 0; i <= FADE_FRAMES; ++i)
+		m_alphaTable[i] = static_cast<uint8_t>(OPACITY_OPAQUE - ((OPACITY_OPAQUE - targetOpacity) * pProgress[i] + 0x7F) / 0xFF);
+
+	m_state.store(State::fadingOut, std::memory_order_relaxed);
+	m_startTime = m_clock.Now();
+	m_startFrame = 0;
+	beginFadeUnlocked();
+	applyFrame(m_startTime);
+}
+
+void FadeEngine::FadeIn()
+{
+	// Quick exit for the common case of user activity while icons are visible
+	if (!IsFading() && getOpacity() == OPACITY_OPAQUE)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto state = m_state.load(std::memory_order_relaxed);
+	if (state == State::fadingIn)
+		return;
+
+	if (state != State::fadingOut)
+	{
+		m_frameTimer.Disarm();
+		setOpacityUnlocked(OPACITY_OPAQUE);
+		return;
+	}
+
+	// Play fade out backwards starting from current frame
+	// NOTE: First step back is applied right away, so restore starts within this call
+	m_state.store(State::fadingIn, std::memory_order_relaxed);
+	m_startTime = m_clock.Now();
+	m_startFrame = m_frame - 1;
+	applyFrame(m_startTime);
+}
+
+void FadeEngine::Restore()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_state.store(State::idle, std::memory_order_relaxed);
+	m_frameTimer.Disarm();
+	setOpacityUnlocked(OPACITY_OPAQUE);
+	endFadeUnlocked();
+}
+
+// NOTE: For when nobody can see fade anyway, so frame timer can be left alone
+void FadeEngine::Finish()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto state = m_state.load(std::memory_order_relaxed);
+	if (state == State::idle)
+		return;
+
+	m_frameTimer.Disarm();
+	m_frame = (state == State::fadingOut ? FADE_FRAMES : 0);
+	setOpacityUnlocked(m_alphaTable[m_frame]);
+	m_state.store(State::idle, std::memory_order_relaxed);
+	endFadeUnlocked();
+}
+
+void FadeEngine::OnFrameTimer()
+{
+	METRICS_SCOPE(histogramFadeStep);
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_state.load(std::memory_order_relaxed) == State::idle)
+		return;		// Cancelled meanwhile
+
+	applyFrame(m_clock.Now());
+}
+
+uint64_t FadeEngine::getSetCallCount() const
+{
+	return m_cSetCalls.load(std::memory_order_relaxed);
+}
+
+uint64_t FadeEngine::getQueryCallCount() const
+{
+	return m_cQueryCalls.load(std::memory_order_relaxed);
+}
+
+// CAUTION: Must be called with 'm_mutex' held
+void FadeEngine::applyFrame(uint64_t now)
+{
+	auto elapsedFrames = static_cast<int>((now - m_startTime) / FADE_FRAMEMILLISECS);
+	if (elapsedFrames > FADE_FRAMES)
+		elapsedFrames = FADE_FRAMES;
+
+	bool bFadingOut = (m_state.load(std::memory_order_relaxed) == State::fadingOut);
+	auto frame = (bFadingOut ? m_startFrame + elapsedFrames : m_startFrame - elapsedFrames);
+	if (frame >= FADE_FRAMES)
+		frame = FADE_FRAMES;
+	else if (frame <= 0)
+		frame = 0;
+
+	m_frame = frame;
+	setOpacityUnlocked(m_alphaTable[frame]);
+
+	if ((bFadingOut && frame == FADE_FRAMES) || (!bFadingOut && frame == 0))
+	{
+		m_state.store(State::idle, std::memory_order_relaxed);
+		endFadeUnlocked();
+		return;
+	}
+
+	// Schedule next step at its deadline
+	auto nextDeadline = m_startTime + static_cast<uint64_t>(elapsedFrames + 1) * FADE_FRAMEMILLISECS;
+	m_frameTimer.Arm(static_cast<uint32_t>(nextDeadline - now));
+}
+
+// CAUTION: Must be called with 'm_mutex' held
+bool FadeEngine::setOpacityUnlocked(uint8_t opacity)
+{
+	if (m_opacity.load(std::memory_order_relaxed) == opacity)
+		return true;	// Nothing to do
+
+	auto pBackend = m_pBackend.load();
+	if (!pBackend)
+		return false;
+
+	m_cSetCalls.fetch_add(1, std::memory_order_relaxed);
+	if (!pBackend->SetOpacity(opacity))
+		return false;
+
+	m_opacity.store(opacity, std::memory_order_relaxed);
+	return true;
+}
+
+// CAUTION: Must be called with 'm_mutex' held
+void FadeEngine::beginFadeUnlocked()
+{
+	if (m_bInFade)
+		return;		// NOTE: Fade out restarted during fade in is still the same fade
+
+	m_bInFade = true;
+	auto pBackend = m_pBackend.load();
+	if (pBackend)
+		pBackend->BeginFade(m_opacity.load(std::memory_order_relaxed));
+}
+
+// CAUTION: Must be called with 'm_mutex' held
+void FadeEngine::endFadeUnlocked()
+{
+	if (!m_bInFade)
+		return;
+
+	m_bInFade = false;
+	auto pBackend = m_pBackend.load();
+	if (pBackend)
+		pBackend->EndFade(m_opacity.load(std::memory_order_relaxed));
+}
+
+// Returns fade progress for each frame, from 0x00 (start) to 0xFF (end)
+const uint8_t *FadeEngine::getProgressTable(Easing easing)
+{
+	struct ProgressTables
+	{
+		uint8_t tables[4][FADE_FRAMES + 1];
+
+		ProgressTables()
+		{
+			for (int i = 0; i <= FADE_FRAMES; ++i)
+			{
+				auto t = static_cast<double>(i) / FADE_FRAMES;
+				tables[static_cast<int>(Easing::linear)][i] = toByte(t);
+				tables[static_cast<int>(Easing::easeIn)][i] = toByte(t * t);
+				tables[static_cast<int>(Easing::easeOut)][i] = toByte(1.0 - (1.0 - t) * (1.0 - t));
+				tables[static_cast<int>(Easing::easeInOut)][i] = toByte(t * t * (3.0 - 2.0 * t));
+			}
+		}
+
+		static uint8_t toByte(double progress)
+		{
+			return static_cast<uint8_t>(std::lround(progress * 0xFF));
+		}
+	};
+	static const ProgressTables s_progressTables;	// NOTE: Built once, on first fade
+
+	return s_progressTables.tables[static_cast<int>(easing)];
+}
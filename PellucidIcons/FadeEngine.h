@@ -0,0 +1,96 @@
+#pragma once
+#include "Timing.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#define OPACITY_OPAQUE		0xFF
+#define OPACITY_HIDDEN		0x01	// CAUTION: Not zero, else window stops receiving mouse messages
+
+#define FADE_FRAMES			16
+#define FADE_FRAMEMILLISECS	40
+
+
+// Owns the authoritative opacity of the shell window and animates it
+// NOTE: Every opacity change goes through here, so the current value is always known and
+//		 hot paths can read it with a relaxed load instead of querying the window. The real
+//		 window is only queried by 'Reconcile()', when something external may have changed it.
+//
+//		 A fade is a sequence of 'FADE_FRAMES' steps, each scheduled as a deadline on a one-shot
+//		 frame timer, so no thread is parked while fading. Late frames are skipped rather than
+//		 replayed. A fade out can be reversed or cancelled at any frame.
+class FadeEngine
+{
+public:
+	// Platform window whose opacity is controlled
+	class Backend
+	{
+	public:
+		virtual ~Backend() {}
+
+		virtual bool SetOpacity(uint8_t opacity) = 0;
+		virtual bool GetOpacity(uint8_t& opacity) = 0;
+
+		// Bracket the opacity changes of each fade, so a backend can prepare for many of them
+		// CAUTION: Like all backend calls, these are made with fade engine's lock held
+		virtual void BeginFade(uint8_t opacity) {}
+		virtual void EndFade(uint8_t opacity) {}
+	};
+
+	enum class Easing
+	{
+		linear,
+		easeIn,
+		easeOut,
+		easeInOut
+	};
+
+	FadeEngine(Clock& clock, TimerBackend& frameTimer);
+
+	void setBackend(Backend *pBackend);
+	void Reconcile();							// Re-read opacity from window
+
+	uint8_t getOpacity() const;
+	bool IsHidden() const;
+	bool IsFading() const;
+	bool setOpacity(uint8_t opacity);			// Returns false if window could not be updated
+
+	void FadeOut(uint8_t targetOpacity, Easing easing);
+	void FadeIn();								// Reverses a running fade out, else restores at once
+	void Restore();								// Cancels any fade and restores at once
+	void Finish();								// Jumps any fade to its last frame at once
+	void OnFrameTimer();
+
+	uint64_t getSetCallCount() const;
+	uint64_t getQueryCallCount() const;
+
+private:
+	enum class State
+	{
+		idle,
+		fadingOut,
+		fadingIn
+	};
+
+	void applyFrame(uint64_t now);
+	bool setOpacityUnlocked(uint8_t opacity);
+	void beginFadeUnlocked();
+	void endFadeUnlocked();
+	static const uint8_t *getProgressTable(Easing easing);
+
+	Clock& m_clock;
+	TimerBackend& m_frameTimer;
+	std::atomic<Backend *> m_pBackend;
+	std::atomic<uint8_t> m_opacity;
+	std::atomic<uint64_t> m_cSetCalls;			// Number of platform calls made
+	std::atomic<uint64_t> m_cQueryCalls;
+
+	// Animation state
+	std::mutex m_mutex;
+	std::atomic<State> m_state;
+	uint8_t m_alphaTable[FADE_FRAMES + 1];		// Opacity for each frame of fade out
+	uint64_t m_startTime;
+	int m_startFrame;
+	int m_frame;
+	bool m_bInFade;								// Between 'Backend::BeginFade()' and 'Backend::EndFade()'
+};
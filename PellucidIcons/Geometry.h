@@ -0,0 +1,47 @@
+#pragma once
+
+
+// Rectangle with exclusive right and bottom edges
+struct Rect
+{
+	int left;
+	int top;
+	int right;
+	int bottom;
+
+	bool operator==(const Rect& other) const
+	{
+		return (left == other.left && top == other.top && right == other.right && bottom == other.bottom);
+	}
+
+	bool contains(int x, int y) const
+	{
+		return (x >= left) & (x < right) & (y >= top) & (y < bottom);		// NOTE: Non short-circuit on purpose
+	}
+
+	bool contains(const Rect& other) const
+	{
+		return (other.left >= left && other.top >= top && other.right <= right && other.bottom <= bottom);
+	}
+
+	bool isEmpty() const
+	{
+		return (right <= left || bottom <= top);
+	}
+
+	Rect inflate(int amount) const
+	{
+		Rect result = { left - amount, top - amount, right + amount, bottom + amount };
+		return result;
+	}
+
+	Rect intersect(const Rect& other) const
+	{
+		Rect result;
+		result.left = (left > other.left ? left : other.left);
+		result.top = (top > other.top ? top : other.top);
+		result.right = (right < other.right ? right : other.right);
+		result.bottom = (bottom < other.bottom ? bottom : other.bottom);
+		return result;
+	}
+};
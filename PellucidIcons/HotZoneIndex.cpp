@@ -0,0 +1,120 @@
+#include "HotZoneIndex.h"
+#include <cstring>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+HotZoneIndex::HotZoneIndex()
+	: m_bounds(),
+	m_cellWidth(1),
+	m_cellHeight(1),
+	m_margin(0),
+	m_zones(),
+	m_cZones(0),
+	m_cells()
+{
+}
+
+void HotZoneIndex::Build(const Rect& bounds, const Rect zones[], size_t count, int margin)
+{
+	Clear();
+	if (bounds.isEmpty())
+		return;
+
+	m_bounds = bounds;
+	m_margin = (margin > 0 ? margin : 0);
+	m_cellWidth = (bounds.right - bounds.left + HOTZONEINDEX_GRIDSIZE - 1) / HOTZONEINDEX_GRIDSIZE;
+	m_cellHeight = (bounds.bottom - bounds.top + HOTZONEINDEX_GRIDSIZE - 1) / HOTZONEINDEX_GRIDSIZE;
+
+	for (size_t i = 0; i < count && m_cZones < HOTZONEINDEX_MAXZONES; ++i)
+	{
+		auto zone = zones[i].intersect(bounds);
+		if (zone.isEmpty())
+			continue;
+
+		auto index = m_cZones++;
+		m_zones[index] = zone;
+
+		// Cells touched by grown zone, inclusive
+		auto grownZone = zone.inflate(m_margin).intersect(bounds);
+		int firstColumn = (grownZone.left - bounds.left) / m_cellWidth;
+		int lastColumn = (grownZone.right - 1 - bounds.left) / m_cellWidth;
+		int firstRow = (grownZone.top - bounds.top) / m_cellHeight;
+		int lastRow = (grownZone.bottom - 1 - bounds.top) / m_cellHeight;
+
+		uint64_t bit = 1ull << index;
+		for (int row = firstRow; row <= lastRow; ++row)
+		{
+			for (int column = firstColumn; column <= lastColumn; ++column)
+			{
+				Rect cellRect;
+				cellRect.left = bounds.left + column * m_cellWidth;
+				cellRect.top = bounds.top + row * m_cellHeight;
+				cellRect.right = cellRect.left + m_cellWidth;
+				cellRect.bottom = cellRect.top + m_cellHeight;
+				cellRect = cellRect.intersect(bounds);
+
+				auto& cell = m_cells[row * HOTZONEINDEX_GRIDSIZE + column];
+				cell.nearby |= bit;
+				if (zone.contains(cellRect))
+					cell.covered |= bit;
+				else if (!zone.intersect(cellRect).isEmpty())
+					cell.overlapped |= bit;
+			}
+		}
+	}
+}
+
+void HotZoneIndex::Clear()
+{
+	m_bounds = Rect();
+	m_margin = 0;
+	m_cZones = 0;
+	memset(m_cells, 0, sizeof(m_cells));
+}
+
+int HotZoneIndex::HitTest(int x, int y, bool bGrown) const
+{
+	if (!m_bounds.contains(x, y))
+		return -1;
+
+	auto& cell = m_cells[((y - m_bounds.top) / m_cellHeight) * HOTZONEINDEX_GRIDSIZE + (x - m_bounds.left) / m_cellWidth];
+	if (cell.covered)
+		return getLowestBitIndex(cell.covered);
+
+	auto margin = (bGrown ? m_margin : 0);
+	for (auto mask = (bGrown ? cell.nearby : cell.overlapped); mask; mask &= mask - 1)
+	{
+		auto index = getLowestBitIndex(mask);
+		if (m_zones[index].inflate(margin).contains(x, y))
+			return index;
+	}
+
+	return -1;
+}
+
+size_t HotZoneIndex::getZoneCount() const
+{
+	return m_cZones;
+}
+
+int HotZoneIndex::getMargin() const
+{
+	return m_margin;
+}
+
+int HotZoneIndex::getLowestBitIndex(uint64_t mask)
+{
+#ifdef _MSC_VER
+	// NOTE: '_BitScanForward64()' isn't available on x86, so scan in halves
+	unsigned long index;
+	if (_BitScanForward(&index, static_cast<unsigned long>(mask)))
+		return static_cast<int>(index);
+
+	_BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+	return static_cast<int>(index) + 32;
+#else
+	return __builtin_ctzll(mask);
+#endif
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "Geometry.h"
+#include <cstddef>
+#include <cstdint>
+
+#define HOTZONEINDEX_MAXZONES		64		// NOTE: One bit per zone in each grid cell
+#define HOTZONEINDEX_GRIDSIZE		16		// Cells along each side of bounds
+
+
+// Uniform grid over a bounding rectangle for hit testing many zones per mouse move
+// NOTE: Each cell keeps which zones cover it completely and which only overlap it, so a hit
+//		 test is one cell lookup plus exact tests of the few zones crossing that cell.
+class HotZoneIndex
+{
+public:
+	HotZoneIndex();
+
+	// Zones are clipped to 'bounds', empty ones are dropped
+	// NOTE: 'margin' is how much zones are grown by for 'HitTest()' with 'bGrown'
+	void Build(const Rect& bounds, const Rect zones[], size_t count, int margin = 0);
+	void Clear();
+
+	// Returns index of a zone containing point, or -1 if none
+	int HitTest(int x, int y, bool bGrown = false) const;
+
+	size_t getZoneCount() const;
+	int getMargin() const;
+
+private:
+	struct Cell
+	{
+		uint64_t covered;		// Zones containing whole cell
+		uint64_t overlapped;	// Zones containing part of cell
+		uint64_t nearby;		// Zones containing part of cell when grown by margin
+	};
+
+	static int getLowestBitIndex(uint64_t mask);
+
+	Rect m_bounds;
+	int m_cellWidth;
+	int m_cellHeight;
+	int m_margin;
+	Rect m_zones[HOTZONEINDEX_MAXZONES];
+	size_t m_cZones;
+	Cell m_cells[HOTZONEINDEX_GRIDSIZE * HOTZONEINDEX_GRIDSIZE];
+};
@@ -0,0 +1,129 @@
+#include "HoverReveal.h"
+#include <cmath>
+
+
+HoverReveal::HoverReveal()
+	: m_radius(HOVERREVEAL_DEFAULTRADIUS),
+	m_items(),
+	m_cItems(0)
+{
+}
+
+void HoverReveal::setRadius(int radius)
+{
+	m_radius = (radius > 0 ? radius : 1);
+}
+
+int HoverReveal::getRadius() const
+{
+	return m_radius;
+}
+
+// NOTE: Only cells of grid around point are looked at, however many items there are
+size_t HoverReveal::Update(const ItemGrid& itemGrid, int x, int y, Change changes[])
+{
+	Rect area = { x - m_radius, y - m_radius, x + m_radius + 1, y + m_radius + 1 };
+	int slots[HOVERREVEAL_MAXITEMS];
+	auto cSlots = itemGrid.Query(area, slots, HOVERREVEAL_MAXITEMS);
+
+	Item items[HOVERREVEAL_MAXITEMS];
+	size_t cItems = 0;
+	for (size_t i = 0; i < cSlots; ++i)
+	{
+		auto& rect = itemGrid.getSlotRect(slots[i]);
+		auto alpha = getAlpha(rect, x, y, m_radius);
+		if (alpha == 0)
+			continue;
+
+		items[cItems].slot = slots[i];
+		items[cItems].rect = rect;
+		items[cItems].alpha = alpha;
+		++cItems;
+	}
+
+	return diff(items, cItems, changes);
+}
+
+size_t HoverReveal::Hide(Change changes[])
+{
+	return diff(NULL, 0, changes);
+}
+
+void HoverReveal::Reset()
+{
+	m_cItems = 0;
+}
+
+size_t HoverReveal::getRevealedCount() const
+{
+	return m_cItems;
+}
+
+// Smoothly rises from zero at radius to opaque where point is on item
+uint8_t HoverReveal::getAlpha(const Rect& rect, int x, int y, int radius)
+{
+	// Distance to nearest point of rectangle
+	int64_t dx = (x < rect.left ? rect.left - x : (x >= rect.right ? x - rect.right + 1 : 0));
+	int64_t dy = (y < rect.top ? rect.top - y : (y >= rect.bottom ? y - rect.bottom + 1 : 0));
+	auto distanceSquared = dx * dx + dy * dy;
+	if (distanceSquared >= static_cast<int64_t>(radius) * radius)
+		return 0;
+
+	auto t = 1.0 - std::sqrt(static_cast<double>(distanceSquared)) / radius;
+	auto eased = t * t * (3.0 - 2.0 * t);
+
+	auto step = static_cast<int>(eased * (HOVERREVEAL_ALPHASTEPS - 1) + 0.5);
+	return static_cast<uint8_t>(step * 0xFF / (HOVERREVEAL_ALPHASTEPS - 1));
+}
+
+// Changes from revealed items to given ones, which then become revealed items
+// NOTE: Items hidden may have overlapped items still revealed, so those are drawn again too
+size_t HoverReveal::diff(const Item items[], size_t count, Change changes[])
+{
+	auto isSame = [](const Item& item, const Item& other) { return (item.slot == other.slot && item.rect == other.rect); };
+
+	size_t cChanges = 0;
+	for (size_t i = 0; i < m_cItems; ++i)
+	{
+		bool bKept = false;
+		for (size_t j = 0; j < count && !bKept; ++j)
+			bKept = isSame(m_items[i], items[j]);
+
+		if (!bKept)
+		{
+			changes[cChanges].rect = m_items[i].rect;
+			changes[cChanges].alpha = 0;
+			++cChanges;
+		}
+	}
+
+	auto cHidden = cChanges;
+	for (size_t j = 0; j < count; ++j)
+	{
+		bool bChanged = true;
+		for (size_t i = 0; i < m_cItems; ++i)
+		{
+			if (isSame(m_items[i], items[j]))
+			{
+				bChanged = (m_items[i].alpha != items[j].alpha);
+				break;
+			}
+		}
+
+		for (size_t k = 0; k < cHidden && !bChanged; ++k)
+			bChanged = !items[j].rect.intersect(changes[k].rect).isEmpty();
+
+		if (bChanged)
+		{
+			changes[cChanges].rect = items[j].rect;
+			changes[cChanges].alpha = items[j].alpha;
+			++cChanges;
+		}
+	}
+
+	for (size_t j = 0; j < count; ++j)
+		m_items[j] = items[j];
+	m_cItems = count;
+
+	return cChanges;
+}
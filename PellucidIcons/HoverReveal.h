@@ -0,0 +1,65 @@
+#pragma once
+#include "Geometry.h"
+#include "ItemGrid.h"
+#include <cstddef>
+#include <cstdint>
+
+#define HOVERREVEAL_MAXITEMS		64		// Items revealed at once
+#define HOVERREVEAL_MAXCHANGES		(2 * HOVERREVEAL_MAXITEMS)	// Hiding all revealed items, then revealing as many
+#define HOVERREVEAL_DEFAULTRADIUS	160		// Pixels from mouse within which items are revealed
+#define HOVERREVEAL_ALPHASTEPS		16		// NOTE: Alpha is quantized, so small mouse moves don't redraw every item
+
+
+// Which items are revealed around mouse while all the others stay hidden, and how much
+// NOTE: Items get more opaque as mouse gets nearer to them. Each update only gives back changes
+//		 from the previous one, so whatever draws the items only redraws what changed.
+class HoverReveal
+{
+public:
+	// New alpha of an item's rectangle, zero hides it again
+	struct Change
+	{
+		Rect rect;
+		uint8_t alpha;
+	};
+
+	// Draws revealed items over hidden window
+	class Backend
+	{
+	public:
+		virtual ~Backend() {}
+
+		// NOTE: Changes hiding items come first, as items may overlap
+		virtual void ApplyReveal(const Change changes[], size_t count) = 0;
+		virtual void EndReveal() = 0;		// Hide everything, what was kept for drawing items may be reused next time
+	};
+
+	HoverReveal();
+
+	void setRadius(int radius);
+	int getRadius() const;
+
+	// Reveals items of grid near point, returns changes from last time
+	// IMPORTANT: 'changes' must have room for 'HOVERREVEAL_MAXCHANGES'
+	size_t Update(const ItemGrid& itemGrid, int x, int y, Change changes[]);
+	size_t Hide(Change changes[]);		// Hides all revealed items
+	void Reset();						// Forgets revealed items, e.g. when what drew them has been cleared
+
+	size_t getRevealedCount() const;
+
+	static uint8_t getAlpha(const Rect& rect, int x, int y, int radius);
+
+private:
+	struct Item
+	{
+		int slot;
+		Rect rect;		// NOTE: Kept, as slot may be reused by another item before this one is hidden
+		uint8_t alpha;
+	};
+
+	size_t diff(const Item items[], size_t count, Change changes[]);
+
+	int m_radius;
+	Item m_items[HOVERREVEAL_MAXITEMS];		// Revealed items
+	size_t m_cItems;
+};
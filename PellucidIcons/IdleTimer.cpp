@@ -0,0 +1,81 @@
+#include "IdleTimer.h"
+
+
+IdleTimer::IdleTimer(TimerBackend& backend)
+	: m_backend(backend),
+	m_bRunning(false),
+	m_bArmed(false),
+	m_interval(0),
+	m_deadline(0),
+	m_cArms(0)
+{
+}
+
+void IdleTimer::Start(uint64_t now, uint32_t intervalMillisecs)
+{
+	m_interval.store(intervalMillisecs, std::memory_order_relaxed);
+	m_deadline.store(now + intervalMillisecs);
+	m_bRunning.store(true);
+
+	// NOTE: Interval may have become shorter than current pending due time, so always re-arm here
+	m_bArmed.store(true);
+	arm(intervalMillisecs);
+}
+
+void IdleTimer::Stop()
+{
+	m_bRunning.store(false);
+	m_bArmed.store(false);
+	m_backend.Disarm();
+}
+
+void IdleTimer::Bump(uint64_t now)
+{
+	if (!m_bRunning.load(std::memory_order_relaxed))
+		return;
+
+	auto interval = m_interval.load(std::memory_order_relaxed);
+	m_deadline.store(now + interval);
+
+	// Common case: platform timer is still pending and will re-check the new deadline when it fires
+	// CAUTION: The deadline store above and 'm_bArmed' accesses here and in 'OnFired()' must be
+	//			sequentially consistent, else a bump racing with an elapsing timer could get lost.
+	if (!m_bArmed.load() && !m_bArmed.exchange(true))
+		arm(interval);
+}
+
+bool IdleTimer::OnFired(uint64_t now)
+{
+	if (!m_bRunning.load())
+		return false;
+
+	m_bArmed.store(false);
+
+	auto deadline = m_deadline.load();
+	if (now < deadline)
+	{
+		// There was activity since we were armed, so sleep for the remaining time
+		if (!m_bArmed.exchange(true))
+			arm(static_cast<uint32_t>(deadline - now));
+
+		return false;
+	}
+
+	return true;
+}
+
+bool IdleTimer::IsRunning() const
+{
+	return m_bRunning.load(std::memory_order_relaxed);
+}
+
+uint64_t IdleTimer::getArmCount() const
+{
+	return m_cArms.load(std::memory_order_relaxed);
+}
+
+void IdleTimer::arm(uint32_t dueMillisecs)
+{
+	m_cArms.fetch_add(1, std::memory_order_relaxed);
+	m_backend.Arm(dueMillisecs);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "Timing.h"
+#include <atomic>
+#include <cstdint>
+
+
+// Idle timer engine
+// NOTE: Instead of tearing down and re-creating a platform timer for every input event,
+//		 one long-lived one-shot timer is kept around. User activity only pushes the idle
+//		 deadline out with an atomic store. When the platform timer fires, the deadline is
+//		 re-checked and, if activity happened meanwhile, the timer is re-armed for the
+//		 remaining time. So the platform timer is touched at most once per idle interval.
+class IdleTimer
+{
+public:
+	IdleTimer(TimerBackend& backend);
+
+	void Start(uint64_t now, uint32_t intervalMillisecs);	// (Re)start with a new interval
+	void Stop();
+	void Bump(uint64_t now);								// Report user activity
+	bool OnFired(uint64_t now);								// Returns true if idle deadline has elapsed
+
+	bool IsRunning() const;
+	uint64_t getArmCount() const;
+
+private:
+	void arm(uint32_t dueMillisecs);
+
+	TimerBackend& m_backend;
+	std::atomic<bool> m_bRunning;
+	std::atomic<bool> m_bArmed;				// Is platform timer pending?
+	std::atomic<uint32_t> m_interval;
+	std::atomic<uint64_t> m_deadline;
+	std::atomic<uint64_t> m_cArms;			// Number of times platform timer was armed
+};
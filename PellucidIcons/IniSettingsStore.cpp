@@ -0,0 +1,88 @@
+#include "IniSettingsStore.h"
+#include <fstream>
+
+
+IniSettingsStore::IniSettingsStore(const std::string& path)
+	: m_path(path),
+	m_bLoaded(false)
+{
+}
+
+bool IniSettingsStore::ReadValues(const wchar_t *const names[], uint32_t values[], size_t count)
+{
+	if (!m_bLoaded && !load())
+		return false;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto it = m_values.find(names[i]);
+		if (it != m_values.end())
+			values[i] = it->second;
+	}
+
+	return true;
+}
+
+bool IniSettingsStore::WriteValue(const wchar_t *name, uint32_t value)
+{
+	if (!m_bLoaded && !load())
+		return false;
+
+	m_values[name] = value;
+	return save();
+}
+
+bool IniSettingsStore::WriteValues(const wchar_t *const names[], const uint32_t values[], size_t count)
+{
+	if (!m_bLoaded && !load())
+		return false;
+
+	for (size_t i = 0; i < count; ++i)
+		m_values[names[i]] = values[i];
+
+	return save();	// NOTE: One write for whole batch
+}
+
+bool IniSettingsStore::Watch(ChangeCallback callback, void *pContext)
+{
+	return false;	// We are the only writer
+}
+
+bool IniSettingsStore::load()
+{
+	m_bLoaded = true;
+	if (m_path.empty())
+		return true;
+
+	std::wifstream file(m_path);
+	if (!file)
+		return true;	// Not created yet, so all defaults
+
+	std::wstring line;
+	while (std::getline(file, line))
+	{
+		auto separator = line.find(L'=');
+		if (separator == std::wstring::npos || separator == 0)
+			continue;
+
+		try
+		{
+			m_values[line.substr(0, separator)] = static_cast<uint32_t>(std::stoul(line.substr(separator + 1)));
+		}
+		catch (...) {}	// Skip malformed lines
+	}
+
+	return true;
+}
+
+bool IniSettingsStore::save() const
+{
+	if (m_path.empty())
+		return true;
+
+	std::wofstream file(m_path, std::ios::trunc);
+	for (auto& value : m_values)
+		file << value.first << L'=' << value.second << L'\n';
+
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "SettingsStore.h"
+#include <map>
+#include <string>
+
+
+// Settings store kept in memory and optionally persisted as 'name=value' lines in a file
+// NOTE: Meant for hosts without a registry. An empty path keeps it purely in memory.
+class IniSettingsStore : public SettingsStore
+{
+public:
+	IniSettingsStore(const std::string& path);
+
+	// SettingsStore
+	virtual bool ReadValues(const wchar_t *const names[], uint32_t values[], size_t count);
+	virtual bool WriteValue(const wchar_t *name, uint32_t value);
+	virtual bool WriteValues(const wchar_t *const names[], const uint32_t values[], size_t count);
+	virtual bool Watch(ChangeCallback callback, void *pContext);
+
+private:
+	bool load();
+	bool save() const;
+
+	std::string m_path;
+	std::map<std::wstring, uint32_t> m_values;
+	bool m_bLoaded;
+};
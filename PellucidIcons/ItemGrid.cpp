@@ -0,0 +1,229 @@
+#include "ItemGrid.h"
+#include <algorithm>
+
+
+ItemGrid::ItemGrid()
+	: m_bounds(),
+	m_cellSize(ITEMGRID_CELLSIZE),
+	m_cColumns(0),
+	m_cRows(0),
+	m_bValid(false),
+	m_queryStamp(0)
+{
+}
+
+void ItemGrid::Reset(const Rect& bounds)
+{
+	Invalidate();
+
+	m_bounds = bounds;
+	if (bounds.isEmpty())
+		m_bounds = Rect();
+
+	int width = m_bounds.right - m_bounds.left;
+	int height = m_bounds.bottom - m_bounds.top;
+	int longestSide = (width > height ? width : height);
+	m_cellSize = (longestSide + ITEMGRID_MAXCELLSPERSIDE - 1) / ITEMGRID_MAXCELLSPERSIDE;
+	if (m_cellSize < ITEMGRID_CELLSIZE)
+		m_cellSize = ITEMGRID_CELLSIZE;
+
+	// NOTE: Always at least one cell, which also holds items outside bounds
+	m_cColumns = (width + m_cellSize - 1) / m_cellSize;
+	m_cRows = (height + m_cellSize - 1) / m_cellSize;
+	if (m_cColumns < 1)
+		m_cColumns = 1;
+	if (m_cRows < 1)
+		m_cRows = 1;
+
+	m_cells.resize(static_cast<size_t>(m_cColumns) * m_cRows);
+	m_bValid = true;
+}
+
+void ItemGrid::Invalidate()
+{
+	m_bValid = false;
+
+	// NOTE: Memory is given back, grid may not be needed again for a long time
+	std::vector<std::vector<int>>().swap(m_cells);
+	std::vector<int>().swap(m_slotOfIndex);
+	std::vector<Rect>().swap(m_slotRects);
+	std::vector<int>().swap(m_freeSlots);
+	std::vector<uint32_t>().swap(m_slotQueryStamps);
+	m_queryStamp = 0;
+}
+
+bool ItemGrid::IsValid() const
+{
+	return m_bValid;
+}
+
+void ItemGrid::Insert(int index, const Rect& rect)
+{
+	if (!m_bValid)
+		return;
+
+	if (index < 0 || static_cast<size_t>(index) > m_slotOfIndex.size())
+	{
+		Invalidate();
+		return;
+	}
+
+	int slot;
+	if (!m_freeSlots.empty())
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = static_cast<int>(m_slotRects.size());
+		m_slotRects.push_back(Rect());
+		m_slotQueryStamps.push_back(0);
+	}
+
+	m_slotRects[slot] = rect;
+	m_slotOfIndex.insert(m_slotOfIndex.begin() + index, slot);
+	link(slot);
+}
+
+void ItemGrid::Remove(int index)
+{
+	if (!m_bValid)
+		return;
+
+	if (index < 0 || static_cast<size_t>(index) >= m_slotOfIndex.size())
+	{
+		Invalidate();
+		return;
+	}
+
+	auto slot = m_slotOfIndex[index];
+	unlink(slot);
+	m_slotRects[slot] = Rect();
+	m_freeSlots.push_back(slot);
+	m_slotOfIndex.erase(m_slotOfIndex.begin() + index);
+}
+
+void ItemGrid::Move(int index, const Rect& rect)
+{
+	if (!m_bValid)
+		return;
+
+	if (index < 0 || static_cast<size_t>(index) >= m_slotOfIndex.size())
+	{
+		Invalidate();
+		return;
+	}
+
+	auto slot = m_slotOfIndex[index];
+	if (m_slotRects[slot] == rect)
+		return;
+
+	unlink(slot);
+	m_slotRects[slot] = rect;
+	link(slot);
+}
+
+size_t ItemGrid::getCount() const
+{
+	return m_slotOfIndex.size();
+}
+
+const Rect& ItemGrid::getBounds() const
+{
+	return m_bounds;
+}
+
+size_t ItemGrid::Query(const Rect& area, int slots[], size_t maxSlots) const
+{
+	int firstColumn, lastColumn, firstRow, lastRow;
+	if (!m_bValid || maxSlots == 0 || !getCellRange(area, firstColumn, lastColumn, firstRow, lastRow))
+		return 0;
+
+	// Stamp is bumped per query instead of clearing a visited flag of every slot
+	if (++m_queryStamp == 0)
+	{
+		std::fill(m_slotQueryStamps.begin(), m_slotQueryStamps.end(), 0);
+		m_queryStamp = 1;
+	}
+
+	size_t count = 0;
+	for (int row = firstRow; row <= lastRow; ++row)
+	{
+		for (int column = firstColumn; column <= lastColumn; ++column)
+		{
+			for (auto slot : m_cells[row * m_cColumns + column])
+			{
+				if (m_slotQueryStamps[slot] == m_queryStamp)
+					continue;
+				m_slotQueryStamps[slot] = m_queryStamp;
+
+				if (m_slotRects[slot].intersect(area).isEmpty())
+					continue;
+
+				slots[count++] = slot;
+				if (count == maxSlots)
+					return count;
+			}
+		}
+	}
+
+	return count;
+}
+
+const Rect& ItemGrid::getSlotRect(int slot) const
+{
+	return m_slotRects[slot];
+}
+
+// Cells overlapped by rectangle, inclusive
+// NOTE: Parts outside bounds are clamped to edge cells
+bool ItemGrid::getCellRange(const Rect& rect, int& firstColumn, int& lastColumn, int& firstRow, int& lastRow) const
+{
+	if (rect.isEmpty())
+		return false;
+
+	auto clampColumn = [this](int x) { auto column = (x < m_bounds.left ? 0 : (x - m_bounds.left) / m_cellSize); return (column < m_cColumns ? column : m_cColumns - 1); };
+	auto clampRow = [this](int y) { auto row = (y < m_bounds.top ? 0 : (y - m_bounds.top) / m_cellSize); return (row < m_cRows ? row : m_cRows - 1); };
+
+	firstColumn = clampColumn(rect.left);
+	lastColumn = clampColumn(rect.right - 1);
+	firstRow = clampRow(rect.top);
+	lastRow = clampRow(rect.bottom - 1);
+	return true;
+}
+
+void ItemGrid::link(int slot)
+{
+	int firstColumn, lastColumn, firstRow, lastRow;
+	if (!getCellRange(m_slotRects[slot], firstColumn, lastColumn, firstRow, lastRow))
+		return;		// NOTE: Items without a rectangle, e.g. hidden ones, are never found
+
+	for (int row = firstRow; row <= lastRow; ++row)
+	{
+		for (int column = firstColumn; column <= lastColumn; ++column)
+			m_cells[row * m_cColumns + column].push_back(slot);
+	}
+}
+
+void ItemGrid::unlink(int slot)
+{
+	int firstColumn, lastColumn, firstRow, lastRow;
+	if (!getCellRange(m_slotRects[slot], firstColumn, lastColumn, firstRow, lastRow))
+		return;
+
+	for (int row = firstRow; row <= lastRow; ++row)
+	{
+		for (int column = firstColumn; column <= lastColumn; ++column)
+		{
+			// NOTE: Order of slots in a cell doesn't matter, so swap with last instead of shifting
+			auto& cell = m_cells[row * m_cColumns + column];
+			auto iterator = std::find(cell.begin(), cell.end(), slot);
+			if (iterator != cell.end())
+			{
+				*iterator = cell.back();
+				cell.pop_back();
+			}
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Geometry.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define ITEMGRID_CELLSIZE			128		// Pixels along each side of a cell, about one icon with its label
+#define ITEMGRID_MAXCELLSPERSIDE	256		// Cells grow beyond 'ITEMGRID_CELLSIZE' for larger bounds
+
+
+// Uniform grid over item rectangles of a list, for finding items near a point without looking at all of them
+// NOTE: Items are known by their index in the list, which moves whenever an item before them is
+//		 inserted or deleted. So cells hold stable slots instead, and only the index to slot table
+//		 is shifted then. Moving an item touches only cells it leaves and enters.
+class ItemGrid
+{
+public:
+	ItemGrid();
+
+	void Reset(const Rect& bounds);			// No items, and valid
+	void Invalidate();						// Drops all items, until next 'Reset()'
+	bool IsValid() const;
+
+	// Changes of items, by their index in the list
+	// NOTE: A change that doesn't fit items known, e.g. a bad index, invalidates grid
+	void Insert(int index, const Rect& rect);	// Items at or after index move one up
+	void Remove(int index);						// Items after index move one down
+	void Move(int index, const Rect& rect);
+
+	size_t getCount() const;
+	const Rect& getBounds() const;
+
+	// Slots of items overlapping area, each only once, up to 'maxSlots'
+	// NOTE: Doesn't allocate. Not safe to call from more than one thread at a time.
+	size_t Query(const Rect& area, int slots[], size_t maxSlots) const;
+	const Rect& getSlotRect(int slot) const;
+
+private:
+	bool getCellRange(const Rect& rect, int& firstColumn, int& lastColumn, int& firstRow, int& lastRow) const;
+	void link(int slot);		// Adds slot to cells its rectangle overlaps
+	void unlink(int slot);
+
+	Rect m_bounds;
+	int m_cellSize;
+	int m_cColumns;
+	int m_cRows;
+	bool m_bValid;
+	std::vector<std::vector<int>> m_cells;		// Slots overlapping each cell, row by row
+	std::vector<int> m_slotOfIndex;				// Slot of each item, by index in list
+	std::vector<Rect> m_slotRects;
+	std::vector<int> m_freeSlots;
+	mutable std::vector<uint32_t> m_slotQueryStamps;	// So items overlapping several cells are reported once
+	mutable uint32_t m_queryStamp;
+};
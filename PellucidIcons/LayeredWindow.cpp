@@ -0,0 +1,356 @@
+#include "LayeredWindow.h"
+
+#ifndef PW_RENDERFULLCONTENT
+#define PW_RENDERFULLCONTENT		0x00000002
+#endif
+
+extern HINSTANCE g_hInst;
+
+// Static variables
+ATOM LayeredWindow::s_atomOverlayClass = 0;
+
+
+LayeredWindow::LayeredWindow()
+	: m_hwnd(NULL),
+	m_hwndOverlay(NULL),
+	m_bSnapshotValid(false),
+	m_bApplying(false),
+	m_cPending(0)
+{
+}
+
+void LayeredWindow::setWindow(HWND hwnd)
+{
+	if (hwnd == m_hwnd)
+		return;
+
+	// NOTE: Overlay frees its snapshot as it is destroyed. It may already be gone, with its parent.
+	if (m_hwndOverlay && IsWindow(m_hwndOverlay))
+		DestroyWindow(m_hwndOverlay);
+	m_hwndOverlay = NULL;
+	m_bSnapshotValid = false;
+
+	m_hwnd = hwnd;
+	m_cPending.store(0, std::memory_order_relaxed);	// NOTE: Changes posted to previous window are dropped with it
+}
+
+HWND LayeredWindow::getWindow() const
+{
+	return m_hwnd;
+}
+
+void LayeredWindow::UnregisterOverlayClass()
+{
+	if (s_atomOverlayClass && UnregisterClass(MAKEINTATOM(s_atomOverlayClass), g_hInst))
+		s_atomOverlayClass = 0;
+}
+
+UINT LayeredWindow::getApplyMessage()
+{
+	static const UINT s_uApplyMessage = RegisterWindowMessage(L"PellucidIcons.LayeredWindow.Apply");
+
+	return s_uApplyMessage;
+}
+
+void LayeredWindow::OnApplyMessage(WPARAM wParam, LPARAM lParam)
+{
+	auto alpha = static_cast<uint8_t>(lParam);
+
+	// Window has changes of its own still to be painted, which below would be taken for ours
+	if (GetUpdateRect(m_hwnd, NULL, FALSE))
+		m_bSnapshotValid = false;
+
+	m_bApplying = true;
+	switch (wParam)
+	{
+		case operationSetLayered:
+			applyLayered(true, alpha);
+			break;
+
+		case operationSetUnlayered:
+			applyLayered(false, alpha);
+			break;
+
+		case operationSetAlpha:
+			SetLayeredWindowAttributes(m_hwnd, NULL, alpha, LWA_ALPHA);
+			break;
+
+		case operationShowSnapshot:
+			showSnapshot(alpha);
+			break;
+
+		case operationSetSnapshotAlpha:
+		{
+			// NOTE: If snapshot couldn't be shown, window itself fades instead
+			if (m_hwndOverlay && IsWindowVisible(m_hwndOverlay))
+				SetLayeredWindowAttributes(m_hwndOverlay, NULL, alpha, LWA_ALPHA);
+			else
+				applyLayered(true, alpha);
+		}
+		break;
+
+		case operationHideSnapshot:
+		{
+			// Window first, so there is no gap where neither is shown
+			applyLayered(alpha != OPACITY_OPAQUE, alpha);
+			if (m_hwndOverlay)
+				ShowWindow(m_hwndOverlay, SW_HIDE);
+		}
+		break;
+
+		default:
+			break;
+	}
+
+	// NOTE: Adding or removing layering makes window repaint, which is done now, so that it isn't
+	//		 taken for a change of window content later
+	UpdateWindow(m_hwnd);
+	m_bApplying = false;
+
+	// NOTE: Only now, so that 'WM_STYLECHANGED' sent by the change above doesn't read window back either
+	m_cPending.fetch_sub(1, std::memory_order_release);
+}
+
+bool LayeredWindow::IsApplying() const
+{
+	return m_bApplying;
+}
+
+void LayeredWindow::InvalidateSnapshot()
+{
+	m_bSnapshotValid = false;
+}
+
+bool LayeredWindow::IsLayered()
+{
+	return ((GetWindowLongPtr(m_hwnd, GWL_EXSTYLE) & WS_EX_LAYERED) != 0);
+}
+
+bool LayeredWindow::SetLayered(bool bLayered, uint8_t alpha)
+{
+	return post(bLayered ? operationSetLayered : operationSetUnlayered, alpha);
+}
+
+bool LayeredWindow::SetAlpha(uint8_t alpha)
+{
+	return post(operationSetAlpha, alpha);
+}
+
+bool LayeredWindow::GetAlpha(uint8_t& alpha)
+{
+	BYTE currentAlpha;
+	DWORD dwFlags;
+	if (GetLayeredWindowAttributes(m_hwnd, NULL, &currentAlpha, &dwFlags) == FALSE)
+		return false;
+
+	// NOTE: If alpha was never set, window is drawn fully opaque
+	alpha = ((dwFlags & LWA_ALPHA) ? currentAlpha : OPACITY_OPAQUE);
+	return true;
+}
+
+// NOTE: Redirection surface is 32 bits per pixel and covers whole window
+size_t LayeredWindow::getSurfaceBytes()
+{
+	RECT rectWindow;
+	if (GetWindowRect(m_hwnd, &rectWindow) == FALSE)
+		return 0;
+
+	return static_cast<size_t>(rectWindow.right - rectWindow.left) * static_cast<size_t>(rectWindow.bottom - rectWindow.top) * 4;
+}
+
+bool LayeredWindow::ShowSnapshot(uint8_t alpha)
+{
+	return post(operationShowSnapshot, alpha);
+}
+
+bool LayeredWindow::SetSnapshotAlpha(uint8_t alpha)
+{
+	return post(operationSetSnapshotAlpha, alpha);
+}
+
+bool LayeredWindow::HideSnapshot(uint8_t alpha)
+{
+	return post(operationHideSnapshot, alpha);
+}
+
+bool LayeredWindow::HasPendingChanges()
+{
+	return (m_cPending.load(std::memory_order_acquire) != 0);
+}
+
+bool LayeredWindow::post(Operation operation, uint8_t alpha)
+{
+	if (!m_hwnd)
+		return false;
+
+	m_cPending.fetch_add(1, std::memory_order_relaxed);
+	if (PostMessage(m_hwnd, getApplyMessage(), operation, alpha) == FALSE)
+	{
+		m_cPending.fetch_sub(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	return true;
+}
+
+// CAUTION: Following functions must be called from window's thread
+
+void LayeredWindow::applyLayered(bool bLayered, uint8_t alpha)
+{
+	auto currentExStyle = GetWindowLongPtr(m_hwnd, GWL_EXSTYLE);
+	if (bLayered)
+	{
+		if ((currentExStyle & WS_EX_LAYERED) == 0)
+			SetWindowLongPtr(m_hwnd, GWL_EXSTYLE, currentExStyle | WS_EX_LAYERED);
+
+		SetLayeredWindowAttributes(m_hwnd, NULL, alpha, LWA_ALPHA);
+	}
+	else if ((currentExStyle & WS_EX_LAYERED) != 0)
+	{
+		SetWindowLongPtr(m_hwnd, GWL_EXSTYLE, currentExStyle & ~WS_EX_LAYERED);
+
+		// IMPORTANT: Once layering is removed, window has to be repainted by itself again
+		RedrawWindow(m_hwnd, NULL, NULL, RDW_ERASE | RDW_INVALIDATE | RDW_FRAME | RDW_ALLCHILDREN);
+	}
+}
+
+// Shows snapshot of window on an overlay above window at given alpha and then nearly hides window itself
+// NOTE: Window is only nearly hidden, so that it still gets mouse messages through the overlay. Window is
+//		 only captured again if it changed since last fade, as that costs as much as a repaint of it.
+void LayeredWindow::showSnapshot(uint8_t alpha)
+{
+	if (!s_atomOverlayClass)
+		s_atomOverlayClass = registerOverlayClass();
+
+	auto hwndParent = GetParent(m_hwnd);
+	RECT rectWindow;
+	if (!s_atomOverlayClass || !hwndParent || GetWindowRect(m_hwnd, &rectWindow) == FALSE)
+		return;
+	MapWindowPoints(HWND_DESKTOP, hwndParent, reinterpret_cast<LPPOINT>(&rectWindow), 2);
+	auto width = rectWindow.right - rectWindow.left;
+	auto height = rectWindow.bottom - rectWindow.top;
+
+	if (!m_hwndOverlay)
+	{
+		m_hwndOverlay = CreateWindowEx(WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_NOACTIVATE, MAKEINTATOM(s_atomOverlayClass), L"",
+									   WS_CHILD, 0, 0, 0, 0, hwndParent, NULL, g_hInst, NULL);
+		if (!m_hwndOverlay)
+			return;
+	}
+
+	// NOTE: Overlay owns its snapshot bitmap, which is reused by next fade unless window size changes
+	auto hbitmapSnapshot = reinterpret_cast<HBITMAP>(GetWindowLongPtr(m_hwndOverlay, GWLP_USERDATA));
+	BITMAP bitmap;
+	if (!hbitmapSnapshot ||
+		GetObject(hbitmapSnapshot, sizeof(bitmap), &bitmap) == 0 ||
+		bitmap.bmWidth != width ||
+		bitmap.bmHeight != height)
+	{
+		if (hbitmapSnapshot)
+			DeleteObject(hbitmapSnapshot);
+		hbitmapSnapshot = createSnapshotBitmap(width, height);
+		SetWindowLongPtr(m_hwndOverlay, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(hbitmapSnapshot));
+		m_bSnapshotValid = false;
+	}
+
+	if (!hbitmapSnapshot)
+		return;
+	if (!m_bSnapshotValid)
+	{
+		if (!captureWindow(hbitmapSnapshot))
+			return;
+		m_bSnapshotValid = true;
+	}
+
+	SetLayeredWindowAttributes(m_hwndOverlay, NULL, alpha, LWA_ALPHA);
+	SetWindowPos(m_hwndOverlay, HWND_TOP, rectWindow.left, rectWindow.top, width, height, SWP_NOACTIVATE | SWP_SHOWWINDOW);
+	RedrawWindow(m_hwndOverlay, NULL, NULL, RDW_INVALIDATE | RDW_UPDATENOW);
+
+	applyLayered(true, OPACITY_HIDDEN);
+}
+
+bool LayeredWindow::captureWindow(HBITMAP hbitmap)
+{
+	auto hdcMemory = CreateCompatibleDC(NULL);
+	if (!hdcMemory)
+		return false;
+
+	// NOTE: Asks window to render everything as it is composited, also while it is layered
+	auto hbitmapOld = SelectObject(hdcMemory, hbitmap);
+	bool bCaptured = (PrintWindow(m_hwnd, hdcMemory, PW_RENDERFULLCONTENT) != FALSE);
+	SelectObject(hdcMemory, hbitmapOld);
+	DeleteDC(hdcMemory);
+
+	return bCaptured;
+}
+
+HBITMAP LayeredWindow::createSnapshotBitmap(int width, int height)
+{
+	if (width <= 0 || height <= 0)
+		return NULL;
+
+	BITMAPINFO bitmapInfo = { 0 };
+	bitmapInfo.bmiHeader.biSize = sizeof(bitmapInfo.bmiHeader);
+	bitmapInfo.bmiHeader.biWidth = width;
+	bitmapInfo.bmiHeader.biHeight = -height;	// Top-down
+	bitmapInfo.bmiHeader.biPlanes = 1;
+	bitmapInfo.bmiHeader.biBitCount = 32;
+	bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+	void *pBits;
+	return CreateDIBSection(NULL, &bitmapInfo, DIB_RGB_COLORS, &pBits, NULL, 0);
+}
+
+ATOM LayeredWindow::registerOverlayClass()
+{
+	WNDCLASSEX windowClass = { sizeof(windowClass) };
+	windowClass.lpfnWndProc = &Overlay_WndProc;
+	windowClass.hInstance = g_hInst;
+	windowClass.lpszClassName = L"PellucidIcons.SnapshotOverlay";
+
+	return RegisterClassEx(&windowClass);
+}
+
+LRESULT CALLBACK LayeredWindow::Overlay_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	switch (uMsg)
+	{
+		case WM_NCHITTEST:
+			return HTTRANSPARENT;	// Mouse goes through to window underneath
+
+		case WM_ERASEBKGND:
+			return 1;				// Snapshot covers everything
+
+		case WM_PAINT:
+		{
+			PAINTSTRUCT paintStruct;
+			auto hdc = BeginPaint(hwnd, &paintStruct);
+			auto hbitmapSnapshot = reinterpret_cast<HBITMAP>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+			auto hdcMemory = (hbitmapSnapshot ? CreateCompatibleDC(hdc) : NULL);
+			if (hdcMemory)
+			{
+				auto hbitmapOld = SelectObject(hdcMemory, hbitmapSnapshot);
+				BitBlt(hdc, paintStruct.rcPaint.left, paintStruct.rcPaint.top,
+					   paintStruct.rcPaint.right - paintStruct.rcPaint.left, paintStruct.rcPaint.bottom - paintStruct.rcPaint.top,
+					   hdcMemory, paintStruct.rcPaint.left, paintStruct.rcPaint.top, SRCCOPY);
+				SelectObject(hdcMemory, hbitmapOld);
+				DeleteDC(hdcMemory);
+			}
+			EndPaint(hwnd, &paintStruct);
+		}
+		return 0;
+
+		case WM_NCDESTROY:
+		{
+			auto hbitmapSnapshot = reinterpret_cast<HBITMAP>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+			if (hbitmapSnapshot)
+				DeleteObject(hbitmapSnapshot);
+		}
+		break;
+
+		default:
+			break;
+	}
+
+	return DefWindowProc(hwnd, uMsg, wParam, lParam);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "OpacityLayering.h"
+#include <Windows.h>
+#include <atomic>
+
+
+// Controls opacity of a window through 'WS_EX_LAYERED'
+// NOTE: Changing window style sends messages to window's thread, which may just then be waiting on
+//		 a lock held by our caller, e.g. that of 'FadeEngine'. So every change is posted to window
+//		 and applied by its own thread, in order, through 'OnApplyMessage()'.
+class LayeredWindow : public OpacityLayering::Surface
+{
+public:
+	LayeredWindow();
+
+	void setWindow(HWND hwnd);		// NOTE: Also destroys snapshot overlay of previous window, so call from its thread
+	HWND getWindow() const;
+
+	static void UnregisterOverlayClass();	// IMPORTANT: Call before DLL is unloaded, once no window is set
+
+	static UINT getApplyMessage();
+	void OnApplyMessage(WPARAM wParam, LPARAM lParam);	// IMPORTANT: Must be called from window procedure of window
+	bool IsApplying() const;		// True while a change is applied, so style changes and paints caused by us can be told apart
+	void InvalidateSnapshot();		// Window content changed, so next snapshot fade captures it again. NOTE: Call from window's thread
+
+	// OpacityLayering::Surface
+	virtual bool IsLayered();
+	virtual bool SetLayered(bool bLayered, uint8_t alpha);
+	virtual bool SetAlpha(uint8_t alpha);
+	virtual bool GetAlpha(uint8_t& alpha);
+	virtual size_t getSurfaceBytes();
+	virtual bool ShowSnapshot(uint8_t alpha);
+	virtual bool SetSnapshotAlpha(uint8_t alpha);
+	virtual bool HideSnapshot(uint8_t alpha);
+	virtual bool HasPendingChanges();
+
+private:
+	enum Operation
+	{
+		operationSetLayered,
+		operationSetUnlayered,
+		operationSetAlpha,
+		operationShowSnapshot,
+		operationSetSnapshotAlpha,
+		operationHideSnapshot
+	};
+
+	bool post(Operation operation, uint8_t alpha);
+	void applyLayered(bool bLayered, uint8_t alpha);
+	void showSnapshot(uint8_t alpha);
+	bool captureWindow(HBITMAP hbitmap);
+
+	static HBITMAP createSnapshotBitmap(int width, int height);
+
+	static ATOM registerOverlayClass();
+	static LRESULT CALLBACK Overlay_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+
+	static ATOM s_atomOverlayClass;	// NOTE: Registered when first needed, and again after being unregistered
+
+	HWND m_hwnd;
+	HWND m_hwndOverlay;				// Shows snapshot of window during snapshot fade, kept for next fade
+	bool m_bSnapshotValid;			// Snapshot of overlay still shows window as it is. NOTE: Only touched from window's thread
+	bool m_bApplying;				// NOTE: Same
+	std::atomic<uint32_t> m_cPending;	// Changes posted but not yet applied
+};
@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+
+
+MappedFile::MappedFile()
+	: m_hFile(INVALID_HANDLE_VALUE),
+	m_hMapping(NULL),
+	m_pData(NULL),
+	m_cbSize(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(LPCWSTR szPath, size_t cbSize)
+{
+	Close();
+
+	// NOTE: Others may read it while we write, e.g. to copy trace of a live session
+	m_hFile = CreateFile(szPath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	ULARGE_INTEGER size;
+	size.QuadPart = cbSize;
+	m_hMapping = CreateFileMapping(m_hFile, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, NULL);
+	m_pData = (m_hMapping ? MapViewOfFile(m_hMapping, FILE_MAP_WRITE, 0, 0, cbSize) : NULL);
+	if (!m_pData)
+	{
+		Close();
+		return false;
+	}
+
+	m_cbSize = cbSize;
+	return true;
+}
+
+bool MappedFile::OpenShared(LPCWSTR szName, size_t cbSize)
+{
+	Close();
+
+	// NOTE: New mapping is zero filled, an existing one keeps its contents
+	ULARGE_INTEGER size;
+	size.QuadPart = cbSize;
+	m_hMapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, szName);
+	m_pData = (m_hMapping ? MapViewOfFile(m_hMapping, FILE_MAP_WRITE, 0, 0, cbSize) : NULL);
+	if (!m_pData)
+	{
+		Close();
+		return false;
+	}
+
+	m_cbSize = cbSize;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData)
+		UnmapViewOfFile(m_pData), m_pData = NULL;
+
+	if (m_hMapping)
+		CloseHandle(m_hMapping), m_hMapping = NULL;
+
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile), m_hFile = INVALID_HANDLE_VALUE;
+
+	m_cbSize = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return (m_pData != NULL);
+}
+
+void *MappedFile::getData() const
+{
+	return m_pData;
+}
+
+size_t MappedFile::getSize() const
+{
+	return m_cbSize;
+}
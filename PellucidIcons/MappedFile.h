@@ -0,0 +1,27 @@
+#pragma once
+#include <Windows.h>
+
+
+// Read-write view of a whole file of fixed size
+// NOTE: File is created if missing and grown to size asked for. 'OpenShared()' instead maps
+//		 named memory backed by paging file, which lives as long as somebody has it open.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(LPCWSTR szPath, size_t cbSize);
+	bool OpenShared(LPCWSTR szName, size_t cbSize);
+	void Close();
+
+	bool IsOpen() const;
+	void *getData() const;
+	size_t getSize() const;
+
+private:
+	HANDLE m_hFile;
+	HANDLE m_hMapping;
+	void *m_pData;
+	size_t m_cbSize;
+};
@@ -0,0 +1,158 @@
+#include "MenuTemplate.h"
+#include <cstring>
+
+// Layout of 'MENUEX_TEMPLATE_ITEM'
+#define ITEM_TYPE_OFFSET		0
+#define ITEM_STATE_OFFSET		4
+#define ITEM_ID_OFFSET			8
+#define ITEM_RESINFO_OFFSET		12
+#define ITEM_TEXT_OFFSET		14
+
+#define RESINFO_POPUP			0x01
+#define RESINFO_LAST			0x80
+
+#define STATE_CHECKED			0x00000008	// Same as 'MFS_CHECKED'
+
+#define MAX_MENUDEPTH			8
+
+
+MenuTemplate::MenuTemplate()
+	: m_items(),
+	m_cItems(0),
+	m_cUpdates(0)
+{
+}
+
+bool MenuTemplate::Load(const void *pTemplate, size_t cbTemplate)
+{
+	m_data.clear();
+	m_cItems = 0;
+
+	// 'MENUEX_TEMPLATE_HEADER' is a version, offset to first item and help ID
+	if (!pTemplate || cbTemplate < 8)
+		return false;
+
+	m_data.assign(static_cast<const uint8_t *>(pTemplate), static_cast<const uint8_t *>(pTemplate) + cbTemplate);
+
+	uint16_t wVersion, wOffset;
+	memcpy(&wVersion, &m_data[0], sizeof(wVersion));
+	memcpy(&wOffset, &m_data[2], sizeof(wOffset));
+
+	size_t offset = 4 + wOffset;
+	if (wVersion != 1 || !parseItems(offset, 0))
+	{
+		m_data.clear();
+		m_cItems = 0;
+		return false;
+	}
+
+	return true;
+}
+
+bool MenuTemplate::IsLoaded() const
+{
+	return !m_data.empty();
+}
+
+const void *MenuTemplate::getData() const
+{
+	return m_data.data();
+}
+
+int MenuTemplate::setItem(uint32_t resourceId, uint32_t commandId, bool bChecked)
+{
+	for (size_t i = 0; i < m_cItems; ++i)
+	{
+		if (m_items[i].resourceId != resourceId)
+			continue;
+
+		int cUpdates = 0;
+		auto offset = m_items[i].offset;
+
+		if (readDword(offset + ITEM_ID_OFFSET) != commandId)
+		{
+			writeDword(offset + ITEM_ID_OFFSET, commandId);
+			++cUpdates;
+		}
+
+		auto state = readDword(offset + ITEM_STATE_OFFSET);
+		auto newState = (bChecked ? state | STATE_CHECKED : state & ~STATE_CHECKED);
+		if (state != newState)
+		{
+			writeDword(offset + ITEM_STATE_OFFSET, newState);
+			++cUpdates;
+		}
+
+		m_cUpdates += cUpdates;
+		return cUpdates;
+	}
+
+	return 0;	// No such item
+}
+
+uint64_t MenuTemplate::getUpdateCount() const
+{
+	return m_cUpdates;
+}
+
+// Indexes items from 'offset' until last item of this level
+// NOTE: Every item starts DWORD aligned, and a popup item is followed by a help ID and its own items
+bool MenuTemplate::parseItems(size_t& offset, int depth)
+{
+	if (depth > MAX_MENUDEPTH)
+		return false;
+
+	for (;;)
+	{
+		offset = (offset + 3) & ~static_cast<size_t>(3);
+		if (offset + ITEM_TEXT_OFFSET > m_data.size())
+			return false;
+
+		auto itemOffset = offset;
+		uint16_t bResInfo;
+		memcpy(&bResInfo, &m_data[offset + ITEM_RESINFO_OFFSET], sizeof(bResInfo));
+
+		// Skip null terminated UTF-16 text
+		offset += ITEM_TEXT_OFFSET;
+		for (;;)
+		{
+			if (offset + 2 > m_data.size())
+				return false;
+
+			bool bTerminator = (m_data[offset] == 0 && m_data[offset + 1] == 0);
+			offset += 2;
+			if (bTerminator)
+				break;
+		}
+
+		if (bResInfo & RESINFO_POPUP)
+		{
+			offset = ((offset + 3) & ~static_cast<size_t>(3)) + 4;	// Help ID
+			if (!parseItems(offset, depth + 1))
+				return false;
+		}
+		else
+		{
+			if (m_cItems == MENUTEMPLATE_MAXITEMS)
+				return false;
+
+			m_items[m_cItems].resourceId = readDword(itemOffset + ITEM_ID_OFFSET);
+			m_items[m_cItems++].offset = itemOffset;
+		}
+
+		if (bResInfo & RESINFO_LAST)
+			return true;
+	}
+}
+
+uint32_t MenuTemplate::readDword(size_t offset) const
+{
+	uint32_t value;
+	memcpy(&value, &m_data[offset], sizeof(value));
+	return value;
+}
+
+void MenuTemplate::writeDword(size_t offset, uint32_t value)
+{
+	memcpy(&m_data[offset], &value, sizeof(value));
+}
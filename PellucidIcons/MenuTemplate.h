@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define MENUTEMPLATE_MAXITEMS		32
+
+
+// Cached copy of an extended ('MENUEX') menu template which can be patched in place
+// NOTE: The template is parsed once to find where each item's command ID and state are stored.
+//		 After that, only fields which actually change are rewritten before a menu is created
+//		 from it, instead of rewriting every item of a freshly loaded menu.
+class MenuTemplate
+{
+public:
+	MenuTemplate();
+
+	bool Load(const void *pTemplate, size_t cbTemplate);	// Copies and indexes template
+	bool IsLoaded() const;
+	const void *getData() const;
+
+	// Gives item with resource ID 'resourceId' command ID 'commandId' and check state
+	// NOTE: Returns number of fields which had to be updated
+	int setItem(uint32_t resourceId, uint32_t commandId, bool bChecked);
+
+	uint64_t getUpdateCount() const;
+
+private:
+	struct Item
+	{
+		uint32_t resourceId;
+		size_t offset;			// Offset of item in template
+	};
+
+	bool parseItems(size_t& offset, int depth);
+	uint32_t readDword(size_t offset) const;
+	void writeDword(size_t offset, uint32_t value);
+
+	std::vector<uint8_t> m_data;
+	Item m_items[MENUTEMPLATE_MAXITEMS];
+	size_t m_cItems;
+	uint64_t m_cUpdates;
+};
@@ -0,0 +1,171 @@
+#include "Metrics.h"
+#include <cstring>
+
+
+// Static variables
+Metrics::Layout Metrics::s_localLayout;
+std::atomic<Metrics::Layout *> Metrics::s_pLayout(nullptr);
+
+
+bool Metrics::Attach(void *pMemory, size_t cbMemory)
+{
+	if (!pMemory || cbMemory < sizeof(Layout))
+		return false;
+
+	auto pLayout = static_cast<Layout *>(pMemory);
+	if (pLayout->magic != METRICS_MAGIC ||
+		pLayout->version != METRICS_VERSION ||
+		pLayout->cCounters != counterCount ||
+		pLayout->cHistograms != histogramCount ||
+		pLayout->cGauges != gaugeCount)
+	{
+		// NOTE: New or stale segment, so start over
+		memset(pMemory, 0, sizeof(Layout));
+		initialize(*pLayout);
+	}
+
+	s_pLayout.store(pLayout, std::memory_order_release);
+	return true;
+}
+
+void Metrics::Detach()
+{
+	s_pLayout.store(nullptr, std::memory_order_release);
+}
+
+void Metrics::Increment(Counter counter)
+{
+	auto pLayout = s_pLayout.load(std::memory_order_acquire);
+	if (!pLayout)
+		pLayout = &s_localLayout;
+
+	pLayout->counters[counter].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::Record(Histogram histogram, uint64_t nanosecs)
+{
+	auto pLayout = s_pLayout.load(std::memory_order_acquire);
+	if (!pLayout)
+		pLayout = &s_localLayout;
+
+	auto& data = pLayout->histograms[histogram];
+	data.count.fetch_add(1, std::memory_order_relaxed);
+	data.sum.fetch_add(nanosecs, std::memory_order_relaxed);
+	data.buckets[getBucketIndex(nanosecs)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::Set(Gauge gauge, uint64_t value)
+{
+	auto pLayout = s_pLayout.load(std::memory_order_acquire);
+	if (!pLayout)
+		pLayout = &s_localLayout;
+
+	pLayout->gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+// NOTE: Values are read one by one, so a snapshot of a live layout may be off by in-flight updates
+bool Metrics::TakeSnapshot(const void *pMemory, size_t cbMemory, Snapshot& snapshot)
+{
+	if (!pMemory || cbMemory < sizeof(Layout))
+		return false;
+
+	auto pLayout = static_cast<const Layout *>(pMemory);
+	if (pLayout->magic != METRICS_MAGIC ||
+		pLayout->version != METRICS_VERSION ||
+		pLayout->cCounters != counterCount ||
+		pLayout->cHistograms != histogramCount ||
+		pLayout->cGauges != gaugeCount)
+		return false;
+
+	for (int i = 0; i < counterCount; ++i)
+		snapshot.counters[i] = pLayout->counters[i].load(std::memory_order_relaxed);
+
+	for (int i = 0; i < histogramCount; ++i)
+	{
+		auto& data = pLayout->histograms[i];
+		snapshot.counts[i] = data.count.load(std::memory_order_relaxed);
+		snapshot.sums[i] = data.sum.load(std::memory_order_relaxed);
+		for (int j = 0; j < METRICS_HISTOGRAMBUCKETS; ++j)
+			snapshot.buckets[i][j] = data.buckets[j].load(std::memory_order_relaxed);
+	}
+
+	for (int i = 0; i < gaugeCount; ++i)
+		snapshot.gauges[i] = pLayout->gauges[i].load(std::memory_order_relaxed);
+
+	return true;
+}
+
+void Metrics::Diff(const Snapshot& before, const Snapshot& after, Snapshot& difference)
+{
+	for (int i = 0; i < counterCount; ++i)
+		difference.counters[i] = after.counters[i] - before.counters[i];
+
+	for (int i = 0; i < histogramCount; ++i)
+	{
+		difference.counts[i] = after.counts[i] - before.counts[i];
+		difference.sums[i] = after.sums[i] - before.sums[i];
+		for (int j = 0; j < METRICS_HISTOGRAMBUCKETS; ++j)
+			difference.buckets[i][j] = after.buckets[i][j] - before.buckets[i][j];
+	}
+
+	for (int i = 0; i < gaugeCount; ++i)
+		difference.gauges[i] = after.gauges[i];		// NOTE: Gauges aren't totals, so latest value is kept
+}
+
+// Returns lower bound of bucket where given percentile, from 0 to 100, falls
+uint64_t Metrics::getPercentile(const Snapshot& snapshot, Histogram histogram, double percentile)
+{
+	uint64_t total = 0;
+	for (int j = 0; j < METRICS_HISTOGRAMBUCKETS; ++j)
+		total += snapshot.buckets[histogram][j];
+	if (total == 0)
+		return 0;
+
+	auto rank = static_cast<uint64_t>(percentile / 100.0 * (total - 1));
+	uint64_t seen = 0;
+	for (int j = 0; j < METRICS_HISTOGRAMBUCKETS; ++j)
+	{
+		seen += snapshot.buckets[histogram][j];
+		if (seen > rank)
+			return getBucketLowerBound(j);
+	}
+
+	return getBucketLowerBound(METRICS_HISTOGRAMBUCKETS - 1);
+}
+
+// Values below '1 << METRICS_SUBBUCKETBITS' get a bucket each, above that each power of two is
+// split into '1 << METRICS_SUBBUCKETBITS' equal buckets
+size_t Metrics::getBucketIndex(uint64_t value)
+{
+	const uint64_t cSubBuckets = 1ull << METRICS_SUBBUCKETBITS;
+	if (value < cSubBuckets)
+		return static_cast<size_t>(value);
+
+	int exponent = 63;
+	while ((value >> exponent) == 0)
+		--exponent;
+
+	auto index = static_cast<size_t>((exponent - METRICS_SUBBUCKETBITS + 1) * cSubBuckets +
+									 ((value >> (exponent - METRICS_SUBBUCKETBITS)) & (cSubBuckets - 1)));
+	return (index < METRICS_HISTOGRAMBUCKETS ? index : METRICS_HISTOGRAMBUCKETS - 1);
+}
+
+uint64_t Metrics::getBucketLowerBound(size_t index)
+{
+	const uint64_t cSubBuckets = 1ull << METRICS_SUBBUCKETBITS;
+	if (index < cSubBuckets)
+		return index;
+
+	auto exponent = index / cSubBuckets + METRICS_SUBBUCKETBITS - 1;
+	auto subBucket = index % cSubBuckets;
+	return (1ull << exponent) + (subBucket << (exponent - METRICS_SUBBUCKETBITS));
+}
+
+void Metrics::initialize(Layout& layout)
+{
+	layout.magic = METRICS_MAGIC;
+	layout.version = METRICS_VERSION;
+	layout.cCounters = counterCount;
+	layout.cHistograms = histogramCount;
+	layout.cGauges = gaugeCount;
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#define METRICS_MAGIC				0x584D4950		// 'PIMX'
+#define METRICS_VERSION				1
+#define METRICS_SUBBUCKETBITS		2				// Four linear buckets per power of two
+#define METRICS_HISTOGRAMBUCKETS	128				// Up to about 4 seconds in nanoseconds
+#define METRICS_SHAREDMEMORYNAME	L"Local\\PellucidIconsMetrics"
+
+
+// Hot path counters and latency histograms
+// NOTE: Everything is updated with relaxed atomics and lives in one flat 'Metrics::Layout', so it
+//		 can be put in shared memory and read by another process while we run. Define
+//		 'PELLUCIDICONS_NO_METRICS' to compile all 'METRICS_*' macros out to nothing.
+class Metrics
+{
+public:
+	enum Counter
+	{
+		counterMouseMove,
+		counterMouseLeave,
+		counterDoubleClick,
+		counterRightButtonDown,
+		counterStyleChanged,
+		counterGeometryChanged,
+		counterOtherMessage,
+		counterAttachAttempt,
+		counterTimerWakeup,				// Idle, fade and attach timer callbacks
+		counterVisibilityChanged,
+		counterCount
+	};
+
+	enum Histogram
+	{
+		histogramWndProc,
+		histogramResetTimer,
+		histogramKillTimer,
+		histogramFadeStep,
+		histogramSettingsRead,
+		histogramSettingsWrite,
+		histogramAttach,
+		histogramCount
+	};
+
+	// Current values rather than running totals
+	enum Gauge
+	{
+		gaugeLayeredSurfaceBytes,
+		gaugeCount
+	};
+
+	// Log-linear histogram of nanoseconds
+	struct HistogramData
+	{
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> sum;
+		std::atomic<uint64_t> buckets[METRICS_HISTOGRAMBUCKETS];
+	};
+
+	// Versioned layout, as published
+	// NOTE: Only append to this, and bump 'METRICS_VERSION' if anything else changes
+	struct Layout
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t cCounters;
+		uint32_t cHistograms;
+		uint32_t cGauges;
+		uint32_t reserved;
+		std::atomic<uint64_t> counters[counterCount];
+		HistogramData histograms[histogramCount];
+		std::atomic<uint64_t> gauges[gaugeCount];
+	};
+
+	// Plain copy of a layout for reading and diffing
+	struct Snapshot
+	{
+		uint64_t counters[counterCount];
+		uint64_t counts[histogramCount];
+		uint64_t sums[histogramCount];
+		uint64_t buckets[histogramCount][METRICS_HISTOGRAMBUCKETS];
+		uint64_t gauges[gaugeCount];
+	};
+
+	// Moves metrics into given memory, e.g. shared memory, which must be zero or a valid layout
+	static bool Attach(void *pMemory, size_t cbMemory);
+	static void Detach();							// Back to process local memory
+
+	static void Increment(Counter counter);
+	static void Record(Histogram histogram, uint64_t nanosecs);
+	static void Set(Gauge gauge, uint64_t value);
+
+	static bool TakeSnapshot(const void *pMemory, size_t cbMemory, Snapshot& snapshot);
+	static void Diff(const Snapshot& before, const Snapshot& after, Snapshot& difference);
+	static uint64_t getPercentile(const Snapshot& snapshot, Histogram histogram, double percentile);
+
+	static size_t getBucketIndex(uint64_t value);
+	static uint64_t getBucketLowerBound(size_t index);
+
+private:
+	static void initialize(Layout& layout);
+
+	static Layout s_localLayout;
+	static std::atomic<Layout *> s_pLayout;
+};
+
+// Records time spent in scope
+class MetricsScope
+{
+public:
+	explicit MetricsScope(Metrics::Histogram histogram)
+		: m_histogram(histogram),
+		m_start(std::chrono::steady_clock::now()) {}
+
+	~MetricsScope()
+	{
+		auto elapsed = std::chrono::steady_clock::now() - m_start;
+		Metrics::Record(m_histogram, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+	}
+
+private:
+	Metrics::Histogram m_histogram;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+#ifndef PELLUCIDICONS_NO_METRICS
+#define METRICS_INCREMENT(counter)		Metrics::Increment(Metrics::counter)
+#define METRICS_SCOPE(histogram)		MetricsScope metricsScope_##histogram(Metrics::histogram)
+#define METRICS_RECORD(histogram, nanosecs)	Metrics::Record(Metrics::histogram, nanosecs)
+#define METRICS_SET(gauge, value)		Metrics::Set(Metrics::gauge, value)
+#else
+#define METRICS_INCREMENT(counter)		((void)0)
+#define METRICS_SCOPE(histogram)		((void)0)
+#define METRICS_RECORD(histogram, nanosecs)	((void)0)
+#define METRICS_SET(gauge, value)		((void)0)
+#endif
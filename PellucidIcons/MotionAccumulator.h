@@ -0,0 +1,69 @@
+#pragma once
+#include "ring_buffer.h"
+#include <cstdlib>
+
+
+// Sliding window of the last 'Depth' pointer positions which keeps the Manhattan distance
+// travelled along each axis as running sums
+// NOTE: Each 'push()' adds the newest delta and subtracts the one falling out of the window,
+//		 so the cost per event is constant regardless of history depth.
+template<size_t Depth>
+class MotionAccumulator
+{
+	static_assert(Depth >= 2, "MotionAccumulator needs at least two positions to measure motion");
+
+public:
+	struct Position
+	{
+		int x;
+		int y;
+	};
+
+	MotionAccumulator()
+		: m_last(),
+		m_bHasLast(false),
+		m_distanceX(0),
+		m_distanceY(0) {}
+
+	void push(int x, int y)
+	{
+		if (m_bHasLast)
+		{
+			if (m_deltas.full())
+			{
+				m_distanceX -= m_deltas.front().x;
+				m_distanceY -= m_deltas.front().y;
+			}
+
+			Position delta = { abs(x - m_last.x), abs(y - m_last.y) };
+			m_deltas.push(delta);
+			m_distanceX += delta.x;
+			m_distanceY += delta.y;
+		}
+
+		m_last.x = x;
+		m_last.y = y;
+		m_bHasLast = true;
+	}
+
+	void clear()
+	{
+		m_deltas.clear();
+		m_bHasLast = false;
+		m_distanceX = 0;
+		m_distanceY = 0;
+	}
+
+	bool empty() const { return !m_bHasLast; }
+	size_t size() const { return (m_bHasLast ? m_deltas.size() + 1 : 0); }	// Number of positions in window
+	const Position& last() const { return m_last; }		// CAUTION: Only valid if not 'empty()'
+	int getDistanceX() const { return m_distanceX; }
+	int getDistanceY() const { return m_distanceY; }
+
+private:
+	ring_buffer<Position, Depth - 1> m_deltas;	// Absolute deltas between consecutive positions
+	Position m_last;
+	bool m_bHasLast;
+	int m_distanceX;
+	int m_distanceY;
+};
@@ -0,0 +1,229 @@
+#include "MouseTrace.h"
+#include <cstring>
+
+
+// Varint of 7 bits per byte, low bits first
+static size_t encodeVarint(uint32_t value, uint8_t *pBytes)
+{
+	size_t cBytes = 0;
+	while (value >= 0x80)
+	{
+		pBytes[cBytes++] = static_cast<uint8_t>(value | 0x80);
+		value >>= 7;
+	}
+	pBytes[cBytes++] = static_cast<uint8_t>(value);
+
+	return cBytes;
+}
+
+static bool decodeVarint(const uint8_t *pRing, uint64_t capacity, uint64_t& offset, uint64_t end, uint32_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		if (offset >= end)
+			return false;
+
+		auto byte = pRing[offset++ % capacity];
+		value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+
+	return false;	// Corrupt
+}
+
+// Maps small negative and positive numbers to small unsigned ones
+static uint32_t zigzagEncode(int value)
+{
+	return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+static int zigzagDecode(uint32_t value)
+{
+	return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+}
+
+
+#pragma region MouseTraceWriter
+MouseTraceWriter::MouseTraceWriter()
+	: m_pHeader(nullptr),
+	m_pRing(nullptr)
+{
+}
+
+bool MouseTraceWriter::Attach(void *pMemory, size_t cbMemory)
+{
+	if (!pMemory || cbMemory < sizeof(MouseTraceHeader) + MOUSETRACE_MAXRECORDBYTES)
+		return false;
+
+	m_pHeader = static_cast<MouseTraceHeader *>(pMemory);
+	m_pRing = static_cast<uint8_t *>(pMemory) + sizeof(MouseTraceHeader);
+
+	uint64_t capacity = cbMemory - sizeof(MouseTraceHeader);
+	if (m_pHeader->magic != MOUSETRACE_MAGIC ||
+		m_pHeader->version != MOUSETRACE_VERSION ||
+		m_pHeader->capacity != capacity ||
+		m_pHeader->tail > m_pHeader->head ||
+		m_pHeader->head - m_pHeader->tail > capacity)
+	{
+		// Start a new trace
+		memset(m_pHeader, 0, sizeof(MouseTraceHeader));
+		m_pHeader->magic = MOUSETRACE_MAGIC;
+		m_pHeader->version = MOUSETRACE_VERSION;
+		m_pHeader->capacity = capacity;
+	}
+
+	return true;
+}
+
+void MouseTraceWriter::Detach()
+{
+	m_pHeader = nullptr;
+	m_pRing = nullptr;
+}
+
+bool MouseTraceWriter::IsAttached() const
+{
+	return (m_pHeader != nullptr);
+}
+
+void MouseTraceWriter::Append(uint64_t time, uint32_t message, int x, int y)
+{
+	if (!m_pHeader)
+		return;
+
+	if (m_pHeader->cRecords == 0)
+		m_pHeader->tailTime = m_pHeader->headTime = time;
+
+	// NOTE: Clock may not go backwards, but don't let a bad time stamp break the trace
+	auto timeDelta = (time > m_pHeader->headTime ? time - m_pHeader->headTime : 0);
+	if (timeDelta > UINT32_MAX)
+		timeDelta = UINT32_MAX;
+
+	uint8_t bytes[MOUSETRACE_MAXRECORDBYTES];
+	auto cBytes = MouseTraceReader::EncodeRecord(timeDelta, message, x, y, bytes);
+
+	while (m_pHeader->head + cBytes - m_pHeader->tail > m_pHeader->capacity)
+		dropOldest();
+
+	write(bytes, cBytes);
+	m_pHeader->headTime += timeDelta;
+	++m_pHeader->cRecords;
+}
+
+uint64_t MouseTraceWriter::getRecordCount() const
+{
+	return (m_pHeader ? m_pHeader->cRecords : 0);
+}
+
+void MouseTraceWriter::write(const uint8_t *pBytes, size_t cBytes)
+{
+	auto capacity = m_pHeader->capacity;
+	auto position = m_pHeader->head % capacity;
+
+	// Record may wrap around end of ring
+	auto cFirst = (cBytes < capacity - position ? cBytes : static_cast<size_t>(capacity - position));
+	memcpy(m_pRing + position, pBytes, cFirst);
+	memcpy(m_pRing, pBytes + cFirst, cBytes - cFirst);
+
+	m_pHeader->head += cBytes;
+}
+
+void MouseTraceWriter::dropOldest()
+{
+	uint64_t timeDelta;
+	MouseTraceRecord record;
+	if (!MouseTraceReader::DecodeRecord(m_pRing, m_pHeader->capacity, m_pHeader->tail, m_pHeader->head, timeDelta, record))
+	{
+		// Corrupt, start over
+		m_pHeader->tail = m_pHeader->head;
+		m_pHeader->cRecords = 0;
+		return;
+	}
+
+	// NOTE: Time delta of a record is from the one before, so new oldest record's time is known
+	//		 only after decoding it. Peek it without consuming.
+	auto offset = m_pHeader->tail;
+	if (MouseTraceReader::DecodeRecord(m_pRing, m_pHeader->capacity, offset, m_pHeader->head, timeDelta, record))
+		m_pHeader->tailTime += timeDelta;
+
+	--m_pHeader->cRecords;
+}
+#pragma endregion
+
+#pragma region MouseTraceReader
+MouseTraceReader::MouseTraceReader(const void *pMemory, size_t cbMemory)
+	: m_pHeader(nullptr),
+	m_pRing(nullptr),
+	m_offset(0),
+	m_time(0)
+{
+	if (!pMemory || cbMemory < sizeof(MouseTraceHeader))
+		return;
+
+	auto pHeader = static_cast<const MouseTraceHeader *>(pMemory);
+	if (pHeader->magic != MOUSETRACE_MAGIC ||
+		pHeader->version != MOUSETRACE_VERSION ||
+		pHeader->capacity != cbMemory - sizeof(MouseTraceHeader) ||
+		pHeader->tail > pHeader->head)
+		return;
+
+	m_pHeader = pHeader;
+	m_pRing = static_cast<const uint8_t *>(pMemory) + sizeof(MouseTraceHeader);
+	m_offset = pHeader->tail;
+	m_time = pHeader->tailTime;
+}
+
+bool MouseTraceReader::IsValid() const
+{
+	return (m_pHeader != nullptr);
+}
+
+bool MouseTraceReader::Next(MouseTraceRecord& record)
+{
+	if (!m_pHeader || m_offset >= m_pHeader->head)
+		return false;
+
+	// NOTE: Oldest record's delta is from a dropped record, its time is in header instead
+	bool bOldest = (m_offset == m_pHeader->tail);
+
+	uint64_t timeDelta;
+	if (!DecodeRecord(m_pRing, m_pHeader->capacity, m_offset, m_pHeader->head, timeDelta, record))
+		return false;
+
+	if (!bOldest)
+		m_time += timeDelta;
+	record.time = m_time;
+
+	return true;
+}
+
+size_t MouseTraceReader::EncodeRecord(uint64_t timeDelta, uint32_t message, int x, int y, uint8_t bytes[MOUSETRACE_MAXRECORDBYTES])
+{
+	size_t cBytes = 0;
+	cBytes += encodeVarint(static_cast<uint32_t>(timeDelta), bytes + cBytes);
+	cBytes += encodeVarint(message, bytes + cBytes);
+	cBytes += encodeVarint(zigzagEncode(x), bytes + cBytes);
+	cBytes += encodeVarint(zigzagEncode(y), bytes + cBytes);
+
+	return cBytes;
+}
+
+bool MouseTraceReader::DecodeRecord(const uint8_t *pRing, uint64_t capacity, uint64_t& offset, uint64_t end, uint64_t& timeDelta, MouseTraceRecord& record)
+{
+	uint32_t delta, x, y;
+	if (!decodeVarint(pRing, capacity, offset, end, delta) ||
+		!decodeVarint(pRing, capacity, offset, end, record.message) ||
+		!decodeVarint(pRing, capacity, offset, end, x) ||
+		!decodeVarint(pRing, capacity, offset, end, y))
+		return false;
+
+	timeDelta = delta;
+	record.time = 0;
+	record.x = zigzagDecode(x);
+	record.y = zigzagDecode(y);
+
+	return true;
+}
+#pragma endregion
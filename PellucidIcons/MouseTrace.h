@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#define MOUSETRACE_MAGIC			0x52544950		// 'PITR'
+#define MOUSETRACE_VERSION			1
+#define MOUSETRACE_MAXRECORDBYTES	(4 * 5)			// Four varints of up to 32 bits each
+
+
+// One window message as recorded
+struct MouseTraceRecord
+{
+	uint64_t time;			// Milliseconds, as given to 'MouseTraceWriter::Append()'
+	uint32_t message;
+	int x;
+	int y;
+};
+
+// Layout at start of trace memory, followed by ring of records
+// NOTE: Offsets are absolute byte counts since trace was reset, position in ring is offset
+//		 modulo capacity. 'tail' is always at start of a record, so a reader can decode from
+//		 there even after ring has wrapped.
+struct MouseTraceHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t capacity;		// Bytes of ring
+	uint64_t head;			// Offset where next record goes
+	uint64_t tail;			// Offset of oldest record
+	uint64_t tailTime;		// Time of oldest record
+	uint64_t headTime;		// Time of newest record
+	uint64_t cRecords;		// Records in ring
+};
+
+// Appends records to a ring in caller provided memory, usually a mapped file
+// NOTE: Each record is time delta from previous record, message, x and y, all as varints
+//		 with coordinates zigzag encoded. Mouse moves are mostly 3 to 6 bytes this way.
+//		 Oldest records are dropped as ring fills up.
+class MouseTraceWriter
+{
+public:
+	MouseTraceWriter();
+
+	// Continues trace already in memory if it is valid, else starts a new one
+	bool Attach(void *pMemory, size_t cbMemory);
+	void Detach();
+	bool IsAttached() const;
+
+	void Append(uint64_t time, uint32_t message, int x, int y);
+
+	uint64_t getRecordCount() const;
+
+private:
+	void write(const uint8_t *pBytes, size_t cBytes);
+	void dropOldest();
+
+	MouseTraceHeader *m_pHeader;
+	uint8_t *m_pRing;
+};
+
+// Reads records out of trace memory from oldest to newest
+class MouseTraceReader
+{
+public:
+	MouseTraceReader(const void *pMemory, size_t cbMemory);
+
+	bool IsValid() const;
+	bool Next(MouseTraceRecord& record);
+
+	// Varint helpers, also used by 'MouseTraceWriter'
+	static size_t EncodeRecord(uint64_t timeDelta, uint32_t message, int x, int y, uint8_t bytes[MOUSETRACE_MAXRECORDBYTES]);
+	static bool DecodeRecord(const uint8_t *pRing, uint64_t capacity, uint64_t& offset, uint64_t end, uint64_t& timeDelta, MouseTraceRecord& record);
+
+private:
+	const MouseTraceHeader *m_pHeader;
+	const uint8_t *m_pRing;
+	uint64_t m_offset;
+	uint64_t m_time;
+};
@@ -0,0 +1,163 @@
+#include "OpacityLayering.h"
+#include "Metrics.h"
+
+
+OpacityLayering::OpacityLayering(Surface& surface)
+	: m_surface(surface),
+	m_bSnapshotFade(false),
+	m_state(State::unlayered),
+	m_opacity(OPACITY_OPAQUE),
+	m_cLayers(0),
+	m_cUnlayers(0),
+	m_cbSurface(0)
+{
+}
+
+void OpacityLayering::setSnapshotFade(bool bSnapshotFade)
+{
+	m_bSnapshotFade.store(bSnapshotFade, std::memory_order_relaxed);
+}
+
+OpacityLayering::State OpacityLayering::getState() const
+{
+	return m_state.load(std::memory_order_relaxed);
+}
+
+uint64_t OpacityLayering::getLayerCount() const
+{
+	return m_cLayers.load(std::memory_order_relaxed);
+}
+
+uint64_t OpacityLayering::getUnlayerCount() const
+{
+	return m_cUnlayers.load(std::memory_order_relaxed);
+}
+
+size_t OpacityLayering::getSurfaceBytes() const
+{
+	return m_cbSurface.load(std::memory_order_relaxed);
+}
+
+bool OpacityLayering::SetOpacity(uint8_t opacity)
+{
+	bool bResult;
+	switch (m_state.load(std::memory_order_relaxed))
+	{
+		case State::overlaid:
+			bResult = m_surface.SetSnapshotAlpha(opacity);
+			break;
+
+		case State::layered:
+		{
+			if (opacity != OPACITY_OPAQUE)
+			{
+				bResult = m_surface.SetAlpha(opacity);
+				break;
+			}
+
+			// Fully opaque needs no layering at all
+			bResult = m_surface.SetLayered(false, opacity);
+			if (bResult)
+			{
+				m_cUnlayers.fetch_add(1, std::memory_order_relaxed);
+				setState(State::unlayered);
+			}
+		}
+		break;
+
+		default:
+		{
+			if (opacity == OPACITY_OPAQUE)
+			{
+				bResult = true;
+				break;
+			}
+
+			bResult = m_surface.SetLayered(true, opacity);
+			if (bResult)
+			{
+				m_cLayers.fetch_add(1, std::memory_order_relaxed);
+				setState(State::layered);
+			}
+		}
+		break;
+	}
+
+	if (bResult)
+		m_opacity.store(opacity, std::memory_order_relaxed);
+	return bResult;
+}
+
+// NOTE: Reads window itself, so also picks up layering added or removed by someone else
+bool OpacityLayering::GetOpacity(uint8_t& opacity)
+{
+	// IMPORTANT: While our own changes are still on their way to window, it shows an older state,
+	//			  which must not roll back what we have set since
+	if (m_state.load(std::memory_order_relaxed) == State::overlaid ||	// Window itself is nearly hidden on purpose
+		m_surface.HasPendingChanges())
+	{
+		opacity = m_opacity.load(std::memory_order_relaxed);
+		return true;
+	}
+
+	if (!m_surface.IsLayered())
+	{
+		setState(State::unlayered);
+		opacity = OPACITY_OPAQUE;
+	}
+	else
+	{
+		setState(State::layered);
+		if (!m_surface.GetAlpha(opacity))
+			return false;
+	}
+
+	m_opacity.store(opacity, std::memory_order_relaxed);
+	return true;
+}
+
+void OpacityLayering::BeginFade(uint8_t opacity)
+{
+	auto state = m_state.load(std::memory_order_relaxed);
+	if (!m_bSnapshotFade.load(std::memory_order_relaxed) || state == State::overlaid)
+		return;
+
+	// NOTE: If snapshot can't be shown, fade just goes on with window itself
+	if (!m_surface.ShowSnapshot(opacity))
+		return;
+
+	if (state == State::unlayered)
+		m_cLayers.fetch_add(1, std::memory_order_relaxed);
+	m_opacity.store(opacity, std::memory_order_relaxed);
+	setState(State::overlaid);
+}
+
+void OpacityLayering::EndFade(uint8_t opacity)
+{
+	if (m_state.load(std::memory_order_relaxed) != State::overlaid)
+		return;
+
+	if (!m_surface.HideSnapshot(opacity))
+		return;
+
+	if (opacity == OPACITY_OPAQUE)
+		m_cUnlayers.fetch_add(1, std::memory_order_relaxed);
+	m_opacity.store(opacity, std::memory_order_relaxed);
+	setState(opacity == OPACITY_OPAQUE ? State::unlayered : State::layered);
+}
+
+void OpacityLayering::setState(State state)
+{
+	if (m_state.exchange(state, std::memory_order_relaxed) == state)
+		return;
+
+	// NOTE: While overlaid, there is snapshot bitmap and redirection surface of its window too
+	size_t cbSurface = 0;
+	if (state == State::layered)
+		cbSurface = m_surface.getSurfaceBytes();
+	else if (state == State::overlaid)
+		cbSurface = m_surface.getSurfaceBytes() * 3;
+
+	m_cbSurface.store(cbSurface, std::memory_order_relaxed);
+	METRICS_SET(gaugeLayeredSurfaceBytes, cbSurface);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "FadeEngine.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+// Keeps a window layered only while it is not fully opaque
+// NOTE: A layered window is composited through an extra redirection surface as big as the
+//		 window, even at full opacity. So layering is added when opacity first drops below
+//		 'OPACITY_OPAQUE' and removed again once it is back there.
+//
+//		 With snapshot fade, a fade instead shows a captured copy of the window on top of it and
+//		 only changes opacity of that copy. Window itself is only touched at start and end, so
+//		 windows that are slow to repaint, e.g. a desktop with thousands of icons, fade smoothly.
+class OpacityLayering : public FadeEngine::Backend
+{
+public:
+	// Platform window that can be layered
+	class Surface
+	{
+	public:
+		virtual ~Surface() {}
+
+		virtual bool IsLayered() = 0;
+		virtual bool SetLayered(bool bLayered, uint8_t alpha) = 0;	// NOTE: Alpha is ignored when removing layering
+		virtual bool SetAlpha(uint8_t alpha) = 0;		// CAUTION: Only while layered
+		virtual bool GetAlpha(uint8_t& alpha) = 0;
+		virtual size_t getSurfaceBytes() = 0;			// Estimated size of redirection surface, if layered
+
+		// Snapshot fade
+		virtual bool ShowSnapshot(uint8_t alpha) = 0;	// Shows copy of window at given alpha and nearly hides window
+		virtual bool SetSnapshotAlpha(uint8_t alpha) = 0;
+		virtual bool HideSnapshot(uint8_t alpha) = 0;	// Shows window itself at given alpha again
+
+		// True while changes made above are yet to be applied to window, so it can't be read back
+		virtual bool HasPendingChanges() = 0;
+	};
+
+	enum class State
+	{
+		unlayered,
+		layered,
+		overlaid		// Snapshot shown, window itself layered and nearly hidden
+	};
+
+	explicit OpacityLayering(Surface& surface);
+
+	void setSnapshotFade(bool bSnapshotFade);	// NOTE: Takes effect from next fade
+
+	State getState() const;
+	uint64_t getLayerCount() const;				// Number of times layering was added
+	uint64_t getUnlayerCount() const;
+	size_t getSurfaceBytes() const;				// Of current layering, zero if unlayered
+
+	// FadeEngine::Backend
+	virtual bool SetOpacity(uint8_t opacity);
+	virtual bool GetOpacity(uint8_t& opacity);
+	virtual void BeginFade(uint8_t opacity);
+	virtual void EndFade(uint8_t opacity);
+
+private:
+	void setState(State state);
+
+	Surface& m_surface;
+	std::atomic<bool> m_bSnapshotFade;
+	std::atomic<State> m_state;
+	std::atomic<uint8_t> m_opacity;				// Last opacity set, of snapshot while overlaid
+	std::atomic<uint64_t> m_cLayers;
+	std::atomic<uint64_t> m_cUnlayers;
+	std::atomic<size_t> m_cbSurface;
+};
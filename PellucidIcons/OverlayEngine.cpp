@@ -0,0 +1,518 @@
+#include "OverlayEngine.h"
+#include "AllocationTracker.h"
+#include "Metrics.h"
+#include <cstring>
+
+#define DEFAULT_INTERVALMILLISECS		5000
+
+static_assert(SETTINGS_MAXHOTZONES <= HOTZONEINDEX_MAXZONES, "Hot zone index can't hold all hot zones from settings");
+
+
+OverlayEngine::OverlayEngine(Platform& platform, Clock& clock, TimerBackend& idleTimer, TimerBackend& frameTimer)
+	: m_platform(platform),
+	m_clock(clock),
+	m_idleTimer(idleTimer),
+	m_fadeEngine(clock, frameTimer),
+	m_interval(DEFAULT_INTERVALMILLISECS),
+	m_bSuspended(false),
+	m_bResumeIdleTimer(false),
+	m_hysteresisPixels(0),
+	m_dwellMillisecs(0),
+	m_packedHotZones(),
+	m_cPackedHotZones(0),
+	m_bMouseInTriggerZone(false),
+	m_pRevealBackend(NULL),
+	m_bRevealing(false)
+{
+}
+
+void OverlayEngine::setOpacityBackend(FadeEngine::Backend *pBackend)
+{
+	m_fadeEngine.setBackend(pBackend);	// Picks up current opacity
+}
+
+void OverlayEngine::setRevealBackend(HoverReveal::Backend *pBackend)
+{
+	m_hoverReveal.Reset();
+	m_bRevealing = false;
+	m_pRevealBackend = pBackend;
+}
+
+void OverlayEngine::setTuning(int hysteresisPixels, uint32_t dwellMillisecs, uint32_t activityQuantumMillisecs)
+{
+	m_dwellMillisecs = dwellMillisecs;
+	m_activityCoalescer.setQuantum(activityQuantumMillisecs);
+
+	if (hysteresisPixels != m_hysteresisPixels)
+	{
+		m_hysteresisPixels = hysteresisPixels;
+		rebuildHotZones();		// Hot zone index is built with hysteresis band
+	}
+}
+
+// NOTE: Index is only rebuilt if zones are different from last time
+void OverlayEngine::setHotZones(const uint32_t packedZones[], size_t count)
+{
+	if (count > SETTINGS_MAXHOTZONES)
+		count = SETTINGS_MAXHOTZONES;
+
+	if (count == m_cPackedHotZones && memcmp(packedZones, m_packedHotZones, count * sizeof(packedZones[0])) == 0)
+		return;
+
+	memcpy(m_packedHotZones, packedZones, count * sizeof(packedZones[0]));
+	m_cPackedHotZones = count;
+	rebuildHotZones();
+}
+
+void OverlayEngine::UpdateGeometry()
+{
+	Rect monitors[TRIGGERGEOMETRY_MAXMONITORS];
+	auto cMonitors = m_platform.getMonitorBounds(monitors, TRIGGERGEOMETRY_MAXMONITORS);
+	m_triggerGeometry.Update(monitors, cMonitors);	// NOTE: Only zones of monitors which changed are recomputed
+
+	rebuildHotZones();
+}
+
+// Zones are fractions of window's client area, which spans all monitors
+void OverlayEngine::rebuildHotZones()
+{
+	Rect bounds;
+	if (!m_platform.getClientBounds(bounds))
+	{
+		m_hotZoneIndex.Clear();
+		return;
+	}
+
+	int64_t width = bounds.right - bounds.left;
+	int64_t height = bounds.bottom - bounds.top;
+
+	Rect zones[SETTINGS_MAXHOTZONES];
+	for (size_t i = 0; i < m_cPackedHotZones; ++i)
+	{
+		auto packedZone = m_packedHotZones[i];
+		zones[i].left = bounds.left + static_cast<int>(width * (packedZone & 0xFF) / 0xFF);
+		zones[i].top = bounds.top + static_cast<int>(height * ((packedZone >> 8) & 0xFF) / 0xFF);
+		zones[i].right = bounds.left + static_cast<int>(width * ((packedZone >> 16) & 0xFF) / 0xFF);
+		zones[i].bottom = bounds.top + static_cast<int>(height * ((packedZone >> 24) & 0xFF) / 0xFF);
+	}
+
+	m_hotZoneIndex.Build(bounds, zones, m_cPackedHotZones, m_hysteresisPixels);
+}
+
+void OverlayEngine::Start(uint32_t intervalMillisecs)
+{
+	std::lock_guard<std::mutex> lock(m_mutexSuspend);
+	start(intervalMillisecs);
+}
+
+// CAUTION: Must be called with 'm_mutexSuspend' held
+void OverlayEngine::start(uint32_t intervalMillisecs)
+{
+	// Reset window opacity
+	m_fadeEngine.Restore();
+
+	m_interval.store(intervalMillisecs, std::memory_order_relaxed);
+	if (m_bSuspended.load(std::memory_order_relaxed))
+	{
+		m_bResumeIdleTimer = true;	// NOTE: Armed on resume
+		return;
+	}
+
+	m_idleTimer.Start(m_clock.Now(), intervalMillisecs);
+}
+
+void OverlayEngine::Stop()
+{
+	METRICS_SCOPE(histogramKillTimer);
+	std::lock_guard<std::mutex> lock(m_mutexSuspend);
+
+	m_bResumeIdleTimer = false;
+	m_idleTimer.Stop();
+
+	// Reset window opacity
+	m_fadeEngine.Restore();
+}
+
+void OverlayEngine::ResetTimer()
+{
+	METRICS_SCOPE(histogramResetTimer);
+
+	// NOTE: This is called for user activity, so we only push out the idle deadline here.
+	//		 The platform timer is not touched unless it had already elapsed.
+	if (m_bSuspended.load(std::memory_order_relaxed))
+		return;		// Desktop can't be seen, so this isn't user activity on it
+
+	if (!m_idleTimer.IsRunning())
+	{
+		Start(m_interval.load(std::memory_order_relaxed));	// NOTE: Rare, so taking lock is fine
+		return;
+	}
+
+	// Restore window opacity, reversing any fade in progress
+	m_fadeEngine.FadeIn();
+
+	m_idleTimer.Bump(m_clock.Now());
+
+	// IMPORTANT: Desktop may have been hidden just now, after the check above. Then fade in may
+	//			  have armed frame timer, or bump the idle timer, after 'Suspend()' finished them.
+	//			  As that is rare, we re-check here instead of locking for every input event.
+	if (m_bSuspended.load())
+		undoActivity();
+}
+
+void OverlayEngine::Suspend()
+{
+	std::lock_guard<std::mutex> lock(m_mutexSuspend);
+
+	// NOTE: Sequentially consistent, to pair with re-check in 'ResetTimer()'
+	if (m_bSuspended.exchange(true))
+		return;
+
+	m_bResumeIdleTimer = m_idleTimer.IsRunning();
+	m_idleTimer.Stop();
+	m_fadeEngine.Finish();
+}
+
+void OverlayEngine::Resume()
+{
+	std::lock_guard<std::mutex> lock(m_mutexSuspend);
+
+	if (!m_bSuspended.exchange(false, std::memory_order_relaxed))
+		return;
+
+	// Shell may have repainted or rebuilt desktop meanwhile, so re-read opacity
+	m_fadeEngine.Reconcile();
+
+	// Icons stay as they are, and idle countdown starts from now
+	if (m_bResumeIdleTimer)
+		m_idleTimer.Start(m_clock.Now(), m_interval.load(std::memory_order_relaxed));
+	m_bResumeIdleTimer = false;
+}
+
+// Redoes what 'Suspend()' did, for activity that raced with it
+void OverlayEngine::undoActivity()
+{
+	std::lock_guard<std::mutex> lock(m_mutexSuspend);
+
+	if (!m_bSuspended.load(std::memory_order_relaxed))
+		return;		// Resumed meanwhile, so activity stands
+
+	m_idleTimer.Stop();		// NOTE: 'm_bResumeIdleTimer' was already recorded
+	m_fadeEngine.Finish();
+}
+
+bool OverlayEngine::IsSuspended() const
+{
+	return m_bSuspended.load(std::memory_order_relaxed);
+}
+
+OverlayEngine::Disposition OverlayEngine::OnMouseMove(int x, int y, const Settings::Snapshot& settings)
+{
+	ALLOCATION_FREE_SCOPE();
+
+	m_motionMousePos.push(x, y);
+
+	switch (settings.restoreWhen)
+	{
+		case Settings::RestoreWhen::mousedMoved:
+		{
+			trackRegion(false, false);	// Not a region setting
+
+			// We keep a running distance over a history of mouse points,
+			// so just compare it with threshold
+			if (m_motionMousePos.getDistanceX() >= MOUSEMOVE_DISTANCETHRESHOLD ||
+				m_motionMousePos.getDistanceY() >= MOUSEMOVE_DISTANCETHRESHOLD)
+			{
+				reportActivity();
+			}
+		}
+		break;
+
+		case Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft:
+		{
+			// Check if mouse entered or left quarter width of the monitor it is on
+			bool bInside = m_triggerGeometry.IsInTriggerZone(x, y);
+			bool bInsideBand = bInside ||
+				(m_regionTracker.IsInside() && m_triggerGeometry.IsInTriggerZone(x, y, m_hysteresisPixels));
+			trackRegion(bInside, bInsideBand);
+		}
+		break;
+
+		case Settings::RestoreWhen::mousedEntersHotZone:
+		{
+			bool bInside = (m_hotZoneIndex.HitTest(x, y) >= 0);
+			bool bInsideBand = bInside ||
+				(m_regionTracker.IsInside() && m_hotZoneIndex.HitTest(x, y, true) >= 0);
+			trackRegion(bInside, bInsideBand);
+		}
+		break;
+
+		default:
+			trackRegion(false, false);
+			break;
+	}
+
+	updateReveal(x, y, settings);
+
+	// If icons are hidden, don't let mouse move pass through
+	return (m_fadeEngine.IsHidden() ? Disposition::swallow : Disposition::passOn);
+}
+
+// Mouse has left the window and probably on some application window
+void OverlayEngine::OnMouseLeave()
+{
+	ALLOCATION_FREE_SCOPE();
+
+	m_motionMousePos.clear();
+
+	// Leaving window leaves any region too
+	if (m_regionTracker.IsInside())
+		ResetTimer();
+	m_regionTracker.Reset();
+	m_bMouseInTriggerZone.store(false, std::memory_order_relaxed);
+
+	hideReveal();
+}
+
+OverlayEngine::Disposition OverlayEngine::OnDoubleClick(const Settings::Snapshot& settings)
+{
+	if (settings.restoreWhen != Settings::RestoreWhen::doubleClicked)
+		return Disposition::passOn;
+
+	bool bSwallow = m_fadeEngine.IsHidden();
+
+	// Ask timer thread to activate
+	ResetTimer();
+
+	return (bSwallow ? Disposition::swallow : Disposition::passOn);
+}
+
+// User is trying to invoke context menu
+OverlayEngine::Disposition OverlayEngine::OnRightButtonDown()
+{
+	ALLOCATION_FREE_SCOPE();
+
+	// If icons are hidden, don't let right click pass through
+	if (m_fadeEngine.IsHidden())
+	{
+		// NOTE: The following is needed because if anything was selected before the icons
+		//		 were transparent, it invokes their context menu. We don't want this.
+		if (m_platform.getSelectedCount() > 0)
+			m_platform.ClearSelection();
+
+		return Disposition::swallow;
+	}
+
+	// Ask timer thread to activate
+	ResetTimer();
+
+	return Disposition::passOn;
+}
+
+void OverlayEngine::OnStyleChanged()
+{
+	m_fadeEngine.Reconcile();
+}
+
+void OverlayEngine::ValidateItems(const Settings::Snapshot& settings)
+{
+	if (settings.to != Settings::To::hoverReveal)
+	{
+		if (m_itemGrid.IsValid())
+		{
+			endReveal();
+			m_itemGrid.Invalidate();	// NOTE: Gives back its memory
+		}
+		return;
+	}
+
+	if (!m_itemGrid.IsValid())
+		rebuildItems();
+}
+
+// NOTE: Following item changes ends any reveal, as what backend drew is now out of date.
+//		 Next mouse move reveals again.
+void OverlayEngine::OnItemInserted(int index, const Rect& rect)
+{
+	if (!m_itemGrid.IsValid())
+		return;
+
+	endReveal();
+	m_itemGrid.Insert(index, rect);
+}
+
+void OverlayEngine::OnItemDeleted(int index)
+{
+	if (!m_itemGrid.IsValid())
+		return;
+
+	endReveal();
+	m_itemGrid.Remove(index);
+}
+
+void OverlayEngine::OnItemMoved(int index, const Rect& rect)
+{
+	if (!m_itemGrid.IsValid())
+		return;
+
+	endReveal();
+	m_itemGrid.Move(index, rect);
+}
+
+void OverlayEngine::OnItemsChanged()
+{
+	endReveal();
+	m_itemGrid.Invalidate();	// NOTE: Rebuilt by next 'ValidateItems()'
+}
+
+void OverlayEngine::OnIdleTimer(const Settings::Snapshot& settings)
+{
+	ALLOCATION_FREE_SCOPE();
+
+	// NOTE: Timer may have fired just before suspending, so don't let it re-arm itself or start a fade
+	std::lock_guard<std::mutex> lock(m_mutexSuspend);
+	if (m_bSuspended.load(std::memory_order_relaxed))
+		return;
+
+	if (!m_idleTimer.OnFired(m_clock.Now()))
+		return;		// There was activity and timer has been re-armed
+
+	// For 'RestoreWhen::mousedEntersQuarterRegionOnLeft' and 'RestoreWhen::mousedEntersHotZone' settings,
+	// if mouse is still in a trigger zone don't change icon transparency. Let it be as is.
+	if ((settings.restoreWhen == Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft ||
+		 settings.restoreWhen == Settings::RestoreWhen::mousedEntersHotZone) &&
+		m_bMouseInTriggerZone.load(std::memory_order_relaxed))
+		return;
+
+	// Change icon opacity depending on 'to' setting
+	// NOTE: Fade engine doesn't let the transparency be zero because then we will not receive
+	//		 window events in our window procedure
+	// NOTE: With 'To::hoverReveal', icons are fully transparent and those near mouse are drawn by reveal backend
+	auto to_transparency = (settings.to == Settings::To::semiTransparency ? 0x5A : 0x00);	// NOTE: About 35% opacity on semi-transparency setting
+
+	m_fadeEngine.FadeOut(to_transparency, FadeEngine::Easing::linear);	// Steps run on frame timer
+}
+
+void OverlayEngine::OnFrameTimer()
+{
+	ALLOCATION_FREE_SCOPE();
+	m_fadeEngine.OnFrameTimer();
+}
+
+bool OverlayEngine::IsHidden() const
+{
+	return m_fadeEngine.IsHidden();
+}
+
+const ActivityCoalescer& OverlayEngine::getActivityCoalescer() const
+{
+	return m_activityCoalescer;
+}
+
+const FadeEngine& OverlayEngine::getFadeEngine() const
+{
+	return m_fadeEngine;
+}
+
+// Reads all items from platform, only when they couldn't be followed
+void OverlayEngine::rebuildItems()
+{
+	Rect bounds;
+	if (!m_platform.getClientBounds(bounds))
+		return;
+
+	m_itemGrid.Reset(bounds);
+
+	auto cItems = m_platform.getItemCount();
+	for (size_t i = 0; i < cItems; ++i)
+	{
+		Rect rect;
+		if (!m_platform.getItemBounds(static_cast<int>(i), rect))
+			rect = Rect();	// NOTE: Still inserted, so indices of later items are right
+		m_itemGrid.Insert(static_cast<int>(i), rect);
+	}
+}
+
+// Draws items near mouse while icons are hidden
+// NOTE: Only after icons are fully hidden, fades are left to fade engine
+void OverlayEngine::updateReveal(int x, int y, const Settings::Snapshot& settings)
+{
+	if (!m_pRevealBackend)
+		return;
+
+	if (settings.to != Settings::To::hoverReveal || !m_fadeEngine.IsHidden() || !m_itemGrid.IsValid())
+	{
+		endReveal();
+		return;
+	}
+
+	m_bRevealing = true;	// NOTE: Backend may have been prepared for this even if nothing changes
+
+	HoverReveal::Change changes[HOVERREVEAL_MAXCHANGES];
+	auto cChanges = m_hoverReveal.Update(m_itemGrid, x, y, changes);
+	if (cChanges > 0)
+		m_pRevealBackend->ApplyReveal(changes, cChanges);
+}
+
+// Hides revealed items, but lets backend keep what it needs to draw them again
+void OverlayEngine::hideReveal()
+{
+	if (!m_pRevealBackend || m_hoverReveal.getRevealedCount() == 0)
+		return;
+
+	HoverReveal::Change changes[HOVERREVEAL_MAXCHANGES];
+	auto cChanges = m_hoverReveal.Hide(changes);
+	m_pRevealBackend->ApplyReveal(changes, cChanges);
+}
+
+void OverlayEngine::endReveal()
+{
+	m_hoverReveal.Reset();
+	if (!m_bRevealing)
+		return;
+
+	m_bRevealing = false;
+	if (m_pRevealBackend)
+		m_pRevealBackend->EndReveal();
+}
+
+// Counts only entering and leaving a region as activity, not every move inside it
+// NOTE: Otherwise each mouse move in region would bump idle timer, and jitter on the
+//		 boundary would keep restoring icons
+void OverlayEngine::trackRegion(bool bInside, bool bInsideBand)
+{
+	auto transition = m_regionTracker.Update(bInside, bInsideBand, m_clock.Now(), m_dwellMillisecs);
+	switch (transition)
+	{
+		case RegionTracker::Transition::entered:
+			reportActivity();
+			break;
+
+		case RegionTracker::Transition::leaving:
+			// IMPORTANT: Idle countdown starts from here, as mouse may stop before leaving is confirmed.
+			//			  Idle timer may have elapsed while mouse was in region, so this re-arms it.
+			reportActivity();
+			break;
+
+		case RegionTracker::Transition::left:
+			if (m_dwellMillisecs == 0)
+				reportActivity();	// NOTE: No 'leaving' comes first without dwell time
+			break;
+
+		default:
+			break;
+	}
+
+	// NOTE: Idle timer may fade icons while leaving is being confirmed
+	m_bMouseInTriggerZone.store(m_regionTracker.IsInside() && !m_regionTracker.IsLeaving(), std::memory_order_relaxed);
+}
+
+// Acts on mouse activity at most once per quantum, see 'ActivityCoalescer'
+void OverlayEngine::reportActivity()
+{
+	if (m_activityCoalescer.OnActivity(m_clock.Now()))
+	{
+		// Ask timer thread to activate
+		ResetTimer();
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "ActivityCoalescer.h"
+#include "FadeEngine.h"
+#include "HotZoneIndex.h"
+#include "HoverReveal.h"
+#include "IdleTimer.h"
+#include "ItemGrid.h"
+#include "MotionAccumulator.h"
+#include "Platform.h"
+#include "RegionTracker.h"
+#include "Settings.h"
+#include "Timing.h"
+#include "TriggerGeometry.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#define MOUSEPOS_HISTORYDEPTH		4
+#define MOUSEMOVE_DISTANCETHRESHOLD	50
+
+
+// Idle, fade and restore behavior of shell window, free of any platform calls
+// NOTE: Platform adapter feeds input events in and forwards timer callbacks. Input events
+//		 must all come from one thread, timer callbacks may come from any.
+class OverlayEngine
+{
+public:
+	// What adapter should do with an input event
+	enum class Disposition
+	{
+		passOn,				// Let shell window have it
+		swallow				// Icons are hidden, so hide it from shell window
+	};
+
+	OverlayEngine(Platform& platform, Clock& clock, TimerBackend& idleTimer, TimerBackend& frameTimer);
+
+	void setOpacityBackend(FadeEngine::Backend *pBackend);
+	void setRevealBackend(HoverReveal::Backend *pBackend);		// IMPORTANT: Called back from input thread only
+	void setTuning(int hysteresisPixels, uint32_t dwellMillisecs, uint32_t activityQuantumMillisecs);
+	void setHotZones(const uint32_t packedZones[], size_t count);	// See 'Settings::getHotZones()'
+	void UpdateGeometry();										// Monitors or window changed
+
+	// Idle timer
+	void Start(uint32_t intervalMillisecs);		// (Re)start and restore opacity
+	void Stop();								// Stop and restore opacity
+	void ResetTimer();							// User activity
+
+	// Desktop visibility, see 'VisibilityOracle'
+	// NOTE: While suspended, no timer is armed at all. Fade running then is finished at once,
+	//		 as nobody can see it, and idle countdown starts over on resume.
+	void Suspend();
+	void Resume();
+	bool IsSuspended() const;
+
+	// Input events
+	Disposition OnMouseMove(int x, int y, const Settings::Snapshot& settings);
+	void OnMouseLeave();
+	Disposition OnDoubleClick(const Settings::Snapshot& settings);
+	Disposition OnRightButtonDown();
+	void OnStyleChanged();						// Someone else may have touched opacity
+
+	// List items, for 'Settings::To::hoverReveal'
+	// NOTE: Must come from input thread too. Items are only followed while that setting is on.
+	void ValidateItems(const Settings::Snapshot& settings);	// Starts or stops following items, call before input events
+	void OnItemInserted(int index, const Rect& rect);
+	void OnItemDeleted(int index);
+	void OnItemMoved(int index, const Rect& rect);
+	void OnItemsChanged();						// Changes that can't be followed, items are read again
+
+	// Timer events
+	void OnIdleTimer(const Settings::Snapshot& settings);
+	void OnFrameTimer();
+
+	bool IsHidden() const;
+	const ActivityCoalescer& getActivityCoalescer() const;
+	const FadeEngine& getFadeEngine() const;
+
+private:
+	void start(uint32_t intervalMillisecs);
+	void undoActivity();
+	void trackRegion(bool bInside, bool bInsideBand);
+	void reportActivity();
+	void rebuildHotZones();
+	void rebuildItems();
+	void updateReveal(int x, int y, const Settings::Snapshot& settings);
+	void hideReveal();
+	void endReveal();
+
+	Platform& m_platform;
+	Clock& m_clock;
+	IdleTimer m_idleTimer;
+	FadeEngine m_fadeEngine;					// NOTE: Owns shell window's opacity
+	std::atomic<uint32_t> m_interval;
+	std::mutex m_mutexSuspend;					// Serializes suspending with starting and stopping idle timer
+	std::atomic<bool> m_bSuspended;
+	bool m_bResumeIdleTimer;					// Idle timer was running, or was started, while suspended
+
+	// Tuning
+	int m_hysteresisPixels;
+	uint32_t m_dwellMillisecs;
+
+	// Input state
+	// NOTE: Only touched from input thread, except where atomic
+	MotionAccumulator<MOUSEPOS_HISTORYDEPTH> m_motionMousePos;
+	TriggerGeometry m_triggerGeometry;
+	HotZoneIndex m_hotZoneIndex;
+	uint32_t m_packedHotZones[SETTINGS_MAXHOTZONES];	// As last given
+	size_t m_cPackedHotZones;
+	RegionTracker m_regionTracker;
+	ActivityCoalescer m_activityCoalescer;
+	std::atomic<bool> m_bMouseInTriggerZone;	// Read by idle timer
+	ItemGrid m_itemGrid;
+	HoverReveal m_hoverReveal;
+	HoverReveal::Backend *m_pRevealBackend;
+	bool m_bRevealing;							// Backend has something to end
+};
@@ -6,23 +6,44 @@
 #include <Shlwapi.h>
 #include <process.h>
 #include <windowsx.h>
+#include <CommCtrl.h>
+#include <mutex>
 
-#define MOUSEPOS_HISTORYDEPTH		4
+#ifndef WM_DPICHANGED_AFTERPARENT
+#define WM_DPICHANGED_AFTERPARENT	0x02E3
+#endif
 
 // Variables from external .cpp
 extern HINSTANCE g_hInst;
 extern long g_cDllRef;
 
 // Static variables
-bool PellucidHandlers::s_bIsMouseOnShellWindow = false;
-sized_queue<POINT> PellucidHandlers::s_queueMousePos(MOUSEPOS_HISTORYDEPTH);
 bool PellucidHandlers::s_bPellucidIcons = true;
-HBITMAP PellucidHandlers::s_hbitmapPellucidIcon = NULL;
-LONG PellucidHandlers::s_quarterWidthShellWindow = 0;
-HANDLE PellucidHandlers::s_heventExitThreadFunc = NULL;
-HANDLE PellucidHandlers::s_hWaitThread = NULL;
+std::map<UINT, HBITMAP> PellucidHandlers::s_iconBitmaps;
+MenuTemplate PellucidHandlers::s_menuTemplate;
+std::mutex PellucidHandlers::s_mutexMenu;
+uint32_t PellucidHandlers::s_storeVersion = 0;
+TickCountClock PellucidHandlers::s_clock;
+ThreadpoolTimer PellucidHandlers::s_timerIdle(&PellucidHandlers::PellucidIconsTimer_ThreadFunc, NULL);
+ThreadpoolTimer PellucidHandlers::s_timerFade(&PellucidHandlers::FadeTimer_ThreadFunc, NULL);
 HWND PellucidHandlers::s_hwndShellWindow = NULL;
+Win32Platform PellucidHandlers::s_platformShellWindow;
+LayeredWindow PellucidHandlers::s_layeredShellWindow;
+OpacityLayering PellucidHandlers::s_opacityShellWindow(PellucidHandlers::s_layeredShellWindow);
+RevealOverlay PellucidHandlers::s_revealShellWindow;
+OverlayEngine PellucidHandlers::s_engine(PellucidHandlers::s_platformShellWindow, PellucidHandlers::s_clock, PellucidHandlers::s_timerIdle, PellucidHandlers::s_timerFade);
 LONG_PTR PellucidHandlers::s_hPrevShellWindowWndProc = NULL;
+HWND PellucidHandlers::s_hwndShellViewWindow = NULL;
+LONG_PTR PellucidHandlers::s_hPrevShellViewWindowWndProc = NULL;
+MappedFile PellucidHandlers::s_fileMouseTrace;
+MouseTraceWriter PellucidHandlers::s_mouseTrace;
+MappedFile PellucidHandlers::s_sharedMetrics;
+VisibilityOracle PellucidHandlers::s_visibility(&PellucidHandlers::Visibility_Changed, NULL);
+VisibilityMonitor PellucidHandlers::s_visibilityMonitor(PellucidHandlers::s_visibility);
+ThreadpoolTimer PellucidHandlers::s_timerAttach(&PellucidHandlers::AttachTimer_ThreadFunc, NULL);
+Win32DesktopLocator PellucidHandlers::s_desktopLocator;
+ShellAttacher PellucidHandlers::s_attacher(PellucidHandlers::s_desktopLocator, PellucidHandlers::s_clock, PellucidHandlers::s_timerAttach,
+										   &PellucidHandlers::AttachShellWindow, &PellucidHandlers::DetachShellWindow, NULL);
 
 
 // Member functions for 'PellucidHandlers' class
@@ -35,11 +56,12 @@ PellucidHandlers::~PellucidHandlers(void)
 {
 	if (InterlockedDecrement(&g_cDllRef) <= 0)
 	{
-		if (s_hbitmapPellucidIcon)
-		{
-			DeleteBitmap(s_hbitmapPellucidIcon);
-			s_hbitmapPellucidIcon = NULL;
-		}
+		Settings::Flush();	// Module may be unloaded soon, so don't leave changes unwritten
+
+		std::lock_guard<std::mutex> lock(s_mutexMenu);
+		for (auto& iconBitmap : s_iconBitmaps)
+			DeleteBitmap(iconBitmap.second);
+		s_iconBitmaps.clear();
 	}
 }
 
@@ -80,6 +102,25 @@ IFACEMETHODIMP_(ULONG) PellucidHandlers::Release()
 
 #pragma endregion
 
+// Closes everything that static destructors would otherwise tear down under loader lock
+// NOTE: DLL may stay loaded after all, so all of this is created again when next needed
+void PellucidHandlers::Unload()
+{
+	// Timer callbacks run our code, so they must have finished
+	s_timerAttach.Close();
+	s_attacher.Stop();		// NOTE: So that it starts over if DLL stays loaded
+	s_timerIdle.Close();
+	s_timerFade.Close();
+
+	// Also for store change notifications
+	Settings::Close();
+
+	// NOTE: Windows of these classes were destroyed on detach, as no DLL reference is left
+	LayeredWindow::UnregisterOverlayClass();
+	RevealOverlay::UnregisterOverlayClass();
+	VisibilityMonitor::UnregisterWindowClass();
+}
+
 #pragma region IShellIconOverlayIdentifier
 
 IFACEMETHODIMP PellucidHandlers::GetOverlayInfo(PWSTR pwszIconFile, int cchMax, int *pIndex, DWORD *pdwFlags)
@@ -89,38 +130,17 @@ IFACEMETHODIMP PellucidHandlers::GetOverlayInfo(PWSTR pwszIconFile, int cchMax,
 	// Force settings read from registry
 	Settings::ForceSettingsRefreshFromRegistry();	// IMPORTANT: Must be called before any get settings function
 
-	// Find desktop ListView
-	auto hwndProgMan = FindWindow(L"Progman", L"Program Manager");
-	auto hwndShellView = FindWindowEx(hwndProgMan, NULL, L"ShellDLL_DefView", L"");
-	auto hwndFolderView = FindWindowEx(hwndShellView, NULL, L"SysListView32", L"FolderView");
-	if (!hwndFolderView)
-		return E_UNEXPECTED;
-
-	s_hwndShellWindow = hwndFolderView;	// We use this in our subclassing window procedure
-	// Calculate one third region, we may use this later
-	RECT rectShellWindow = { 0 };
-	GetWindowRect(s_hwndShellWindow, &rectShellWindow);
-	s_quarterWidthShellWindow = (rectShellWindow.right - rectShellWindow.left) / 3;
-
-	// IMPORTANT: Add 'WS_EX_LAYERED' to ListView's extended window style, so that we can
-	//			  using 'SetLayeredAttributes()'
-	auto currentExStyle = GetWindowLongPtr(hwndFolderView, GWL_EXSTYLE);
-	if ((currentExStyle & WS_EX_LAYERED) == 0)
-	{
-		SetWindowLongPtr(hwndFolderView, GWL_EXSTYLE, currentExStyle | WS_EX_LAYERED);
+#ifndef PELLUCIDICONS_NO_METRICS
+	// Publish counters and latencies for outside readers, else they stay in process
+	if (s_sharedMetrics.OpenShared(METRICS_SHAREDMEMORYNAME, sizeof(Metrics::Layout)))
+		Metrics::Attach(s_sharedMetrics.getData(), s_sharedMetrics.getSize());
+#endif
 
-		if (SetLayeredWindowAttributes(hwndFolderView, NULL, 0xFF, LWA_ALPHA) == FALSE)
-			return E_UNEXPECTED;
-	}
-
-	// Subclass listview's window procedure
-	s_hPrevShellWindowWndProc = SetWindowLongPtr(s_hwndShellWindow, GWLP_WNDPROC, (LONG_PTR)ShellWindow_WndProc);
-	if (!s_hPrevShellWindowWndProc)
-		return E_FAIL;
-
-	// Create a timer thread if this extension is enabled
-	if (Settings::getIsEnabled())
-		ResetTimer();
+	// NOTE: This is on Explorer's startup path and desktop may not have been built yet, so
+	//		 desktop ListView is looked for on a thread pool thread, and subclassed on its own thread
+	//		 once found, see 'AttachShellWindow()'
+	if (s_timerAttach.Create())
+		s_attacher.Start();
 
 	// We return a dummy icon index in this module's resource table
 	hr = (GetModuleFileName(g_hInst, pwszIconFile, cchMax) != 0 ? S_OK : E_UNEXPECTED);
@@ -166,99 +186,45 @@ IFACEMETHODIMP PellucidHandlers::QueryContextMenu(HMENU hmenu, UINT indexMenu, U
 	if ((uFlags & CMF_DEFAULTONLY) || (uFlags & CMF_EXPLORE))
 		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_NULL, 0);
 
-	// Load submenu from resource
-	auto hSubMenu = LoadMenu(g_hInst, MAKEINTRESOURCE(IDR_PELLUCIDICONSMENU));
-	if (!hSubMenu)
-		return E_UNEXPECTED;
+	HRESULT hr;
 
-	hSubMenu = GetSubMenu(hSubMenu, 0);	// We need to get the sub menu of the main root
-	if (!hSubMenu)
-		return E_UNEXPECTED;
+	// Get current settings
+	auto settings = Settings::getSnapshot();
 
-	HRESULT hr;
+	HMENU hSubMenu = NULL;
+	{
+		std::lock_guard<std::mutex> lock(s_mutexMenu);
 
-	// NOTE: We don't need the variable 'idCmdLast' and so will reuse to keep track
-	//		 of the number of items added to the menu. This is 'cause we will need to return a count + 1.
-	idCmdLast = idCmdFirst;
+		// Menu template is loaded from resource just once
+		if (!s_menuTemplate.IsLoaded())
+		{
+			auto hrsrcMenu = FindResource(g_hInst, MAKEINTRESOURCE(IDR_PELLUCIDICONSMENU), RT_MENU);
+			auto hglobalMenu = (hrsrcMenu ? LoadResource(g_hInst, hrsrcMenu) : NULL);
+			if (!hglobalMenu || !s_menuTemplate.Load(LockResource(hglobalMenu), SizeofResource(g_hInst, hrsrcMenu)))
+				return E_UNEXPECTED;
+		}
 
-	// Get current settings
-	auto isEnabled = Settings::getIsEnabled();
-	auto inSetting = Settings::getInSetting();
-	auto restoreWhenSetting = Settings::getRestoreWhenSetting();
-	auto toSetting = Settings::getToSetting();
-
-	// Before we add sub menu, we will need to set proper menu item id starting from 'idCmdFirst'
-	MENUITEMINFO menuItemInfo = { 0 };
-	menuItemInfo.cbSize = sizeof(menuItemInfo);
-
-	// Set radiocheck and command ID for menu items
-	// 'are Enabled' submenu item
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::Are_Enabled; // Keep track of command offset and respective handler's function pointer
-	menuItemInfo.fMask = MIIM_ID | MIIM_STATE;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (isEnabled ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_PELLUCIDICONS_AREENABLED, FALSE, &menuItemInfo);
-
-	menuItemInfo.fMask = MIIM_ID | MIIM_FTYPE | MIIM_STATE;
-	menuItemInfo.fType = MFT_RADIOCHECK;
-
-	// 'In' submenu items
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::In_5secs;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (inSetting == Settings::In::secs5 ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_IN_5SECS, FALSE, &menuItemInfo);
-
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::In_10secs;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (inSetting == Settings::In::secs10 ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_IN_10SECS, FALSE, &menuItemInfo);
-
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::In_20secs;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (inSetting == Settings::In::secs20 ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_IN_20SECS, FALSE, &menuItemInfo);
-
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::In_30secs;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (inSetting == Settings::In::secs30 ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_IN_30SECS, FALSE, &menuItemInfo);
-
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::In_1min;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (inSetting == Settings::In::min1 ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_IN_1MIN, FALSE, &menuItemInfo);
-
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::In_2mins;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (inSetting == Settings::In::mins2 ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_IN_2MINS, FALSE, &menuItemInfo);
-
-	// 'Get restored when' submenu items
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::Get_restoredwhen_mousemoved;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (restoreWhenSetting == Settings::RestoreWhen::mousedMoved ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_GET_RESTORED_WHEN_MOUSEMOVED, FALSE, &menuItemInfo);
-
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::Get_restoredwhen_mouseenterquarterregiononleft;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (restoreWhenSetting == Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_GET_RESTORED_WHEN_MOUSEENTERSQUARTERREGIONONLEFT, FALSE, &menuItemInfo);
-
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::Get_restoredwhen_doubleclicked;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (restoreWhenSetting == Settings::RestoreWhen::doubleClicked ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_GET_RESTORED_WHEN_DOUBLECLICKED, FALSE, &menuItemInfo);
-
-	// To submenu items
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::To_fulltransparency;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (toSetting == Settings::To::fullTransparency ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_TO_FULLTRANSPARENCY, FALSE, &menuItemInfo);
-
-	m_mapHandlers[idCmdLast - idCmdFirst] = &PellucidHandlers::To_semitransparency;
-	menuItemInfo.wID = idCmdLast++;
-	menuItemInfo.fState = (toSetting == Settings::To::semiTransparency ? MFS_CHECKED : MFS_UNCHECKED);
-	SetMenuItemInfo(hSubMenu, ID_TO_SEMITRANSPARENCY, FALSE, &menuItemInfo);
+		// NOTE: We don't need the variable 'idCmdLast' and so will reuse to keep track
+		//		 of the number of items added to the menu. This is 'cause we will need to return a count + 1.
+		// NOTE: Template keeps last command IDs and check states, so only those which changed are patched
+		// NOTE: Command offset of each item is its index in 'g_commands'
+		idCmdLast = idCmdFirst;
+		for (auto& command : g_commands)
+			s_menuTemplate.setItem(command.resourceId, idCmdLast++, IsCommandChecked(command, settings));
+
+		auto hMenu = LoadMenuIndirect(s_menuTemplate.getData());
+		if (!hMenu)
+			return E_UNEXPECTED;
+
+		// We need to get the sub menu of the main root and detach it, so that destroying root doesn't destroy it
+		// NOTE: Sub menu is destroyed along with 'hmenu' by its owner
+		hSubMenu = GetSubMenu(hMenu, 0);
+		RemoveMenu(hMenu, 0, MF_BYPOSITION);
+		DestroyMenu(hMenu);
+	}
+
+	if (!hSubMenu)
+		return E_UNEXPECTED;
 
 	// Add our submenu to 'hmenu' from function parameters
 	MENUITEMINFO mi = { 0 };
@@ -266,19 +232,11 @@ IFACEMETHODIMP PellucidHandlers::QueryContextMenu(HMENU hmenu, UINT indexMenu, U
 	mi.fMask = MIIM_STRING | MIIM_SUBMENU | MIIM_BITMAP;
 	mi.dwTypeData = L"Pellucid icons";
 	mi.hSubMenu = hSubMenu;
-	if (!s_hbitmapPellucidIcon)	// Create bitmap just once
-	{
-		auto hiconPeullicdIcon = (HICON)LoadImage(g_hInst, MAKEINTRESOURCE(IDI_PELLUCIDICONSICON), IMAGE_ICON, 0, 0, LR_DEFAULTCOLOR);
-		if (hiconPeullicdIcon)
-		{
-			s_hbitmapPellucidIcon = Utility::ConvertIconHandleToBitmapHandle(hiconPeullicdIcon);	// Convert icon to premultiplied bitmap handle
-			DestroyIcon(hiconPeullicdIcon);
-		}
-	}
-	
-	mi.hbmpItem = s_hbitmapPellucidIcon;	// NOTE: According to 'SetMenuItemBitmaps()' doc, it is up to this DLL to destroy this bitmap
+	mi.hbmpItem = getIconBitmap();	// NOTE: According to 'SetMenuItemBitmaps()' doc, it is up to this DLL to destroy this bitmap
 
 	hr = (InsertMenuItem(hmenu, indexMenu, TRUE, &mi) != FALSE ? S_OK : E_UNEXPECTED);
+	if (FAILED(hr))
+		DestroyMenu(hSubMenu);	// Not owned by 'hmenu'
 
 	return (SUCCEEDED(hr) ? MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_NULL, (idCmdLast - idCmdFirst + 1)) : E_UNEXPECTED);
 }
@@ -289,13 +247,13 @@ IFACEMETHODIMP PellucidHandlers::InvokeCommand(LPCMINVOKECOMMANDINFO pici)
 	if (HIWORD(pici->lpVerb) != NULL)
 		return E_FAIL;		// IMPORTANT: According to docs, if we don't handle this menu item offset return 'E_FAIL' so that anothers may handle it
 
-	int indexMenuItem = LOWORD(pici->lpVerb);
+	size_t indexMenuItem = LOWORD(pici->lpVerb);
 
 	// Do Action
-	if (m_mapHandlers.count(indexMenuItem) == 0)	// NOTE: 'map::count()' is a quick way of finding if given index if among the keys
+	if (indexMenuItem >= COMMAND_COUNT)
 		return E_FAIL;
 
-	(this->*m_mapHandlers[indexMenuItem])();	// Call associated handler
+	ExecuteCommand(g_commands[indexMenuItem]);
 
 	return S_OK;
 }
@@ -312,324 +270,481 @@ IFACEMETHODIMP PellucidHandlers::Initialize(PCIDLIST_ABSOLUTE pidlFolder, IDataO
 #pragma endregion
 
 #pragma region Context menu handlers
-void PellucidHandlers::In_5secs()
+bool PellucidHandlers::IsCommandChecked(const CommandDescriptor& command, const Settings::Snapshot& settings)
 {
-	if (Settings::getInSetting() == Settings::In::secs5)
-		return;
-
-	Settings::setInSetting(Settings::In::secs5);
+	auto value = Settings::getValue(settings, command.field);
 
-	ResetTimer();
+	return (command.value == COMMAND_VALUE_TOGGLE ? value != 0 : value == command.value);
 }
 
-void PellucidHandlers::In_10secs()
+void PellucidHandlers::ExecuteCommand(const CommandDescriptor& command)
 {
-	if (Settings::getInSetting() == Settings::In::secs10)
+	auto value = Settings::getValue(Settings::getSnapshot(), command.field);
+	if (command.value == COMMAND_VALUE_TOGGLE)
+		value = !value;		// Toggle with current setting
+	else if (value == command.value)
 		return;
+	else
+		value = command.value;
+
+	Settings::setValue(command.field, value);
+
+	switch (command.postAction)
+	{
+		case PostAction::resetTimer:
+			ResetTimer();
+			break;
 
-	Settings::setInSetting(Settings::In::secs10);
+		case PostAction::restartTimer:
+			RestartTimer();
+			break;
 
-	ResetTimer();
+		case PostAction::enableTimer:
+		{
+			// Depending on new setting
+			if (value)
+				RestartTimer();
+			else
+				KillTimer();
+		}
+		break;
+	}
 }
 
-void PellucidHandlers::In_20secs()
+// Returns menu icon bitmap for DPI of monitor where menu is being shown
+// NOTE: Bitmaps are created once per DPI and kept until the last handler is released, as one may still be
+//		 in an open menu. There are only a handful of DPIs in use, so nothing is evicted meanwhile.
+HBITMAP PellucidHandlers::getIconBitmap()
 {
-	if (Settings::getInSetting() == Settings::In::secs20)
-		return;
+	POINT ptCursor = { 0 };
+	GetCursorPos(&ptCursor);
+	auto dpi = Utility::GetDpiForPoint(ptCursor);
+
+	std::lock_guard<std::mutex> lock(s_mutexMenu);
 
-	Settings::setInSetting(Settings::In::secs20);
+	auto iter = s_iconBitmaps.find(dpi);
+	if (iter != s_iconBitmaps.end())
+		return iter->second;
 
-	ResetTimer();
+	auto hbitmap = Utility::CreatePremultipliedIconBitmap(g_hInst, MAKEINTRESOURCE(IDI_PELLUCIDICONSICON), dpi);
+	if (hbitmap)
+		s_iconBitmaps.emplace(dpi, hbitmap);
+
+	return hbitmap;
 }
 
-void PellucidHandlers::In_30secs()
+// Gives hot zones and tuning to engine if they have changed in store since last time
+// NOTE: Store is read on its change notification thread, so this only copies what was read
+void PellucidHandlers::RefreshFromStore()
 {
-	if (Settings::getInSetting() == Settings::In::secs30)
+	auto version = Settings::getStoreVersion();
+	if (version == s_storeVersion)
 		return;
+	s_storeVersion = version;
+
+	s_engine.setTuning(Settings::getRegionHysteresisPixels(), Settings::getRegionDwellMillisecs(), Settings::getActivityQuantumMillisecs());
+	s_opacityShellWindow.setSnapshotFade(Settings::getSnapshotFade());
 
-	Settings::setInSetting(Settings::In::secs30);
+	uint32_t packedZones[SETTINGS_MAXHOTZONES];
+	auto cZones = Settings::getHotZones(packedZones);
+	s_engine.setHotZones(packedZones, cZones);	// NOTE: Index is only rebuilt if zones changed
 
-	ResetTimer();
+	UpdateMouseTrace(Settings::getMouseTraceKilobytes());
 }
 
-void PellucidHandlers::In_1min()
+// Starts or stops recording mouse messages to '%LOCALAPPDATA%\PellucidIcons\MouseTrace.bin'
+// NOTE: Trace continues across sessions as long as its size stays the same
+void PellucidHandlers::UpdateMouseTrace(uint32_t kilobytes)
 {
-	if (Settings::getInSetting() == Settings::In::min1)
+	size_t cbTrace = static_cast<size_t>(kilobytes) * 1024;
+	if (cbTrace == s_fileMouseTrace.getSize())
 		return;
 
-	Settings::setInSetting(Settings::In::min1);
+	s_mouseTrace.Detach();
+	s_fileMouseTrace.Close();
+	if (cbTrace == 0)
+		return;
 
-	ResetTimer();
-}
+	PWSTR pszLocalAppData = NULL;
+	if (FAILED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, NULL, &pszLocalAppData)))
+		return;
 
-void PellucidHandlers::In_2mins()
-{
-	if (Settings::getInSetting() == Settings::In::mins2)
+	WCHAR szPath[MAX_PATH];
+	auto hr = StringCchPrintf(szPath, ARRAYSIZE(szPath), L"%s\\PellucidIcons", pszLocalAppData);
+	CoTaskMemFree(pszLocalAppData);
+	if (FAILED(hr))
 		return;
 
-	Settings::setInSetting(Settings::In::mins2);
+	CreateDirectory(szPath, NULL);	// NOTE: Fails if it already exists, which is fine
+	if (FAILED(StringCchCat(szPath, ARRAYSIZE(szPath), L"\\MouseTrace.bin")))
+		return;
 
-	ResetTimer();
+	if (s_fileMouseTrace.Open(szPath, cbTrace))
+		s_mouseTrace.Attach(s_fileMouseTrace.getData(), s_fileMouseTrace.getSize());
 }
 
-void PellucidHandlers::Get_restoredwhen_mousemoved()
+// Sets up desktop ListView found by 's_attacher'
+// NOTE: Called on ListView's own thread, and returning false makes 's_attacher' try again later
+bool PellucidHandlers::AttachShellWindow(void *pWindow, void *pContext)
 {
-	if (Settings::getRestoreWhenSetting() == Settings::RestoreWhen::mousedMoved)
-		return;
+	auto hwndFolderView = static_cast<HWND>(pWindow);
 
-	Settings::setRestoreWhenSetting(Settings::RestoreWhen::mousedMoved);
+	s_hwndShellWindow = hwndFolderView;	// We use this in our subclassing window procedure
+	s_platformShellWindow.setWindow(hwndFolderView);
+	// Calculate trigger zone on each monitor and hot zones, we may use these later
+	RefreshFromStore();
+	s_engine.UpdateGeometry();
+
+	// NOTE: 'WS_EX_LAYERED' is only in ListView's extended window style while icons aren't
+	//		 fully opaque, see 'OpacityLayering'
+	s_layeredShellWindow.setWindow(hwndFolderView);
+	s_engine.setOpacityBackend(&s_opacityShellWindow);	// Picks up current opacity
+
+	// Items of a previous ListView are of no use, they are read again when needed
+	s_revealShellWindow.setWindow(hwndFolderView);
+	s_engine.setRevealBackend(&s_revealShellWindow);
+	s_engine.OnItemsChanged();
+
+	// Our window procedures are about to be put in use, so this DLL must stay loaded until they are taken out again
+	InterlockedIncrement(&g_cDllRef);
 
-	ResetTimer();
-}
+	// Subclass window procedure of listview's parent, which gets its selection changes
+	// NOTE: Without this, neither selection nor items are followed, see 'Win32Platform::OnNotify()'
+	//		 and 'ShellViewWindow_WndProc()'
+	s_hwndShellViewWindow = GetParent(hwndFolderView);
+	s_hPrevShellViewWindowWndProc = (s_hwndShellViewWindow ? subclassWindow(s_hwndShellViewWindow, ShellViewWindow_WndProc) : NULL);
 
-void PellucidHandlers::Get_restoredwhen_mouseenterquarterregiononleft()
-{
-	if (Settings::getRestoreWhenSetting() == Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft)
-		return;
+	// Subclass listview's window procedure
+	// CAUTION: Previous window procedure must be known before ours can be called
+	s_hPrevShellWindowWndProc = subclassWindow(hwndFolderView, ShellWindow_WndProc);
+	if (!s_hPrevShellWindowWndProc)
+	{
+		// Parent's notifications are of no use without it, until next try
+		if (s_hPrevShellViewWindowWndProc)
+			unsubclassWindow(s_hwndShellViewWindow, ShellViewWindow_WndProc, s_hPrevShellViewWindowWndProc);
+		s_hwndShellViewWindow = NULL;
+		s_hPrevShellViewWindowWndProc = NULL;
+
+		InterlockedDecrement(&g_cDllRef);
+		return false;
+	}
+
+	// NOTE: On this thread, as it runs a message loop
+	s_visibilityMonitor.Create(hwndFolderView);
+
+	// Drop layering left at full opacity, e.g. by earlier versions
+	// NOTE: Only now, as this is applied by our window procedure
+	uint8_t opacity;
+	if (s_opacityShellWindow.GetOpacity(opacity) && opacity == OPACITY_OPAQUE)
+		s_opacityShellWindow.SetOpacity(OPACITY_OPAQUE);
+
+	// Start idle timer if this extension is enabled
+	if (Settings::getIsEnabled())
+		RestartTimer();
 
-	Settings::setRestoreWhenSetting(Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft);
+	return true;
+}
 
-	ResetTimer();
+// Undoes 'AttachShellWindow()', on ListView's thread, before shell destroys it
+void PellucidHandlers::DetachShellWindow(void *pWindow, void *pContext)
+{
+	auto hwndFolderView = static_cast<HWND>(pWindow);
+
+	KillTimer();	// Reset window opacity
+	// NOTE: Opacity changes still posted to window are dropped once previous window procedure is
+	//		 back, which only matters if shell keeps using this window. From here on, our window
+	//		 procedures only pass messages on if they can't be taken out, see 'StrandedWindow_WndProc()'.
+	s_hwndShellWindow = NULL;
+	unsubclassWindow(hwndFolderView, ShellWindow_WndProc, s_hPrevShellWindowWndProc);
+	if (s_hPrevShellViewWindowWndProc)
+		unsubclassWindow(s_hwndShellViewWindow, ShellViewWindow_WndProc, s_hPrevShellViewWindowWndProc);
+	s_hwndShellViewWindow = NULL;
+	s_hPrevShellViewWindowWndProc = NULL;
+
+	s_engine.setOpacityBackend(NULL);
+	s_engine.setRevealBackend(NULL);
+	s_layeredShellWindow.setWindow(NULL);
+	s_revealShellWindow.setWindow(NULL);
+	s_platformShellWindow.setWindow(NULL);
+
+	// NOTE: Made again with next window, on its thread. Desktop is taken to be visible meanwhile.
+	s_visibilityMonitor.Destroy();
+
+	InterlockedDecrement(&g_cDllRef);	// NOTE: Windows we couldn't unsubclass hold their own reference
 }
 
-void PellucidHandlers::Get_restoredwhen_doubleclicked()
+// Subclasses window and returns its previous window procedure, or zero on failure
+// NOTE: Window may still have our procedure from a detach that couldn't take it out. Then that
+//		 one is taken back into use, rather than being put in chain a second time.
+LONG_PTR PellucidHandlers::subclassWindow(HWND hwnd, WNDPROC wndProc)
 {
-	if (Settings::getRestoreWhenSetting() == Settings::RestoreWhen::doubleClicked)
-		return;
+	auto hPrevWndProc = reinterpret_cast<LONG_PTR>(GetProp(hwnd, PROP_PREVWNDPROC));
+	if (hPrevWndProc)
+	{
+		RemoveProp(hwnd, PROP_PREVWNDPROC);
+		InterlockedDecrement(&g_cDllRef);	// Was held by window while stranded
+		return hPrevWndProc;
+	}
 
-	Settings::setRestoreWhenSetting(Settings::RestoreWhen::doubleClicked);
+	hPrevWndProc = GetWindowLongPtr(hwnd, GWLP_WNDPROC);
+	if (!hPrevWndProc || !SetWindowLongPtr(hwnd, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(wndProc)))
+		return 0;
 
-	ResetTimer();
+	return hPrevWndProc;
 }
 
-void PellucidHandlers::To_fulltransparency()
+// Puts back previous window procedure, returns false if somebody subclassed window on top of us
+// CAUTION: Then their window procedure still calls ours, so ours has to stay in chain and this DLL
+//			loaded until window is gone. As detach only comes on 'WM_DESTROY', there is no later
+//			chance to take ours out. So window holds a reference on DLL until 'WM_NCDESTROY', see
+//			'StrandedWindow_WndProc()'.
+bool PellucidHandlers::unsubclassWindow(HWND hwnd, WNDPROC wndProc, LONG_PTR hPrevWndProc)
 {
-	if (Settings::getToSetting() == Settings::To::fullTransparency)
-		return;
+	if (GetWindowLongPtr(hwnd, GWLP_WNDPROC) == reinterpret_cast<LONG_PTR>(wndProc) &&
+		SetWindowLongPtr(hwnd, GWLP_WNDPROC, hPrevWndProc))
+	{
+		return true;
+	}
 
-	Settings::setToSetting(Settings::To::fullTransparency);
+	InterlockedIncrement(&g_cDllRef);
+	SetProp(hwnd, PROP_PREVWNDPROC, reinterpret_cast<HANDLE>(hPrevWndProc));	// NOTE: If this fails, DLL just stays loaded for good
+	return false;
+}
 
-	ResetTimer();
+void PellucidHandlers::KillTimer()
+{
+	s_engine.Stop();
+}
+
+void PellucidHandlers::ResetTimer()
+{
+	s_engine.ResetTimer();
 }
 
-void PellucidHandlers::To_semitransparency()
+void PellucidHandlers::RestartTimer()
 {
-	if (Settings::getToSetting() == Settings::To::semiTransparency)
+	if (!s_timerIdle.Create() || !s_timerFade.Create())
+	{
+		s_engine.Stop();	// Reset window opacity
 		return;
+	}
+
+	auto interval = Settings::convertInToMillisecs(Settings::getInSetting());
+	s_engine.Start(interval);
+}
 
-	Settings::setToSetting(Settings::To::semiTransparency);
+#pragma endregion
 
-	ResetTimer();
+void PellucidHandlers::PellucidIconsTimer_ThreadFunc(PVOID lpParameter)
+{
+	METRICS_INCREMENT(counterTimerWakeup);
+	s_engine.OnIdleTimer(Settings::getSnapshot());	// NOTE: One consistent read, menu thread may be writing
 }
 
-void PellucidHandlers::Are_Enabled()
+void PellucidHandlers::FadeTimer_ThreadFunc(PVOID lpParameter)
 {
-	// Toggle with current setting
-	auto toEnable = !Settings::getIsEnabled();	// NOTE: 'toEnable' is new requested setting
-	Settings::setIsEnabled(toEnable);
+	METRICS_INCREMENT(counterTimerWakeup);
+	s_engine.OnFrameTimer();
+}
 
-	// Depending on current setting
-	if (toEnable == true)
-		ResetTimer();
-	else
-		KillTimer();
+void PellucidHandlers::AttachTimer_ThreadFunc(PVOID lpParameter)
+{
+	METRICS_INCREMENT(counterTimerWakeup);
+	s_attacher.OnTimer();
 }
 
-void PellucidHandlers::KillTimer()
+// Desktop was covered or uncovered, locked, turned off or disconnected, or the other way round
+// NOTE: Nothing wakes up while it can't be seen. On return, engine re-reads opacity and starts
+//		 idle countdown over, and attacher checks its window at once.
+void PellucidHandlers::Visibility_Changed(bool bVisible, void *pContext)
 {
-	if (s_heventExitThreadFunc)
+	if (bVisible)
 	{
-		if (s_hWaitThread)
-		{
-			SetEvent(s_heventExitThreadFunc);									// Ask thread to terminate
-			UnregisterWait(s_hWaitThread), s_hWaitThread = NULL;				// Close handle
-			CloseHandle(s_heventExitThreadFunc), s_heventExitThreadFunc = NULL;	// Close event handle
-		}
+		s_attacher.Resume();
+		s_engine.Resume();
+	}
+	else
+	{
+		s_engine.Suspend();
+		s_attacher.Suspend();
 	}
-
-	// Reset window opacity
-	SetLayeredWindowAttributes(s_hwndShellWindow, NULL, 0xFF, LWA_ALPHA);
 }
 
-void PellucidHandlers::ResetTimer()
+LRESULT CALLBACK PellucidHandlers::ShellWindow_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
-	KillTimer();
+	if (hwnd != s_hwndShellWindow)
+		return StrandedWindow_WndProc(hwnd, uMsg, wParam, lParam);
 
-	s_heventExitThreadFunc = CreateEvent(NULL, TRUE, FALSE, NULL);
+	METRICS_SCOPE(histogramWndProc);
 
-	if (s_heventExitThreadFunc)
+	// Opacity changes posted from other threads, see 'LayeredWindow'
+	// NOTE: Applied even while disabled, so that icons are always restored
+	if (uMsg == LayeredWindow::getApplyMessage())
 	{
-		auto interval = Settings::convertInToMillisecs(Settings::getInSetting());
-		RegisterWaitForSingleObject(&s_hWaitThread,
-									s_heventExitThreadFunc,
-									&PellucidIconsTimer_ThreadFunc,
-									NULL,
-									interval,
-									WT_EXECUTEDEFAULT | WT_EXECUTEONLYONCE);
+		s_layeredShellWindow.OnApplyMessage(wParam, lParam);
+		return 0;
 	}
-}
 
-#pragma endregion
+	auto settings = Settings::getSnapshot();	// NOTE: One atomic load for all settings
 
-VOID CALLBACK PellucidHandlers::PellucidIconsTimer_ThreadFunc(PVOID lpParameter, BOOLEAN TimerOrWaitFired)
-{
-	if (TimerOrWaitFired)	// If FALSE, exit event has been set so do nothing
+	// Catch up with store, selection and items only before input, as only input makes engine
+	// look at them
+	// NOTE: ListView gets a stream of paint, hit test and notification messages that don't need any of it
+	if ((uMsg >= WM_MOUSEFIRST && uMsg <= WM_MOUSELAST) || uMsg == WM_MOUSELEAVE)
+	{
+		RefreshFromStore();
+		if (s_hPrevShellViewWindowWndProc)
+			s_platformShellWindow.ValidateSelection();	// NOTE: Only walks items the first time
+		s_engine.ValidateItems(settings);			// NOTE: Same, and only with 'To::hoverReveal' setting
+
+		if (s_mouseTrace.IsAttached())
+			s_mouseTrace.Append(s_clock.Now(), uMsg, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+	}
+	
+	// NOTE: Keep trigger zones current even while disabled, so that they are right when enabled again.
+	//		 Messages are counted here too, for the same reason.
+	switch (uMsg)
 	{
-		// Timer tick
-		auto in = Settings::getInSetting();
-		auto restoreWhen = Settings::getRestoreWhenSetting();
-		auto to = Settings::getToSetting();
-
-		// For 'RestoreWhen::mousedEntersQuarterRegionOnLeft' setting, if mouse is still under third of the screen
-		// don't change icon transparency. Let it be as is.
-		if (restoreWhen == Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft &&
-			s_bIsMouseOnShellWindow)
+		case WM_DISPLAYCHANGE:
+		case WM_DPICHANGED_AFTERPARENT:
+			METRICS_INCREMENT(counterGeometryChanged);
+			s_engine.UpdateGeometry();
+			s_engine.OnItemsChanged();
+			break;
+
+		case WM_WINDOWPOSCHANGED:
+		{
+			METRICS_INCREMENT(counterGeometryChanged);
+			auto pWindowPos = reinterpret_cast<const WINDOWPOS *>(lParam);
+			if ((pWindowPos->flags & (SWP_NOMOVE | SWP_NOSIZE)) != (SWP_NOMOVE | SWP_NOSIZE))
+				s_engine.UpdateGeometry();
+			if ((pWindowPos->flags & SWP_NOSIZE) == 0)
+				s_engine.OnItemsChanged();	// ListView may rearrange its items
+		}
+		break;
+
+		case LVM_SETITEMPOSITION:
+		case LVM_SETITEMPOSITION32:
+		{
+			// Follow item moved, once ListView has moved it
+			METRICS_INCREMENT(counterOtherMessage);
+			auto result = CallWindowProc((WNDPROC)s_hPrevShellWindowWndProc, hwnd, uMsg, wParam, lParam);
+
+			Rect bounds;
+			if (s_platformShellWindow.getItemBounds(static_cast<int>(wParam), bounds))
+				s_engine.OnItemMoved(static_cast<int>(wParam), bounds);
+			else
+				s_engine.OnItemsChanged();
+
+			return result;
+		}
+
+		case LVM_ARRANGE:
+		case LVM_SETVIEW:
+		case LVM_SETICONSPACING:
+		case LVM_SETIMAGELIST:
+		case LVM_SETEXTENDEDLISTVIEWSTYLE:
+		case WM_SETFONT:
+		case WM_SETTINGCHANGE:
 		{
-			try
+			// Every item may have moved or changed size
+			METRICS_INCREMENT(counterOtherMessage);
+			auto result = CallWindowProc((WNDPROC)s_hPrevShellWindowWndProc, hwnd, uMsg, wParam, lParam);
+			s_engine.OnItemsChanged();
+
+			return result;
+		}
+
+		case WM_MOUSEMOVE:
+			METRICS_INCREMENT(counterMouseMove);
+			break;
+
+		case WM_MOUSELEAVE:
+			METRICS_INCREMENT(counterMouseLeave);
+			break;
+
+		case WM_LBUTTONDBLCLK:
+			METRICS_INCREMENT(counterDoubleClick);
+			break;
+
+		case WM_RBUTTONDOWN:
+			METRICS_INCREMENT(counterRightButtonDown);
+			break;
+
+		case WM_STYLECHANGED:
+			METRICS_INCREMENT(counterStyleChanged);
+			break;
+
+		case WM_PAINT:
+		{
+			// Icons may have changed, unless it was us changing layering
+			METRICS_INCREMENT(counterOtherMessage);
+			if (!s_layeredShellWindow.IsApplying())
 			{
-				if (s_queueMousePos.back().x <= s_quarterWidthShellWindow)
-					return;
+				s_layeredShellWindow.InvalidateSnapshot();
+				s_revealShellWindow.InvalidateCapture();
 			}
-			catch (...) {}
 		}
+		break;
 
-		// Change icon opacity depending on 'to' setting
-		auto to_transparency = (to == Settings::To::fullTransparency ? 0x00 : 0x5A);	// NOTE: About 35% opacity on semi-transparency setting
-
-		for (int i = 0xFF; i >= to_transparency; i -= 0x0F)
+		case WM_DESTROY:
 		{
-			// CAUTION: We don't let the transparency to be zero because then we will not receive
-			//			window events in our window procedure. Hence, the 'max()' below.
-			SetLayeredWindowAttributes(s_hwndShellWindow, NULL, (BYTE)max(i, 0x01), LWA_ALPHA);
-			Sleep(40);
+			// Possibly windows is shutting down or shell is replacing its view, so save settings,
+			// undo our changes and look for a new desktop ListView
+			METRICS_INCREMENT(counterOtherMessage);
+			auto prevWndProc = (WNDPROC)s_hPrevShellWindowWndProc;
+			Settings::Flush();
+			s_attacher.OnWindowDestroyed(hwnd);	// NOTE: Puts back previous window procedure
+
+			return CallWindowProc(prevWndProc, hwnd, uMsg, wParam, lParam);
 		}
+
+		default:
+			METRICS_INCREMENT(counterOtherMessage);
+			break;
 	}
-}
 
-LRESULT CALLBACK PellucidHandlers::ShellWindow_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
-{
-	auto isEnabled = Settings::getIsEnabled();
-	
-	if (isEnabled)
+	if (settings.isEnabled)
 	{
 		switch (uMsg)
 		{
 			case WM_MOUSEMOVE:
 			{
-				s_bIsMouseOnShellWindow = true;	// Mouse entered event
-				s_queueMousePos.push(POINT{ GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) });
-
-				auto settingRestoreWhen = Settings::getRestoreWhenSetting();
-				switch (settingRestoreWhen)
-				{
-					case Settings::RestoreWhen::mousedMoved:
-					{
-						// We have a history of mouse points so we use those to calculate a
-						// distance and compare with threshold
-						if (s_queueMousePos.size() < 2)
-							break;
-
-						auto last_it = s_queueMousePos.cbegin();
-						auto it = ++last_it;
-						int distance_x = 0, distance_y = 0;
-						for (; it != s_queueMousePos.cend(); last_it = it++)
-						{
-							distance_x += abs(it->x - last_it->x);
-							distance_y += abs(it->y - last_it->y);
-						}
-
-						const int DISTANCE_THRESHOLD = 50;
-						if (distance_x >= DISTANCE_THRESHOLD || distance_y >= DISTANCE_THRESHOLD)
-						{
-							// Ask timer thread to activate
-							ResetTimer();
-						}
-					}
-					break;
-
-					case Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft:
-					{
-						// Check if mouse entered quarter width for ShellWindow
-						if (GET_X_LPARAM(lParam) <= s_quarterWidthShellWindow)
-						{
-							// Ask timer thread to activate
-							ResetTimer();
-						}
-					}
-					break;
-
-					default:
-						break;
-				}
-
-				// If opacity is set at 0x01, don't let mouse move pass through
-				BYTE opacityShellWindow;
-				if (GetLayeredWindowAttributes(s_hwndShellWindow, NULL, &opacityShellWindow, NULL) != FALSE)
-				{
-					if (opacityShellWindow == 0x01)
-						return DefWindowProc(s_hwndShellWindow, uMsg, wParam, lParam);
-				}
+				// Capture icons for revealing them, before engine needs them
+				if (settings.to == Settings::To::hoverReveal && s_engine.IsHidden())
+					s_revealShellWindow.Prepare();
+
+				// If icons are hidden, don't let mouse move pass through
+				if (s_engine.OnMouseMove(GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), settings) == OverlayEngine::Disposition::swallow)
+					return DefWindowProc(s_hwndShellWindow, uMsg, wParam, lParam);
 			}
 			break;
 
 			case WM_MOUSELEAVE:	// Mouse has left the desktop window and probably on some application window
-			{
-				s_bIsMouseOnShellWindow = false;
-				s_queueMousePos.clear();
-			}
-			break;
+				s_engine.OnMouseLeave();
+				break;
 
 			case WM_LBUTTONDBLCLK:
 			{
-				auto settingRestoreWhen = Settings::getRestoreWhenSetting();
-				if (settingRestoreWhen == Settings::RestoreWhen::doubleClicked)
-				{
-					bool bCallDefProc = false;
-					BYTE opacityShellWindow;
-					if (GetLayeredWindowAttributes(s_hwndShellWindow, NULL, &opacityShellWindow, NULL) != FALSE)
-					{
-						if (opacityShellWindow == 0x01)
-							bCallDefProc = true;
-					}
-
-					// Ask timer thread to activate
-					ResetTimer();
-
-					if (bCallDefProc)
-						return DefWindowProc(s_hwndShellWindow, uMsg, wParam, lParam);
-				}
+				if (s_engine.OnDoubleClick(settings) == OverlayEngine::Disposition::swallow)
+					return DefWindowProc(s_hwndShellWindow, uMsg, wParam, lParam);
 			}
 			break;
 
 			case WM_RBUTTONDOWN:
 			{
 				// User is trying to invoke context menu
-				// If opacity is set at 0x01, don't let right click pass through
-				BYTE opacityShellWindow;
-				if (GetLayeredWindowAttributes(s_hwndShellWindow, NULL, &opacityShellWindow, NULL) != FALSE)
-				{
-					if (opacityShellWindow == 0x01)
-					{
-						// NOTE: The following is needed because if anything was selected before the icons
-						//		 were transparent, it invokes their context menu. We don't want this.
-						if (ListView_GetSelectedCount(s_hwndShellWindow) > 0)
-							ListView_SetItemState(s_hwndShellWindow, -1, FALSE, LVIS_SELECTED);
-
-						return DefWindowProc(s_hwndShellWindow, uMsg, wParam, lParam);
-					}
-				}
-
-				// Ask timer thread to activate
-				ResetTimer();
+				// If icons are hidden, don't let right click pass through
+				if (s_engine.OnRightButtonDown() == OverlayEngine::Disposition::swallow)
+					return DefWindowProc(s_hwndShellWindow, uMsg, wParam, lParam);
 			}
 			break;
 
-			case WM_DESTROY:
+			case WM_STYLECHANGED:
 			{
-				// Possibly windows is shutting down, so cleanup
-				KillTimer();
-
-				SetWindowLongPtr(s_hwndShellWindow, GWLP_WNDPROC, s_hPrevShellWindowWndProc);
+				// Someone else may have touched our layering, so re-read opacity
+				if (wParam == GWL_EXSTYLE && !s_layeredShellWindow.IsApplying())
+					s_engine.OnStyleChanged();
 			}
 			break;
 
@@ -639,4 +754,70 @@ LRESULT CALLBACK PellucidHandlers::ShellWindow_WndProc(HWND hwnd, UINT uMsg, WPA
 	}
 
 	return CallWindowProc((WNDPROC)s_hPrevShellWindowWndProc, hwnd, uMsg, wParam, lParam);
-}
\ No newline at end of file
+}
+
+// Follows selection and item changes of shell window, see 'Win32Platform::OnNotify()'
+LRESULT CALLBACK PellucidHandlers::ShellViewWindow_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	if (hwnd != s_hwndShellViewWindow)
+		return StrandedWindow_WndProc(hwnd, uMsg, wParam, lParam);
+
+	auto prevWndProc = (WNDPROC)s_hPrevShellViewWindowWndProc;
+	if (uMsg == WM_NOTIFY && reinterpret_cast<const NMHDR *>(lParam)->hwndFrom == s_hwndShellWindow)
+	{
+		auto pNotifyHeader = reinterpret_cast<const NMHDR *>(lParam);
+		s_platformShellWindow.OnNotify(pNotifyHeader);
+
+		// NOTE: Item is already inserted, but not yet deleted, when these are sent
+		switch (pNotifyHeader->code)
+		{
+			case LVN_INSERTITEM:
+			{
+				s_layeredShellWindow.InvalidateSnapshot();
+				s_revealShellWindow.InvalidateCapture();
+				auto index = reinterpret_cast<const NMLISTVIEW *>(pNotifyHeader)->iItem;
+				Rect bounds;
+				if (s_platformShellWindow.getItemBounds(index, bounds))
+					s_engine.OnItemInserted(index, bounds);
+				else
+					s_engine.OnItemsChanged();
+			}
+			break;
+
+			case LVN_DELETEITEM:
+				s_layeredShellWindow.InvalidateSnapshot();
+				s_revealShellWindow.InvalidateCapture();
+				s_engine.OnItemDeleted(reinterpret_cast<const NMLISTVIEW *>(pNotifyHeader)->iItem);
+				break;
+
+			case LVN_DELETEALLITEMS:
+				s_layeredShellWindow.InvalidateSnapshot();
+				s_revealShellWindow.InvalidateCapture();
+				s_engine.OnItemsChanged();
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	return CallWindowProc(prevWndProc, hwnd, uMsg, wParam, lParam);
+}
+
+// Only passes messages on, for a window whose subclass couldn't be taken out on detach
+LRESULT PellucidHandlers::StrandedWindow_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	auto prevWndProc = reinterpret_cast<WNDPROC>(GetProp(hwnd, PROP_PREVWNDPROC));
+	if (!prevWndProc)
+		return DefWindowProc(hwnd, uMsg, wParam, lParam);	// NOTE: Only if property couldn't be set
+
+	auto result = CallWindowProc(prevWndProc, hwnd, uMsg, wParam, lParam);
+	if (uMsg == WM_NCDESTROY)
+	{
+		// Last message window gets, so our window procedure is no longer called
+		RemoveProp(hwnd, PROP_PREVWNDPROC);
+		InterlockedDecrement(&g_cDllRef);	// Taken by 'unsubclassWindow()'
+	}
+
+	return result;
+}
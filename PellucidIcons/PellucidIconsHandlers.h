@@ -1,11 +1,26 @@
 #pragma once
 
-#include "sized_queue.h"
+#include "LayeredWindow.h"
+#include "MappedFile.h"
+#include "MenuTemplate.h"
+#include "Metrics.h"
+#include "MouseTrace.h"
+#include "OverlayEngine.h"
+#include "RevealOverlay.h"
+#include "ShellAttacher.h"
+#include "Commands.h"
+#include "ThreadpoolTimer.h"
+#include "VisibilityMonitor.h"
+#include "VisibilityOracle.h"
+#include "Win32Platform.h"
 #include <windows.h>
 #include <shlobj.h>
 #include <map>
+#include <mutex>
 #include <utility>
 
+#define PROP_PREVWNDPROC	L"PellucidIcons.PrevWndProc"	// Window property of windows we couldn't unsubclass
+
 
 class PellucidHandlers : public IShellIconOverlayIdentifier, public IContextMenu, public IShellExtInit
 {
@@ -30,6 +45,8 @@ public:
 	// IShellExtInit
 	IFACEMETHODIMP Initialize(PCIDLIST_ABSOLUTE pidlFolder, IDataObject *pdtobj, HKEY hkeyProgID);
 
+	static void Unload();			// IMPORTANT: Call before DLL is unloaded, see 'DllCanUnloadNow()'
+
 protected:
 	~PellucidHandlers(void);
 
@@ -37,42 +54,55 @@ private:
 	// Instance variable
 	long m_cRef;					// Reference count of component
 
-	// Mapping from menu item index to associated handler
-	std::map<int, void(PellucidHandlers::*)()> m_mapHandlers;
-
 	// Functions to handle user selections
-	void In_5secs();
-	void In_10secs();
-	void In_20secs();
-	void In_30secs();
-	void In_1min();
-	void In_2mins();
-
-	void Get_restoredwhen_mousemoved();
-	void Get_restoredwhen_mouseenterquarterregiononleft();
-	void Get_restoredwhen_doubleclicked();
-
-	void To_fulltransparency();
-	void To_semitransparency();
-
-	void Are_Enabled();		// Enable/Disable this extension
+	static bool IsCommandChecked(const CommandDescriptor& command, const Settings::Snapshot& settings);
+	static void ExecuteCommand(const CommandDescriptor& command);
 
 	// Utility functions
 	static void KillTimer();
 	static void ResetTimer();
+	static void RestartTimer();
+	static HBITMAP getIconBitmap();
+	static void RefreshFromStore();
+	static void UpdateMouseTrace(uint32_t kilobytes);
+	static bool AttachShellWindow(void *pWindow, void *pContext);
+	static void DetachShellWindow(void *pWindow, void *pContext);
+	static LONG_PTR subclassWindow(HWND hwnd, WNDPROC wndProc);
+	static bool unsubclassWindow(HWND hwnd, WNDPROC wndProc, LONG_PTR hPrevWndProc);
 
 	// Static variables
-	static bool s_bIsMouseOnShellWindow;
-	static sized_queue<POINT> s_queueMousePos;
 	static bool s_bPellucidIcons;
-	static HBITMAP s_hbitmapPellucidIcon;	// Application icon bitmap handle
-	static LONG s_quarterWidthShellWindow;
-	static HANDLE s_heventExitThreadFunc;
-	static HANDLE s_hWaitThread;
+	static std::map<UINT, HBITMAP> s_iconBitmaps;	// Application icon bitmap handle per DPI
+	static MenuTemplate s_menuTemplate;		// Cached context menu template
+	static std::mutex s_mutexMenu;
+	static uint32_t s_storeVersion;			// Of hot zones and tuning last given to 's_engine'. NOTE: Only touched from shell window's thread
+	static TickCountClock s_clock;
+	static ThreadpoolTimer s_timerIdle;	// Long-lived platform timer behind idle timer of 's_engine'
+	static ThreadpoolTimer s_timerFade;	// Frame timer of fade engine of 's_engine'
 	static HWND s_hwndShellWindow;
+	static Win32Platform s_platformShellWindow;
+	static LayeredWindow s_layeredShellWindow;
+	static OpacityLayering s_opacityShellWindow;	// NOTE: Layers shell window only while not opaque
+	static RevealOverlay s_revealShellWindow;	// Draws icons near mouse while shell window is hidden
+	static OverlayEngine s_engine;			// NOTE: All idle, fade and restore behavior lives here
 	static LONG_PTR s_hPrevShellWindowWndProc;
+	static HWND s_hwndShellViewWindow;		// Parent of shell window, which gets its notifications
+	static LONG_PTR s_hPrevShellViewWindowWndProc;
+	static MappedFile s_fileMouseTrace;
+	static MouseTraceWriter s_mouseTrace;		// NOTE: Only touched from shell window's thread
+	static MappedFile s_sharedMetrics;		// Named shared memory that 'Metrics' are published to
+	static ThreadpoolTimer s_timerAttach;
+	static Win32DesktopLocator s_desktopLocator;
+	static ShellAttacher s_attacher;		// NOTE: Finds desktop list-view and (re)subclasses it
+	static VisibilityOracle s_visibility;	// NOTE: All timers are suspended while desktop can't be seen
+	static VisibilityMonitor s_visibilityMonitor;
 
 	// Hook for mouse procedure
 	static LRESULT CALLBACK ShellWindow_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
-	static VOID CALLBACK PellucidIconsTimer_ThreadFunc(PVOID lpParameter, BOOLEAN TimerOrWaitFired);
+	static LRESULT CALLBACK ShellViewWindow_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+	static LRESULT StrandedWindow_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+	static void PellucidIconsTimer_ThreadFunc(PVOID lpParameter);
+	static void FadeTimer_ThreadFunc(PVOID lpParameter);
+	static void AttachTimer_ThreadFunc(PVOID lpParameter);
+	static void Visibility_Changed(bool bVisible, void *pContext);
 };
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "PixelKernels.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXELKERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+
+// Exact division by 255 with rounding, for 'x' up to 255 * 255
+static inline uint32_t divideBy255(uint32_t x)
+{
+	x += 0x80;
+	return (x + (x >> 8)) >> 8;
+}
+
+void PixelKernels::PremultiplyAlpha(uint32_t *pPixels, size_t count)
+{
+#ifdef PIXELKERNELS_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(0x80);
+	const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);		// Alpha lane of two pixels
+	const __m128i opaque = _mm_set_epi16(0xFF, 0, 0, 0, 0xFF, 0, 0, 0);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pPixels + i));
+
+		// Two pixels per register, as 16-bit lanes
+		__m128i lo = _mm_unpacklo_epi8(pixels, zero);
+		__m128i hi = _mm_unpackhi_epi8(pixels, zero);
+
+		// Broadcast alpha to all lanes of its pixel, alpha lane itself is multiplied by 255 so it stays unchanged
+		__m128i alphaLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		__m128i alphaHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		alphaLo = _mm_or_si128(_mm_andnot_si128(alphaMask, alphaLo), opaque);
+		alphaHi = _mm_or_si128(_mm_andnot_si128(alphaMask, alphaHi), opaque);
+
+		lo = _mm_add_epi16(_mm_mullo_epi16(lo, alphaLo), bias);
+		hi = _mm_add_epi16(_mm_mullo_epi16(hi, alphaHi), bias);
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pPixels + i), _mm_packus_epi16(lo, hi));
+	}
+
+	PremultiplyAlpha_Scalar(pPixels + i, count - i);	// Leftover pixels
+#else
+	PremultiplyAlpha_Scalar(pPixels, count);
+#endif
+}
+
+void PixelKernels::PremultiplyAlpha_Scalar(uint32_t *pPixels, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto pixel = pPixels[i];
+		auto alpha = pixel >> 24;
+
+		pPixels[i] = (alpha << 24) |
+					 (divideBy255(((pixel >> 16) & 0xFF) * alpha) << 16) |
+					 (divideBy255(((pixel >> 8) & 0xFF) * alpha) << 8) |
+					 divideBy255((pixel & 0xFF) * alpha);
+	}
+}
+
+void PixelKernels::CopyWithAlpha(const uint32_t *pSource, uint32_t *pDestination, size_t count, uint8_t alpha)
+{
+	if (alpha == 0)
+	{
+		memset(pDestination, 0, count * sizeof(pDestination[0]));	// Premultiplied, so all channels are zero
+		return;
+	}
+	if (alpha == 0xFF)
+	{
+		memcpy(pDestination, pSource, count * sizeof(pDestination[0]));
+		return;
+	}
+
+#ifdef PIXELKERNELS_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(0x80);
+	const __m128i factor = _mm_set1_epi16(alpha);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSource + i));
+
+		// Two pixels per register, as 16-bit lanes
+		__m128i lo = _mm_unpacklo_epi8(pixels, zero);
+		__m128i hi = _mm_unpackhi_epi8(pixels, zero);
+
+		lo = _mm_add_epi16(_mm_mullo_epi16(lo, factor), bias);
+		hi = _mm_add_epi16(_mm_mullo_epi16(hi, factor), bias);
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pDestination + i), _mm_packus_epi16(lo, hi));
+	}
+
+	CopyWithAlpha_Scalar(pSource + i, pDestination + i, count - i, alpha);	// Leftover pixels
+#else
+	CopyWithAlpha_Scalar(pSource, pDestination, count, alpha);
+#endif
+}
+
+void PixelKernels::CopyWithAlpha_Scalar(const uint32_t *pSource, uint32_t *pDestination, size_t count, uint8_t alpha)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto pixel = pSource[i];
+
+		pDestination[i] = (divideBy255((pixel >> 24) * alpha) << 24) |
+						  (divideBy255(((pixel >> 16) & 0xFF) * alpha) << 16) |
+						  (divideBy255(((pixel >> 8) & 0xFF) * alpha) << 8) |
+						  divideBy255((pixel & 0xFF) * alpha);
+	}
+}
+
+void PixelKernels::ExtractAlpha(const uint32_t *pOnBlack, const uint32_t *pOnWhite, uint32_t *pDestination, size_t count)
+{
+#ifdef PIXELKERNELS_SSE2
+	const __m128i lowByte = _mm_set1_epi32(0xFF);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i onBlack = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pOnBlack + i));
+		__m128i onWhite = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pOnWhite + i));
+
+		// Largest difference of color channels ends up in low byte of each pixel
+		__m128i difference = _mm_subs_epu8(onWhite, onBlack);
+		difference = _mm_max_epu8(difference, _mm_max_epu8(_mm_srli_epi32(difference, 8), _mm_srli_epi32(difference, 16)));
+		__m128i alpha = _mm_sub_epi32(lowByte, _mm_and_si128(difference, lowByte));
+
+		// Color can't exceed alpha once premultiplied, which also clears alpha lane for it to be put in
+		__m128i alphaColor = _mm_or_si128(alpha, _mm_or_si128(_mm_slli_epi32(alpha, 8), _mm_slli_epi32(alpha, 16)));
+		__m128i pixels = _mm_or_si128(_mm_min_epu8(onBlack, alphaColor), _mm_slli_epi32(alpha, 24));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pDestination + i), pixels);
+	}
+
+	ExtractAlpha_Scalar(pOnBlack + i, pOnWhite + i, pDestination + i, count - i);	// Leftover pixels
+#else
+	ExtractAlpha_Scalar(pOnBlack, pOnWhite, pDestination, count);
+#endif
+}
+
+void PixelKernels::ExtractAlpha_Scalar(const uint32_t *pOnBlack, const uint32_t *pOnWhite, uint32_t *pDestination, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint32_t difference = 0;
+		for (int shift = 0; shift < 24; shift += 8)
+		{
+			auto black = (pOnBlack[i] >> shift) & 0xFF;
+			auto white = (pOnWhite[i] >> shift) & 0xFF;
+			if (white > black && white - black > difference)
+				difference = white - black;
+		}
+
+		auto alpha = 0xFF - difference;
+		auto pixel = alpha << 24;
+		for (int shift = 0; shift < 24; shift += 8)
+		{
+			auto black = (pOnBlack[i] >> shift) & 0xFF;
+			pixel |= (black < alpha ? black : alpha) << shift;
+		}
+		pDestination[i] = pixel;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+// Kernels over 32-bit BGRA pixels
+class PixelKernels
+{
+public:
+	// Multiplies color channels by alpha, rounding like GDI does ('(c * a + 127) / 255')
+	// NOTE: Uses SSE2 when available, four pixels at a time
+	static void PremultiplyAlpha(uint32_t *pPixels, size_t count);
+	static void PremultiplyAlpha_Scalar(uint32_t *pPixels, size_t count);	// Reference implementation
+
+	// Copies premultiplied pixels, multiplying all channels by given alpha
+	static void CopyWithAlpha(const uint32_t *pSource, uint32_t *pDestination, size_t count, uint8_t alpha);
+	static void CopyWithAlpha_Scalar(const uint32_t *pSource, uint32_t *pDestination, size_t count, uint8_t alpha);
+
+	// Recovers premultiplied pixels from two renders of the same content, over black and over white
+	// NOTE: Alpha is what is left of background, '255 - max(white - black)' over color channels.
+	//		 Alpha of renders is ignored, as GDI leaves it undefined. Destination may be 'pOnBlack'.
+	static void ExtractAlpha(const uint32_t *pOnBlack, const uint32_t *pOnWhite, uint32_t *pDestination, size_t count);
+	static void ExtractAlpha_Scalar(const uint32_t *pOnBlack, const uint32_t *pOnWhite, uint32_t *pDestination, size_t count);
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include "Geometry.h"
+#include <cstddef>
+
+
+// Window services the overlay engine needs from the platform
+// NOTE: Opacity, timers and clock have their own interfaces, see 'FadeEngine::Backend' and 'Timing.h'
+class Platform
+{
+public:
+	virtual ~Platform() {}
+
+	// Window, in its client coordinates
+	virtual bool getClientBounds(Rect& bounds) = 0;
+	virtual size_t getMonitorBounds(Rect monitors[], size_t maxCount) = 0;
+
+	// List-view
+	virtual size_t getSelectedCount() = 0;
+	virtual void ClearSelection() = 0;
+	virtual size_t getItemCount() = 0;
+	virtual bool getItemBounds(int index, Rect& bounds) = 0;	// Icon and label, in window's client coordinates
+};
@@ -0,0 +1,67 @@
+#include "RegionTracker.h"
+
+
+RegionTracker::RegionTracker()
+	: m_bInside(false),
+	m_bLeaving(false),
+	m_leavingSince(0),
+	m_cTransitions(0)
+{
+}
+
+RegionTracker::Transition RegionTracker::Update(bool bInside, bool bInsideBand, uint64_t now, uint32_t dwellMillisecs)
+{
+	if (!m_bInside)
+	{
+		if (!bInside)
+			return Transition::none;
+
+		m_bInside = true;
+		++m_cTransitions;
+		return Transition::entered;
+	}
+
+	if (bInsideBand)
+	{
+		m_bLeaving = false;		// Came back before dwell time was over
+		return Transition::none;
+	}
+
+	if (!m_bLeaving)
+	{
+		m_bLeaving = true;
+		m_leavingSince = now;
+		if (dwellMillisecs > 0)
+			return Transition::leaving;
+	}
+
+	if (now - m_leavingSince < dwellMillisecs)
+		return Transition::none;
+
+	m_bInside = false;
+	m_bLeaving = false;
+	++m_cTransitions;
+
+	return Transition::left;
+}
+
+void RegionTracker::Reset()
+{
+	m_bInside = false;
+	m_bLeaving = false;
+}
+
+bool RegionTracker::IsInside() const
+{
+	return m_bInside;
+}
+
+bool RegionTracker::IsLeaving() const
+{
+	return m_bLeaving;
+}
+
+uint64_t RegionTracker::getTransitionCount() const
+{
+	return m_cTransitions;
+}
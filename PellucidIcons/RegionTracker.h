@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+
+// Edge-triggered enter/leave detector for region policies
+// NOTE: Reports a transition only once per entry or exit. To leave, the mouse must get out of
+//		 the region grown by a hysteresis band, so jitter on the boundary doesn't flap.
+//
+//		 Entering is reported at once, so it never waits for a mouse move that may not come.
+//		 Leaving is reported at once as 'leaving', and as 'left' only once the mouse has stayed
+//		 out for the minimum dwell time. Coming back in between is no transition at all.
+class RegionTracker
+{
+public:
+	enum class Transition
+	{
+		none,
+		entered,
+		leaving,				// Out of band, but may still come back within dwell time
+		left
+	};
+
+	RegionTracker();
+
+	// 'bInsideBand' is whether point is inside region grown by hysteresis band, only looked at
+	// while inside
+	Transition Update(bool bInside, bool bInsideBand, uint64_t now, uint32_t dwellMillisecs);
+	void Reset();
+
+	bool IsInside() const;		// Still true while leaving
+	bool IsLeaving() const;
+	uint64_t getTransitionCount() const;	// Entries and confirmed exits
+
+private:
+	bool m_bInside;
+	bool m_bLeaving;			// Is leaving waiting for dwell time?
+	uint64_t m_leavingSince;
+	uint64_t m_cTransitions;
+};
@@ -0,0 +1,193 @@
+#include "RegistrySettingsStore.h"
+
+#ifndef REG_NOTIFY_THREAD_AGNOSTIC
+#define REG_NOTIFY_THREAD_AGNOSTIC		0x10000000L
+#endif
+
+#define MAX_READVALUES					64		// NOTE: Enough for all hot zones in one read
+
+
+RegistrySettingsStore::RegistrySettingsStore(HKEY hkeyRoot, LPCWSTR szKeyPath)
+	: m_hkeyRoot(hkeyRoot),
+	m_szKeyPath(szKeyPath),
+	m_hkey(NULL),
+	m_heventChanged(NULL),
+	m_hWait(NULL),
+	m_callback(NULL),
+	m_pContext(NULL)
+{
+}
+
+// CAUTION: Static instances are destroyed at DLL detach under loader lock, where waiting for a change
+//			callback may deadlock. So 'Close()' must be called before unload, and here we only stop further
+//			callbacks without waiting.
+RegistrySettingsStore::~RegistrySettingsStore()
+{
+	if (m_hWait)
+	{
+		UnregisterWaitEx(m_hWait, NULL), m_hWait = NULL;	// Doesn't wait
+
+		// NOTE: A callback may still be running and using the event and key, so leave them to process exit
+		return;
+	}
+
+	Close();
+}
+
+void RegistrySettingsStore::Close()
+{
+	if (m_hWait)
+		UnregisterWaitEx(m_hWait, INVALID_HANDLE_VALUE), m_hWait = NULL;	// Wait for running callback
+
+	if (m_heventChanged)
+		CloseHandle(m_heventChanged), m_heventChanged = NULL;
+
+	auto hkey = m_hkey.exchange(NULL);
+	if (hkey)
+		RegCloseKey(hkey);
+}
+
+bool RegistrySettingsStore::ReadValues(const wchar_t *const names[], uint32_t values[], size_t count)
+{
+	auto hkey = open();
+	if (!hkey || count > MAX_READVALUES)
+		return false;
+
+	// Try to read all values in one round trip
+	VALENT valents[MAX_READVALUES] = { 0 };
+	DWORD buffer[MAX_READVALUES];
+	DWORD cbBuffer = sizeof(buffer);
+	for (size_t i = 0; i < count; ++i)
+		valents[i].ve_valuename = const_cast<LPWSTR>(names[i]);
+
+	if (RegQueryMultipleValues(hkey, valents, (DWORD)count, (LPWSTR)buffer, &cbBuffer) == ERROR_SUCCESS)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (valents[i].ve_type == REG_DWORD && valents[i].ve_valuelen == sizeof(DWORD))
+				values[i] = *(const DWORD *)valents[i].ve_valueptr;
+		}
+
+		return true;
+	}
+
+	// NOTE: Above fails if any value is missing, so fall back to reading one by one
+	for (size_t i = 0; i < count; ++i)
+	{
+		DWORD Type;
+		DWORD Data;
+		DWORD cbData = sizeof(Data);
+
+		if (RegQueryValueEx(hkey, names[i], NULL, &Type, (LPBYTE)&Data, &cbData) == ERROR_SUCCESS &&
+			Type == REG_DWORD && cbData == sizeof(DWORD))
+		{
+			values[i] = Data;
+		}
+	}
+
+	return true;
+}
+
+bool RegistrySettingsStore::WriteValue(const wchar_t *name, uint32_t value)
+{
+	auto hkey = open();
+	if (!hkey)
+		return false;
+
+	DWORD Data = value;
+	return (RegSetValueEx(hkey, name, NULL, REG_DWORD, (const BYTE *)&Data, sizeof(Data)) == ERROR_SUCCESS);
+}
+
+bool RegistrySettingsStore::WriteValues(const wchar_t *const names[], const uint32_t values[], size_t count)
+{
+	auto hkey = open();
+	if (!hkey)
+		return false;
+
+	bool bSucceeded = true;
+	for (size_t i = 0; i < count; ++i)
+	{
+		DWORD Data = values[i];
+		bSucceeded &= (RegSetValueEx(hkey, names[i], NULL, REG_DWORD, (const BYTE *)&Data, sizeof(Data)) == ERROR_SUCCESS);
+	}
+
+	return bSucceeded;
+}
+
+bool RegistrySettingsStore::Watch(ChangeCallback callback, void *pContext)
+{
+	if (m_hWait)
+		return true;	// Already watching
+
+	if (!open())
+		return false;
+
+	m_callback = callback;
+	m_pContext = pContext;
+
+	m_heventChanged = CreateEvent(NULL, FALSE, FALSE, NULL);	// Auto reset
+	if (!m_heventChanged)
+		return false;
+
+	if (!armNotification() ||
+		!RegisterWaitForSingleObject(&m_hWait, m_heventChanged, &KeyChanged_Callback, this, INFINITE, WT_EXECUTEDEFAULT))
+	{
+		m_hWait = NULL;
+		CloseHandle(m_heventChanged), m_heventChanged = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+// Returns cached key, opening it on first use
+// NOTE: Reads, flushes and change notifications come on different threads, so two of them may
+//		 open the key at once. Only the first handle is published and the other one is closed.
+HKEY RegistrySettingsStore::open()
+{
+	auto hkey = m_hkey.load(std::memory_order_acquire);
+	if (hkey)
+		return hkey;
+
+	// Create key if it doesn't exists
+	// NOTE: If both 'Pellucid' and its subkey 'Settings' doesn't exist, the 'RegCreateKeyEx()' function creates both
+	if (RegCreateKeyEx(m_hkeyRoot,
+						m_szKeyPath,
+						NULL,
+						NULL,
+						REG_OPTION_NON_VOLATILE,
+						KEY_READ | KEY_WRITE,
+						NULL,
+						&hkey, NULL) != ERROR_SUCCESS)
+	{
+		return NULL;
+	}
+
+	HKEY hkeyPublished = NULL;
+	if (!m_hkey.compare_exchange_strong(hkeyPublished, hkey, std::memory_order_acq_rel, std::memory_order_acquire))
+	{
+		RegCloseKey(hkey);	// Lost the race, so use winner's key
+		return hkeyPublished;
+	}
+
+	return hkey;
+}
+
+bool RegistrySettingsStore::armNotification()
+{
+	// NOTE: Notification is one shot, so this is called again each time it fires. Being thread agnostic,
+	//		 it is not cancelled when the thread pool thread which armed it exits.
+	return (RegNotifyChangeKeyValue(m_hkey.load(std::memory_order_acquire),
+									FALSE,
+									REG_NOTIFY_CHANGE_LAST_SET | REG_NOTIFY_THREAD_AGNOSTIC,
+									m_heventChanged,
+									TRUE) == ERROR_SUCCESS);
+}
+
+VOID CALLBACK RegistrySettingsStore::KeyChanged_Callback(PVOID lpParameter, BOOLEAN TimerOrWaitFired)
+{
+	auto pThis = static_cast<RegistrySettingsStore *>(lpParameter);
+
+	pThis->armNotification();
+	pThis->m_callback(pThis->m_pContext);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "SettingsStore.h"
+#include <Windows.h>
+#include <atomic>
+
+
+// Settings store under a registry key
+// NOTE: The key is opened once and its handle cached for the lifetime of this object
+class RegistrySettingsStore : public SettingsStore
+{
+public:
+	RegistrySettingsStore(HKEY hkeyRoot, LPCWSTR szKeyPath);
+	virtual ~RegistrySettingsStore();
+
+	// SettingsStore
+	virtual bool ReadValues(const wchar_t *const names[], uint32_t values[], size_t count);
+	virtual bool WriteValue(const wchar_t *name, uint32_t value);
+	virtual bool WriteValues(const wchar_t *const names[], const uint32_t values[], size_t count);
+	virtual bool Watch(ChangeCallback callback, void *pContext);
+	virtual void Close();
+
+private:
+	HKEY open();
+	bool armNotification();
+
+	HKEY m_hkeyRoot;
+	LPCWSTR m_szKeyPath;
+	std::atomic<HKEY> m_hkey;
+	HANDLE m_heventChanged;
+	HANDLE m_hWait;
+	ChangeCallback m_callback;
+	void *m_pContext;
+
+	static VOID CALLBACK KeyChanged_Callback(PVOID lpParameter, BOOLEAN TimerOrWaitFired);
+};
@@ -0,0 +1,293 @@
+#include "RevealOverlay.h"
+#include "PixelKernels.h"
+#include <cstring>
+
+extern HINSTANCE g_hInst;
+
+// Static variables
+ATOM RevealOverlay::s_atomOverlayClass = 0;
+
+
+RevealOverlay::RevealOverlay()
+	: m_hwnd(NULL),
+	m_hwndOverlay(NULL),
+	m_hdcFrame(NULL),
+	m_hbitmapFrame(NULL),
+	m_hbitmapFrameOld(NULL),
+	m_hbitmapCapture(NULL),
+	m_hbitmapOnWhite(NULL),
+	m_pFramePixels(NULL),
+	m_pCapturePixels(NULL),
+	m_pOnWhitePixels(NULL),
+	m_width(0),
+	m_height(0),
+	m_bCaptured(false),
+	m_bShown(false)
+{
+	SetRectEmpty(&m_rectRevealed);
+}
+
+void RevealOverlay::setWindow(HWND hwnd)
+{
+	if (hwnd == m_hwnd)
+		return;
+
+	// NOTE: Overlay may already be gone, with its parent
+	if (m_hwndOverlay && IsWindow(m_hwndOverlay))
+		DestroyWindow(m_hwndOverlay);
+	m_hwndOverlay = NULL;
+	m_bShown = false;
+	releaseBitmaps();
+
+	m_hwnd = hwnd;
+}
+
+// Captures client area of window without its background, from which revealed items are copied
+// NOTE: Items already revealed keep showing previous capture until they change again
+bool RevealOverlay::Prepare()
+{
+	if (m_bCaptured)
+		return true;
+
+	RECT rectClient;
+	if (!m_hwnd || GetClientRect(m_hwnd, &rectClient) == FALSE)
+		return false;
+
+	if (!createBitmaps(rectClient.right - rectClient.left, rectClient.bottom - rectClient.top))
+		return false;
+
+	auto hdcCapture = CreateCompatibleDC(NULL);
+	if (!hdcCapture)
+		return false;
+
+	// NOTE: Whatever differs between window drawn over black and over white is background showing through
+	//		 its items, so that is what becomes transparent. Should window draw an opaque background even so,
+	//		 both are alike and items are revealed with it, as with a plain capture.
+	auto bRendered = render(hdcCapture, m_hbitmapCapture, m_pCapturePixels, 0x00) &&
+					 render(hdcCapture, m_hbitmapOnWhite, m_pOnWhitePixels, 0xFF);
+	DeleteDC(hdcCapture);
+	if (!bRendered)
+		return false;
+
+	PixelKernels::ExtractAlpha(m_pCapturePixels, m_pOnWhitePixels, m_pCapturePixels, static_cast<size_t>(m_width) * m_height);
+	m_bCaptured = true;
+
+	return true;
+}
+
+void RevealOverlay::InvalidateCapture()
+{
+	m_bCaptured = false;
+}
+
+void RevealOverlay::UnregisterOverlayClass()
+{
+	if (s_atomOverlayClass && UnregisterClass(MAKEINTATOM(s_atomOverlayClass), g_hInst))
+		s_atomOverlayClass = 0;
+}
+
+// Copies changed items from capture to frame and presents only their part of frame
+void RevealOverlay::ApplyReveal(const HoverReveal::Change changes[], size_t count)
+{
+	if (!m_bCaptured)
+		return;
+
+	RECT rectBounds = { 0, 0, m_width, m_height };
+	RECT rectDirty = { 0 };
+	for (size_t i = 0; i < count; ++i)
+	{
+		RECT rectItem = { changes[i].rect.left, changes[i].rect.top, changes[i].rect.right, changes[i].rect.bottom };
+		if (IntersectRect(&rectItem, &rectItem, &rectBounds) == FALSE)
+			continue;
+
+		for (auto y = rectItem.top; y < rectItem.bottom; ++y)
+		{
+			auto offset = static_cast<size_t>(y) * m_width + rectItem.left;
+			PixelKernels::CopyWithAlpha(m_pCapturePixels + offset, m_pFramePixels + offset, rectItem.right - rectItem.left, changes[i].alpha);
+		}
+
+		UnionRect(&rectDirty, &rectDirty, &rectItem);
+	}
+
+	if (IsRectEmpty(&rectDirty) == FALSE)
+	{
+		UnionRect(&m_rectRevealed, &m_rectRevealed, &rectDirty);
+		present(&rectDirty);
+	}
+}
+
+void RevealOverlay::EndReveal()
+{
+	if (m_hwndOverlay && m_bShown)
+		ShowWindow(m_hwndOverlay, SW_HIDE);
+	m_bShown = false;
+
+	// NOTE: Capture and bitmaps are kept for next reveal, only what was revealed is cleared
+	clearFrame(m_rectRevealed);
+	SetRectEmpty(&m_rectRevealed);
+}
+
+bool RevealOverlay::createBitmaps(int width, int height)
+{
+	if (m_hbitmapFrame && width == m_width && height == m_height)
+		return true;
+
+	releaseBitmaps();
+	if (width <= 0 || height <= 0)
+		return false;
+
+	m_hdcFrame = CreateCompatibleDC(NULL);
+	m_hbitmapFrame = (m_hdcFrame ? createBitmap(m_hdcFrame, width, height, &m_pFramePixels) : NULL);
+	m_hbitmapCapture = (m_hbitmapFrame ? createBitmap(m_hdcFrame, width, height, &m_pCapturePixels) : NULL);
+	m_hbitmapOnWhite = (m_hbitmapCapture ? createBitmap(m_hdcFrame, width, height, &m_pOnWhitePixels) : NULL);
+	if (!m_hbitmapOnWhite)
+	{
+		releaseBitmaps();
+		return false;
+	}
+
+	m_hbitmapFrameOld = SelectObject(m_hdcFrame, m_hbitmapFrame);
+	m_width = width;
+	m_height = height;
+
+	// Frame starts with nothing revealed
+	RECT rectFrame = { 0, 0, width, height };
+	clearFrame(rectFrame);
+	return true;
+}
+
+void RevealOverlay::releaseBitmaps()
+{
+	if (m_hdcFrame)
+	{
+		if (m_hbitmapFrameOld)
+			SelectObject(m_hdcFrame, m_hbitmapFrameOld);
+		DeleteDC(m_hdcFrame);
+	}
+	if (m_hbitmapFrame)
+		DeleteObject(m_hbitmapFrame);
+	if (m_hbitmapCapture)
+		DeleteObject(m_hbitmapCapture);
+	if (m_hbitmapOnWhite)
+		DeleteObject(m_hbitmapOnWhite);
+
+	m_hdcFrame = NULL;
+	m_hbitmapFrame = NULL;
+	m_hbitmapFrameOld = NULL;
+	m_hbitmapCapture = NULL;
+	m_hbitmapOnWhite = NULL;
+	m_pFramePixels = NULL;
+	m_pCapturePixels = NULL;
+	m_pOnWhitePixels = NULL;
+	m_width = 0;
+	m_height = 0;
+	m_bCaptured = false;
+	SetRectEmpty(&m_rectRevealed);
+}
+
+// Has window draw its client area into bitmap, over a solid background
+bool RevealOverlay::render(HDC hdc, HBITMAP hbitmap, uint32_t *pPixels, uint8_t background)
+{
+	GdiFlush();		// IMPORTANT: Before pixels of DIB sections are touched directly
+	memset(pPixels, background, static_cast<size_t>(m_width) * m_height * sizeof(pPixels[0]));
+
+	// NOTE: Without 'PRF_ERASEBKGND' window draws only its items, also while it is layered
+	auto hbitmapOld = SelectObject(hdc, hbitmap);
+	if (!hbitmapOld)
+		return false;
+	SendMessage(m_hwnd, WM_PRINTCLIENT, reinterpret_cast<WPARAM>(hdc), PRF_CLIENT);
+	SelectObject(hdc, hbitmapOld);
+
+	GdiFlush();
+	return true;
+}
+
+void RevealOverlay::clearFrame(const RECT& rect)
+{
+	if (!m_pFramePixels || IsRectEmpty(&rect) != FALSE)
+		return;
+
+	GdiFlush();		// IMPORTANT: Before pixels of DIB sections are touched directly
+	for (auto y = rect.top; y < rect.bottom; ++y)
+		memset(m_pFramePixels + static_cast<size_t>(y) * m_width + rect.left, 0, (rect.right - rect.left) * sizeof(m_pFramePixels[0]));
+}
+
+// Shows frame on overlay, which is created and placed over window the first time
+// NOTE: Once shown, only dirty part of frame is given to compositor
+bool RevealOverlay::present(const RECT *pDirtyRect)
+{
+	if (!s_atomOverlayClass)
+		s_atomOverlayClass = registerOverlayClass();
+
+	auto hwndParent = GetParent(m_hwnd);
+	if (!s_atomOverlayClass || !hwndParent)
+		return false;
+
+	if (!m_hwndOverlay)
+	{
+		m_hwndOverlay = CreateWindowEx(WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_NOACTIVATE, MAKEINTATOM(s_atomOverlayClass), L"",
+									   WS_CHILD, 0, 0, 0, 0, hwndParent, NULL, g_hInst, NULL);
+		if (!m_hwndOverlay)
+			return false;
+	}
+
+	SIZE size = { m_width, m_height };
+	POINT pointSource = { 0, 0 };
+	BLENDFUNCTION blendFunction = { AC_SRC_OVER, 0, 0xFF, AC_SRC_ALPHA };
+
+	UPDATELAYEREDWINDOWINFO updateInfo = { sizeof(updateInfo) };
+	updateInfo.psize = &size;
+	updateInfo.hdcSrc = m_hdcFrame;
+	updateInfo.pptSrc = &pointSource;
+	updateInfo.pblend = &blendFunction;
+	updateInfo.dwFlags = ULW_ALPHA;
+	updateInfo.prcDirty = (m_bShown ? pDirtyRect : NULL);
+	if (UpdateLayeredWindowIndirect(m_hwndOverlay, &updateInfo) == FALSE)
+		return false;
+
+	if (!m_bShown)
+	{
+		POINT pointClient = { 0, 0 };
+		MapWindowPoints(m_hwnd, hwndParent, &pointClient, 1);
+		SetWindowPos(m_hwndOverlay, HWND_TOP, pointClient.x, pointClient.y, m_width, m_height, SWP_NOACTIVATE | SWP_SHOWWINDOW);
+		m_bShown = true;
+	}
+
+	return true;
+}
+
+HBITMAP RevealOverlay::createBitmap(HDC hdc, int width, int height, uint32_t **ppPixels)
+{
+	BITMAPINFO bitmapInfo = { 0 };
+	bitmapInfo.bmiHeader.biSize = sizeof(bitmapInfo.bmiHeader);
+	bitmapInfo.bmiHeader.biWidth = width;
+	bitmapInfo.bmiHeader.biHeight = -height;	// Top-down, so rows are in item coordinates
+	bitmapInfo.bmiHeader.biPlanes = 1;
+	bitmapInfo.bmiHeader.biBitCount = 32;
+	bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+	void *pBits = NULL;
+	auto hbitmap = CreateDIBSection(hdc, &bitmapInfo, DIB_RGB_COLORS, &pBits, NULL, 0);
+	*ppPixels = static_cast<uint32_t *>(pBits);
+
+	return hbitmap;
+}
+
+ATOM RevealOverlay::registerOverlayClass()
+{
+	WNDCLASSEX windowClass = { sizeof(windowClass) };
+	windowClass.lpfnWndProc = &Overlay_WndProc;
+	windowClass.hInstance = g_hInst;
+	windowClass.lpszClassName = L"PellucidIcons.RevealOverlay";
+
+	return RegisterClassEx(&windowClass);
+}
+
+LRESULT CALLBACK RevealOverlay::Overlay_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	// NOTE: Contents are given with 'UpdateLayeredWindowIndirect()', so there is nothing to paint
+	if (uMsg == WM_NCHITTEST)
+		return HTTRANSPARENT;	// Mouse goes through to window underneath
+
+	return DefWindowProc(hwnd, uMsg, wParam, lParam);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "HoverReveal.h"
+#include <Windows.h>
+
+
+// Draws revealed items of a hidden window on a per-pixel alpha overlay above it
+// NOTE: Items are copied from a capture of window taken by 'Prepare()', which also works while
+//		 window is layered and nearly transparent. Capture and bitmaps are kept between reveals, until
+//		 window changes. Must be called from window's thread, which owns overlay.
+class RevealOverlay : public HoverReveal::Backend
+{
+public:
+	RevealOverlay();
+
+	void setWindow(HWND hwnd);		// NOTE: Also destroys overlay of previous window
+	bool Prepare();					// Captures window unless capture is still valid, call before changes are applied
+	void InvalidateCapture();		// Window content changed, so next 'Prepare()' captures it again
+
+	static void UnregisterOverlayClass();	// IMPORTANT: Call before DLL is unloaded, once no window is set
+
+	// HoverReveal::Backend
+	virtual void ApplyReveal(const HoverReveal::Change changes[], size_t count);
+	virtual void EndReveal();
+
+private:
+	bool createBitmaps(int width, int height);
+	void releaseBitmaps();
+	bool render(HDC hdc, HBITMAP hbitmap, uint32_t *pPixels, uint8_t background);
+	void clearFrame(const RECT& rect);
+	bool present(const RECT *pDirtyRect);
+
+	static HBITMAP createBitmap(HDC hdc, int width, int height, uint32_t **ppPixels);
+
+	static ATOM registerOverlayClass();
+	static LRESULT CALLBACK Overlay_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+
+	static ATOM s_atomOverlayClass;	// NOTE: Registered when first needed, and again after being unregistered
+
+	HWND m_hwnd;
+	HWND m_hwndOverlay;
+	HDC m_hdcFrame;					// Frame bitmap is kept selected, it is what overlay shows
+	HBITMAP m_hbitmapFrame;
+	HGDIOBJ m_hbitmapFrameOld;
+	HBITMAP m_hbitmapCapture;
+	HBITMAP m_hbitmapOnWhite;		// Window rendered over white, only used while capturing
+	uint32_t *m_pFramePixels;		// Premultiplied, only revealed items aren't zero
+	uint32_t *m_pCapturePixels;		// Premultiplied, background of window is left out
+	uint32_t *m_pOnWhitePixels;
+	RECT m_rectRevealed;			// Part of frame which may not be zero, cleared when reveal ends
+	int m_width;
+	int m_height;
+	bool m_bCaptured;
+	bool m_bShown;
+};
@@ -0,0 +1,69 @@
+#include "SelectionSet.h"
+#include <algorithm>
+
+
+SelectionSet::SelectionSet()
+	: m_bValid(false)
+{
+}
+
+void SelectionSet::Clear()
+{
+	m_indices.clear();	// NOTE: Keeps capacity, so selecting again doesn't allocate
+	m_bValid.store(true, std::memory_order_relaxed);
+}
+
+void SelectionSet::Invalidate()
+{
+	m_bValid.store(false, std::memory_order_relaxed);
+}
+
+bool SelectionSet::IsValid() const
+{
+	return m_bValid.load(std::memory_order_relaxed);
+}
+
+void SelectionSet::Select(int index)
+{
+	auto it = std::lower_bound(m_indices.begin(), m_indices.end(), index);
+	if (it == m_indices.end() || *it != index)
+		m_indices.insert(it, index);
+}
+
+void SelectionSet::Deselect(int index)
+{
+	auto it = std::lower_bound(m_indices.begin(), m_indices.end(), index);
+	if (it != m_indices.end() && *it == index)
+		m_indices.erase(it);
+}
+
+void SelectionSet::OnInserted(int index)
+{
+	for (auto it = std::lower_bound(m_indices.begin(), m_indices.end(), index); it != m_indices.end(); ++it)
+		++*it;
+}
+
+void SelectionSet::OnDeleted(int index)
+{
+	auto it = std::lower_bound(m_indices.begin(), m_indices.end(), index);
+	if (it != m_indices.end() && *it == index)
+		it = m_indices.erase(it);
+
+	for (; it != m_indices.end(); ++it)
+		--*it;
+}
+
+size_t SelectionSet::getCount() const
+{
+	return m_indices.size();
+}
+
+bool SelectionSet::Contains(int index) const
+{
+	return std::binary_search(m_indices.begin(), m_indices.end(), index);
+}
+
+int SelectionSet::getLast() const
+{
+	return m_indices.back();
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+
+// Indices of selected items of a list, kept up to date from item change notifications
+// NOTE: Indices are kept sorted, so every update costs O(selected) at most, whatever the
+//		 number of items. When a change can't be followed, e.g. a change to all items at once,
+//		 set becomes invalid until it is rebuilt from the list.
+class SelectionSet
+{
+public:
+	SelectionSet();
+
+	void Clear();						// Nothing selected, and valid
+	void Invalidate();
+	bool IsValid() const;
+
+	void Select(int index);
+	void Deselect(int index);
+	void OnInserted(int index);			// Items at or after index move one up
+	void OnDeleted(int index);			// Items after index move one down
+
+	size_t getCount() const;
+	bool Contains(int index) const;
+	int getLast() const;				// CAUTION: Only if not empty
+
+private:
+	std::vector<int> m_indices;
+	std::atomic<bool> m_bValid;
+};
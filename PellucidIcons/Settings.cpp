@@ -1,127 +1,395 @@
 #include "Settings.h"
+#include "Metrics.h"
+#ifdef _WIN32
+#include "RegistrySettingsStore.h"
+#include "ThreadpoolTimer.h"
+#else
+#include "IniSettingsStore.h"
+#endif
+#include <cstring>
+#include <cwchar>
+
+#define FLUSH_DEBOUNCEMILLISECS		500
+#define DEFAULT_REGIONHYSTERESISPIXELS	8
+#define DEFAULT_REGIONDWELLMILLISECS	50
+#define DEFAULT_ACTIVITYQUANTUMMILLISECS	50
 
 
 // Static constants
-const WCHAR Settings::szSettingsKeyPath[] = L"SOFTWARE\\PellucidIcons\\Settings";
+const wchar_t Settings::szSettingsKeyPath[] = L"SOFTWARE\\PellucidIcons\\Settings";
+const wchar_t *const Settings::szValueNames[] = { L"In", L"RestoreWhen", L"To", L"Enabled" };	// NOTE: In order of 'Snapshot' fields
 
 // Static variables
-Settings::In Settings::InSetting = Settings::In();
-Settings::RestoreWhen Settings::RestoreWhenSetting = Settings::RestoreWhen();
-Settings::To Settings::ToSetting = Settings::To();
-bool Settings::IsEnabledSetting = true;
+std::atomic<uint64_t> Settings::PackedSettings(Settings::Snapshot{ Settings::In(), Settings::RestoreWhen(), Settings::To(), true }.pack());
+std::atomic<uint32_t> Settings::StoreVersion(1);
+std::atomic<uint32_t> Settings::PackedRegionTuning(DEFAULT_REGIONHYSTERESISPIXELS | DEFAULT_REGIONDWELLMILLISECS << 16);
+std::atomic<uint32_t> Settings::ActivityQuantum(DEFAULT_ACTIVITYQUANTUMMILLISECS);
+std::atomic<uint32_t> Settings::MouseTraceKilobytes(0);
+std::atomic<bool> Settings::SnapshotFade(false);
+std::mutex Settings::MutexHotZones;
+uint32_t Settings::PackedHotZones[SETTINGS_MAXHOTZONES] = { 0 };
+size_t Settings::HotZoneCount = 0;
 
 
 void Settings::ForceSettingsRefreshFromRegistry()
 {
-	InSetting = static_cast<In>(getSetting(L"In"));
-	RestoreWhenSetting = static_cast<RestoreWhen>(getSetting(L"RestoreWhen"));
-	ToSetting = static_cast<To>(getSetting(L"To"));
-	IsEnabledSetting = (getSetting(L"Enabled") > FALSE);
+	refreshSnapshot();
+	refreshTuning();
+	refreshHotZones();
+	StoreVersion.fetch_add(1, std::memory_order_release);
+
+	// From now on, only refresh when somebody else changes the settings
+	getStore().Watch(&SettingsStore_Changed, NULL);
+
+#ifdef _WIN32
+	// NOTE: If this fails, changes are flushed on 'Flush()' only
+	static_cast<ThreadpoolTimer&>(getFlushTimer()).Create();
+#endif
+}
+
+void Settings::Flush()
+{
+	getWriteBehind().Flush();
+}
+
+// NOTE: Flush timer and store are opened again by next 'ForceSettingsRefreshFromRegistry()', if module stays loaded
+void Settings::Close()
+{
+#ifdef _WIN32
+	static_cast<ThreadpoolTimer&>(getFlushTimer()).Close();	// Waits for a running flush
+#endif
+	getWriteBehind().Flush();
+	getStore().Close();
+}
+
+// Packed layout: byte 0 'In', byte 1 'RestoreWhen', byte 2 'To', byte 3 'Enabled'
+uint64_t Settings::Snapshot::pack() const
+{
+	return (static_cast<uint64_t>(static_cast<uint8_t>(in)) |
+			static_cast<uint64_t>(static_cast<uint8_t>(restoreWhen)) << 8 |
+			static_cast<uint64_t>(static_cast<uint8_t>(to)) << 16 |
+			static_cast<uint64_t>(isEnabled ? 1 : 0) << 24);
+}
+
+Settings::Snapshot Settings::Snapshot::unpack(uint64_t packed)
+{
+	Snapshot snapshot;
+	snapshot.in = static_cast<In>(packed & 0xFF);
+	snapshot.restoreWhen = static_cast<RestoreWhen>((packed >> 8) & 0xFF);
+	snapshot.to = static_cast<To>((packed >> 16) & 0xFF);
+	snapshot.isEnabled = (((packed >> 24) & 0xFF) != 0);
+	return snapshot;
+}
+
+Settings::Snapshot Settings::getSnapshot()
+{
+	return Snapshot::unpack(PackedSettings.load(std::memory_order_acquire));
 }
 
 Settings::In Settings::getInSetting()
 {
-	return InSetting;
+	return getSnapshot().in;
 }
 
 Settings::RestoreWhen Settings::getRestoreWhenSetting()
 {
-	return RestoreWhenSetting;
+	return getSnapshot().restoreWhen;
 }
 
 Settings::To Settings::getToSetting()
 {
-	return ToSetting;
+	return getSnapshot().to;
 }
 
 bool Settings::getIsEnabled()
 {
-	return IsEnabledSetting;
+	return getSnapshot().isEnabled;
 }
 
-DWORD Settings::getSetting(LPWSTR szValueName)
+SettingsStore& Settings::getStore()
 {
-	HKEY hkeyPellucidSettings;
+#ifdef _WIN32
+	static RegistrySettingsStore s_store(HKEY_CURRENT_USER, szSettingsKeyPath);
+#else
+	static IniSettingsStore s_store("");	// NOTE: Headless hosts keep settings in memory
+#endif
+
+	return s_store;
+}
 
-	if (RegOpenKeyEx(HKEY_CURRENT_USER,
-						szSettingsKeyPath,
-						0,
-						KEY_READ,
-						&hkeyPellucidSettings) == ERROR_SUCCESS)
+// Value names 'HotZone0' to 'HotZone63'
+const wchar_t *const *Settings::getHotZoneValueNames()
+{
+	struct HotZoneValueNames
 	{
-		DWORD Type;
-		DWORD Data;
-		DWORD cbData;
-
-		if (RegQueryValueEx(hkeyPellucidSettings,
-							szValueName,
-							NULL,
-							&Type,
-							(LPBYTE)&Data,
-							&cbData) == ERROR_SUCCESS)
+		wchar_t szNames[SETTINGS_MAXHOTZONES][16];
+		const wchar_t *pszNames[SETTINGS_MAXHOTZONES];
+
+		HotZoneValueNames()
 		{
-			if (Type == REG_DWORD && cbData == sizeof(DWORD))
+			for (int i = 0; i < SETTINGS_MAXHOTZONES; ++i)
 			{
-				return Data;
+				swprintf(szNames[i], sizeof(szNames[i]) / sizeof(szNames[i][0]), L"HotZone%d", i);
+				pszNames[i] = szNames[i];
 			}
 		}
+	};
+	static const HotZoneValueNames s_hotZoneValueNames;
+
+	return s_hotZoneValueNames.pszNames;
+}
+
+// NOTE: Created by 'ForceSettingsRefreshFromRegistry()' and closed by 'Close()', arming it does nothing in between
+TimerBackend& Settings::getFlushTimer()
+{
+#ifdef _WIN32
+	static ThreadpoolTimer s_timerFlush(&FlushTimer_Callback, NULL);
+#else
+	// NOTE: Headless hosts have no timer, so changes are written on 'Flush()' only
+	class NullTimer : public TimerBackend
+	{
+	public:
+		virtual void Arm(uint32_t dueMillisecs) {}
+		virtual void Disarm() {}
+	};
+	static NullTimer s_timerFlush;
+#endif
+
+	return s_timerFlush;
+}
+
+WriteBehindQueue& Settings::getWriteBehind()
+{
+	static WriteBehindQueue s_writeBehind(getFlushTimer(), FLUSH_DEBOUNCEMILLISECS, &WriteBehind_Flush, NULL);
+
+	return s_writeBehind;
+}
+
+// Atomically applies 'modify' to current snapshot
+// NOTE: Menu thread and store change notifications may both write, hence compare and swap
+template<typename F>
+void Settings::update(F modify)
+{
+	auto packed = PackedSettings.load(std::memory_order_relaxed);
+	Snapshot snapshot;
+	do
+	{
+		snapshot = Snapshot::unpack(packed);
+		modify(snapshot);
+	} while (!PackedSettings.compare_exchange_weak(packed, snapshot.pack(), std::memory_order_release, std::memory_order_relaxed));
+}
+
+void Settings::refreshSnapshot()
+{
+	METRICS_SCOPE(histogramSettingsRead);
+
+	uint32_t values[fieldCount] = { 0 };	// Default settings
+	if (!getStore().ReadValues(szValueNames, values, fieldCount))
+		return;
+
+	// CAUTION: Fields changed by us but not yet flushed are newer than store, so keep them
+	uint32_t currentValues[fieldCount];
+	auto unflushedMask = getWriteBehind().getUnflushedMask();
+	update([&](Snapshot& snapshot)
+	{
+		toValues(snapshot, currentValues);
+		for (int i = 0; i < fieldCount; ++i)
+		{
+			if (unflushedMask & (1u << i))
+				values[i] = currentValues[i];
+		}
+
+		snapshot = fromValues(values);
+	});
+}
+
+// Returns true if any tuning setting changed
+bool Settings::refreshTuning()
+{
+	static const wchar_t *const szTuningValueNames[] = { L"RegionHysteresisPixels", L"RegionDwellMillisecs", L"ActivityQuantumMillisecs", L"MouseTraceKilobytes", L"SnapshotFade" };
+	uint32_t values[] = { DEFAULT_REGIONHYSTERESISPIXELS, DEFAULT_REGIONDWELLMILLISECS, DEFAULT_ACTIVITYQUANTUMMILLISECS, 0, 0 };
+	if (!getStore().ReadValues(szTuningValueNames, values, sizeof(values) / sizeof(values[0])))
+		return false;
+
+	uint32_t packedRegionTuning = (values[0] & 0xFFFF) | (values[1] & 0xFFFF) << 16;
+	bool bSnapshotFade = (values[4] != 0);
+
+	bool bChanged = (PackedRegionTuning.exchange(packedRegionTuning, std::memory_order_relaxed) != packedRegionTuning);
+	bChanged |= (ActivityQuantum.exchange(values[2], std::memory_order_relaxed) != values[2]);
+	bChanged |= (MouseTraceKilobytes.exchange(values[3], std::memory_order_relaxed) != values[3]);
+	bChanged |= (SnapshotFade.exchange(bSnapshotFade, std::memory_order_relaxed) != bSnapshotFade);
+	return bChanged;
+}
 
-		RegCloseKey(hkeyPellucidSettings);
+// Reads hot zones into 'PackedHotZones', returns true if they changed
+// NOTE: Called on store's change notification thread, so window thread only ever copies them
+bool Settings::refreshHotZones()
+{
+	uint32_t packedZones[SETTINGS_MAXHOTZONES] = { 0 };
+	if (!getStore().ReadValues(getHotZoneValueNames(), packedZones, SETTINGS_MAXHOTZONES))
+		return false;
+
+	size_t count = SETTINGS_MAXHOTZONES;
+	while (count > 0 && packedZones[count - 1] == 0)
+		--count;
+
+	std::lock_guard<std::mutex> lock(MutexHotZones);
+	if (count == HotZoneCount && memcmp(packedZones, PackedHotZones, sizeof(PackedHotZones)) == 0)
+		return false;
+
+	memcpy(PackedHotZones, packedZones, sizeof(PackedHotZones));
+	HotZoneCount = count;
+	return true;
+}
+
+void Settings::toValues(const Snapshot& snapshot, uint32_t values[fieldCount])
+{
+	values[fieldIn] = static_cast<uint32_t>(snapshot.in);
+	values[fieldRestoreWhen] = static_cast<uint32_t>(snapshot.restoreWhen);
+	values[fieldTo] = static_cast<uint32_t>(snapshot.to);
+	values[fieldEnabled] = (snapshot.isEnabled ? 1 : 0);
+}
+
+Settings::Snapshot Settings::fromValues(const uint32_t values[fieldCount])
+{
+	Snapshot snapshot;
+	snapshot.in = static_cast<In>(values[fieldIn]);
+	snapshot.restoreWhen = static_cast<RestoreWhen>(values[fieldRestoreWhen]);
+	snapshot.to = static_cast<To>(values[fieldTo]);
+	snapshot.isEnabled = (values[fieldEnabled] != 0);
+	return snapshot;
+}
+
+// NOTE: Our own flushes also end up here, and these change neither tuning nor hot zones. So version
+//		 is only bumped when either changed, and window thread doesn't look at them for nothing.
+void Settings::SettingsStore_Changed(void *pContext)
+{
+	refreshSnapshot();
+	bool bChanged = refreshTuning();
+	bChanged |= refreshHotZones();
+	if (bChanged)
+		StoreVersion.fetch_add(1, std::memory_order_release);
+}
+
+bool Settings::WriteBehind_Flush(uint32_t dirtyMask, void *pContext)
+{
+	METRICS_SCOPE(histogramSettingsWrite);
+
+	uint32_t currentValues[fieldCount];
+	toValues(getSnapshot(), currentValues);
+
+	// Batch up dirty fields
+	const wchar_t *names[fieldCount];
+	uint32_t values[fieldCount];
+	size_t count = 0;
+	for (int i = 0; i < fieldCount; ++i)
+	{
+		if (dirtyMask & (1u << i))
+		{
+			names[count] = szValueNames[i];
+			values[count++] = currentValues[i];
+		}
 	}
 
-	return 0;	// Default setting
+	// NOTE: On failure, fields are kept dirty and written again with the next flush
+	return getStore().WriteValues(names, values, count);
+}
+
+void Settings::FlushTimer_Callback(void *pContext)
+{
+	getWriteBehind().Flush();
 }
 
 
 void Settings::setInSetting(In setting)
 {
-	setSetting(L"In", static_cast<DWORD>(setting));
-	InSetting = setting;
+	update([setting](Snapshot& snapshot) { snapshot.in = setting; });
+	setSetting(fieldIn);
 }
 
 void Settings::setRestoreWhenSetting(RestoreWhen setting)
 {
-	setSetting(L"RestoreWhen", static_cast<DWORD>(setting));
-	RestoreWhenSetting = setting;
+	update([setting](Snapshot& snapshot) { snapshot.restoreWhen = setting; });
+	setSetting(fieldRestoreWhen);
 }
 
 void Settings::setToSetting(To setting)
 {
-	setSetting(L"To", static_cast<DWORD>(setting));
-	ToSetting = setting;
+	update([setting](Snapshot& snapshot) { snapshot.to = setting; });
+	setSetting(fieldTo);
 }
 
 void Settings::setIsEnabled(bool setting)
 {
-	setSetting(L"Enabled", (setting ? 1 : 0));
-	IsEnabledSetting = setting;
+	update([setting](Snapshot& snapshot) { snapshot.isEnabled = setting; });
+	setSetting(fieldEnabled);
 }
 
-void Settings::setSetting(LPWSTR szValueName, DWORD value)
+uint32_t Settings::getValue(const Snapshot& snapshot, Field field)
 {
-	HKEY hkeyPellucidSettings;
+	uint32_t values[fieldCount];
+	toValues(snapshot, values);
+	return values[field];
+}
 
-	// Create key if it doesn't exists
-	// NOTE: If both 'Pellucid' and its subkey 'Settings' doesn't exist, the 'RegCreateKeyEx()' function creates both
-	if (RegCreateKeyEx(HKEY_CURRENT_USER,
-						szSettingsKeyPath,
-						NULL,
-						NULL,
-						REG_OPTION_NON_VOLATILE,
-						KEY_READ | KEY_WRITE,
-						NULL,
-						&hkeyPellucidSettings, NULL) != ERROR_SUCCESS)
+void Settings::setValue(Field field, uint32_t value)
+{
+	update([field, value](Snapshot& snapshot)
 	{
-		// TODO: Log error
-		return;
-	}
+		uint32_t values[fieldCount];
+		toValues(snapshot, values);
+		values[field] = value;
+		snapshot = fromValues(values);
+	});
+	setSetting(field);
+}
 
-	RegSetValueEx(hkeyPellucidSettings, szValueName, NULL, REG_DWORD, (const BYTE *)&value, sizeof(value));
+// Returns number of hot zone values up to last one set, zones not set are zero
+size_t Settings::getHotZones(uint32_t packedZones[SETTINGS_MAXHOTZONES])
+{
+	std::lock_guard<std::mutex> lock(MutexHotZones);
 
-	RegCloseKey(hkeyPellucidSettings);
+	memcpy(packedZones, PackedHotZones, sizeof(PackedHotZones));
+	return HotZoneCount;
+}
+
+uint32_t Settings::getStoreVersion()
+{
+	return StoreVersion.load(std::memory_order_acquire);
+}
+
+int Settings::getRegionHysteresisPixels()
+{
+	return static_cast<int>(PackedRegionTuning.load(std::memory_order_relaxed) & 0xFFFF);
+}
+
+uint32_t Settings::getRegionDwellMillisecs()
+{
+	return PackedRegionTuning.load(std::memory_order_relaxed) >> 16;
+}
+
+uint32_t Settings::getActivityQuantumMillisecs()
+{
+	return ActivityQuantum.load(std::memory_order_relaxed);
+}
+
+uint32_t Settings::getMouseTraceKilobytes()
+{
+	return MouseTraceKilobytes.load(std::memory_order_relaxed);
+}
+
+bool Settings::getSnapshotFade()
+{
+	return SnapshotFade.load(std::memory_order_relaxed);
+}
+
+// NOTE: New value is already in memory, store is written later off the calling thread
+void Settings::setSetting(Field field)
+{
+	getWriteBehind().MarkDirty(1u << field);
 }
 
-UINT Settings::convertInToMillisecs(Settings::In in)
+uint32_t Settings::convertInToMillisecs(Settings::In in)
 {
 	switch (in)
 	{
@@ -1,5 +1,12 @@
 #pragma once
-#include <Windows.h>
+#include "SettingsStore.h"
+#include "WriteBehindQueue.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#define SETTINGS_MAXHOTZONES		64
 
 
 class Settings
@@ -20,13 +27,15 @@ public:
 	{
 		mousedMoved,
 		mousedEntersQuarterRegionOnLeft,
-		doubleClicked
+		doubleClicked,
+		mousedEntersHotZone
 	};
 
 	enum class To
 	{
 		fullTransparency,
-		semiTransparency
+		semiTransparency,
+		hoverReveal			// Full transparency, except icons near mouse
 	};
 
 	enum class Enabled
@@ -36,8 +45,36 @@ public:
 	};
 #pragma endregion
 
+	// Fields in store, in order of 'szValueNames'
+	enum Field
+	{
+		fieldIn,
+		fieldRestoreWhen,
+		fieldTo,
+		fieldEnabled,
+		fieldCount
+	};
+
+	// All settings as read together from store
+	// NOTE: Settings are published packed in a single 64-bit word, so that readers on any
+	//		 thread get a consistent snapshot with one atomic load and no locks.
+	struct Snapshot
+	{
+		In in;
+		RestoreWhen restoreWhen;
+		To to;
+		bool isEnabled;
+
+		uint64_t pack() const;
+		static Snapshot unpack(uint64_t packed);
+	};
+
 #pragma region Functions
 	static void ForceSettingsRefreshFromRegistry();
+	static void Flush();							// Writes out pending changes now
+	static void Close();							// Writes out pending changes and stops watching store, call before module unload
+
+	static Snapshot getSnapshot();
 
 	static In getInSetting();
 	static RestoreWhen getRestoreWhenSetting();
@@ -49,21 +86,56 @@ public:
 	static void setToSetting(To setting);
 	static void setIsEnabled(bool setting);
 
-	static UINT convertInToMillisecs(In in);
+	static uint32_t getValue(const Snapshot& snapshot, Field field);
+	static void setValue(Field field, uint32_t value);
+
+	// Hot zones, each packed as bytes 'left', 'top', 'right' and 'bottom' in 255ths of desktop
+	// NOTE: Copies what was last read from store, so only call again when 'getStoreVersion()' has changed
+	static size_t getHotZones(uint32_t packedZones[SETTINGS_MAXHOTZONES]);
+	static uint32_t getStoreVersion();
+
+	// Tuning settings, these are not on menu
+	static int getRegionHysteresisPixels();		// Band mouse must go past to leave a region
+	static uint32_t getRegionDwellMillisecs();		// Time mouse must stay in or out before it counts
+	static uint32_t getActivityQuantumMillisecs();	// Input activity is acted on at most once per this
+	static uint32_t getMouseTraceKilobytes();		// Size of mouse trace to record, zero if not recording
+	static bool getSnapshotFade();					// Fade a captured copy of icons instead of icons themselves
+
+	static uint32_t convertInToMillisecs(In in);
 #pragma endregion
 
 private:
 	// Constants
-	static const WCHAR szSettingsKeyPath[];
+	static const wchar_t szSettingsKeyPath[];
+	static const wchar_t *const szValueNames[];
 
 	// Variables
-	static In InSetting;
-	static RestoreWhen RestoreWhenSetting;
-	static To ToSetting;
-	static bool IsEnabledSetting;
-
-	static DWORD getSetting(LPWSTR szValueName);
-	static void setSetting(LPWSTR szValueName, DWORD value);
+	static std::atomic<uint64_t> PackedSettings;	// Packed 'Snapshot'
+	static std::atomic<uint32_t> StoreVersion;	// Bumped whenever hot zones or tuning changed in store
+	static std::atomic<uint32_t> PackedRegionTuning;	// Hysteresis in low word, dwell in high word
+	static std::atomic<uint32_t> ActivityQuantum;
+	static std::atomic<uint32_t> MouseTraceKilobytes;
+	static std::atomic<bool> SnapshotFade;
+	static std::mutex MutexHotZones;
+	static uint32_t PackedHotZones[SETTINGS_MAXHOTZONES];	// NOTE: Guarded by 'MutexHotZones'
+	static size_t HotZoneCount;
+
+	static SettingsStore& getStore();
+	static const wchar_t *const *getHotZoneValueNames();
+	static TimerBackend& getFlushTimer();
+	static WriteBehindQueue& getWriteBehind();
+	static void refreshSnapshot();
+	static bool refreshTuning();
+	static bool refreshHotZones();
+	template<typename F> static void update(F modify);
+	static void setSetting(Field field);
+
+	static void toValues(const Snapshot& snapshot, uint32_t values[fieldCount]);
+	static Snapshot fromValues(const uint32_t values[fieldCount]);
+
+	static void SettingsStore_Changed(void *pContext);
+	static bool WriteBehind_Flush(uint32_t dirtyMask, void *pContext);
+	static void FlushTimer_Callback(void *pContext);
 };
 
 
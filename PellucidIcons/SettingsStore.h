@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+// Backing store of named DWORD settings
+class SettingsStore
+{
+public:
+	typedef void(*ChangeCallback)(void *pContext);
+
+	virtual ~SettingsStore() {}
+
+	// Reads all given values in one go, values not found are left untouched
+	virtual bool ReadValues(const wchar_t *const names[], uint32_t values[], size_t count) = 0;
+	virtual bool WriteValue(const wchar_t *name, uint32_t value) = 0;
+	virtual bool WriteValues(const wchar_t *const names[], const uint32_t values[], size_t count) = 0;
+
+	// Asks to be called back when the store is changed from outside
+	// NOTE: Returns false if store can't notify changes
+	virtual bool Watch(ChangeCallback callback, void *pContext) = 0;
+
+	// Stops watching and releases any handles, store is opened again on next use
+	// CAUTION: May wait for a running change callback, so don't call from within one or under loader lock
+	virtual void Close() {}
+};
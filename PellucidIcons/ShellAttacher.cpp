@@ -0,0 +1,153 @@
+#include "ShellAttacher.h"
+#include "Metrics.h"
+
+
+ShellAttacher::ShellAttacher(Locator& locator, Clock& clock, TimerBackend& timer, AttachCallback attach, DetachCallback detach, void *pContext)
+	: m_locator(locator),
+	m_clock(clock),
+	m_timer(timer),
+	m_attach(attach),
+	m_detach(detach),
+	m_pContext(pContext),
+	m_state(State::stopped),
+	m_bSuspended(false),
+	m_pWindow(nullptr),
+	m_searchStart(0),
+	m_retryDelay(SHELLATTACHER_FIRSTRETRYMILLISECS),
+	m_cAttempts(0),
+	m_cAttaches(0),
+	m_lastAttachMillisecs(0)
+{
+}
+
+void ShellAttacher::Start()
+{
+	auto state = State::stopped;
+	if (m_state.compare_exchange_strong(state, State::searching, std::memory_order_acq_rel))
+		beginSearch();
+}
+
+void ShellAttacher::Stop()
+{
+	auto state = State::searching;
+	if (m_state.compare_exchange_strong(state, State::stopped, std::memory_order_acq_rel))
+		m_timer.Disarm();
+}
+
+void ShellAttacher::OnTimer()
+{
+	// NOTE: Timer may have fired just before suspending, or after an attach that took too long to answer
+	if (m_bSuspended.load(std::memory_order_relaxed) || m_state.load(std::memory_order_acquire) != State::searching)
+		return;
+
+	search();
+}
+
+void ShellAttacher::OnWindowDestroyed(void *pWindow)
+{
+	if (m_state.load(std::memory_order_acquire) != State::attached || pWindow != m_pWindow.load(std::memory_order_relaxed))
+		return;
+
+	m_detach(pWindow, m_pContext);
+	m_pWindow.store(nullptr, std::memory_order_relaxed);
+
+	// Shell is shutting down or replacing its view, so look for a new one
+	m_state.store(State::searching, std::memory_order_release);
+	beginSearch();
+}
+
+void ShellAttacher::Suspend()
+{
+	m_bSuspended.store(true, std::memory_order_relaxed);
+	m_timer.Disarm();
+}
+
+void ShellAttacher::Resume()
+{
+	if (!m_bSuspended.exchange(false, std::memory_order_relaxed))
+		return;
+
+	if (m_state.load(std::memory_order_acquire) == State::searching)
+		m_timer.Arm(0);
+}
+
+bool ShellAttacher::IsSuspended() const
+{
+	return m_bSuspended.load(std::memory_order_relaxed);
+}
+
+ShellAttacher::State ShellAttacher::getState() const
+{
+	return m_state.load(std::memory_order_acquire);
+}
+
+void *ShellAttacher::getWindow() const
+{
+	return m_pWindow.load(std::memory_order_relaxed);
+}
+
+uint32_t ShellAttacher::getAttemptCount() const
+{
+	return m_cAttempts.load(std::memory_order_relaxed);
+}
+
+uint32_t ShellAttacher::getAttachCount() const
+{
+	return m_cAttaches.load(std::memory_order_relaxed);
+}
+
+uint64_t ShellAttacher::getLastAttachMillisecs() const
+{
+	return m_lastAttachMillisecs.load(std::memory_order_relaxed);
+}
+
+uint32_t ShellAttacher::getRetryDelay() const
+{
+	return m_retryDelay.load(std::memory_order_relaxed);
+}
+
+void ShellAttacher::beginSearch()
+{
+	m_searchStart.store(m_clock.Now(), std::memory_order_relaxed);
+	m_retryDelay.store(SHELLATTACHER_FIRSTRETRYMILLISECS, std::memory_order_relaxed);
+	if (!m_bSuspended.load(std::memory_order_relaxed))
+		m_timer.Arm(0);		// NOTE: First attempt right away, but on timer thread
+}
+
+// NOTE: On timer thread, which only finds window and leaves setting it up to window's thread
+void ShellAttacher::search()
+{
+	m_cAttempts.fetch_add(1, std::memory_order_relaxed);
+	METRICS_INCREMENT(counterAttachAttempt);
+
+	auto pWindow = m_locator.FindShellWindow();
+	if (pWindow && m_locator.CallOnWindowThread(pWindow, &Window_Attach, this))
+		return;
+
+	// Desktop isn't ready, or its thread is busy, so try again later and less often
+	auto retryDelay = m_retryDelay.load(std::memory_order_relaxed);
+	m_timer.Arm(retryDelay);
+	m_retryDelay.store(retryDelay < SHELLATTACHER_MAXRETRYMILLISECS / 2 ? retryDelay * 2 : SHELLATTACHER_MAXRETRYMILLISECS, std::memory_order_relaxed);
+}
+
+// Sets up window on its own thread, see 'search()'
+// NOTE: An earlier call that didn't answer in time may have got through since, so only the first one attaches
+bool ShellAttacher::Window_Attach(void *pWindow, void *pContext)
+{
+	auto pThis = static_cast<ShellAttacher *>(pContext);
+
+	auto state = pThis->m_state.load(std::memory_order_acquire);
+	if (state != State::searching)
+		return (state == State::attached);
+	if (!pThis->m_attach(pWindow, pThis->m_pContext))
+		return false;
+
+	auto attachMillisecs = pThis->m_clock.Now() - pThis->m_searchStart.load(std::memory_order_relaxed);
+	pThis->m_lastAttachMillisecs.store(attachMillisecs, std::memory_order_relaxed);
+	METRICS_RECORD(histogramAttach, attachMillisecs * 1000000);
+
+	pThis->m_pWindow.store(pWindow, std::memory_order_relaxed);
+	pThis->m_cAttaches.fetch_add(1, std::memory_order_relaxed);
+	pThis->m_state.store(State::attached, std::memory_order_release);
+	return true;
+}
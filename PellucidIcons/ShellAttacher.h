@@ -0,0 +1,87 @@
+#pragma once
+#include "Timing.h"
+#include <atomic>
+#include <cstdint>
+
+#define SHELLATTACHER_FIRSTRETRYMILLISECS	50
+#define SHELLATTACHER_MAXRETRYMILLISECS		5000
+
+
+// Finds desktop list-view and stays attached to it
+// NOTE: Desktop may not have been built yet when we are loaded, so search is retried with
+//		 exponential backoff on timer thread. Window itself is only ever set up and torn down on
+//		 its own thread: attach is handed to that thread by 'Locator', and detach is done when
+//		 window procedure sees window go. Nothing wakes up while attached.
+class ShellAttacher
+{
+public:
+	enum class State
+	{
+		stopped,
+		searching,
+		attached
+	};
+
+	typedef bool(*AttachCallback)(void *pWindow, void *pContext);
+	typedef void(*DetachCallback)(void *pWindow, void *pContext);
+
+	// Where desktop list-view is looked up
+	class Locator
+	{
+	public:
+		typedef bool(*WindowFunction)(void *pWindow, void *pContext);
+
+		virtual ~Locator() {}
+
+		virtual void *FindShellWindow() = 0;			// NULL if not there (yet)
+
+		// Runs function on thread that owns window and waits for it
+		// NOTE: Returns false if function did, or if window's thread didn't answer in time. Function
+		//		 may still run after that, e.g. once a hung thread comes back.
+		virtual bool CallOnWindowThread(void *pWindow, WindowFunction function, void *pContext) = 0;
+	};
+
+	ShellAttacher(Locator& locator, Clock& clock, TimerBackend& timer, AttachCallback attach, DetachCallback detach, void *pContext);
+
+	void Start();								// Starts searching, unless already started
+	void Stop();								// Stops searching, but doesn't detach. CAUTION: Timer callbacks must have finished
+	void OnTimer();
+	void OnWindowDestroyed(void *pWindow);		// IMPORTANT: Call on window's thread before it is gone, e.g. on 'WM_DESTROY'
+
+	// No timer is armed while suspended, e.g. while desktop can't be seen
+	// NOTE: Search goes on right away on resume
+	void Suspend();
+	void Resume();
+	bool IsSuspended() const;
+
+	State getState() const;
+	void *getWindow() const;
+	uint32_t getAttemptCount() const;
+	uint32_t getAttachCount() const;
+	uint64_t getLastAttachMillisecs() const;	// From start of search to attach
+	uint32_t getRetryDelay() const;
+
+private:
+	void beginSearch();
+	void search();
+
+	static bool Window_Attach(void *pWindow, void *pContext);
+
+	Locator& m_locator;
+	Clock& m_clock;
+	TimerBackend& m_timer;
+	AttachCallback m_attach;
+	DetachCallback m_detach;
+	void *m_pContext;
+
+	// NOTE: Nothing is locked. Only window's thread goes from searching to attached and back, and
+	//		 timer thread only looks for window while searching.
+	std::atomic<State> m_state;
+	std::atomic<bool> m_bSuspended;
+	std::atomic<void *> m_pWindow;
+	std::atomic<uint64_t> m_searchStart;
+	std::atomic<uint32_t> m_retryDelay;
+	std::atomic<uint32_t> m_cAttempts;
+	std::atomic<uint32_t> m_cAttaches;
+	std::atomic<uint64_t> m_lastAttachMillisecs;
+};
@@ -0,0 +1,66 @@
+#include "ThreadpoolTimer.h"
+
+
+ThreadpoolTimer::ThreadpoolTimer(Callback callback, PVOID pContext)
+	: m_callback(callback),
+	m_pContext(pContext),
+	m_pTimer(NULL)
+{
+}
+
+// NOTE: Doesn't wait for running callbacks, as static timers are destroyed under loader lock,
+//		 where waiting on thread pool can deadlock. 'Close()' must have been called before unloading.
+ThreadpoolTimer::~ThreadpoolTimer()
+{
+	if (m_pTimer)
+	{
+		SetThreadpoolTimer(m_pTimer, NULL, 0, 0);
+		CloseThreadpoolTimer(m_pTimer);
+	}
+}
+
+bool ThreadpoolTimer::Create()
+{
+	if (!m_pTimer)
+		m_pTimer = CreateThreadpoolTimer(&ThreadpoolTimer_Callback, this, NULL);
+
+	return (m_pTimer != NULL);
+}
+
+void ThreadpoolTimer::Close()
+{
+	if (m_pTimer)
+	{
+		SetThreadpoolTimer(m_pTimer, NULL, 0, 0);
+		WaitForThreadpoolTimerCallbacks(m_pTimer, TRUE);	// Cancel pending and wait for running callbacks
+		CloseThreadpoolTimer(m_pTimer), m_pTimer = NULL;
+	}
+}
+
+void ThreadpoolTimer::Arm(uint32_t dueMillisecs)
+{
+	if (!m_pTimer)
+		return;
+
+	// NOTE: Negative due time is relative, in 100 nanosecond units
+	ULARGE_INTEGER dueTime;
+	dueTime.QuadPart = (ULONGLONG)(-((LONGLONG)dueMillisecs * 10000));
+
+	FILETIME fileTimeDue;
+	fileTimeDue.dwLowDateTime = dueTime.LowPart;
+	fileTimeDue.dwHighDateTime = dueTime.HighPart;
+
+	SetThreadpoolTimer(m_pTimer, &fileTimeDue, 0, 0);
+}
+
+void ThreadpoolTimer::Disarm()
+{
+	if (m_pTimer)
+		SetThreadpoolTimer(m_pTimer, NULL, 0, 0);
+}
+
+VOID CALLBACK ThreadpoolTimer::ThreadpoolTimer_Callback(PTP_CALLBACK_INSTANCE pInstance, PVOID pContext, PTP_TIMER pTimer)
+{
+	auto pThis = static_cast<ThreadpoolTimer *>(pContext);
+	pThis->m_callback(pThis->m_pContext);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Timing.h"
+#include <Windows.h>
+
+
+// One-shot timer on the default thread pool which is created once and re-armed in place
+// NOTE: Unlike timer-queue timers, a thread pool timer can be re-armed after it has expired
+class ThreadpoolTimer : public TimerBackend
+{
+public:
+	typedef void(*Callback)(PVOID pContext);
+
+	ThreadpoolTimer(Callback callback, PVOID pContext);
+	virtual ~ThreadpoolTimer();
+
+	bool Create();
+	void Close();		// CAUTION: Waits for running callbacks, so don't call from within one or under loader lock
+
+	// TimerBackend
+	virtual void Arm(uint32_t dueMillisecs);
+	virtual void Disarm();
+
+private:
+	Callback m_callback;
+	PVOID m_pContext;
+	PTP_TIMER m_pTimer;
+
+	static VOID CALLBACK ThreadpoolTimer_Callback(PTP_CALLBACK_INSTANCE pInstance, PVOID pContext, PTP_TIMER pTimer);
+};
+
+
+// Clock backed by system tick count
+class TickCountClock : public Clock
+{
+public:
+	// Clock
+	virtual uint64_t Now() { return GetTickCount64(); }
+};
\ No newline at end of file
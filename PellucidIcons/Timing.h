@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+
+// Monotonic millisecond clock
+class Clock
+{
+public:
+	virtual ~Clock() {}
+
+	virtual uint64_t Now() = 0;
+};
+
+// Platform one-shot timer
+class TimerBackend
+{
+public:
+	virtual ~TimerBackend() {}
+
+	virtual void Arm(uint32_t dueMillisecs) = 0;	// IMPORTANT: Must replace any pending due time
+	virtual void Disarm() = 0;
+};
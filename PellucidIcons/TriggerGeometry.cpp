@@ -0,0 +1,56 @@
+#include "TriggerGeometry.h"
+
+
+TriggerGeometry::TriggerGeometry()
+	: m_monitors(),
+	m_triggerZones(),
+	m_cMonitors(0)
+{
+}
+
+size_t TriggerGeometry::Update(const Rect monitors[], size_t count)
+{
+	if (count > TRIGGERGEOMETRY_MAXMONITORS)
+		count = TRIGGERGEOMETRY_MAXMONITORS;
+
+	size_t cRebuilt = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (i < m_cMonitors && m_monitors[i] == monitors[i])
+			continue;	// Unchanged
+
+		m_monitors[i] = monitors[i];
+		m_triggerZones[i] = computeTriggerZone(monitors[i]);
+		++cRebuilt;
+	}
+
+	m_cMonitors = count;
+	return cRebuilt;
+}
+
+bool TriggerGeometry::IsInTriggerZone(int x, int y, int margin) const
+{
+	// NOTE: Few monitors, so test all of them without branching on each
+	bool bInZone = false;
+	for (size_t i = 0; i < m_cMonitors; ++i)
+		bInZone |= m_triggerZones[i].inflate(margin).contains(x, y);
+
+	return bInZone;
+}
+
+size_t TriggerGeometry::getMonitorCount() const
+{
+	return m_cMonitors;
+}
+
+const Rect& TriggerGeometry::getTriggerZone(size_t index) const
+{
+	return m_triggerZones[index];
+}
+
+Rect TriggerGeometry::computeTriggerZone(const Rect& monitor)
+{
+	Rect triggerZone = monitor;
+	triggerZone.right = monitor.left + (monitor.right - monitor.left) / TRIGGER_REGION_DIVISOR;
+	return triggerZone;
+}
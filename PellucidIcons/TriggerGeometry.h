@@ -0,0 +1,30 @@
+#pragma once
+#include "Geometry.h"
+#include <cstddef>
+
+#define TRIGGERGEOMETRY_MAXMONITORS		16
+#define TRIGGER_REGION_DIVISOR			4		// NOTE: Quarter of monitor width, as menu item says
+
+
+// Trigger zones for 'mouse enters quarter region on left' policy, one per monitor
+// NOTE: Monitor rectangles are given in client coordinates of the shell window, so that lookups
+//		 can use mouse message coordinates as is.
+class TriggerGeometry
+{
+public:
+	TriggerGeometry();
+
+	// Rebuilds trigger zones of monitors which changed, returns number of zones rebuilt
+	size_t Update(const Rect monitors[], size_t count);
+	bool IsInTriggerZone(int x, int y, int margin = 0) const;	// 'margin' grows zones
+
+	size_t getMonitorCount() const;
+	const Rect& getTriggerZone(size_t index) const;
+
+private:
+	static Rect computeTriggerZone(const Rect& monitor);
+
+	Rect m_monitors[TRIGGERGEOMETRY_MAXMONITORS];
+	Rect m_triggerZones[TRIGGERGEOMETRY_MAXMONITORS];
+	size_t m_cMonitors;
+};
@@ -1,4 +1,7 @@
 #include "Utility.h"
+#include "PixelKernels.h"
+#include <cstdint>
+#include <new>
 
 
 // NOTE: The following function comes from TortoiseSVN project
@@ -34,33 +37,120 @@ HRESULT Utility::Create32BitHBITMAP(HDC hdc, const SIZE *psize, __deref_opt_out
 	return (NULL == *phBmp) ? E_OUTOFMEMORY : S_OK;
 }
 
-HBITMAP Utility::ConvertIconHandleToBitmapHandle(HICON hIcon)
+// Rasterizes small icon for given DPI straight into a premultiplied 32-bit bitmap, as menus want
+HBITMAP Utility::CreatePremultipliedIconBitmap(HINSTANCE hInst, LPCWSTR szIconName, UINT dpi)
 {
-	HBITMAP hbitmapRet = NULL;
+	typedef int (WINAPI *GetSystemMetricsForDpi_t)(int, UINT);
+	static auto pfnGetSystemMetricsForDpi = (GetSystemMetricsForDpi_t)GetProcAddress(GetModuleHandle(L"user32.dll"), "GetSystemMetricsForDpi");
 
 	SIZE sizeIcon;
-	sizeIcon.cx = GetSystemMetrics(SM_CXSMICON);
-	sizeIcon.cy = GetSystemMetrics(SM_CYSMICON);
-
-	HDC hdcDest = CreateCompatibleDC(NULL);
-	if (hdcDest)
+	if (pfnGetSystemMetricsForDpi)
+	{
+		sizeIcon.cx = pfnGetSystemMetricsForDpi(SM_CXSMICON, dpi);
+		sizeIcon.cy = pfnGetSystemMetricsForDpi(SM_CYSMICON, dpi);
+	}
+	else	// NOTE: Before Windows 10, metrics are for system DPI only
 	{
-		SetBkMode(hdcDest, TRANSPARENT);
+		sizeIcon.cx = GetSystemMetrics(SM_CXSMICON);
+		sizeIcon.cy = GetSystemMetrics(SM_CYSMICON);
+	}
+
+	auto hIcon = (HICON)LoadImage(hInst, szIconName, IMAGE_ICON, sizeIcon.cx, sizeIcon.cy, LR_DEFAULTCOLOR);
+	if (!hIcon)
+		return NULL;
 
+	HBITMAP hbitmapRet = NULL;
+	ICONINFO iconInfo = { 0 };
+	HDC hdc = GetDC(NULL);
+
+	if (hdc && GetIconInfo(hIcon, &iconInfo))
+	{
+		void *pvBits;
 		HBITMAP hbitmapDest;
-		
-		if (SUCCEEDED(Create32BitHBITMAP(hdcDest, &sizeIcon, NULL, &hbitmapDest)))
+
+		if (SUCCEEDED(Create32BitHBITMAP(hdc, &sizeIcon, &pvBits, &hbitmapDest)))
 		{
-			auto hbitmapPrevDest = SelectObject(hdcDest, hbitmapDest);
+			// Read icon pixels in the same bottom-up 32-bit layout as our bitmap
+			BITMAPINFO bmi;
+			SecureZeroMemory(&bmi, sizeof(bmi));
+			bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+			bmi.bmiHeader.biWidth = sizeIcon.cx;
+			bmi.bmiHeader.biHeight = sizeIcon.cy;
+			bmi.bmiHeader.biPlanes = 1;
+			bmi.bmiHeader.biBitCount = 32;
+			bmi.bmiHeader.biCompression = BI_RGB;
 
-			DrawIconEx(hdcDest, 0, 0, hIcon, sizeIcon.cx, sizeIcon.cy, 0, NULL, DI_NORMAL);
-			SelectObject(hdcDest, hbitmapPrevDest);	// Restore DC's original bitmap
+			auto pPixels = static_cast<uint32_t *>(pvBits);
+			size_t cPixels = sizeIcon.cx * sizeIcon.cy;
 
-			hbitmapRet = hbitmapDest;
-		}
+			if (iconInfo.hbmColor &&
+				GetDIBits(hdc, iconInfo.hbmColor, 0, sizeIcon.cy, pvBits, &bmi, DIB_RGB_COLORS) == sizeIcon.cy)
+			{
+				bool bHasAlpha = false;
+				for (size_t i = 0; i < cPixels && !bHasAlpha; ++i)
+					bHasAlpha = ((pPixels[i] >> 24) != 0);
+
+				// NOTE: Icons without an alpha channel get their transparency from mask
+				if (!bHasAlpha)
+				{
+					uint32_t *pMask = new (std::nothrow) uint32_t[cPixels];
+					if (pMask && GetDIBits(hdc, iconInfo.hbmMask, 0, sizeIcon.cy, pMask, &bmi, DIB_RGB_COLORS) == sizeIcon.cy)
+					{
+						for (size_t i = 0; i < cPixels; ++i)
+							pPixels[i] = (pPixels[i] & 0x00FFFFFF) | ((pMask[i] & 0x00FFFFFF) ? 0 : 0xFF000000);
+					}
+					delete[] pMask;
+				}
+
+				PixelKernels::PremultiplyAlpha(pPixels, cPixels);
+				GdiFlush();
 
-		DeleteDC(hdcDest);
+				hbitmapRet = hbitmapDest;
+			}
+			else
+				DeleteObject(hbitmapDest);
+		}
 	}
 
+	if (iconInfo.hbmColor)
+		DeleteObject(iconInfo.hbmColor);
+	if (iconInfo.hbmMask)
+		DeleteObject(iconInfo.hbmMask);
+	if (hdc)
+		ReleaseDC(NULL, hdc);
+	DestroyIcon(hIcon);
+
 	return hbitmapRet;
 }
+
+// Returns DPI of monitor containing given point
+UINT Utility::GetDpiForPoint(POINT pt)
+{
+	typedef HRESULT (WINAPI *GetDpiForMonitor_t)(HMONITOR, int, UINT *, UINT *);
+
+	// NOTE: Explorer links to 'shcore.dll' itself from Windows 8.1 on, so we needn't load it or hold a reference to it.
+	//		 Where it isn't loaded, there is no per-monitor DPI anyway.
+	static auto pfnGetDpiForMonitor = []() -> GetDpiForMonitor_t
+	{
+		auto hmoduleShcore = GetModuleHandle(L"shcore.dll");
+		return (hmoduleShcore ? (GetDpiForMonitor_t)GetProcAddress(hmoduleShcore, "GetDpiForMonitor") : NULL);
+	}();
+
+	UINT dpiX, dpiY;
+	if (pfnGetDpiForMonitor &&
+		SUCCEEDED(pfnGetDpiForMonitor(MonitorFromPoint(pt, MONITOR_DEFAULTTONEAREST), 0 /* MDT_EFFECTIVE_DPI */, &dpiX, &dpiY)))
+	{
+		return dpiX;
+	}
+
+	// NOTE: Before Windows 8.1, there is only system DPI
+	UINT dpi = USER_DEFAULT_SCREEN_DPI;
+	HDC hdc = GetDC(NULL);
+	if (hdc)
+	{
+		dpi = GetDeviceCaps(hdc, LOGPIXELSX);
+		ReleaseDC(NULL, hdc);
+	}
+
+	return dpi;
+}
\ No newline at end of file
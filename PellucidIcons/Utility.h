@@ -6,5 +6,6 @@ class Utility
 {
 public:
 	static HRESULT Create32BitHBITMAP(HDC hdc, const SIZE *psize, __deref_opt_out void **ppvBits, __out HBITMAP* phBmp);
-	static HBITMAP ConvertIconHandleToBitmapHandle(HICON hIcon);
+	static HBITMAP CreatePremultipliedIconBitmap(HINSTANCE hInst, LPCWSTR szIconName, UINT dpi);
+	static UINT GetDpiForPoint(POINT pt);
 };
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "VisibilityMonitor.h"
+#include <shellapi.h>
+#include <VersionHelpers.h>
+#include <WtsApi32.h>
+
+extern HINSTANCE g_hInst;
+
+// Static variables
+ATOM VisibilityMonitor::s_atomWindowClass = 0;
+
+
+VisibilityMonitor::VisibilityMonitor(VisibilityOracle& oracle)
+	: m_oracle(oracle),
+	m_hwnd(NULL),
+	m_hwndDesktop(NULL),
+	m_hPowerNotify(NULL)
+{
+}
+
+bool VisibilityMonitor::Create(HWND hwndDesktop)
+{
+	m_hwndDesktop = hwndDesktop;
+	if (IsCreated())
+		return true;
+
+	// NOTE: Whatever was known before is stale, e.g. if thread of previous window has gone
+	m_oracle.Clear();
+	m_hPowerNotify = NULL;
+
+	if (!s_atomWindowClass)
+		s_atomWindowClass = registerWindowClass();
+	if (!s_atomWindowClass)
+		return false;
+	m_hwnd = CreateWindowEx(WS_EX_TOOLWINDOW, MAKEINTATOM(s_atomWindowClass), L"", WS_POPUP,
+							0, 0, 0, 0, NULL, NULL, g_hInst, this);
+	if (!m_hwnd)
+		return false;
+
+	// IMPORTANT: Display state is sent right away on registering, so nothing else needs to be queried for it
+	WTSRegisterSessionNotification(m_hwnd, NOTIFY_FOR_THIS_SESSION);
+	m_hPowerNotify = RegisterPowerSettingNotification(m_hwnd, &GUID_CONSOLE_DISPLAY_STATE, DEVICE_NOTIFY_WINDOW_HANDLE);
+
+	APPBARDATA appBarData = { sizeof(appBarData) };
+	appBarData.hWnd = m_hwnd;
+	appBarData.uCallbackMessage = getAppBarMessage();
+	SHAppBarMessage(ABM_NEW, &appBarData);
+
+	querySessionState();
+	return true;
+}
+
+// NOTE: Notifications are unregistered and oracle cleared as window is destroyed
+void VisibilityMonitor::Destroy()
+{
+	if (IsCreated())
+		DestroyWindow(m_hwnd);
+	m_hwnd = NULL;
+	m_hwndDesktop = NULL;
+}
+
+bool VisibilityMonitor::IsCreated() const
+{
+	return (m_hwnd && IsWindow(m_hwnd) != FALSE);
+}
+
+void VisibilityMonitor::UnregisterWindowClass()
+{
+	if (s_atomWindowClass && UnregisterClass(MAKEINTATOM(s_atomWindowClass), g_hInst))
+		s_atomWindowClass = 0;
+}
+
+// Session may already be locked or disconnected when we are created
+void VisibilityMonitor::querySessionState()
+{
+	LPWSTR pBuffer = NULL;
+	DWORD cbBuffer = 0;
+	if (WTSQuerySessionInformation(WTS_CURRENT_SERVER_HANDLE, WTS_CURRENT_SESSION, WTSSessionInfoEx, &pBuffer, &cbBuffer) == FALSE)
+		return;
+
+	auto pSessionInfo = reinterpret_cast<const WTSINFOEX *>(pBuffer);
+	if (cbBuffer >= sizeof(WTSINFOEX) && pSessionInfo->Level == 1)
+	{
+		// CAUTION: Before Windows 8, lock flag means just the opposite. There session is taken to be unlocked
+		//			until told otherwise by 'WTS_SESSION_LOCK'.
+		if (IsWindows8OrGreater())
+			m_oracle.Set(VisibilityOracle::reasonSessionLocked, pSessionInfo->Data.WTSInfoExLevel1.SessionFlags == WTS_SESSIONSTATE_LOCK);
+		m_oracle.Set(VisibilityOracle::reasonSessionDisconnected, pSessionInfo->Data.WTSInfoExLevel1.SessionState == WTSDisconnected);
+	}
+
+	WTSFreeMemory(pBuffer);
+}
+
+void VisibilityMonitor::onSessionChange(WPARAM wParam)
+{
+	switch (wParam)
+	{
+		case WTS_SESSION_LOCK:
+		case WTS_SESSION_UNLOCK:
+			m_oracle.Set(VisibilityOracle::reasonSessionLocked, wParam == WTS_SESSION_LOCK);
+			break;
+
+		// NOTE: Switching between console and remote client disconnects one, then connects other
+		case WTS_CONSOLE_DISCONNECT:
+		case WTS_REMOTE_DISCONNECT:
+			m_oracle.Set(VisibilityOracle::reasonSessionDisconnected, true);
+			break;
+
+		case WTS_CONSOLE_CONNECT:
+		case WTS_REMOTE_CONNECT:
+			m_oracle.Set(VisibilityOracle::reasonSessionDisconnected, false);
+			break;
+
+		default:
+			break;
+	}
+}
+
+void VisibilityMonitor::onPowerBroadcast(WPARAM wParam, LPARAM lParam)
+{
+	if (wParam != PBT_POWERSETTINGCHANGE)
+		return;
+
+	auto pSetting = reinterpret_cast<const POWERBROADCAST_SETTING *>(lParam);
+	if (!pSetting || !IsEqualGUID(pSetting->PowerSetting, GUID_CONSOLE_DISPLAY_STATE) || pSetting->DataLength < sizeof(DWORD))
+		return;
+
+	// NOTE: Display state is 0 for off, 1 for on and 2 for dimmed, which can still be seen
+	auto displayState = *reinterpret_cast<const DWORD *>(pSetting->Data);
+	m_oracle.Set(VisibilityOracle::reasonDisplayOff, displayState == 0);
+}
+
+void VisibilityMonitor::onAppBarNotify(WPARAM wParam, LPARAM lParam)
+{
+	if (wParam != ABN_FULLSCREENAPP)
+		return;
+
+	bool bFullScreen = (lParam != FALSE && isDesktopCovered());
+	m_oracle.Set(VisibilityOracle::reasonFullScreen, bFullScreen);
+}
+
+// Whether foreground window fills every monitor desktop is shown on
+// CAUTION: Shell tells about a full-screen application on any monitor, so desktop may still be
+//			seen on another. With one full-screen application per monitor, desktop is taken to be seen.
+bool VisibilityMonitor::isDesktopCovered() const
+{
+	auto hwndForeground = GetForegroundWindow();
+	RECT rectDesktop, rectForeground;
+	if (!m_hwndDesktop || !hwndForeground ||
+		GetWindowRect(m_hwndDesktop, &rectDesktop) == FALSE || GetWindowRect(hwndForeground, &rectForeground) == FALSE)
+		return false;
+
+	auto hmonitorForeground = MonitorFromWindow(hwndForeground, MONITOR_DEFAULTTONULL);
+	MONITORINFO monitorInfo = { sizeof(monitorInfo) };
+	if (!hmonitorForeground || GetMonitorInfo(hmonitorForeground, &monitorInfo) == FALSE)
+		return false;
+
+	RECT rectCovered;
+	if (IntersectRect(&rectCovered, &rectForeground, &monitorInfo.rcMonitor) == FALSE ||
+		EqualRect(&rectCovered, &monitorInfo.rcMonitor) == FALSE)
+		return false;
+
+	MonitorSearch search = { hmonitorForeground, false, false };
+	EnumDisplayMonitors(NULL, &rectDesktop, &Monitor_EnumProc, reinterpret_cast<LPARAM>(&search));
+	return (search.bCovered && !search.bUncovered);
+}
+
+BOOL CALLBACK VisibilityMonitor::Monitor_EnumProc(HMONITOR hmonitor, HDC hdc, LPRECT pRect, LPARAM lParam)
+{
+	auto pSearch = reinterpret_cast<MonitorSearch *>(lParam);
+	if (hmonitor == pSearch->hmonitorCovered)
+		pSearch->bCovered = true;
+	else
+		pSearch->bUncovered = true;
+
+	return !pSearch->bUncovered;		// NOTE: Desktop can be seen on this one, no need to look further
+}
+
+UINT VisibilityMonitor::getAppBarMessage()
+{
+	static const UINT s_uAppBarMessage = RegisterWindowMessage(L"PellucidIcons.VisibilityMonitor.AppBar");
+
+	return s_uAppBarMessage;
+}
+
+ATOM VisibilityMonitor::registerWindowClass()
+{
+	WNDCLASSEX windowClass = { sizeof(windowClass) };
+	windowClass.lpfnWndProc = &Window_WndProc;
+	windowClass.hInstance = g_hInst;
+	windowClass.lpszClassName = L"PellucidIcons.VisibilityMonitor";
+
+	return RegisterClassEx(&windowClass);
+}
+
+LRESULT CALLBACK VisibilityMonitor::Window_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	if (uMsg == WM_NCCREATE)
+	{
+		auto pCreateStruct = reinterpret_cast<const CREATESTRUCT *>(lParam);
+		SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(pCreateStruct->lpCreateParams));
+	}
+
+	auto pThis = reinterpret_cast<VisibilityMonitor *>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+	if (!pThis)
+		return DefWindowProc(hwnd, uMsg, wParam, lParam);
+
+	if (uMsg == getAppBarMessage())
+	{
+		pThis->onAppBarNotify(wParam, lParam);
+		return 0;
+	}
+
+	switch (uMsg)
+	{
+		case WM_WTSSESSION_CHANGE:
+			pThis->onSessionChange(wParam);
+			return 0;
+
+		case WM_POWERBROADCAST:
+			pThis->onPowerBroadcast(wParam, lParam);
+			return TRUE;
+
+		case WM_DESTROY:
+		{
+			APPBARDATA appBarData = { sizeof(appBarData) };
+			appBarData.hWnd = hwnd;
+			SHAppBarMessage(ABM_REMOVE, &appBarData);
+
+			WTSUnRegisterSessionNotification(hwnd);
+			if (pThis->m_hPowerNotify)
+				UnregisterPowerSettingNotification(pThis->m_hPowerNotify), pThis->m_hPowerNotify = NULL;
+
+			pThis->m_oracle.Clear();	// NOTE: Without events, desktop is taken to be visible
+		}
+		break;
+
+		default:
+			break;
+	}
+
+	return DefWindowProc(hwnd, uMsg, wParam, lParam);
+}
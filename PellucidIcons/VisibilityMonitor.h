@@ -0,0 +1,49 @@
+#pragma once
+#include "VisibilityOracle.h"
+#include <Windows.h>
+
+
+// Feeds 'VisibilityOracle' from session lock, session connection, display power and full-screen
+// application notifications
+// NOTE: All of these come to one hidden window, which is registered as an app bar so that shell
+//		 tells it about full-screen applications. It lives on thread that creates it, which must
+//		 run a message loop, e.g. that of desktop ListView.
+class VisibilityMonitor
+{
+public:
+	VisibilityMonitor(VisibilityOracle& oracle);
+
+	bool Create(HWND hwndDesktop);	// Starts over with current state, unless window is still there
+	void Destroy();					// IMPORTANT: Call from thread that created it, e.g. before desktop is detached
+	bool IsCreated() const;
+
+	static void UnregisterWindowClass();	// IMPORTANT: Call before DLL is unloaded, once window is destroyed
+
+private:
+	// Monitors desktop is shown on, looked through for any but that of a full-screen application
+	struct MonitorSearch
+	{
+		HMONITOR hmonitorCovered;
+		bool bCovered;				// Desktop is on covered monitor
+		bool bUncovered;			// And also on another
+	};
+
+	void querySessionState();
+	void onSessionChange(WPARAM wParam);
+	void onPowerBroadcast(WPARAM wParam, LPARAM lParam);
+	void onAppBarNotify(WPARAM wParam, LPARAM lParam);
+	bool isDesktopCovered() const;
+
+	static BOOL CALLBACK Monitor_EnumProc(HMONITOR hmonitor, HDC hdc, LPRECT pRect, LPARAM lParam);
+
+	static UINT getAppBarMessage();
+	static ATOM registerWindowClass();
+	static LRESULT CALLBACK Window_WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+
+	static ATOM s_atomWindowClass;	// NOTE: Registered when first needed, and again after being unregistered
+
+	VisibilityOracle& m_oracle;
+	HWND m_hwnd;
+	HWND m_hwndDesktop;				// Whose monitors full-screen applications must cover
+	HPOWERNOTIFY m_hPowerNotify;
+};
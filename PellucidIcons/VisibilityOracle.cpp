@@ -0,0 +1,54 @@
+#include "VisibilityOracle.h"
+#include "Metrics.h"
+
+
+VisibilityOracle::VisibilityOracle(ChangedCallback changed, void *pContext)
+	: m_changed(changed),
+	m_pContext(pContext),
+	m_hiddenReasons(0),
+	m_cChanges(0)
+{
+}
+
+void VisibilityOracle::Set(Reason reason, bool bHidden)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto hiddenReasons = m_hiddenReasons.load(std::memory_order_relaxed);
+	update(bHidden ? (hiddenReasons | reason) : (hiddenReasons & ~static_cast<uint32_t>(reason)));
+}
+
+void VisibilityOracle::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	update(0);
+}
+
+bool VisibilityOracle::IsVisible() const
+{
+	return (getHiddenReasons() == 0);
+}
+
+uint32_t VisibilityOracle::getHiddenReasons() const
+{
+	return m_hiddenReasons.load(std::memory_order_relaxed);
+}
+
+uint32_t VisibilityOracle::getChangeCount() const
+{
+	return m_cChanges.load(std::memory_order_relaxed);
+}
+
+// CAUTION: Must be called with 'm_mutex' held
+void VisibilityOracle::update(uint32_t hiddenReasons)
+{
+	auto previousReasons = m_hiddenReasons.exchange(hiddenReasons, std::memory_order_relaxed);
+	if ((previousReasons == 0) == (hiddenReasons == 0))
+		return;		// NOTE: Another reason coming or going alone doesn't change anything
+
+	m_cChanges.fetch_add(1, std::memory_order_relaxed);
+	METRICS_INCREMENT(counterVisibilityChanged);
+
+	if (m_changed)
+		m_changed(hiddenReasons == 0, m_pContext);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+
+// Whether desktop can be seen at all, from events that hide it
+// NOTE: Each event sets or clears its own reason, and desktop is visible only while there is no
+//		 reason left. Callback is only made when that changes, in order, so timers can be gated on
+//		 it from any thread events come from.
+class VisibilityOracle
+{
+public:
+	enum Reason
+	{
+		reasonFullScreen = 1 << 0,			// A full-screen application covers desktop
+		reasonSessionLocked = 1 << 1,
+		reasonDisplayOff = 1 << 2,
+		reasonSessionDisconnected = 1 << 3	// Session has no console or remote client attached
+	};
+
+	typedef void(*ChangedCallback)(bool bVisible, void *pContext);
+
+	VisibilityOracle(ChangedCallback changed, void *pContext);
+
+	void Set(Reason reason, bool bHidden);	// Calls back if desktop became visible or hidden
+	void Clear();							// Forgets all reasons, e.g. when events can no longer be had
+
+	bool IsVisible() const;
+	uint32_t getHiddenReasons() const;
+	uint32_t getChangeCount() const;
+
+private:
+	void update(uint32_t hiddenReasons);
+
+	ChangedCallback m_changed;
+	void *m_pContext;
+
+	std::mutex m_mutex;						// NOTE: Held while calling back, so changes can't be reordered
+	std::atomic<uint32_t> m_hiddenReasons;
+	std::atomic<uint32_t> m_cChanges;
+};
@@ -0,0 +1,260 @@
+#include "Win32Platform.h"
+#include <CommCtrl.h>
+
+
+Win32Platform::Win32Platform()
+	: m_hwnd(NULL)
+{
+}
+
+void Win32Platform::setWindow(HWND hwnd)
+{
+	m_hwnd = hwnd;
+	m_selection.Invalidate();
+}
+
+HWND Win32Platform::getWindow() const
+{
+	return m_hwnd;
+}
+
+bool Win32Platform::getClientBounds(Rect& bounds)
+{
+	RECT rectClient;
+	if (!m_hwnd || GetClientRect(m_hwnd, &rectClient) == FALSE)
+		return false;
+
+	bounds.left = rectClient.left;
+	bounds.top = rectClient.top;
+	bounds.right = rectClient.right;
+	bounds.bottom = rectClient.bottom;
+	return true;
+}
+
+size_t Win32Platform::getMonitorBounds(Rect monitors[], size_t maxCount)
+{
+	if (!m_hwnd)
+		return 0;
+
+	MonitorList monitorList = { m_hwnd, monitors, 0, maxCount };
+	EnumDisplayMonitors(NULL, NULL, &MonitorEnumProc, reinterpret_cast<LPARAM>(&monitorList));
+
+	return monitorList.count;
+}
+
+void Win32Platform::OnNotify(const NMHDR *pNotifyHeader)
+{
+	if (pNotifyHeader->hwndFrom != m_hwnd || !m_selection.IsValid())
+		return;
+
+	switch (pNotifyHeader->code)
+	{
+		case LVN_ITEMCHANGED:
+		{
+			auto pNotifyListView = reinterpret_cast<const NMLISTVIEW *>(pNotifyHeader);
+			if ((pNotifyListView->uChanged & LVIF_STATE) == 0 ||
+				((pNotifyListView->uOldState ^ pNotifyListView->uNewState) & LVIS_SELECTED) == 0)
+				break;
+
+			bool bSelected = ((pNotifyListView->uNewState & LVIS_SELECTED) != 0);
+			if (pNotifyListView->iItem >= 0)
+			{
+				if (bSelected)
+					m_selection.Select(pNotifyListView->iItem);
+				else
+					m_selection.Deselect(pNotifyListView->iItem);
+			}
+			else if (bSelected)
+				m_selection.Invalidate();	// Everything selected, e.g. with Ctrl+A
+			else
+				m_selection.Clear();
+		}
+		break;
+
+		case LVN_INSERTITEM:
+			m_selection.OnInserted(reinterpret_cast<const NMLISTVIEW *>(pNotifyHeader)->iItem);
+			break;
+
+		case LVN_DELETEITEM:
+			m_selection.OnDeleted(reinterpret_cast<const NMLISTVIEW *>(pNotifyHeader)->iItem);
+			break;
+
+		case LVN_DELETEALLITEMS:
+			m_selection.Clear();
+			break;
+
+		case LVN_ODSTATECHANGED:
+			m_selection.Invalidate();	// NOTE: Ranges of owner data items, we don't follow these
+			break;
+
+		default:
+			break;
+	}
+}
+
+// NOTE: Walks selected items once, after that set is kept up to date from notifications
+void Win32Platform::ValidateSelection()
+{
+	if (m_selection.IsValid() || !m_hwnd)
+		return;
+
+	m_selection.Clear();
+	for (int index = ListView_GetNextItem(m_hwnd, -1, LVNI_SELECTED); index >= 0; index = ListView_GetNextItem(m_hwnd, index, LVNI_SELECTED))
+		m_selection.Select(index);
+}
+
+size_t Win32Platform::getSelectedCount()
+{
+	if (!m_selection.IsValid())
+		return ListView_GetSelectedCount(m_hwnd);
+
+	return m_selection.getCount();
+}
+
+// Deselects only items that are selected, rather than asking every item of window
+void Win32Platform::ClearSelection()
+{
+	while (m_selection.IsValid() && m_selection.getCount() > 0)
+	{
+		auto index = m_selection.getLast();
+		ListView_SetItemState(m_hwnd, index, FALSE, LVIS_SELECTED);
+		m_selection.Deselect(index);	// NOTE: Normally already done by notification of change
+	}
+
+	if (!m_selection.IsValid())
+		ListView_SetItemState(m_hwnd, -1, FALSE, LVIS_SELECTED);
+}
+
+size_t Win32Platform::getItemCount()
+{
+	if (!m_hwnd)
+		return 0;
+
+	auto cItems = ListView_GetItemCount(m_hwnd);
+	return (cItems > 0 ? static_cast<size_t>(cItems) : 0);
+}
+
+bool Win32Platform::getItemBounds(int index, Rect& bounds)
+{
+	RECT rectItem;
+	if (!m_hwnd || ListView_GetItemRect(m_hwnd, index, &rectItem, LVIR_BOUNDS) == FALSE)
+		return false;
+
+	bounds.left = rectItem.left;
+	bounds.top = rectItem.top;
+	bounds.right = rectItem.right;
+	bounds.bottom = rectItem.bottom;
+	return true;
+}
+
+BOOL CALLBACK Win32Platform::MonitorEnumProc(HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData)
+{
+	auto pMonitorList = reinterpret_cast<MonitorList *>(dwData);
+	if (pMonitorList->count >= pMonitorList->maxCount)
+		return FALSE;
+
+	// NOTE: Mouse messages come in client coordinates of window, so convert monitor
+	//		 rectangle from screen coordinates once here instead of per mouse move
+	RECT rectMonitor = *lprcMonitor;
+	MapWindowPoints(NULL, pMonitorList->hwnd, reinterpret_cast<LPPOINT>(&rectMonitor), 2);
+
+	auto& monitor = pMonitorList->pMonitors[pMonitorList->count++];
+	monitor.left = rectMonitor.left;
+	monitor.top = rectMonitor.top;
+	monitor.right = rectMonitor.right;
+	monitor.bottom = rectMonitor.bottom;
+
+	return TRUE;
+}
+
+
+Win32DesktopLocator::Win32DesktopLocator()
+	: m_function(nullptr),
+	m_pContext(nullptr),
+	m_callSequence(0),
+	m_succeededSequence(0)
+{
+}
+
+void *Win32DesktopLocator::FindShellWindow()
+{
+	auto hwndProgMan = FindWindow(L"Progman", L"Program Manager");
+	auto hwndShellView = (hwndProgMan ? FindWindowEx(hwndProgMan, NULL, L"ShellDLL_DefView", L"") : NULL);
+
+	// NOTE: With slideshow or animated wallpaper, shell moves its view to one of the 'WorkerW' windows
+	if (!hwndShellView)
+		EnumWindows(&WorkerWEnumProc, reinterpret_cast<LPARAM>(&hwndShellView));
+	if (!hwndShellView)
+		return NULL;
+
+	auto hwndFolderView = FindWindowEx(hwndShellView, NULL, L"SysListView32", L"FolderView");
+	if (!hwndFolderView)
+		return NULL;
+
+	// IMPORTANT: We can only subclass windows of our own process
+	DWORD processId = 0;
+	GetWindowThreadProcessId(hwndFolderView, &processId);
+	return (processId == GetCurrentProcessId() ? hwndFolderView : NULL);
+}
+
+bool Win32DesktopLocator::CallOnWindowThread(void *pWindow, WindowFunction function, void *pContext)
+{
+	auto hwnd = static_cast<HWND>(pWindow);
+	auto threadId = GetWindowThreadProcessId(hwnd, NULL);
+	if (threadId == 0)
+		return false;
+
+	m_function.store(function, std::memory_order_relaxed);
+	m_pContext.store(pContext, std::memory_order_relaxed);
+	auto sequence = m_callSequence.fetch_add(1, std::memory_order_release) + 1;
+
+	// NOTE: A call that gets through after we stopped waiting finds no hook, and window procedure
+	//		 ignores message it doesn't know
+	auto hHook = SetWindowsHookEx(WH_CALLWNDPROC, &CallWndProc, NULL, threadId);
+	if (!hHook)
+		return false;
+
+	DWORD_PTR result;
+	SendMessageTimeout(hwnd, getCallMessage(), sequence, reinterpret_cast<LPARAM>(this),
+					   SMTO_BLOCK | SMTO_ABORTIFHUNG, DESKTOPLOCATOR_CALLTIMEOUTMILLISECS, &result);
+	UnhookWindowsHookEx(hHook);
+
+	return (m_succeededSequence.load(std::memory_order_acquire) == sequence);
+}
+
+UINT Win32DesktopLocator::getCallMessage()
+{
+	static const UINT s_uCallMessage = RegisterWindowMessage(L"PellucidIcons.DesktopLocator.Call");
+
+	return s_uCallMessage;
+}
+
+BOOL CALLBACK Win32DesktopLocator::WorkerWEnumProc(HWND hwnd, LPARAM lParam)
+{
+	WCHAR szClassName[16];
+	if (GetClassName(hwnd, szClassName, ARRAYSIZE(szClassName)) == 0 || wcscmp(szClassName, L"WorkerW") != 0)
+		return TRUE;
+
+	auto hwndShellView = FindWindowEx(hwnd, NULL, L"ShellDLL_DefView", L"");
+	if (!hwndShellView)
+		return TRUE;
+
+	*reinterpret_cast<HWND *>(lParam) = hwndShellView;
+	return FALSE;	// Found, stop enumerating
+}
+
+// Runs call of 'CallOnWindowThread()' on window's thread
+LRESULT CALLBACK Win32DesktopLocator::CallWndProc(int nCode, WPARAM wParam, LPARAM lParam)
+{
+	auto pCallWndProc = reinterpret_cast<const CWPSTRUCT *>(lParam);
+	if (nCode == HC_ACTION && pCallWndProc->message == getCallMessage())
+	{
+		auto pThis = reinterpret_cast<Win32DesktopLocator *>(pCallWndProc->lParam);
+		auto sequence = static_cast<uint32_t>(pCallWndProc->wParam);
+		auto function = pThis->m_function.load(std::memory_order_relaxed);
+		if (function(pCallWndProc->hwnd, pThis->m_pContext.load(std::memory_order_relaxed)))
+			pThis->m_succeededSequence.store(sequence, std::memory_order_release);
+	}
+
+	return CallNextHookEx(NULL, nCode, wParam, lParam);
+}
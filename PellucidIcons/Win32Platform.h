@@ -0,0 +1,73 @@
+#pragma once
+#include "Platform.h"
+#include "SelectionSet.h"
+#include "ShellAttacher.h"
+#include <Windows.h>
+#include <atomic>
+#include <cstdint>
+
+#define DESKTOPLOCATOR_CALLTIMEOUTMILLISECS	1000	// How long desktop thread is waited for
+
+
+// Platform services of a list-view window
+class Win32Platform : public Platform
+{
+public:
+	Win32Platform();
+
+	void setWindow(HWND hwnd);
+	HWND getWindow() const;
+
+	// Selection tracking
+	// IMPORTANT: Notifications of window, sent to its parent, must be passed to 'OnNotify()'
+	void OnNotify(const NMHDR *pNotifyHeader);
+	void ValidateSelection();		// Rebuilds selection set if it couldn't follow changes, call on window's thread
+
+	// Platform
+	virtual bool getClientBounds(Rect& bounds);
+	virtual size_t getMonitorBounds(Rect monitors[], size_t maxCount);
+	virtual size_t getSelectedCount();
+	virtual void ClearSelection();
+	virtual size_t getItemCount();
+	virtual bool getItemBounds(int index, Rect& bounds);
+
+private:
+	struct MonitorList
+	{
+		HWND hwnd;
+		Rect *pMonitors;
+		size_t count;
+		size_t maxCount;
+	};
+
+	static BOOL CALLBACK MonitorEnumProc(HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData);
+
+	HWND m_hwnd;
+	SelectionSet m_selection;		// NOTE: Only touched from window's thread, but for invalidation
+};
+
+
+// Finds desktop list-view of this process, and runs code on its thread
+// NOTE: Call is sent to window as a registered message, which a hook on window's thread picks up
+//		 before window procedure sees it. Hook is only there while caller waits.
+class Win32DesktopLocator : public ShellAttacher::Locator
+{
+public:
+	Win32DesktopLocator();
+
+	// ShellAttacher::Locator
+	virtual void *FindShellWindow();
+	virtual bool CallOnWindowThread(void *pWindow, WindowFunction function, void *pContext);
+
+private:
+	static UINT getCallMessage();
+	static BOOL CALLBACK WorkerWEnumProc(HWND hwnd, LPARAM lParam);
+	static LRESULT CALLBACK CallWndProc(int nCode, WPARAM wParam, LPARAM lParam);
+
+	// NOTE: Kept here rather than on caller's stack, as window's thread may still be running a call
+	//		 its caller stopped waiting for. Calls are told apart by sequence number.
+	std::atomic<WindowFunction> m_function;
+	std::atomic<void *> m_pContext;
+	std::atomic<uint32_t> m_callSequence;
+	std::atomic<uint32_t> m_succeededSequence;
+};
@@ -0,0 +1,50 @@
+#include "WriteBehindQueue.h"
+
+
+WriteBehindQueue::WriteBehindQueue(TimerBackend& timer, uint32_t debounceMillisecs, FlushCallback flush, void *pContext)
+	: m_timer(timer),
+	m_debounceMillisecs(debounceMillisecs),
+	m_flush(flush),
+	m_pContext(pContext),
+	m_pendingMask(0),
+	m_inflightMask(0),
+	m_cFlushes(0)
+{
+}
+
+void WriteBehindQueue::MarkDirty(uint32_t mask)
+{
+	m_pendingMask.fetch_or(mask);
+	m_timer.Arm(m_debounceMillisecs);	// Debounce: restart quiet period
+}
+
+void WriteBehindQueue::Flush()
+{
+	std::lock_guard<std::mutex> lock(m_mutexFlush);
+
+	// NOTE: Fields being written stay in 'm_inflightMask' until written, so that a concurrent
+	//		 refresh from backing store doesn't pick up their old values
+	auto mask = m_pendingMask.load();
+	if (!mask)
+		return;
+
+	m_inflightMask.store(mask);
+	m_pendingMask.fetch_and(~mask);
+
+	if (m_flush(mask, m_pContext))
+		m_cFlushes.fetch_add(1, std::memory_order_relaxed);
+	else
+		m_pendingMask.fetch_or(mask);	// NOTE: Not re-armed, so written with next change or next 'Flush()'
+
+	m_inflightMask.store(0);
+}
+
+uint32_t WriteBehindQueue::getUnflushedMask() const
+{
+	return (m_pendingMask.load() | m_inflightMask.load());
+}
+
+uint64_t WriteBehindQueue::getFlushCount() const
+{
+	return m_cFlushes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "Timing.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+
+// Coalesces changes of up to 32 fields and flushes them off the caller's thread
+// NOTE: Each change only sets a dirty bit and pushes the debounced flush out. Fields are written
+//		 to the backing store in one batch once changes stop for 'debounceMillisecs'.
+class WriteBehindQueue
+{
+public:
+	typedef bool(*FlushCallback)(uint32_t dirtyMask, void *pContext);	// Returns false if fields weren't written
+
+	WriteBehindQueue(TimerBackend& timer, uint32_t debounceMillisecs, FlushCallback flush, void *pContext);
+
+	void MarkDirty(uint32_t mask);
+	void Flush();								// Writes out pending fields now, e.g. on shutdown
+												// NOTE: Fields that fail to write stay pending for next flush
+	uint32_t getUnflushedMask() const;			// Fields not yet in backing store, including one being written
+
+	uint64_t getFlushCount() const;				// Successful flushes only
+
+private:
+	TimerBackend& m_timer;
+	uint32_t m_debounceMillisecs;
+	FlushCallback m_flush;
+	void *m_pContext;
+
+	std::mutex m_mutexFlush;					// Serializes flushes
+	std::atomic<uint32_t> m_pendingMask;
+	std::atomic<uint32_t> m_inflightMask;
+	std::atomic<uint64_t> m_cFlushes;
+};
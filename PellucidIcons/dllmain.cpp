@@ -33,6 +33,7 @@ WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
 #include <atlbase.h>
 #include <atlcom.h>
 #include "ClassFactory.h"           // For the class factory
+#include "PellucidIconsHandlers.h"   // For unloading
 #include "Reg.h"
 
 
@@ -109,7 +110,12 @@ STDAPI DllGetClassObject(REFCLSID rclsid, REFIID riid, void **ppv)
 // 
 STDAPI DllCanUnloadNow(void)
 {
-    return g_cDllRef > 0 ? S_FALSE : S_OK;
+    if (g_cDllRef > 0)
+        return S_FALSE;
+
+    // IMPORTANT: Waits for thread pool callbacks, which can't be done from DllMain
+    PellucidHandlers::Unload();
+    return S_OK;
 }
 
 
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+
+
+// Fixed capacity queue which drops its oldest element on overflow
+// NOTE: Storage is inline, so nothing is ever allocated and nothing throws. Accessing
+//		 'front()', 'back()' or 'operator[]' on an empty buffer is a precondition violation.
+template<typename T, size_t N>
+class ring_buffer
+{
+	static_assert(N > 0, "ring_buffer capacity must be non-zero");
+
+private:
+	T m_items[N];
+	size_t m_head;		// Index of oldest element
+	size_t m_size;
+
+	static size_t wrap(size_t index)
+	{
+		return (index >= N ? index - N : index);
+	}
+
+public:
+	ring_buffer()
+		: m_items(),
+		m_head(0),
+		m_size(0) {}
+
+	static constexpr size_t capacity() { return N; }
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	bool full() const { return m_size == N; }
+
+	void push(const T& value)
+	{
+		if (m_size == N)
+		{
+			m_items[m_head] = value;	// Overwrite oldest
+			m_head = wrap(m_head + 1);
+		}
+		else
+			m_items[wrap(m_head + m_size++)] = value;
+	}
+
+	void clear()
+	{
+		m_head = 0;
+		m_size = 0;
+	}
+
+	// Index 0 is the oldest element
+	T& operator[](size_t index) { return m_items[wrap(m_head + index)]; }
+	const T& operator[](size_t index) const { return m_items[wrap(m_head + index)]; }
+
+	T& front() { return m_items[m_head]; }
+	const T& front() const { return m_items[m_head]; }
+	T& back() { return (*this)[m_size - 1]; }
+	const T& back() const { return (*this)[m_size - 1]; }
+};
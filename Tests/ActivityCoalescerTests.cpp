@@ -0,0 +1,68 @@
+#include "TestHarness.h"
+#include "ActivityCoalescer.h"
+#include "HeadlessEngine.h"
+
+
+TEST_CASE(FirstEventIsActedOnAtOnce)
+{
+	ActivityCoalescer coalescer(50);
+	CHECK(coalescer.OnActivity(1000));
+	CHECK_EQUAL(1u, coalescer.getActedCount());
+
+	// Even at time zero
+	ActivityCoalescer fromZero(50);
+	CHECK(fromZero.OnActivity(0));
+}
+
+TEST_CASE(AtMostOneActionPerQuantum)
+{
+	ActivityCoalescer coalescer(50);
+	CHECK(coalescer.OnActivity(1000));
+	CHECK(!coalescer.OnActivity(1000));
+	CHECK(!coalescer.OnActivity(1049));
+	CHECK(coalescer.OnActivity(1050));
+	CHECK(!coalescer.OnActivity(1099));
+
+	CHECK_EQUAL(5u, coalescer.getEventCount());
+	CHECK_EQUAL(2u, coalescer.getActedCount());
+}
+
+TEST_CASE(ResetActsOnNextEventButKeepsStatistics)
+{
+	ActivityCoalescer coalescer(50);
+	coalescer.OnActivity(1000);
+	coalescer.Reset();
+	CHECK(coalescer.OnActivity(1001));
+	CHECK_EQUAL(2u, coalescer.getEventCount());
+	CHECK_EQUAL(2u, coalescer.getActedCount());
+}
+
+TEST_CASE(ZeroQuantumActsOnEveryEvent)
+{
+	ActivityCoalescer coalescer(50);
+	coalescer.setQuantum(0);
+	CHECK_EQUAL(0u, coalescer.getQuantum());
+	for (int i = 0; i < 100; ++i)
+		CHECK(coalescer.OnActivity(1000));
+}
+
+// 8 kHz mouse moving fast enough for 'RestoreWhen::mousedMoved' for a second
+TEST_CASE(EngineActsOnHighRateMouseOncePerQuantum)
+{
+	HeadlessEngine headless;
+	headless.getEngine().setTuning(0, 0, 50);
+	headless.Start();
+
+	for (int ms = 0; ms < 1000; ++ms)
+	{
+		for (int i = 0; i < 8; ++i)
+			headless.getEngine().OnMouseMove((ms * 8 + i) * 20 % HEADLESSENGINE_CLIENTWIDTH, 500, headless.getSettings());
+		headless.Advance(1);
+	}
+
+	auto& coalescer = headless.getEngine().getActivityCoalescer();
+	CHECK(coalescer.getEventCount() >= 8000 - MOUSEPOS_HISTORYDEPTH);		// All but first few moves are activity
+	CHECK(coalescer.getActedCount() <= 1000 / 50 + 1);
+	CHECK(coalescer.getActedCount() >= 1000 / 50);
+	CHECK_EQUAL(OPACITY_OPAQUE, headless.getOpacity().getOpacity());
+}
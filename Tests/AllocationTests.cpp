@@ -0,0 +1,113 @@
+#include "TestHarness.h"
+#include "AllocationTracker.h"
+#include "HeadlessEngine.h"
+#include <memory>
+
+#define FADEMILLISECS	(FADE_FRAMES * FADE_FRAMEMILLISECS)
+#define ITEMCOLUMNS		20
+#define ITEMROWS		10
+#define ITEMSIZE		80
+
+
+// Every message and timer handler of the hot path, in steady state, for each setting
+// NOTE: This test is also run as a build step, see 'CMakeLists.txt', so a hot path that starts
+//		 allocating fails the build rather than waiting for someone to run the tests
+
+// Mouse sweeping desktop, clicks, leaving and coming back, and icons fading out and back in
+static void runSession(HeadlessEngine& headless)
+{
+	auto& engine = headless.getEngine();
+	auto& settings = headless.getSettings();
+	for (int pass = 0; pass < 3; ++pass)
+	{
+		engine.ValidateItems(settings);
+		for (int i = 0; i < 2000; ++i)
+		{
+			engine.OnMouseMove((i * 37) % HEADLESSENGINE_CLIENTWIDTH, (i * 11) % HEADLESSENGINE_CLIENTHEIGHT, settings);
+			headless.Advance(1);
+		}
+		engine.OnDoubleClick(settings);
+		engine.OnRightButtonDown();
+		engine.OnMouseLeave();
+
+		// Icons fade out on idle timer, then mouse moves over hidden icons
+		headless.Advance(Settings::convertInToMillisecs(settings.in) + FADEMILLISECS);
+		for (int i = 0; i < 2000; ++i)
+			engine.OnMouseMove(10 + (i * 3) % 400, 10 + (i * 7) % 400, settings);
+		engine.OnDoubleClick(settings);
+		engine.OnRightButtonDown();
+
+		// Desktop covered and uncovered
+		engine.Suspend();
+		engine.Resume();
+		engine.ResetTimer();
+		headless.Advance(FADEMILLISECS);
+	}
+}
+
+static void checkSessionDoesNotAllocate(Settings::RestoreWhen restoreWhen, Settings::To to)
+{
+	std::unique_ptr<HeadlessEngine> pHeadless(new HeadlessEngine());
+	FakeRevealBackend revealBackend;
+	auto settings = HeadlessEngine::getDefaultSettings();
+	settings.restoreWhen = restoreWhen;
+	settings.to = to;
+	pHeadless->setSettings(settings);
+	pHeadless->getEngine().setRevealBackend(&revealBackend);
+
+	auto& items = pHeadless->getPlatform().getItems();
+	for (int row = 0; row < ITEMROWS; ++row)
+	{
+		for (int column = 0; column < ITEMCOLUMNS; ++column)
+		{
+			Rect item = { column * ITEMSIZE, row * ITEMSIZE, (column + 1) * ITEMSIZE, (row + 1) * ITEMSIZE };
+			items.push_back(item);
+		}
+	}
+
+	uint32_t packedZone = 0x40400000;	// Left quarter of top quarter
+	pHeadless->getEngine().setHotZones(&packedZone, 1);
+	pHeadless->Start();
+
+	// NOTE: First session may build item grid, which is allowed to allocate once
+	runSession(*pHeadless);
+
+	AllocationScope allocationScope;
+	runSession(*pHeadless);
+	CHECK_EQUAL(0u, allocationScope.getAllocationCount());
+}
+
+TEST_CASE(TrackerCountsAllocations)
+{
+	// NOTE: Otherwise every other check here would pass without looking
+	AllocationScope allocationScope;
+	std::unique_ptr<int> pValue(new int(1));
+	CHECK_EQUAL(1u, allocationScope.getAllocationCount());
+}
+
+TEST_CASE(MouseMovedSessionDoesNotAllocate)
+{
+	checkSessionDoesNotAllocate(Settings::RestoreWhen::mousedMoved, Settings::To::fullTransparency);
+	checkSessionDoesNotAllocate(Settings::RestoreWhen::mousedMoved, Settings::To::semiTransparency);
+}
+
+TEST_CASE(RegionSessionDoesNotAllocate)
+{
+	checkSessionDoesNotAllocate(Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft, Settings::To::fullTransparency);
+}
+
+TEST_CASE(HotZoneSessionDoesNotAllocate)
+{
+	checkSessionDoesNotAllocate(Settings::RestoreWhen::mousedEntersHotZone, Settings::To::fullTransparency);
+}
+
+TEST_CASE(DoubleClickSessionDoesNotAllocate)
+{
+	checkSessionDoesNotAllocate(Settings::RestoreWhen::doubleClicked, Settings::To::fullTransparency);
+}
+
+TEST_CASE(HoverRevealSessionDoesNotAllocate)
+{
+	checkSessionDoesNotAllocate(Settings::RestoreWhen::doubleClicked, Settings::To::hoverReveal);
+	checkSessionDoesNotAllocate(Settings::RestoreWhen::mousedEntersHotZone, Settings::To::hoverReveal);
+}
@@ -0,0 +1,205 @@
+#include "TestHarness.h"
+#include "FadeEngine.h"
+#include "FakePlatform.h"
+
+#define FADEMILLISECS	(FADE_FRAMES * FADE_FRAMEMILLISECS)
+
+
+// Records every opacity set, with time it was set at
+class RecordingOpacity : public FadeEngine::Backend
+{
+public:
+	explicit RecordingOpacity(FakeClock& clock)
+		: m_clock(clock),
+		m_opacity(OPACITY_OPAQUE),
+		m_cSteps(0),
+		m_cBegins(0),
+		m_cEnds(0)
+	{
+	}
+
+	uint8_t getOpacity() const { return m_opacity; }
+	size_t getStepCount() const { return m_cSteps; }
+	uint8_t getStepOpacity(size_t i) const { return m_steps[i].opacity; }
+	uint64_t getStepTime(size_t i) const { return m_steps[i].time; }
+	size_t getBeginCount() const { return m_cBegins; }
+	size_t getEndCount() const { return m_cEnds; }
+
+	virtual bool SetOpacity(uint8_t opacity)
+	{
+		if (m_cSteps < sizeof(m_steps) / sizeof(m_steps[0]))
+			m_steps[m_cSteps++] = { m_clock.Now(), opacity };
+		m_opacity = opacity;
+		return true;
+	}
+
+	virtual bool GetOpacity(uint8_t& opacity)
+	{
+		opacity = m_opacity;
+		return true;
+	}
+
+	virtual void BeginFade(uint8_t opacity) { ++m_cBegins; }
+	virtual void EndFade(uint8_t opacity) { ++m_cEnds; }
+
+private:
+	struct Step
+	{
+		uint64_t time;
+		uint8_t opacity;
+	};
+
+	FakeClock& m_clock;
+	uint8_t m_opacity;
+	Step m_steps[4 * FADE_FRAMES];
+	size_t m_cSteps;
+	size_t m_cBegins;
+	size_t m_cEnds;
+};
+
+struct FadeFixture
+{
+	FakeClock clock;
+	FakeTimer frameTimer;
+	RecordingOpacity opacity;
+	FadeEngine fadeEngine;
+
+	FadeFixture()
+		: clock(1000),
+		frameTimer(clock, &FadeFixture::onFrameTimer, this),
+		opacity(clock),
+		fadeEngine(clock, frameTimer)
+	{
+		fadeEngine.setBackend(&opacity);
+	}
+
+	static void onFrameTimer(void *pContext)
+	{
+		static_cast<FadeFixture *>(pContext)->fadeEngine.OnFrameTimer();
+	}
+};
+
+TEST_CASE(FadeOutStepsOnePerFrameDeadline)
+{
+	FadeFixture fixture;
+	fixture.fadeEngine.FadeOut(OPACITY_HIDDEN, FadeEngine::Easing::linear);
+	CHECK(fixture.fadeEngine.IsFading());
+	CHECK_EQUAL(1u, fixture.opacity.getBeginCount());
+
+	fixture.clock.Advance(FADEMILLISECS);
+	CHECK(!fixture.fadeEngine.IsFading());
+	CHECK(fixture.fadeEngine.IsHidden());
+	CHECK_EQUAL(1u, fixture.opacity.getEndCount());
+	CHECK(!fixture.frameTimer.IsArmed());
+
+	// First frame is the opaque start, so it sets nothing
+	CHECK_EQUAL(static_cast<size_t>(FADE_FRAMES), fixture.opacity.getStepCount());
+	for (size_t i = 0; i < fixture.opacity.getStepCount(); ++i)
+	{
+		CHECK_EQUAL(1000u + (i + 1) * FADE_FRAMEMILLISECS, fixture.opacity.getStepTime(i));
+		if (i > 0)
+			CHECK(fixture.opacity.getStepOpacity(i) < fixture.opacity.getStepOpacity(i - 1));
+	}
+	CHECK_EQUAL(OPACITY_HIDDEN, fixture.opacity.getStepOpacity(FADE_FRAMES - 1));
+}
+
+TEST_CASE(EveryEasingEndsAtTarget)
+{
+	static const FadeEngine::Easing s_easings[] =
+	{
+		FadeEngine::Easing::linear,
+		FadeEngine::Easing::easeIn,
+		FadeEngine::Easing::easeOut,
+		FadeEngine::Easing::easeInOut
+	};
+
+	for (auto easing : s_easings)
+	{
+		FadeFixture fixture;
+		fixture.fadeEngine.FadeOut(0x40, easing);
+		fixture.clock.Advance(FADEMILLISECS);
+
+		CHECK_EQUAL(0x40, fixture.fadeEngine.getOpacity());
+		for (size_t i = 1; i < fixture.opacity.getStepCount(); ++i)
+			CHECK(fixture.opacity.getStepOpacity(i) <= fixture.opacity.getStepOpacity(i - 1));
+	}
+}
+
+TEST_CASE(LateFramesAreSkippedNotReplayed)
+{
+	FadeFixture fixture;
+	fixture.fadeEngine.FadeOut(OPACITY_HIDDEN, FadeEngine::Easing::linear);
+
+	// Frame timer comes 5 and a half frames late
+	fixture.frameTimer.Disarm();
+	fixture.clock.Advance(5 * FADE_FRAMEMILLISECS + FADE_FRAMEMILLISECS / 2);
+	fixture.fadeEngine.OnFrameTimer();
+	CHECK_EQUAL(1u, fixture.opacity.getStepCount());
+
+	// Next deadline stays on frame grid
+	CHECK_EQUAL(1000u + 6 * FADE_FRAMEMILLISECS, fixture.frameTimer.getDue());
+	fixture.clock.Advance(FADEMILLISECS);
+	CHECK_EQUAL(static_cast<size_t>(FADE_FRAMES - 4), fixture.opacity.getStepCount());
+	CHECK(fixture.fadeEngine.IsHidden());
+}
+
+TEST_CASE(RestoreCancelsWithinSameCall)
+{
+	FadeFixture fixture;
+	fixture.fadeEngine.FadeOut(OPACITY_HIDDEN, FadeEngine::Easing::linear);
+	fixture.clock.Advance(FADEMILLISECS / 2);
+
+	auto cSteps = fixture.opacity.getStepCount();
+	fixture.fadeEngine.Restore();
+	CHECK_EQUAL(OPACITY_OPAQUE, fixture.opacity.getOpacity());
+	CHECK_EQUAL(cSteps + 1, fixture.opacity.getStepCount());
+	CHECK_EQUAL(fixture.clock.Now(), fixture.opacity.getStepTime(cSteps));		// Zero latency
+	CHECK(!fixture.frameTimer.IsArmed());
+	CHECK(!fixture.fadeEngine.IsFading());
+
+	// Stale frame timer callback does nothing
+	fixture.fadeEngine.OnFrameTimer();
+	CHECK_EQUAL(cSteps + 1, fixture.opacity.getStepCount());
+}
+
+TEST_CASE(FadeInReversesFromCurrentFrame)
+{
+	FadeFixture fixture;
+	fixture.fadeEngine.FadeOut(OPACITY_HIDDEN, FadeEngine::Easing::linear);
+	fixture.clock.Advance(4 * FADE_FRAMEMILLISECS);
+	auto opacityAtFrame4 = fixture.fadeEngine.getOpacity();
+	auto opacityAtFrame3 = fixture.opacity.getStepOpacity(fixture.opacity.getStepCount() - 2);
+
+	// First step back is taken in the call itself
+	fixture.fadeEngine.FadeIn();
+	CHECK(fixture.fadeEngine.getOpacity() > opacityAtFrame4);
+	CHECK_EQUAL(opacityAtFrame3, fixture.fadeEngine.getOpacity());
+
+	// Takes only as many frames back as were taken forward
+	fixture.clock.Advance(3 * FADE_FRAMEMILLISECS);
+	CHECK_EQUAL(OPACITY_OPAQUE, fixture.fadeEngine.getOpacity());
+	CHECK(!fixture.fadeEngine.IsFading());
+	CHECK(!fixture.frameTimer.IsArmed());
+	CHECK_EQUAL(1u, fixture.opacity.getBeginCount());
+	CHECK_EQUAL(1u, fixture.opacity.getEndCount());
+}
+
+TEST_CASE(FadeInOnVisibleIconsDoesNothing)
+{
+	FadeFixture fixture;
+	fixture.fadeEngine.FadeIn();
+	CHECK_EQUAL(0u, fixture.opacity.getStepCount());
+	CHECK_EQUAL(0u, fixture.frameTimer.getArmCount());
+}
+
+TEST_CASE(FinishJumpsToLastFrame)
+{
+	FadeFixture fixture;
+	fixture.fadeEngine.FadeOut(OPACITY_HIDDEN, FadeEngine::Easing::easeInOut);
+	fixture.clock.Advance(FADE_FRAMEMILLISECS);
+
+	fixture.fadeEngine.Finish();
+	CHECK(fixture.fadeEngine.IsHidden());
+	CHECK(!fixture.fadeEngine.IsFading());
+	CHECK(!fixture.frameTimer.IsArmed());
+}
@@ -0,0 +1,145 @@
+#include "TestHarness.h"
+#include "HotZoneIndex.h"
+#include <cstdlib>
+
+#define BOUNDS_WIDTH		1920
+#define BOUNDS_HEIGHT		1080
+
+
+// Random zones, from thin edges to large rectangles, some reaching past bounds
+static size_t makeZones(Rect zones[], size_t count, unsigned int seed)
+{
+	srand(seed);
+	for (size_t i = 0; i < count; ++i)
+	{
+		int left = rand() % (BOUNDS_WIDTH + 40) - 20;
+		int top = rand() % (BOUNDS_HEIGHT + 40) - 20;
+		zones[i] = Rect{ left, top, left + 1 + rand() % 400, top + 1 + rand() % 300 };
+	}
+
+	return count;
+}
+
+// Checks every point of a coarse grid against testing each zone in turn
+static void checkAgainstLinearScan(const Rect zones[], size_t count, int margin)
+{
+	Rect bounds = { 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT };
+	HotZoneIndex index;
+	index.Build(bounds, zones, count, margin);
+
+	size_t cMismatches = 0;
+	for (int y = -3; y < BOUNDS_HEIGHT + 3; y += 3)
+	{
+		for (int x = -3; x < BOUNDS_WIDTH + 3; x += 3)
+		{
+			for (int grown = 0; grown < 2; ++grown)
+			{
+				bool bExpected = false;
+				if (bounds.contains(x, y))
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						auto zone = zones[i].intersect(bounds);
+						bExpected |= (!zone.isEmpty() && zone.inflate(grown ? margin : 0).contains(x, y));
+					}
+				}
+
+				auto hit = index.HitTest(x, y, grown != 0);
+				if ((hit >= 0) != bExpected)
+					++cMismatches;
+			}
+		}
+	}
+	CHECK_EQUAL(0u, cMismatches);
+}
+
+TEST_CASE(CornerZonesAreHit)
+{
+	Rect bounds = { 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT };
+	Rect zones[] =
+	{
+		{ 0, 0, 32, 32 },
+		{ BOUNDS_WIDTH - 32, 0, BOUNDS_WIDTH, 32 },
+		{ 0, BOUNDS_HEIGHT - 32, 32, BOUNDS_HEIGHT },
+		{ BOUNDS_WIDTH - 32, BOUNDS_HEIGHT - 32, BOUNDS_WIDTH, BOUNDS_HEIGHT }
+	};
+	HotZoneIndex index;
+	index.Build(bounds, zones, 4);
+	CHECK_EQUAL(4u, index.getZoneCount());
+
+	CHECK_EQUAL(0, index.HitTest(0, 0));
+	CHECK_EQUAL(1, index.HitTest(BOUNDS_WIDTH - 1, 31));
+	CHECK_EQUAL(2, index.HitTest(31, BOUNDS_HEIGHT - 1));
+	CHECK_EQUAL(3, index.HitTest(BOUNDS_WIDTH - 1, BOUNDS_HEIGHT - 1));
+	CHECK_EQUAL(-1, index.HitTest(32, 32));
+	CHECK_EQUAL(-1, index.HitTest(BOUNDS_WIDTH / 2, BOUNDS_HEIGHT / 2));
+	CHECK_EQUAL(-1, index.HitTest(-1, 0));				// Outside bounds
+	CHECK_EQUAL(-1, index.HitTest(BOUNDS_WIDTH, BOUNDS_HEIGHT));
+}
+
+TEST_CASE(EmptyAndOutOfBoundsZonesAreDropped)
+{
+	Rect bounds = { 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT };
+	Rect zones[] =
+	{
+		{ 10, 10, 10, 20 },									// Empty
+		{ -100, -100, -10, -10 },							// Outside
+		{ BOUNDS_WIDTH - 10, 100, BOUNDS_WIDTH + 100, 200 }	// Clipped
+	};
+	HotZoneIndex index;
+	index.Build(bounds, zones, 3);
+	CHECK_EQUAL(1u, index.getZoneCount());
+	CHECK_EQUAL(0, index.HitTest(BOUNDS_WIDTH - 1, 150));
+}
+
+TEST_CASE(MarginGrowsZonesOnlyWhenAsked)
+{
+	Rect bounds = { 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT };
+	Rect zone = { 500, 500, 600, 600 };
+	HotZoneIndex index;
+	index.Build(bounds, &zone, 1, 8);
+	CHECK_EQUAL(8, index.getMargin());
+
+	CHECK_EQUAL(-1, index.HitTest(495, 550));
+	CHECK_EQUAL(0, index.HitTest(495, 550, true));
+	CHECK_EQUAL(0, index.HitTest(607, 607, true));
+	CHECK_EQUAL(-1, index.HitTest(608, 550, true));
+}
+
+TEST_CASE(ZonesPastMaximumAreIgnored)
+{
+	Rect bounds = { 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT };
+	Rect zones[HOTZONEINDEX_MAXZONES + 1];
+	for (int i = 0; i <= HOTZONEINDEX_MAXZONES; ++i)
+		zones[i] = Rect{ i * 20, 0, i * 20 + 20, 20 };
+
+	HotZoneIndex index;
+	index.Build(bounds, zones, HOTZONEINDEX_MAXZONES + 1);
+	CHECK_EQUAL(static_cast<size_t>(HOTZONEINDEX_MAXZONES), index.getZoneCount());
+	CHECK_EQUAL(HOTZONEINDEX_MAXZONES - 1, index.HitTest((HOTZONEINDEX_MAXZONES - 1) * 20, 0));
+	CHECK_EQUAL(-1, index.HitTest(HOTZONEINDEX_MAXZONES * 20, 0));
+}
+
+TEST_CASE(ClearRemovesAllZones)
+{
+	Rect bounds = { 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT };
+	HotZoneIndex index;
+	index.Build(bounds, &bounds, 1);
+	CHECK_EQUAL(0, index.HitTest(100, 100));
+
+	index.Clear();
+	CHECK_EQUAL(0u, index.getZoneCount());
+	CHECK_EQUAL(-1, index.HitTest(100, 100));
+}
+
+TEST_CASE(MatchesLinearScan)
+{
+	static const size_t s_counts[] = { 1, 4, 16, HOTZONEINDEX_MAXZONES };
+	Rect zones[HOTZONEINDEX_MAXZONES];
+	for (auto count : s_counts)
+	{
+		makeZones(zones, count, static_cast<unsigned int>(count));
+		checkAgainstLinearScan(zones, count, 0);
+		checkAgainstLinearScan(zones, count, 12);
+	}
+}
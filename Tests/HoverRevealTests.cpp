@@ -0,0 +1,180 @@
+#include "TestHarness.h"
+#include "HoverReveal.h"
+
+#define ICONSIZE		80
+#define ICONSPACING		100
+#define RADIUS			160
+
+
+// Desktop of icons laid out in columns and rows, as list-view arranges them
+static void makeDesktop(ItemGrid& grid, int cColumns, int cRows)
+{
+	grid.Reset(Rect{ 0, 0, cColumns * ICONSPACING, cRows * ICONSPACING });
+	for (int i = 0; i < cColumns * cRows; ++i)
+	{
+		int left = (i % cColumns) * ICONSPACING, top = (i / cColumns) * ICONSPACING;
+		grid.Insert(i, Rect{ left, top, left + ICONSIZE, top + ICONSIZE });
+	}
+}
+
+static size_t countHiding(const HoverReveal::Change changes[], size_t count)
+{
+	size_t cHiding = 0;
+	for (size_t i = 0; i < count; ++i)
+		cHiding += (changes[i].alpha == 0 ? 1 : 0);
+	return cHiding;
+}
+
+TEST_CASE(AlphaRisesTowardsItem)
+{
+	Rect rect = { 100, 100, 180, 180 };
+	CHECK_EQUAL(0xFF, HoverReveal::getAlpha(rect, 140, 140, RADIUS));
+	CHECK_EQUAL(0xFF, HoverReveal::getAlpha(rect, 100, 179, RADIUS));		// Edges are on item
+	CHECK_EQUAL(0, HoverReveal::getAlpha(rect, 180 + RADIUS, 140, RADIUS));
+	CHECK_EQUAL(0, HoverReveal::getAlpha(rect, 100 - RADIUS, 100 - RADIUS, RADIUS));
+
+	uint8_t previousAlpha = 0;
+	for (int x = 180 + RADIUS; x >= 180; --x)
+	{
+		auto alpha = HoverReveal::getAlpha(rect, x, 140, RADIUS);
+		CHECK(alpha >= previousAlpha);
+		previousAlpha = alpha;
+	}
+}
+
+TEST_CASE(AlphaIsQuantized)
+{
+	Rect rect = { 0, 0, 1, 1 };
+	for (int x = 0; x < RADIUS; ++x)
+	{
+		auto alpha = HoverReveal::getAlpha(rect, x, 0, RADIUS);
+		CHECK_EQUAL(0, alpha * (HOVERREVEAL_ALPHASTEPS - 1) % 0xFF);
+	}
+}
+
+TEST_CASE(FirstUpdateRevealsItemsNearMouse)
+{
+	ItemGrid grid;
+	makeDesktop(grid, 10, 10);
+	HoverReveal hoverReveal;
+	hoverReveal.setRadius(RADIUS);
+
+	HoverReveal::Change changes[HOVERREVEAL_MAXCHANGES];
+	auto cChanges = hoverReveal.Update(grid, 540, 540, changes);
+	CHECK(cChanges > 1);
+	CHECK_EQUAL(cChanges, hoverReveal.getRevealedCount());
+	CHECK_EQUAL(0u, countHiding(changes, cChanges));
+
+	// Items far from mouse stay hidden
+	for (size_t i = 0; i < cChanges; ++i)
+	{
+		CHECK(changes[i].rect.left > 540 - RADIUS - ICONSIZE);
+		CHECK(changes[i].rect.right < 540 + RADIUS + ICONSIZE);
+	}
+}
+
+TEST_CASE(SameMouseGivesNoChanges)
+{
+	ItemGrid grid;
+	makeDesktop(grid, 10, 10);
+	HoverReveal hoverReveal;
+
+	HoverReveal::Change changes[HOVERREVEAL_MAXCHANGES];
+	hoverReveal.Update(grid, 540, 540, changes);
+	CHECK_EQUAL(0u, hoverReveal.Update(grid, 540, 540, changes));
+
+	// A small move mostly stays within the same alpha steps
+	auto cChanges = hoverReveal.Update(grid, 541, 540, changes);
+	CHECK(cChanges < hoverReveal.getRevealedCount());
+}
+
+TEST_CASE(MovingAwayHidesItemsFirst)
+{
+	ItemGrid grid;
+	makeDesktop(grid, 20, 10);
+	HoverReveal hoverReveal;
+
+	HoverReveal::Change changes[HOVERREVEAL_MAXCHANGES];
+	auto cRevealed = hoverReveal.Update(grid, 240, 540, changes);
+	auto cChanges = hoverReveal.Update(grid, 1740, 540, changes);
+
+	// Nothing is kept, so all revealed items are hidden, before new ones are revealed
+	CHECK_EQUAL(cRevealed, countHiding(changes, cChanges));
+	for (size_t i = 0; i < cChanges; ++i)
+		CHECK_EQUAL(i < cRevealed, changes[i].alpha == 0);
+}
+
+TEST_CASE(HidingRedrawsOverlappingItemsStillRevealed)
+{
+	// Two overlapping items, one of which moves out of radius
+	ItemGrid grid;
+	grid.Reset(Rect{ 0, 0, 1000, 1000 });
+	grid.Insert(0, Rect{ 100, 100, 180, 180 });
+	grid.Insert(1, Rect{ 150, 100, 230, 180 });
+	HoverReveal hoverReveal;
+	hoverReveal.setRadius(RADIUS);
+
+	HoverReveal::Change changes[HOVERREVEAL_MAXCHANGES];
+	CHECK_EQUAL(2u, hoverReveal.Update(grid, 190, 140, changes));
+	grid.Move(0, Rect{ 800, 800, 880, 880 });
+
+	// Kept item is drawn again at same alpha, as hiding the other cleared part of it
+	auto cChanges = hoverReveal.Update(grid, 190, 140, changes);
+	CHECK_EQUAL(2u, cChanges);
+	CHECK_EQUAL(0, changes[0].alpha);
+	CHECK(changes[0].rect == (Rect{ 100, 100, 180, 180 }));
+	CHECK(changes[1].rect == (Rect{ 150, 100, 230, 180 }));
+	CHECK_EQUAL(0xFF, changes[1].alpha);
+}
+
+TEST_CASE(RevealedItemsAreCapped)
+{
+	// Tiny icons, far more than can be revealed at once within radius
+	ItemGrid grid;
+	grid.Reset(Rect{ 0, 0, 1000, 1000 });
+	for (int i = 0; i < 10000; ++i)
+		grid.Insert(i, Rect{ (i % 100) * 10, (i / 100) * 10, (i % 100) * 10 + 8, (i / 100) * 10 + 8 });
+	HoverReveal hoverReveal;
+
+	HoverReveal::Change changes[HOVERREVEAL_MAXCHANGES];
+	auto cChanges = hoverReveal.Update(grid, 500, 500, changes);
+	CHECK(cChanges <= HOVERREVEAL_MAXITEMS);
+	CHECK(hoverReveal.getRevealedCount() <= HOVERREVEAL_MAXITEMS);
+
+	cChanges = hoverReveal.Update(grid, 100, 100, changes);
+	CHECK(cChanges <= HOVERREVEAL_MAXCHANGES);
+}
+
+TEST_CASE(HideAndResetForgetRevealedItems)
+{
+	ItemGrid grid;
+	makeDesktop(grid, 10, 10);
+	HoverReveal hoverReveal;
+
+	HoverReveal::Change changes[HOVERREVEAL_MAXCHANGES];
+	auto cRevealed = hoverReveal.Update(grid, 540, 540, changes);
+	CHECK_EQUAL(cRevealed, hoverReveal.Hide(changes));
+	CHECK_EQUAL(cRevealed, countHiding(changes, cRevealed));
+	CHECK_EQUAL(0u, hoverReveal.getRevealedCount());
+	CHECK_EQUAL(0u, hoverReveal.Hide(changes));
+
+	// After reset, whatever drew items starts from scratch, so all are revealed again
+	hoverReveal.Update(grid, 540, 540, changes);
+	hoverReveal.Reset();
+	CHECK_EQUAL(cRevealed, hoverReveal.Update(grid, 540, 540, changes));
+}
+
+TEST_CASE(InvalidGridRevealsNothing)
+{
+	ItemGrid grid;
+	HoverReveal hoverReveal;
+
+	HoverReveal::Change changes[HOVERREVEAL_MAXCHANGES];
+	CHECK_EQUAL(0u, hoverReveal.Update(grid, 540, 540, changes));
+
+	makeDesktop(grid, 10, 10);
+	auto cRevealed = hoverReveal.Update(grid, 540, 540, changes);
+	grid.Invalidate();
+	CHECK_EQUAL(cRevealed, hoverReveal.Update(grid, 540, 540, changes));		// All hidden
+	CHECK_EQUAL(0u, hoverReveal.getRevealedCount());
+}
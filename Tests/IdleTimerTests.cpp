@@ -0,0 +1,121 @@
+#include "TestHarness.h"
+#include "FakePlatform.h"
+#include "IdleTimer.h"
+
+#define INTERVALMILLISECS	5000
+
+
+// Idle timer on a fake timer, which counts when it elapsed
+struct IdleTimerFixture
+{
+	FakeClock clock;
+	FakeTimer timer;
+	IdleTimer idleTimer;
+	int cElapsed;
+
+	IdleTimerFixture()
+		: clock(1000),
+		timer(clock, &Timer_Callback, this),
+		idleTimer(timer),
+		cElapsed(0) {}
+
+	static void Timer_Callback(void *pContext)
+	{
+		auto pThis = static_cast<IdleTimerFixture *>(pContext);
+		if (pThis->idleTimer.OnFired(pThis->clock.Now()))
+			++pThis->cElapsed;
+	}
+};
+
+TEST_CASE(StartArmsForInterval)
+{
+	IdleTimerFixture fixture;
+	fixture.idleTimer.Start(fixture.clock.Now(), INTERVALMILLISECS);
+
+	CHECK(fixture.idleTimer.IsRunning());
+	CHECK(fixture.timer.IsArmed());
+	CHECK_EQUAL(fixture.clock.Now() + INTERVALMILLISECS, fixture.timer.getDue());
+	CHECK_EQUAL(1u, fixture.idleTimer.getArmCount());
+
+	fixture.clock.Advance(INTERVALMILLISECS);
+	CHECK_EQUAL(1, fixture.cElapsed);
+	CHECK(!fixture.timer.IsArmed());
+}
+
+TEST_CASE(BumpsWhileArmedDoNotTouchTimer)
+{
+	IdleTimerFixture fixture;
+	fixture.idleTimer.Start(fixture.clock.Now(), INTERVALMILLISECS);
+
+	// A 1000 Hz mouse for one interval
+	for (int i = 0; i < INTERVALMILLISECS - 1; ++i)
+	{
+		fixture.clock.Advance(1);
+		fixture.idleTimer.Bump(fixture.clock.Now());
+	}
+	CHECK_EQUAL(1u, fixture.timer.getArmCount());
+	CHECK_EQUAL(0u, fixture.timer.getDisarmCount());
+}
+
+TEST_CASE(FiringEarlyRearmsForRemainingTime)
+{
+	IdleTimerFixture fixture;
+	auto start = fixture.clock.Now();
+	fixture.idleTimer.Start(start, INTERVALMILLISECS);
+
+	fixture.clock.Advance(1000);
+	fixture.idleTimer.Bump(fixture.clock.Now());		// Deadline is now start + 6000
+
+	fixture.clock.Advance(INTERVALMILLISECS - 1000);
+	CHECK_EQUAL(0, fixture.cElapsed);
+	CHECK(fixture.timer.IsArmed());
+	CHECK_EQUAL(start + 1000 + INTERVALMILLISECS, fixture.timer.getDue());
+	CHECK_EQUAL(2u, fixture.idleTimer.getArmCount());
+
+	fixture.clock.Advance(1000);
+	CHECK_EQUAL(1, fixture.cElapsed);
+}
+
+TEST_CASE(BumpAfterElapsingArmsAgain)
+{
+	IdleTimerFixture fixture;
+	fixture.idleTimer.Start(fixture.clock.Now(), INTERVALMILLISECS);
+	fixture.clock.Advance(INTERVALMILLISECS);
+	CHECK_EQUAL(1, fixture.cElapsed);
+
+	fixture.idleTimer.Bump(fixture.clock.Now());
+	fixture.idleTimer.Bump(fixture.clock.Now());
+	CHECK_EQUAL(2u, fixture.idleTimer.getArmCount());
+	CHECK(fixture.timer.IsArmed());
+
+	fixture.clock.Advance(INTERVALMILLISECS);
+	CHECK_EQUAL(2, fixture.cElapsed);
+}
+
+TEST_CASE(StopDisarmsAndIgnoresLateFiring)
+{
+	IdleTimerFixture fixture;
+	fixture.idleTimer.Start(fixture.clock.Now(), INTERVALMILLISECS);
+	fixture.idleTimer.Stop();
+
+	CHECK(!fixture.idleTimer.IsRunning());
+	CHECK(!fixture.timer.IsArmed());
+
+	// Bumps after stopping don't start it again
+	fixture.idleTimer.Bump(fixture.clock.Now());
+	CHECK(!fixture.timer.IsArmed());
+
+	// Callback that was already running when stopped
+	CHECK(!fixture.idleTimer.OnFired(fixture.clock.Now() + INTERVALMILLISECS));
+}
+
+TEST_CASE(RestartWithShorterIntervalRearms)
+{
+	IdleTimerFixture fixture;
+	fixture.idleTimer.Start(fixture.clock.Now(), 60000);
+	fixture.idleTimer.Start(fixture.clock.Now(), INTERVALMILLISECS);
+
+	CHECK_EQUAL(fixture.clock.Now() + INTERVALMILLISECS, fixture.timer.getDue());
+	fixture.clock.Advance(INTERVALMILLISECS);
+	CHECK_EQUAL(1, fixture.cElapsed);
+}
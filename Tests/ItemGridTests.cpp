@@ -0,0 +1,230 @@
+#include "TestHarness.h"
+#include "AllocationTracker.h"
+#include "ItemGrid.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#define BOUNDS_WIDTH		1920
+#define BOUNDS_HEIGHT		1080
+#define ITEMS				1000
+#define OPERATIONS			5000
+
+
+// Random item rectangle, some reaching past bounds and a few empty, as for hidden items
+static Rect makeItemRect()
+{
+	if (rand() % 50 == 0)
+		return Rect();
+
+	int left = rand() % (BOUNDS_WIDTH + 200) - 100;
+	int top = rand() % (BOUNDS_HEIGHT + 200) - 100;
+	return Rect{ left, top, left + 1 + rand() % 300, top + 1 + rand() % 200 };
+}
+
+static bool isBefore(const Rect& rect, const Rect& other)
+{
+	if (rect.left != other.left)
+		return rect.left < other.left;
+	if (rect.top != other.top)
+		return rect.top < other.top;
+	if (rect.right != other.right)
+		return rect.right < other.right;
+	return rect.bottom < other.bottom;
+}
+
+// Checks rectangles found by grid against testing each item in turn
+static void checkAgainstLinearScan(const ItemGrid& grid, const std::vector<Rect>& items, const Rect& area)
+{
+	std::vector<Rect> expected;
+	for (auto& item : items)
+	{
+		if (!item.isEmpty() && !item.intersect(area).isEmpty())
+			expected.push_back(item);
+	}
+
+	std::vector<int> slots(items.size() + 1);
+	auto count = grid.Query(area, slots.data(), slots.size());
+	std::vector<Rect> found;
+	for (size_t i = 0; i < count; ++i)
+		found.push_back(grid.getSlotRect(slots[i]));
+
+	std::sort(expected.begin(), expected.end(), &isBefore);
+	std::sort(found.begin(), found.end(), &isBefore);
+	CHECK_EQUAL(expected.size(), found.size());
+	CHECK(expected == found);
+}
+
+TEST_CASE(StartsInvalidAndResetMakesItValid)
+{
+	ItemGrid grid;
+	CHECK(!grid.IsValid());
+
+	// Changes while invalid are dropped
+	grid.Insert(0, Rect{ 0, 0, 10, 10 });
+	CHECK_EQUAL(0u, grid.getCount());
+
+	grid.Reset(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT });
+	CHECK(grid.IsValid());
+	CHECK_EQUAL(0u, grid.getCount());
+
+	int slots[4];
+	CHECK_EQUAL(0u, grid.Query(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT }, slots, 4));
+}
+
+TEST_CASE(BadIndexInvalidates)
+{
+	ItemGrid grid;
+	grid.Reset(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT });
+	grid.Insert(0, Rect{ 0, 0, 10, 10 });
+	grid.Insert(2, Rect{ 0, 0, 10, 10 });
+	CHECK(!grid.IsValid());
+	CHECK_EQUAL(0u, grid.getCount());
+
+	grid.Reset(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT });
+	grid.Remove(0);
+	CHECK(!grid.IsValid());
+
+	grid.Reset(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT });
+	grid.Insert(0, Rect{ 0, 0, 10, 10 });
+	grid.Move(-1, Rect{ 0, 0, 10, 10 });
+	CHECK(!grid.IsValid());
+}
+
+TEST_CASE(ItemOverManyCellsIsFoundOnce)
+{
+	ItemGrid grid;
+	grid.Reset(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT });
+	grid.Insert(0, Rect{ 10, 10, 10 + 5 * ITEMGRID_CELLSIZE, 10 + 3 * ITEMGRID_CELLSIZE });
+
+	int slots[4];
+	CHECK_EQUAL(1u, grid.Query(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT }, slots, 4));
+
+	// Again, once stamps have been used
+	CHECK_EQUAL(1u, grid.Query(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT }, slots, 4));
+}
+
+TEST_CASE(ItemsOutsideBoundsAreFoundInEdgeCells)
+{
+	ItemGrid grid;
+	grid.Reset(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT });
+	grid.Insert(0, Rect{ -500, -500, -400, -400 });
+	grid.Insert(1, Rect{ BOUNDS_WIDTH + 100, BOUNDS_HEIGHT + 100, BOUNDS_WIDTH + 200, BOUNDS_HEIGHT + 200 });
+
+	int slots[4];
+	CHECK_EQUAL(1u, grid.Query(Rect{ -450, -450, -440, -440 }, slots, 4));
+	CHECK(grid.getSlotRect(slots[0]) == (Rect{ -500, -500, -400, -400 }));
+	CHECK_EQUAL(1u, grid.Query(Rect{ BOUNDS_WIDTH + 150, BOUNDS_HEIGHT + 150, BOUNDS_WIDTH + 160, BOUNDS_HEIGHT + 160 }, slots, 4));
+
+	// Near edge cell but not overlapping, so not found
+	CHECK_EQUAL(0u, grid.Query(Rect{ 0, 0, 10, 10 }, slots, 4));
+}
+
+TEST_CASE(QueryStopsAtMaxSlots)
+{
+	ItemGrid grid;
+	grid.Reset(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT });
+	for (int i = 0; i < 10; ++i)
+		grid.Insert(i, Rect{ 0, 0, 10, 10 });
+
+	int slots[4];
+	CHECK_EQUAL(4u, grid.Query(Rect{ 0, 0, 10, 10 }, slots, 4));
+}
+
+TEST_CASE(SlotsFollowIndicesThroughInsertAndRemove)
+{
+	ItemGrid grid;
+	grid.Reset(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT });
+	grid.Insert(0, Rect{ 0, 0, 10, 10 });
+	grid.Insert(1, Rect{ 100, 0, 110, 10 });
+	grid.Insert(0, Rect{ 200, 0, 210, 10 });		// Others move up
+
+	// Moving what is now item 2 moves rectangle inserted second
+	grid.Move(2, Rect{ 500, 500, 510, 510 });
+	int slots[4];
+	CHECK_EQUAL(0u, grid.Query(Rect{ 100, 0, 110, 10 }, slots, 4));
+	CHECK_EQUAL(1u, grid.Query(Rect{ 500, 500, 510, 510 }, slots, 4));
+
+	// Removing first item moves others down, so item 0 is rectangle inserted first
+	grid.Remove(0);
+	grid.Remove(0);
+	CHECK_EQUAL(1u, grid.getCount());
+	CHECK_EQUAL(1u, grid.Query(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT }, slots, 4));
+	CHECK(grid.getSlotRect(slots[0]) == (Rect{ 500, 500, 510, 510 }));
+}
+
+TEST_CASE(MatchesLinearScanOverRandomChanges)
+{
+	srand(1);
+	std::vector<Rect> items;
+	ItemGrid grid;
+	grid.Reset(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT });
+	for (int i = 0; i < ITEMS; ++i)
+	{
+		items.push_back(makeItemRect());
+		grid.Insert(i, items.back());
+	}
+
+	for (int i = 0; i < OPERATIONS; ++i)
+	{
+		auto index = rand() % static_cast<int>(items.size());
+		switch (rand() % 4)
+		{
+			case 0:
+				items.insert(items.begin() + index, makeItemRect());
+				grid.Insert(index, items[index]);
+				break;
+
+			case 1:
+				items.erase(items.begin() + index);
+				grid.Remove(index);
+				break;
+
+			default:
+				items[index] = makeItemRect();
+				grid.Move(index, items[index]);
+				break;
+		}
+
+		if (i % 100 == 0)
+			checkAgainstLinearScan(grid, items, makeItemRect().inflate(50));
+	}
+
+	CHECK(grid.IsValid());
+	CHECK_EQUAL(items.size(), grid.getCount());
+	checkAgainstLinearScan(grid, items, Rect{ -1000, -1000, BOUNDS_WIDTH + 1000, BOUNDS_HEIGHT + 1000 });
+}
+
+TEST_CASE(LargeBoundsKeepCellCountBounded)
+{
+	// NOTE: Spanning many monitors, cells grow rather than their count
+	ItemGrid grid;
+	grid.Reset(Rect{ 0, 0, 64 * ITEMGRID_CELLSIZE * ITEMGRID_MAXCELLSPERSIDE, 100 });
+	grid.Insert(0, Rect{ 10, 10, 20, 20 });
+
+	int slots[4];
+	CHECK_EQUAL(1u, grid.Query(Rect{ 0, 0, 30, 30 }, slots, 4));
+}
+
+TEST_CASE(QueriesAndMovesWithinCapacityDoNotAllocate)
+{
+	ItemGrid grid;
+	grid.Reset(Rect{ 0, 0, BOUNDS_WIDTH, BOUNDS_HEIGHT });
+	for (int i = 0; i < 100; ++i)
+		grid.Insert(i, Rect{ (i % 20) * 90, (i / 20) * 90, (i % 20) * 90 + 80, (i / 20) * 90 + 80 });
+
+	// NOTE: A mouse sweep queries every time, while items are dragged back and forth between the same cells
+	int slots[64];
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		AllocationScope allocationScope;
+		size_t cFound = 0;
+		for (int x = 0; x < BOUNDS_WIDTH; x += 7)
+			cFound += grid.Query(Rect{ x - 160, 200, x + 160, 520 }, slots, 64);
+		grid.Move(0, Rect{ 1000, 1000, 1080, 1080 });
+		grid.Move(0, Rect{ 0, 0, 80, 80 });
+		CHECK(cFound > 0);
+		if (pass == 1)
+			CHECK_EQUAL(0u, allocationScope.getAllocationCount());
+	}
+}
@@ -0,0 +1,189 @@
+#include "TestHarness.h"
+#include "MenuTemplate.h"
+#include <cstring>
+#include <vector>
+
+#define RESINFO_POPUP		0x01
+#define RESINFO_LAST		0x80
+#define STATE_CHECKED		0x00000008
+
+// Resource IDs of test menu, laid out like the context menu
+#define ID_IN_FIRST			100		// Six items
+#define ID_RESTOREWHEN_FIRST	200		// Four items
+#define ID_TO_FIRST			300		// Three items
+#define ID_ENABLED			400
+
+
+// Builds a 'MENUEX' template in memory, as a resource compiler would
+class MenuBuilder
+{
+public:
+	MenuBuilder()
+	{
+		putWord(1);			// Version
+		putWord(4);			// Offset to items, past help ID
+		putDword(0);		// Help ID
+	}
+
+	void Item(uint32_t id, const char *pszText, bool bLast, uint32_t state = 0)
+	{
+		beginItem(id, state, bLast ? RESINFO_LAST : 0, pszText);
+	}
+
+	// Items up to the one with 'bLast' set are in popup
+	void Popup(const char *pszText, bool bLast)
+	{
+		beginItem(0, 0, RESINFO_POPUP | (bLast ? RESINFO_LAST : 0), pszText);
+		align();
+		putDword(0);		// Help ID of popup
+	}
+
+	const std::vector<uint8_t>& getData() const { return m_data; }
+
+private:
+	void beginItem(uint32_t id, uint32_t state, uint16_t resInfo, const char *pszText)
+	{
+		align();
+		putDword(0);		// Type
+		putDword(state);
+		putDword(id);
+		putWord(resInfo);
+		for (auto psz = pszText; *psz; ++psz)
+			putWord(static_cast<uint16_t>(*psz));
+		putWord(0);
+	}
+
+	void align()
+	{
+		while (m_data.size() % 4)
+			m_data.push_back(0);
+	}
+
+	void putWord(uint16_t value)
+	{
+		m_data.push_back(static_cast<uint8_t>(value));
+		m_data.push_back(static_cast<uint8_t>(value >> 8));
+	}
+
+	void putDword(uint32_t value)
+	{
+		putWord(static_cast<uint16_t>(value));
+		putWord(static_cast<uint16_t>(value >> 16));
+	}
+
+	std::vector<uint8_t> m_data;
+};
+
+static std::vector<uint8_t> buildContextMenu()
+{
+	MenuBuilder builder;
+	builder.Popup("Pellucid Icons", true);
+	{
+		builder.Popup("In", false);
+		for (int i = 0; i < 6; ++i)
+			builder.Item(ID_IN_FIRST + i, "secs", i == 5);
+
+		builder.Popup("Restore when", false);
+		for (int i = 0; i < 4; ++i)
+			builder.Item(ID_RESTOREWHEN_FIRST + i, "mouse", i == 3);
+
+		builder.Popup("To", false);
+		for (int i = 0; i < 3; ++i)
+			builder.Item(ID_TO_FIRST + i, "transparency", i == 2);
+
+		builder.Item(ID_ENABLED, "Enabled", true, STATE_CHECKED);
+	}
+
+	return builder.getData();
+}
+
+// Sets every item as the context menu handler does, returning number of fields updated
+static int setAllItems(MenuTemplate& menuTemplate, uint32_t idCmdFirst, int in, int restoreWhen, int to, bool bEnabled)
+{
+	int cUpdates = 0;
+	auto idCmd = idCmdFirst;
+	for (int i = 0; i < 6; ++i)
+		cUpdates += menuTemplate.setItem(ID_IN_FIRST + i, idCmd++, i == in);
+	for (int i = 0; i < 4; ++i)
+		cUpdates += menuTemplate.setItem(ID_RESTOREWHEN_FIRST + i, idCmd++, i == restoreWhen);
+	for (int i = 0; i < 3; ++i)
+		cUpdates += menuTemplate.setItem(ID_TO_FIRST + i, idCmd++, i == to);
+	cUpdates += menuTemplate.setItem(ID_ENABLED, idCmd++, bEnabled);
+
+	return cUpdates;
+}
+
+TEST_CASE(LoadsNestedPopups)
+{
+	auto data = buildContextMenu();
+	MenuTemplate menuTemplate;
+	CHECK(!menuTemplate.IsLoaded());
+	CHECK(menuTemplate.Load(data.data(), data.size()));
+	CHECK(menuTemplate.IsLoaded());
+
+	// Loaded copy is its own
+	CHECK(menuTemplate.getData() != data.data());
+	CHECK(memcmp(menuTemplate.getData(), data.data(), data.size()) == 0);
+}
+
+TEST_CASE(RejectsMalformedTemplates)
+{
+	auto data = buildContextMenu();
+	MenuTemplate menuTemplate;
+	CHECK(!menuTemplate.Load(nullptr, 0));
+	CHECK(!menuTemplate.Load(data.data(), 6));
+	CHECK(!menuTemplate.Load(data.data(), data.size() - 8));		// Text of last item cut off
+	CHECK(!menuTemplate.IsLoaded());
+
+	data[0] = 0;		// Not a 'MENUEX' template
+	CHECK(!menuTemplate.Load(data.data(), data.size()));
+}
+
+TEST_CASE(OnlyChangedFieldsAreUpdated)
+{
+	auto data = buildContextMenu();
+	MenuTemplate menuTemplate;
+	menuTemplate.Load(data.data(), data.size());
+
+	// First time, every command ID and three radio checks differ from template
+	CHECK_EQUAL(14 + 3, setAllItems(menuTemplate, 1, 0, 0, 0, true));
+
+	// Same right click again updates nothing
+	CHECK_EQUAL(0, setAllItems(menuTemplate, 1, 0, 0, 0, true));
+
+	// Picking another radio item moves one check
+	CHECK_EQUAL(2, setAllItems(menuTemplate, 1, 3, 0, 0, true));
+	CHECK_EQUAL(1, setAllItems(menuTemplate, 1, 3, 0, 0, false));
+	CHECK_EQUAL(7, setAllItems(menuTemplate, 1, 5, 1, 2, true));
+
+	// Shell gives a new command ID base only now and then
+	CHECK_EQUAL(14, setAllItems(menuTemplate, 7, 5, 1, 2, true));
+
+	CHECK_EQUAL(17u + 2 + 1 + 7 + 14, menuTemplate.getUpdateCount());
+}
+
+TEST_CASE(UpdatesAreWrittenIntoTemplate)
+{
+	auto data = buildContextMenu();
+	MenuTemplate menuTemplate;
+	menuTemplate.Load(data.data(), data.size());
+	setAllItems(menuTemplate, 1000, 2, 0, 0, false);
+
+	// Reloading patched template finds items under their new command IDs, with checks as set
+	auto pData = static_cast<const uint8_t *>(menuTemplate.getData());
+	MenuTemplate reloaded;
+	CHECK(reloaded.Load(pData, data.size()));
+	CHECK_EQUAL(0, reloaded.setItem(1000 + 2, 1000 + 2, true));
+	CHECK_EQUAL(0, reloaded.setItem(1000 + 13, 1000 + 13, false));
+	CHECK_EQUAL(1, reloaded.setItem(1000 + 3, 1000 + 3, true));
+}
+
+TEST_CASE(UnknownItemIsIgnored)
+{
+	auto data = buildContextMenu();
+	MenuTemplate menuTemplate;
+	menuTemplate.Load(data.data(), data.size());
+
+	CHECK_EQUAL(0, menuTemplate.setItem(999, 1, true));
+	CHECK_EQUAL(0u, menuTemplate.getUpdateCount());
+}
@@ -0,0 +1,210 @@
+#include "TestHarness.h"
+#include "AllocationTracker.h"
+#include "Metrics.h"
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define THREADS				4
+#define INCREMENTSPERTHREAD	100000
+
+
+// Layout as a reader in another process would map it, with snapshots taken of it
+struct MetricsFixture
+{
+	MetricsFixture()
+		: pLayout(new Metrics::Layout()),
+		pBefore(new Metrics::Snapshot()),
+		pAfter(new Metrics::Snapshot()),
+		pDifference(new Metrics::Snapshot())
+	{
+		Metrics::Attach(pLayout.get(), sizeof(Metrics::Layout));
+	}
+
+	~MetricsFixture()
+	{
+		Metrics::Detach();
+	}
+
+	bool TakeSnapshot(Metrics::Snapshot& snapshot)
+	{
+		return Metrics::TakeSnapshot(pLayout.get(), sizeof(Metrics::Layout), snapshot);
+	}
+
+	std::unique_ptr<Metrics::Layout> pLayout;
+	std::unique_ptr<Metrics::Snapshot> pBefore;
+	std::unique_ptr<Metrics::Snapshot> pAfter;
+	std::unique_ptr<Metrics::Snapshot> pDifference;
+};
+
+TEST_CASE(BucketsCoverValuesInOrder)
+{
+	// Each value falls in bucket whose lower bound is at most it, and next bucket's is above it
+	for (uint64_t value = 0; value < 100000; ++value)
+	{
+		auto index = Metrics::getBucketIndex(value);
+		CHECK(Metrics::getBucketLowerBound(index) <= value);
+		CHECK(Metrics::getBucketLowerBound(index + 1) > value);
+	}
+
+	for (size_t index = 1; index < METRICS_HISTOGRAMBUCKETS; ++index)
+	{
+		CHECK(Metrics::getBucketLowerBound(index) > Metrics::getBucketLowerBound(index - 1));
+		CHECK_EQUAL(index, Metrics::getBucketIndex(Metrics::getBucketLowerBound(index)));
+	}
+
+	// Anything too long ends up in last bucket
+	CHECK_EQUAL(static_cast<size_t>(METRICS_HISTOGRAMBUCKETS - 1), Metrics::getBucketIndex(UINT64_MAX));
+}
+
+TEST_CASE(BucketsAreWithinAQuarterOfValue)
+{
+	for (uint64_t value = 1ull << METRICS_SUBBUCKETBITS; value < (1ull << 40); value = value * 3 / 2 + 1)
+	{
+		auto lowerBound = Metrics::getBucketLowerBound(Metrics::getBucketIndex(value));
+		if (Metrics::getBucketIndex(value) < METRICS_HISTOGRAMBUCKETS - 1)
+			CHECK(value - lowerBound <= value / (1ull << METRICS_SUBBUCKETBITS));
+	}
+}
+
+TEST_CASE(AttachStartsOverWithStaleLayout)
+{
+	std::unique_ptr<Metrics::Layout> pLayout(new Metrics::Layout());
+	memset(static_cast<void *>(pLayout.get()), 0xCD, sizeof(Metrics::Layout));
+
+	CHECK(!Metrics::Attach(pLayout.get(), sizeof(Metrics::Layout) - 1));
+	CHECK(Metrics::Attach(pLayout.get(), sizeof(Metrics::Layout)));
+	CHECK_EQUAL(static_cast<uint32_t>(METRICS_MAGIC), pLayout->magic);
+	CHECK_EQUAL(static_cast<uint32_t>(METRICS_VERSION), pLayout->version);
+	CHECK_EQUAL(0u, pLayout->counters[Metrics::counterMouseMove].load());
+
+	// Valid layout is kept as it is, e.g. after shell restarted
+	Metrics::Increment(Metrics::counterMouseMove);
+	Metrics::Detach();
+	CHECK(Metrics::Attach(pLayout.get(), sizeof(Metrics::Layout)));
+	CHECK_EQUAL(1u, pLayout->counters[Metrics::counterMouseMove].load());
+	Metrics::Detach();
+}
+
+TEST_CASE(SnapshotRejectsOtherLayouts)
+{
+	MetricsFixture fixture;
+	CHECK(fixture.TakeSnapshot(*fixture.pBefore));
+	CHECK(!Metrics::TakeSnapshot(fixture.pLayout.get(), sizeof(Metrics::Layout) - 1, *fixture.pBefore));
+
+	fixture.pLayout->version = METRICS_VERSION + 1;
+	CHECK(!fixture.TakeSnapshot(*fixture.pBefore));
+	fixture.pLayout->version = METRICS_VERSION;
+	fixture.pLayout->cCounters = Metrics::counterCount + 1;
+	CHECK(!fixture.TakeSnapshot(*fixture.pBefore));
+}
+
+TEST_CASE(UpdatesGoToAttachedLayoutOnly)
+{
+	MetricsFixture fixture;
+	Metrics::Increment(Metrics::counterTimerWakeup);
+	Metrics::Increment(Metrics::counterTimerWakeup);
+	Metrics::Record(Metrics::histogramFadeStep, 1000);
+	Metrics::Set(Metrics::gaugeLayeredSurfaceBytes, 4096);
+
+	CHECK(fixture.TakeSnapshot(*fixture.pBefore));
+	CHECK_EQUAL(2u, fixture.pBefore->counters[Metrics::counterTimerWakeup]);
+	CHECK_EQUAL(1u, fixture.pBefore->counts[Metrics::histogramFadeStep]);
+	CHECK_EQUAL(1000u, fixture.pBefore->sums[Metrics::histogramFadeStep]);
+	CHECK_EQUAL(1u, fixture.pBefore->buckets[Metrics::histogramFadeStep][Metrics::getBucketIndex(1000)]);
+	CHECK_EQUAL(4096u, fixture.pBefore->gauges[Metrics::gaugeLayeredSurfaceBytes]);
+
+	// Once detached, updates stay in process
+	Metrics::Detach();
+	Metrics::Increment(Metrics::counterTimerWakeup);
+	CHECK(fixture.TakeSnapshot(*fixture.pAfter));
+	CHECK_EQUAL(2u, fixture.pAfter->counters[Metrics::counterTimerWakeup]);
+}
+
+TEST_CASE(DiffSubtractsTotalsAndKeepsLatestGauge)
+{
+	MetricsFixture fixture;
+	Metrics::Increment(Metrics::counterMouseMove);
+	Metrics::Record(Metrics::histogramWndProc, 10);
+	Metrics::Set(Metrics::gaugeLayeredSurfaceBytes, 100);
+	fixture.TakeSnapshot(*fixture.pBefore);
+
+	for (int i = 0; i < 5; ++i)
+		Metrics::Increment(Metrics::counterMouseMove);
+	Metrics::Record(Metrics::histogramWndProc, 2000);
+	Metrics::Set(Metrics::gaugeLayeredSurfaceBytes, 50);
+	fixture.TakeSnapshot(*fixture.pAfter);
+
+	Metrics::Diff(*fixture.pBefore, *fixture.pAfter, *fixture.pDifference);
+	CHECK_EQUAL(5u, fixture.pDifference->counters[Metrics::counterMouseMove]);
+	CHECK_EQUAL(0u, fixture.pDifference->counters[Metrics::counterMouseLeave]);
+	CHECK_EQUAL(1u, fixture.pDifference->counts[Metrics::histogramWndProc]);
+	CHECK_EQUAL(2000u, fixture.pDifference->sums[Metrics::histogramWndProc]);
+	CHECK_EQUAL(0u, fixture.pDifference->buckets[Metrics::histogramWndProc][Metrics::getBucketIndex(10)]);
+	CHECK_EQUAL(1u, fixture.pDifference->buckets[Metrics::histogramWndProc][Metrics::getBucketIndex(2000)]);
+	CHECK_EQUAL(50u, fixture.pDifference->gauges[Metrics::gaugeLayeredSurfaceBytes]);
+}
+
+TEST_CASE(PercentilesFallInRightBuckets)
+{
+	MetricsFixture fixture;
+	fixture.TakeSnapshot(*fixture.pBefore);
+	CHECK_EQUAL(0u, Metrics::getPercentile(*fixture.pBefore, Metrics::histogramAttach, 50));
+
+	// 1000 values from 1 to 1000 microseconds
+	for (uint64_t i = 1; i <= 1000; ++i)
+		Metrics::Record(Metrics::histogramAttach, i * 1000);
+	fixture.TakeSnapshot(*fixture.pAfter);
+
+	static const double s_percentiles[] = { 0, 50, 90, 99, 100 };
+	for (auto percentile : s_percentiles)
+	{
+		auto expected = static_cast<uint64_t>(percentile / 100.0 * 999) * 1000 + 1000;
+		CHECK_EQUAL(Metrics::getBucketLowerBound(Metrics::getBucketIndex(expected)), Metrics::getPercentile(*fixture.pAfter, Metrics::histogramAttach, percentile));
+	}
+}
+
+TEST_CASE(ConcurrentUpdatesAreNotLost)
+{
+	MetricsFixture fixture;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < THREADS; ++i)
+	{
+		threads.emplace_back([]
+		{
+			for (int j = 0; j < INCREMENTSPERTHREAD; ++j)
+			{
+				Metrics::Increment(Metrics::counterMouseMove);
+				Metrics::Record(Metrics::histogramWndProc, j);
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	fixture.TakeSnapshot(*fixture.pAfter);
+	CHECK_EQUAL(static_cast<uint64_t>(THREADS) * INCREMENTSPERTHREAD, fixture.pAfter->counters[Metrics::counterMouseMove]);
+	CHECK_EQUAL(static_cast<uint64_t>(THREADS) * INCREMENTSPERTHREAD, fixture.pAfter->counts[Metrics::histogramWndProc]);
+
+	uint64_t cBucketed = 0;
+	for (int j = 0; j < METRICS_HISTOGRAMBUCKETS; ++j)
+		cBucketed += fixture.pAfter->buckets[Metrics::histogramWndProc][j];
+	CHECK_EQUAL(static_cast<uint64_t>(THREADS) * INCREMENTSPERTHREAD, cBucketed);
+}
+
+TEST_CASE(UpdatesDoNotAllocate)
+{
+	MetricsFixture fixture;
+
+	AllocationScope allocationScope;
+	for (int i = 0; i < 10000; ++i)
+	{
+		Metrics::Increment(Metrics::counterMouseMove);
+		Metrics::Record(Metrics::histogramWndProc, i);
+		Metrics::Set(Metrics::gaugeLayeredSurfaceBytes, i);
+		METRICS_SCOPE(histogramResetTimer);
+	}
+	fixture.TakeSnapshot(*fixture.pBefore);
+	CHECK_EQUAL(0u, allocationScope.getAllocationCount());
+}
@@ -0,0 +1,123 @@
+#include "TestHarness.h"
+#include "MotionAccumulator.h"
+#include <cstdlib>
+
+
+// Distance as the whole history is walked, to compare against
+template<size_t Depth>
+struct NaiveHistory
+{
+	int xs[Depth];
+	int ys[Depth];
+	size_t count;
+
+	NaiveHistory() : count(0) {}
+
+	void push(int x, int y)
+	{
+		if (count == Depth)
+		{
+			for (size_t i = 1; i < Depth; ++i)
+				xs[i - 1] = xs[i], ys[i - 1] = ys[i];
+			--count;
+		}
+		xs[count] = x;
+		ys[count] = y;
+		++count;
+	}
+
+	int getDistanceX() const
+	{
+		int distance = 0;
+		for (size_t i = 1; i < count; ++i)
+			distance += abs(xs[i] - xs[i - 1]);
+		return distance;
+	}
+
+	int getDistanceY() const
+	{
+		int distance = 0;
+		for (size_t i = 1; i < count; ++i)
+			distance += abs(ys[i] - ys[i - 1]);
+		return distance;
+	}
+};
+
+template<size_t Depth>
+static void checkAgainstNaive(unsigned int seed)
+{
+	MotionAccumulator<Depth> accumulator;
+	NaiveHistory<Depth> naive;
+
+	srand(seed);
+	for (int i = 0; i < 5000; ++i)
+	{
+		auto x = rand() % 3840 - 100;
+		auto y = rand() % 2160 - 100;
+		accumulator.push(x, y);
+		naive.push(x, y);
+
+		CHECK_EQUAL(naive.getDistanceX(), accumulator.getDistanceX());
+		CHECK_EQUAL(naive.getDistanceY(), accumulator.getDistanceY());
+		CHECK_EQUAL(naive.count, accumulator.size());
+	}
+}
+
+TEST_CASE(SinglePositionHasNoDistance)
+{
+	MotionAccumulator<4> accumulator;
+	CHECK(accumulator.empty());
+
+	accumulator.push(10, 20);
+	CHECK(!accumulator.empty());
+	CHECK_EQUAL(1u, accumulator.size());
+	CHECK_EQUAL(0, accumulator.getDistanceX());
+	CHECK_EQUAL(0, accumulator.getDistanceY());
+	CHECK_EQUAL(10, accumulator.last().x);
+	CHECK_EQUAL(20, accumulator.last().y);
+}
+
+TEST_CASE(SumsAbsoluteDeltasPerAxis)
+{
+	MotionAccumulator<4> accumulator;
+	accumulator.push(0, 0);
+	accumulator.push(10, -5);
+	accumulator.push(4, 5);
+
+	CHECK_EQUAL(16, accumulator.getDistanceX());
+	CHECK_EQUAL(15, accumulator.getDistanceY());
+}
+
+TEST_CASE(OldestDeltaFallsOutOfWindow)
+{
+	MotionAccumulator<3> accumulator;
+	accumulator.push(0, 0);
+	accumulator.push(100, 0);		// Delta 100
+	accumulator.push(101, 0);		// Delta 1
+	CHECK_EQUAL(101, accumulator.getDistanceX());
+
+	accumulator.push(102, 0);		// Delta 1, delta 100 falls out
+	CHECK_EQUAL(3u, accumulator.size());
+	CHECK_EQUAL(2, accumulator.getDistanceX());
+}
+
+TEST_CASE(ClearForgetsEverything)
+{
+	MotionAccumulator<4> accumulator;
+	accumulator.push(0, 0);
+	accumulator.push(500, 500);
+	accumulator.clear();
+
+	CHECK(accumulator.empty());
+	accumulator.push(1000, 1000);	// No delta from before clearing
+	CHECK_EQUAL(0, accumulator.getDistanceX());
+	CHECK_EQUAL(0, accumulator.getDistanceY());
+}
+
+TEST_CASE(MatchesFullWalkAtAnyDepth)
+{
+	checkAgainstNaive<2>(1);
+	checkAgainstNaive<4>(2);
+	checkAgainstNaive<16>(3);
+	checkAgainstNaive<256>(4);
+}
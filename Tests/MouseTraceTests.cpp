@@ -0,0 +1,141 @@
+#include "TestHarness.h"
+#include "MouseTrace.h"
+#include <vector>
+
+#define MESSAGE_MOUSEMOVE	0x0200
+
+
+static std::vector<uint8_t> makeTraceMemory(size_t cbRing)
+{
+	return std::vector<uint8_t>(sizeof(MouseTraceHeader) + cbRing, 0xCD);	// NOTE: Not zero, as a reused file wouldn't be
+}
+
+TEST_CASE(RecordsRoundTrip)
+{
+	auto memory = makeTraceMemory(4096);
+	MouseTraceWriter writer;
+	CHECK(writer.Attach(memory.data(), memory.size()));
+
+	static const MouseTraceRecord s_records[] =
+	{
+		{ 1000, MESSAGE_MOUSEMOVE, 0, 0 },
+		{ 1001, MESSAGE_MOUSEMOVE, -1, 1 },
+		{ 1001, 0x0204, -3840, 2160 },
+		{ 61000, 0x02A3, 0x7FFFFFFF, -0x7FFFFFFF - 1 },
+		{ 61000 + 0xFFFFFFFFull, 0xFFFFFFFF, 12345, -12345 }
+	};
+	for (auto& record : s_records)
+		writer.Append(record.time, record.message, record.x, record.y);
+	CHECK_EQUAL(5u, writer.getRecordCount());
+
+	MouseTraceReader reader(memory.data(), memory.size());
+	CHECK(reader.IsValid());
+	MouseTraceRecord record;
+	for (auto& expected : s_records)
+	{
+		CHECK(reader.Next(record));
+		CHECK_EQUAL(expected.time, record.time);
+		CHECK_EQUAL(expected.message, record.message);
+		CHECK_EQUAL(expected.x, record.x);
+		CHECK_EQUAL(expected.y, record.y);
+	}
+	CHECK(!reader.Next(record));
+}
+
+TEST_CASE(MouseMovesAreCompact)
+{
+	uint8_t bytes[MOUSETRACE_MAXRECORDBYTES];
+	CHECK(MouseTraceReader::EncodeRecord(8, MESSAGE_MOUSEMOVE, 1900, 1000, bytes) <= 7);
+	CHECK(MouseTraceReader::EncodeRecord(1, MESSAGE_MOUSEMOVE, 60, 60, bytes) <= 5);
+	CHECK(MouseTraceReader::EncodeRecord(0xFFFFFFFF, 0xFFFFFFFF, -0x7FFFFFFF - 1, 0x7FFFFFFF, bytes) == MOUSETRACE_MAXRECORDBYTES);
+}
+
+TEST_CASE(RingKeepsNewestRecordsWhenWrapping)
+{
+	// Small ring, so it wraps many times and records straddle its end
+	auto memory = makeTraceMemory(97);
+	MouseTraceWriter writer;
+	writer.Attach(memory.data(), memory.size());
+
+	const int cAppended = 10000;
+	for (int i = 0; i < cAppended; ++i)
+		writer.Append(1000 + i * 3, MESSAGE_MOUSEMOVE, i % 2000, -(i % 700));
+
+	auto cKept = writer.getRecordCount();
+	CHECK(cKept > 97 / MOUSETRACE_MAXRECORDBYTES);
+	CHECK(cKept < 97 / 3);
+
+	// Reader gets exactly last 'cKept' records, with their times
+	MouseTraceReader reader(memory.data(), memory.size());
+	MouseTraceRecord record;
+	int i = cAppended - static_cast<int>(cKept);
+	size_t cRead = 0;
+	while (reader.Next(record))
+	{
+		CHECK_EQUAL(static_cast<uint64_t>(1000 + i * 3), record.time);
+		CHECK_EQUAL(i % 2000, record.x);
+		CHECK_EQUAL(-(i % 700), record.y);
+		++i, ++cRead;
+	}
+	CHECK_EQUAL(cKept, cRead);
+	CHECK_EQUAL(cAppended, i);
+}
+
+TEST_CASE(ReattachingContinuesTrace)
+{
+	auto memory = makeTraceMemory(1024);
+	{
+		MouseTraceWriter writer;
+		writer.Attach(memory.data(), memory.size());
+		writer.Append(1000, MESSAGE_MOUSEMOVE, 1, 1);
+		writer.Detach();
+		CHECK(!writer.IsAttached());
+	}
+
+	// As after Explorer restarts with same file
+	MouseTraceWriter writer;
+	writer.Attach(memory.data(), memory.size());
+	writer.Append(5000, MESSAGE_MOUSEMOVE, 2, 2);
+	CHECK_EQUAL(2u, writer.getRecordCount());
+
+	MouseTraceReader reader(memory.data(), memory.size());
+	MouseTraceRecord record;
+	CHECK(reader.Next(record) && record.time == 1000);
+	CHECK(reader.Next(record) && record.time == 5000);
+}
+
+TEST_CASE(InvalidTraceStartsOver)
+{
+	auto memory = makeTraceMemory(1024);
+	MouseTraceReader unwritten(memory.data(), memory.size());
+	CHECK(!unwritten.IsValid());
+
+	MouseTraceWriter writer;
+	writer.Attach(memory.data(), memory.size());
+	writer.Append(1000, MESSAGE_MOUSEMOVE, 1, 1);
+	writer.Detach();
+
+	// Different size, e.g. when trace size setting changed
+	MouseTraceReader wrongSize(memory.data(), memory.size() - 1);
+	CHECK(!wrongSize.IsValid());
+	CHECK(writer.Attach(memory.data(), memory.size() - 1));
+	CHECK_EQUAL(0u, writer.getRecordCount());
+
+	CHECK(!writer.Attach(memory.data(), sizeof(MouseTraceHeader)));
+}
+
+TEST_CASE(TimeGoingBackwardsIsClamped)
+{
+	auto memory = makeTraceMemory(1024);
+	MouseTraceWriter writer;
+	writer.Attach(memory.data(), memory.size());
+	writer.Append(1000, MESSAGE_MOUSEMOVE, 1, 1);
+	writer.Append(900, MESSAGE_MOUSEMOVE, 2, 2);
+	writer.Append(1100, MESSAGE_MOUSEMOVE, 3, 3);
+
+	MouseTraceReader reader(memory.data(), memory.size());
+	MouseTraceRecord record;
+	CHECK(reader.Next(record) && record.time == 1000);
+	CHECK(reader.Next(record) && record.time == 1000);
+	CHECK(reader.Next(record) && record.time == 1100);
+}
@@ -0,0 +1,191 @@
+#include "TestHarness.h"
+#include "FakePlatform.h"
+#include "OpacityLayering.h"
+
+#define SURFACEBYTES	(1920 * 1080 * 4)
+#define FADEMILLISECS	(FADE_FRAMES * FADE_FRAMEMILLISECS)
+
+
+// Layering driven by a fade engine, as 'OverlayEngine' drives it
+struct LayeringFixture
+{
+	FakeClock clock;
+	FakeTimer frameTimer;
+	FakeSurface surface;
+	OpacityLayering layering;
+	FadeEngine fadeEngine;
+
+	LayeringFixture()
+		: frameTimer(clock, &LayeringFixture::onFrameTimer, this),
+		surface(SURFACEBYTES),
+		layering(surface),
+		fadeEngine(clock, frameTimer)
+	{
+		fadeEngine.setBackend(&layering);
+	}
+
+	static void onFrameTimer(void *pContext)
+	{
+		static_cast<LayeringFixture *>(pContext)->fadeEngine.OnFrameTimer();
+	}
+};
+
+TEST_CASE(OpaqueWindowIsNeverLayered)
+{
+	LayeringFixture fixture;
+	auto cCalls = fixture.surface.getCallCount();
+
+	CHECK(fixture.layering.SetOpacity(OPACITY_OPAQUE));
+	CHECK(fixture.layering.getState() == OpacityLayering::State::unlayered);
+	CHECK_EQUAL(cCalls, fixture.surface.getCallCount());		// NOTE: Nothing to tell window
+	CHECK_EQUAL(0u, fixture.layering.getSurfaceBytes());
+}
+
+TEST_CASE(LayeringIsAddedBelowOpaqueAndRemovedAtOpaque)
+{
+	LayeringFixture fixture;
+
+	CHECK(fixture.layering.SetOpacity(0x80));
+	CHECK(fixture.layering.getState() == OpacityLayering::State::layered);
+	CHECK_EQUAL(0x80, fixture.surface.getAlpha());
+	CHECK_EQUAL(1u, fixture.layering.getLayerCount());
+	CHECK_EQUAL(static_cast<size_t>(SURFACEBYTES), fixture.layering.getSurfaceBytes());
+
+	// Opacity changes while layered only change alpha
+	for (int opacity = 0x7F; opacity >= OPACITY_HIDDEN; --opacity)
+		CHECK(fixture.layering.SetOpacity(static_cast<uint8_t>(opacity)));
+	CHECK_EQUAL(OPACITY_HIDDEN, fixture.surface.getAlpha());
+	CHECK_EQUAL(1u, fixture.surface.getStyleChangeCount());
+
+	CHECK(fixture.layering.SetOpacity(OPACITY_OPAQUE));
+	CHECK(fixture.layering.getState() == OpacityLayering::State::unlayered);
+	CHECK_EQUAL(1u, fixture.layering.getUnlayerCount());
+	CHECK_EQUAL(2u, fixture.surface.getStyleChangeCount());
+	CHECK_EQUAL(0u, fixture.layering.getSurfaceBytes());
+}
+
+TEST_CASE(FadeOutAndBackChangesStyleTwice)
+{
+	LayeringFixture fixture;
+
+	fixture.fadeEngine.FadeOut(OPACITY_HIDDEN, FadeEngine::Easing::linear);
+	fixture.clock.Advance(FADEMILLISECS);
+	CHECK(fixture.fadeEngine.IsHidden());
+	CHECK_EQUAL(OPACITY_HIDDEN, fixture.surface.getAlpha());
+
+	fixture.fadeEngine.FadeIn();
+	fixture.clock.Advance(FADEMILLISECS);
+	CHECK_EQUAL(OPACITY_OPAQUE, fixture.surface.getAlpha());
+	CHECK(fixture.layering.getState() == OpacityLayering::State::unlayered);
+
+	// Once for adding layering at first frame, once for removing it at last
+	CHECK_EQUAL(2u, fixture.surface.getStyleChangeCount());
+	CHECK_EQUAL(1u, fixture.layering.getLayerCount());
+	CHECK_EQUAL(1u, fixture.layering.getUnlayerCount());
+}
+
+TEST_CASE(ReadOpacityFollowsLayeringOfOthers)
+{
+	LayeringFixture fixture;
+	uint8_t opacity;
+
+	fixture.surface.setExternalLayered(true, 0x40);
+	CHECK(fixture.layering.GetOpacity(opacity));
+	CHECK_EQUAL(0x40, opacity);
+	CHECK(fixture.layering.getState() == OpacityLayering::State::layered);
+	CHECK_EQUAL(static_cast<size_t>(SURFACEBYTES), fixture.layering.getSurfaceBytes());
+
+	// Going opaque from there removes layering someone else added
+	CHECK(fixture.layering.SetOpacity(OPACITY_OPAQUE));
+	CHECK_EQUAL(1u, fixture.surface.getStyleChangeCount());
+
+	fixture.surface.setExternalLayered(true, 0x40);
+	fixture.surface.setExternalLayered(false, 0);
+	CHECK(fixture.layering.GetOpacity(opacity));
+	CHECK_EQUAL(OPACITY_OPAQUE, opacity);
+	CHECK(fixture.layering.getState() == OpacityLayering::State::unlayered);
+}
+
+TEST_CASE(ReadOpacityKeepsChangesNotYetApplied)
+{
+	// NOTE: As 'LayeredWindow' posts changes to window, re-reading before they arrive must not undo them
+	LayeringFixture fixture;
+	fixture.surface.setDeferred(true);
+	uint8_t opacity;
+
+	CHECK(fixture.layering.SetOpacity(0x80));
+	fixture.fadeEngine.Reconcile();
+	CHECK_EQUAL(0x80, fixture.fadeEngine.getOpacity());
+	CHECK(fixture.layering.getState() == OpacityLayering::State::layered);
+
+	// Likewise on the way back to opaque, where window is still layered until then
+	fixture.surface.ApplyPending();
+	CHECK(fixture.layering.SetOpacity(OPACITY_OPAQUE));
+	CHECK(fixture.layering.GetOpacity(opacity));
+	CHECK_EQUAL(OPACITY_OPAQUE, opacity);
+	CHECK(fixture.layering.getState() == OpacityLayering::State::unlayered);
+
+	// Once applied, window is read again
+	fixture.surface.ApplyPending();
+	fixture.surface.setExternalLayered(true, 0x40);
+	CHECK(fixture.layering.GetOpacity(opacity));
+	CHECK_EQUAL(0x40, opacity);
+	CHECK(fixture.layering.getState() == OpacityLayering::State::layered);
+}
+
+TEST_CASE(SnapshotFadeOnlyTouchesWindowAtEnds)
+{
+	LayeringFixture fixture;
+	fixture.layering.setSnapshotFade(true);
+
+	fixture.fadeEngine.FadeOut(OPACITY_HIDDEN, FadeEngine::Easing::linear);
+	CHECK(fixture.layering.getState() == OpacityLayering::State::overlaid);
+	CHECK(fixture.surface.IsSnapshotShown());
+	CHECK_EQUAL(OPACITY_HIDDEN, fixture.surface.getAlpha());		// Window itself is nearly hidden underneath
+	CHECK_EQUAL(static_cast<size_t>(3 * SURFACEBYTES), fixture.layering.getSurfaceBytes());
+
+	// Frames only change snapshot
+	auto cStyleChanges = fixture.surface.getStyleChangeCount();
+	fixture.clock.Advance(FADEMILLISECS / 2);
+	auto snapshotAlpha = fixture.surface.getSnapshotAlpha();
+	CHECK(snapshotAlpha < OPACITY_OPAQUE);
+	CHECK(snapshotAlpha > OPACITY_HIDDEN);
+	CHECK_EQUAL(cStyleChanges, fixture.surface.getStyleChangeCount());
+
+	// Read opacity is that of snapshot, not of window underneath
+	uint8_t opacity;
+	CHECK(fixture.layering.GetOpacity(opacity));
+	CHECK_EQUAL(snapshotAlpha, opacity);
+
+	// At end, window itself takes over at target opacity
+	fixture.clock.Advance(FADEMILLISECS);
+	CHECK(!fixture.surface.IsSnapshotShown());
+	CHECK(fixture.layering.getState() == OpacityLayering::State::layered);
+	CHECK_EQUAL(OPACITY_HIDDEN, fixture.surface.getAlpha());
+	CHECK_EQUAL(static_cast<size_t>(SURFACEBYTES), fixture.layering.getSurfaceBytes());
+
+	// And fading back in ends unlayered
+	fixture.fadeEngine.FadeOut(OPACITY_HIDDEN, FadeEngine::Easing::linear);
+	fixture.fadeEngine.Restore();
+	fixture.fadeEngine.FadeIn();
+	fixture.clock.Advance(FADEMILLISECS);
+	CHECK(fixture.layering.getState() == OpacityLayering::State::unlayered);
+	CHECK_EQUAL(OPACITY_OPAQUE, fixture.surface.getAlpha());
+	CHECK_EQUAL(0u, fixture.layering.getSurfaceBytes());
+}
+
+TEST_CASE(SnapshotFadeSettingTakesEffectFromNextFade)
+{
+	LayeringFixture fixture;
+
+	fixture.fadeEngine.FadeOut(OPACITY_HIDDEN, FadeEngine::Easing::linear);
+	fixture.layering.setSnapshotFade(true);
+	fixture.clock.Advance(FADEMILLISECS);
+	CHECK(!fixture.surface.IsSnapshotShown());
+	CHECK(fixture.layering.getState() == OpacityLayering::State::layered);
+
+	fixture.fadeEngine.FadeIn();
+	CHECK(fixture.layering.getState() == OpacityLayering::State::unlayered);	// Restored at once, as it wasn't fading
+	fixture.fadeEngine.FadeOut(OPACITY_HIDDEN, FadeEngine::Easing::linear);
+	CHECK(fixture.surface.IsSnapshotShown());
+}
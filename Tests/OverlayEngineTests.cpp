@@ -0,0 +1,239 @@
+#include "TestHarness.h"
+#include "AllocationTracker.h"
+#include "HeadlessEngine.h"
+
+#define FADEMILLISECS	(FADE_FRAMES * FADE_FRAMEMILLISECS)
+
+
+// Moves mouse far enough for 'RestoreWhen::mousedMoved'
+static void moveFar(HeadlessEngine& headless)
+{
+	for (int i = 0; i < MOUSEPOS_HISTORYDEPTH; ++i)
+		headless.getEngine().OnMouseMove(100 + i * MOUSEMOVE_DISTANCETHRESHOLD, 100, headless.getSettings());
+}
+
+TEST_CASE(IconsFadeOutAfterIdleInterval)
+{
+	HeadlessEngine headless(1000);
+	headless.Start();
+	CHECK(headless.getIdleTimer().IsArmed());
+
+	headless.Advance(Settings::convertInToMillisecs(Settings::In::secs5) - 1);
+	CHECK_EQUAL(OPACITY_OPAQUE, headless.getOpacity().getOpacity());
+
+	headless.Advance(1);
+	CHECK(headless.getEngine().getFadeEngine().IsFading());
+
+	headless.Advance(FADEMILLISECS);
+	CHECK(headless.getEngine().IsHidden());
+	CHECK_EQUAL(OPACITY_HIDDEN, headless.getOpacity().getOpacity());
+	CHECK(!headless.getFrameTimer().IsArmed());
+}
+
+TEST_CASE(SemiTransparencyStopsShortOfHidden)
+{
+	HeadlessEngine headless;
+	auto settings = HeadlessEngine::getDefaultSettings();
+	settings.to = Settings::To::semiTransparency;
+	headless.setSettings(settings);
+	headless.Start();
+
+	headless.Advance(Settings::convertInToMillisecs(settings.in) + FADEMILLISECS);
+	CHECK(!headless.getEngine().IsHidden());
+	CHECK(headless.getOpacity().getOpacity() > OPACITY_HIDDEN);
+	CHECK(headless.getOpacity().getOpacity() < OPACITY_OPAQUE);
+}
+
+TEST_CASE(MouseMoveRestoresHiddenIcons)
+{
+	HeadlessEngine headless;
+	headless.Start();
+	headless.Advance(Settings::convertInToMillisecs(Settings::In::secs5) + FADEMILLISECS);
+	CHECK(headless.getEngine().IsHidden());
+
+	// A small move is not activity
+	auto disposition = headless.getEngine().OnMouseMove(10, 10, headless.getSettings());
+	CHECK(disposition == OverlayEngine::Disposition::swallow);
+	CHECK(headless.getEngine().IsHidden());
+
+	moveFar(headless);
+	CHECK(!headless.getEngine().IsHidden());
+	CHECK_EQUAL(OPACITY_OPAQUE, headless.getOpacity().getOpacity());
+
+	// Idle countdown starts over from last activity
+	headless.Advance(Settings::convertInToMillisecs(Settings::In::secs5) - 1);
+	CHECK_EQUAL(OPACITY_OPAQUE, headless.getOpacity().getOpacity());
+}
+
+TEST_CASE(ActivityDuringFadeOutReversesIt)
+{
+	HeadlessEngine headless;
+	headless.Start();
+	headless.Advance(Settings::convertInToMillisecs(Settings::In::secs5) + FADEMILLISECS / 2);
+	auto opacityMidFade = headless.getOpacity().getOpacity();
+	CHECK(opacityMidFade < OPACITY_OPAQUE);
+
+	moveFar(headless);
+	CHECK(headless.getOpacity().getOpacity() > opacityMidFade);		// First step back is taken at once
+
+	headless.Advance(FADEMILLISECS);
+	CHECK_EQUAL(OPACITY_OPAQUE, headless.getOpacity().getOpacity());
+	CHECK(!headless.getEngine().getFadeEngine().IsFading());
+}
+
+TEST_CASE(RightClickOnHiddenIconsClearsSelection)
+{
+	HeadlessEngine headless;
+	headless.getPlatform().setSelectedCount(3);
+	headless.Start();
+	headless.Advance(Settings::convertInToMillisecs(Settings::In::secs5) + FADEMILLISECS);
+
+	CHECK(headless.getEngine().OnRightButtonDown() == OverlayEngine::Disposition::swallow);
+	CHECK_EQUAL(1u, headless.getPlatform().getClearSelectionCount());
+	CHECK(headless.getEngine().IsHidden());
+
+	// Right click on visible icons is passed on and counts as activity
+	moveFar(headless);
+	headless.getPlatform().setSelectedCount(3);
+	CHECK(headless.getEngine().OnRightButtonDown() == OverlayEngine::Disposition::passOn);
+	CHECK_EQUAL(1u, headless.getPlatform().getClearSelectionCount());
+}
+
+TEST_CASE(DoubleClickRestoresOnlyWithItsSetting)
+{
+	HeadlessEngine headless;
+	auto settings = HeadlessEngine::getDefaultSettings();
+	settings.restoreWhen = Settings::RestoreWhen::doubleClicked;
+	headless.setSettings(settings);
+	headless.Start();
+	headless.Advance(Settings::convertInToMillisecs(settings.in) + FADEMILLISECS);
+
+	moveFar(headless);
+	CHECK(headless.getEngine().IsHidden());
+
+	CHECK(headless.getEngine().OnDoubleClick(settings) == OverlayEngine::Disposition::swallow);
+	CHECK(!headless.getEngine().IsHidden());
+}
+
+TEST_CASE(StopRestoresAndDisarms)
+{
+	HeadlessEngine headless;
+	headless.Start();
+	headless.Advance(Settings::convertInToMillisecs(Settings::In::secs5) + FADEMILLISECS / 2);
+
+	headless.getEngine().Stop();
+	CHECK_EQUAL(OPACITY_OPAQUE, headless.getOpacity().getOpacity());
+	CHECK(!headless.getIdleTimer().IsArmed());
+	CHECK(!headless.getFrameTimer().IsArmed());
+}
+
+// Engine set up for 'RestoreWhen::mousedEntersQuarterRegionOnLeft', with icons hidden
+static void hideWithRegionPolicy(HeadlessEngine& headless)
+{
+	auto settings = HeadlessEngine::getDefaultSettings();
+	settings.restoreWhen = Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft;
+	headless.setSettings(settings);
+	headless.getEngine().setTuning(8, 50, 50);
+	headless.Start();
+	headless.getEngine().OnMouseMove(HEADLESSENGINE_CLIENTWIDTH / 2, 500, settings);
+	headless.Advance(Settings::convertInToMillisecs(settings.in) + FADEMILLISECS);
+}
+
+TEST_CASE(EnteringRegionAndStoppingRestoresIcons)
+{
+	HeadlessEngine headless;
+	hideWithRegionPolicy(headless);
+	CHECK(headless.getEngine().IsHidden());
+
+	// One move into left quarter, then mouse rests there
+	headless.getEngine().OnMouseMove(100, 500, headless.getSettings());
+	headless.Advance(FADEMILLISECS);
+	CHECK_EQUAL(OPACITY_OPAQUE, headless.getOpacity().getOpacity());
+
+	// Icons stay while mouse is in region
+	headless.Advance(10 * Settings::convertInToMillisecs(Settings::In::secs5));
+	CHECK_EQUAL(OPACITY_OPAQUE, headless.getOpacity().getOpacity());
+}
+
+TEST_CASE(LeavingRegionAndStoppingFadesIcons)
+{
+	HeadlessEngine headless;
+	hideWithRegionPolicy(headless);
+	headless.getEngine().OnMouseMove(100, 500, headless.getSettings());
+	headless.Advance(10 * Settings::convertInToMillisecs(Settings::In::secs5));
+
+	// One move out, well past hysteresis band, then mouse rests there
+	headless.getEngine().OnMouseMove(HEADLESSENGINE_CLIENTWIDTH / 2, 500, headless.getSettings());
+	headless.Advance(Settings::convertInToMillisecs(Settings::In::secs5) - 1);
+	CHECK_EQUAL(OPACITY_OPAQUE, headless.getOpacity().getOpacity());
+
+	headless.Advance(1 + FADEMILLISECS);
+	CHECK(headless.getEngine().IsHidden());
+}
+
+TEST_CASE(MovingInsideRegionDoesNotReArmTimer)
+{
+	HeadlessEngine headless;
+	hideWithRegionPolicy(headless);
+
+	auto cArms = headless.getIdleTimer().getArmCount();
+	for (int i = 0; i < 10000; ++i)
+	{
+		headless.getEngine().OnMouseMove(10 + i % 400, 100 + i % 800, headless.getSettings());
+		headless.Advance(1);
+	}
+	CHECK_EQUAL(cArms + 1, headless.getIdleTimer().getArmCount());		// Only for entering
+
+	// Jitter across edge of region, within hysteresis band
+	cArms = headless.getIdleTimer().getArmCount();
+	auto edge = HEADLESSENGINE_CLIENTWIDTH / TRIGGER_REGION_DIVISOR;
+	for (int i = 0; i < 10000; ++i)
+	{
+		headless.getEngine().OnMouseMove(edge - 4 + i % 8, 500, headless.getSettings());
+		headless.Advance(1);
+	}
+	CHECK_EQUAL(cArms, headless.getIdleTimer().getArmCount());
+}
+
+TEST_CASE(InputEventsDoNotQueryOpacity)
+{
+	HeadlessEngine headless;
+	headless.Start();
+	auto cQueries = headless.getOpacity().getGetCount();
+
+	// Visible, fading and hidden icons alike are judged from the shadowed opacity
+	for (int i = 0; i < 1000; ++i)
+		headless.getEngine().OnMouseMove(i % 8, 0, headless.getSettings());
+	headless.Advance(Settings::convertInToMillisecs(Settings::In::secs5) + FADEMILLISECS / 2);
+	for (int i = 0; i < 1000; ++i)
+		headless.getEngine().OnMouseMove(i % 8, 0, headless.getSettings());
+	headless.Advance(FADEMILLISECS);
+	for (int i = 0; i < 1000; ++i)
+		headless.getEngine().OnMouseMove(i % 8, 0, headless.getSettings());
+	headless.getEngine().OnDoubleClick(headless.getSettings());
+	headless.getEngine().OnRightButtonDown();
+
+	CHECK_EQUAL(cQueries, headless.getOpacity().getGetCount());
+
+	// Only a style change made by someone else makes it look at window again
+	headless.getOpacity().setExternalOpacity(0x80);
+	headless.getEngine().OnStyleChanged();
+	CHECK_EQUAL(cQueries + 1, headless.getOpacity().getGetCount());
+	CHECK_EQUAL(0x80, headless.getEngine().getFadeEngine().getOpacity());
+}
+
+TEST_CASE(InputEventsDoNotAllocate)
+{
+	HeadlessEngine headless;
+	headless.Start();
+
+	AllocationScope allocationScope;
+	for (int i = 0; i < 10000; ++i)
+	{
+		headless.getEngine().OnMouseMove(i % HEADLESSENGINE_CLIENTWIDTH, (i * 7) % HEADLESSENGINE_CLIENTHEIGHT, headless.getSettings());
+		headless.Advance(1);
+	}
+	headless.getEngine().OnMouseLeave();
+	headless.getEngine().OnRightButtonDown();
+	CHECK_EQUAL(0u, allocationScope.getAllocationCount());
+}
@@ -0,0 +1,138 @@
+#include "TestHarness.h"
+#include "PixelKernels.h"
+#include <vector>
+
+
+// As GDI rounds
+static uint32_t premultiply(uint32_t channel, uint32_t alpha)
+{
+	return (channel * alpha + 127) / 255;
+}
+
+static uint32_t makePixel(uint32_t alpha, uint32_t red, uint32_t green, uint32_t blue)
+{
+	return (alpha << 24) | (red << 16) | (green << 8) | blue;
+}
+
+TEST_CASE(PremultiplyRoundsLikeGdiForEveryChannelAndAlpha)
+{
+	// Every channel value against every alpha, with each color channel getting a different value
+	std::vector<uint32_t> pixels(256 * 256), scalarPixels;
+	for (uint32_t alpha = 0; alpha < 256; ++alpha)
+	{
+		for (uint32_t channel = 0; channel < 256; ++channel)
+			pixels[alpha * 256 + channel] = makePixel(alpha, channel, 255 - channel, channel ^ 0x5A);
+	}
+	scalarPixels = pixels;
+
+	PixelKernels::PremultiplyAlpha(pixels.data(), pixels.size());
+	PixelKernels::PremultiplyAlpha_Scalar(scalarPixels.data(), scalarPixels.size());
+
+	size_t cMismatches = 0;
+	for (uint32_t alpha = 0; alpha < 256; ++alpha)
+	{
+		for (uint32_t channel = 0; channel < 256; ++channel)
+		{
+			auto expected = makePixel(alpha, premultiply(channel, alpha), premultiply(255 - channel, alpha), premultiply(channel ^ 0x5A, alpha));
+			auto i = alpha * 256 + channel;
+			if (pixels[i] != expected || scalarPixels[i] != expected)
+				++cMismatches;
+		}
+	}
+	CHECK_EQUAL(0u, cMismatches);
+}
+
+TEST_CASE(PremultiplyHandlesLeftoverPixels)
+{
+	// Lengths around the four pixels done at a time, with a guard pixel past the end
+	for (size_t count = 0; count <= 9; ++count)
+	{
+		std::vector<uint32_t> pixels(count + 1, makePixel(0x80, 0xFF, 0x40, 0x01));
+		PixelKernels::PremultiplyAlpha(pixels.data(), count);
+
+		for (size_t i = 0; i < count; ++i)
+			CHECK_EQUAL(makePixel(0x80, 0x80, 0x20, 0x01), pixels[i]);
+		CHECK_EQUAL(makePixel(0x80, 0xFF, 0x40, 0x01), pixels[count]);
+	}
+}
+
+TEST_CASE(CopyWithAlphaMatchesScalarAndScalesEveryChannel)
+{
+	std::vector<uint32_t> source(1027);
+	for (size_t i = 0; i < source.size(); ++i)
+		source[i] = static_cast<uint32_t>(i * 2654435761u);
+
+	static const uint8_t s_alphas[] = { 0, 1, 0x7F, 0x80, 0xFE, 0xFF };
+	for (auto alpha : s_alphas)
+	{
+		std::vector<uint32_t> destination(source.size()), scalarDestination(source.size());
+		PixelKernels::CopyWithAlpha(source.data(), destination.data(), source.size(), alpha);
+		PixelKernels::CopyWithAlpha_Scalar(source.data(), scalarDestination.data(), source.size(), alpha);
+
+		size_t cMismatches = 0;
+		for (size_t i = 0; i < source.size(); ++i)
+		{
+			auto expected = makePixel(premultiply(source[i] >> 24, alpha),
+									  premultiply((source[i] >> 16) & 0xFF, alpha),
+									  premultiply((source[i] >> 8) & 0xFF, alpha),
+									  premultiply(source[i] & 0xFF, alpha));
+			if (destination[i] != expected || scalarDestination[i] != expected)
+				++cMismatches;
+		}
+		CHECK_EQUAL(0u, cMismatches);
+	}
+}
+
+TEST_CASE(ExtractAlphaRecoversPremultipliedPixels)
+{
+	// Renders of a premultiplied pixel over black and white, with garbage in their alpha lane as GDI leaves it
+	struct Case
+	{
+		uint32_t onBlack;
+		uint32_t onWhite;
+		uint32_t expected;
+	};
+	static const Case s_cases[] =
+	{
+		{ makePixel(0x12, 0, 0, 0), makePixel(0x34, 0xFF, 0xFF, 0xFF), makePixel(0, 0, 0, 0) },					// Background
+		{ makePixel(0x56, 0xC8, 0x64, 0x32), makePixel(0x78, 0xC8, 0x64, 0x32), makePixel(0xFF, 0xC8, 0x64, 0x32) },	// Opaque
+		{ makePixel(0, 0x64, 0x32, 0x19), makePixel(0, 0xE3, 0xB1, 0x98), makePixel(0x80, 0x64, 0x32, 0x19) },		// Half
+		{ makePixel(0, 0x10, 0x20, 0x30), makePixel(0, 0xFF, 0xE0, 0xD0), makePixel(0x10, 0x10, 0x10, 0x10) },		// ClearType fringe
+	};
+
+	for (const auto& testCase : s_cases)
+	{
+		uint32_t pixel = 0, scalarPixel = 0;
+		PixelKernels::ExtractAlpha(&testCase.onBlack, &testCase.onWhite, &pixel, 1);
+		PixelKernels::ExtractAlpha_Scalar(&testCase.onBlack, &testCase.onWhite, &scalarPixel, 1);
+
+		CHECK_EQUAL(testCase.expected, pixel);
+		CHECK_EQUAL(testCase.expected, scalarPixel);
+	}
+}
+
+TEST_CASE(ExtractAlphaMatchesScalar)
+{
+	// Lengths around the four pixels done at a time
+	std::vector<uint32_t> onBlack(1027), onWhite(onBlack.size());
+	for (size_t i = 0; i < onBlack.size(); ++i)
+	{
+		onBlack[i] = static_cast<uint32_t>(i * 2654435761u);
+		onWhite[i] = static_cast<uint32_t>(i * 40503u + 0x9E3779B9u);
+	}
+
+	for (size_t count = 1019; count <= onBlack.size(); ++count)
+	{
+		std::vector<uint32_t> destination(count), scalarDestination(count);
+		PixelKernels::ExtractAlpha(onBlack.data(), onWhite.data(), destination.data(), count);
+		PixelKernels::ExtractAlpha_Scalar(onBlack.data(), onWhite.data(), scalarDestination.data(), count);
+
+		size_t cMismatches = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (destination[i] != scalarDestination[i])
+				++cMismatches;
+		}
+		CHECK_EQUAL(0u, cMismatches);
+	}
+}
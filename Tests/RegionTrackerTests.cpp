@@ -0,0 +1,85 @@
+#include "TestHarness.h"
+#include "RegionTracker.h"
+
+#define DWELLMILLISECS		50
+
+
+TEST_CASE(EnteringIsReportedAtOnce)
+{
+	RegionTracker tracker;
+	CHECK(tracker.Update(false, false, 1000, DWELLMILLISECS) == RegionTracker::Transition::none);
+	CHECK(tracker.Update(true, true, 1001, DWELLMILLISECS) == RegionTracker::Transition::entered);
+	CHECK(tracker.IsInside());
+	CHECK_EQUAL(1u, tracker.getTransitionCount());
+
+	// Moving about inside reports nothing more
+	for (uint64_t now = 1002; now < 2000; ++now)
+		CHECK(tracker.Update(true, true, now, DWELLMILLISECS) == RegionTracker::Transition::none);
+	CHECK_EQUAL(1u, tracker.getTransitionCount());
+}
+
+TEST_CASE(LeavingIsConfirmedAfterDwell)
+{
+	RegionTracker tracker;
+	tracker.Update(true, true, 1000, DWELLMILLISECS);
+
+	CHECK(tracker.Update(false, false, 2000, DWELLMILLISECS) == RegionTracker::Transition::leaving);
+	CHECK(tracker.IsInside());
+	CHECK(tracker.IsLeaving());
+	CHECK(tracker.Update(false, false, 2000 + DWELLMILLISECS - 1, DWELLMILLISECS) == RegionTracker::Transition::none);
+
+	CHECK(tracker.Update(false, false, 2000 + DWELLMILLISECS, DWELLMILLISECS) == RegionTracker::Transition::left);
+	CHECK(!tracker.IsInside());
+	CHECK(!tracker.IsLeaving());
+	CHECK_EQUAL(2u, tracker.getTransitionCount());
+}
+
+TEST_CASE(ComingBackWithinDwellIsNoTransition)
+{
+	RegionTracker tracker;
+	tracker.Update(true, true, 1000, DWELLMILLISECS);
+	CHECK(tracker.Update(false, false, 2000, DWELLMILLISECS) == RegionTracker::Transition::leaving);
+	CHECK(tracker.Update(true, true, 2010, DWELLMILLISECS) == RegionTracker::Transition::none);
+	CHECK(!tracker.IsLeaving());
+
+	// Dwell counts from latest time out
+	CHECK(tracker.Update(false, false, 2020, DWELLMILLISECS) == RegionTracker::Transition::leaving);
+	CHECK(tracker.Update(false, false, 2060, DWELLMILLISECS) == RegionTracker::Transition::none);
+	CHECK(tracker.Update(false, false, 2070, DWELLMILLISECS) == RegionTracker::Transition::left);
+}
+
+TEST_CASE(JitterInsideBandDoesNotFlap)
+{
+	RegionTracker tracker;
+	tracker.Update(true, true, 1000, DWELLMILLISECS);
+
+	// Just out of region but inside hysteresis band, back and forth
+	for (uint64_t now = 1001; now < 3000; ++now)
+		CHECK(tracker.Update((now & 1) != 0, true, now, DWELLMILLISECS) == RegionTracker::Transition::none);
+	CHECK(tracker.IsInside());
+	CHECK(!tracker.IsLeaving());
+	CHECK_EQUAL(1u, tracker.getTransitionCount());
+
+	// Band only matters while inside
+	RegionTracker outside;
+	CHECK(outside.Update(false, true, 1000, DWELLMILLISECS) == RegionTracker::Transition::none);
+}
+
+TEST_CASE(NoDwellLeavesAtOnce)
+{
+	RegionTracker tracker;
+	CHECK(tracker.Update(true, true, 1000, 0) == RegionTracker::Transition::entered);
+	CHECK(tracker.Update(false, false, 1000, 0) == RegionTracker::Transition::left);
+	CHECK(!tracker.IsInside());
+}
+
+TEST_CASE(ResetForgetsRegion)
+{
+	RegionTracker tracker;
+	tracker.Update(true, true, 1000, DWELLMILLISECS);
+	tracker.Update(false, false, 1010, DWELLMILLISECS);
+	tracker.Reset();
+	CHECK(!tracker.IsInside());
+	CHECK(!tracker.IsLeaving());
+	CHECK(tracker.Update(true, true, 1020, DWELLMILLISECS) == RegionTracker::Transition::entered);
+}
@@ -0,0 +1,92 @@
+#include "TestHarness.h"
+#include "AllocationTracker.h"
+#include "ring_buffer.h"
+
+
+TEST_CASE(StartsEmpty)
+{
+	ring_buffer<int, 4> buffer;
+	static_assert(ring_buffer<int, 4>::capacity() == 4, "Capacity is a compile time constant");
+
+	CHECK(buffer.empty());
+	CHECK(!buffer.full());
+	CHECK_EQUAL(0u, buffer.size());
+}
+
+TEST_CASE(KeepsOrderUntilFull)
+{
+	ring_buffer<int, 4> buffer;
+	for (int i = 1; i <= 3; ++i)
+		buffer.push(i);
+
+	CHECK_EQUAL(3u, buffer.size());
+	CHECK(!buffer.full());
+	CHECK_EQUAL(1, buffer.front());
+	CHECK_EQUAL(3, buffer.back());
+	for (size_t i = 0; i < buffer.size(); ++i)
+		CHECK_EQUAL(static_cast<int>(i) + 1, buffer[i]);
+}
+
+TEST_CASE(DropsOldestOnOverflow)
+{
+	ring_buffer<int, 4> buffer;
+	for (int i = 1; i <= 10; ++i)
+		buffer.push(i);
+
+	CHECK(buffer.full());
+	CHECK_EQUAL(4u, buffer.size());
+	CHECK_EQUAL(7, buffer.front());
+	CHECK_EQUAL(10, buffer.back());
+	for (size_t i = 0; i < buffer.size(); ++i)
+		CHECK_EQUAL(static_cast<int>(i) + 7, buffer[i]);
+}
+
+TEST_CASE(ClearStartsOver)
+{
+	ring_buffer<int, 3> buffer;
+	for (int i = 1; i <= 5; ++i)
+		buffer.push(i);
+	buffer.clear();
+
+	CHECK(buffer.empty());
+	buffer.push(42);
+	CHECK_EQUAL(1u, buffer.size());
+	CHECK_EQUAL(42, buffer.front());
+	CHECK_EQUAL(42, buffer.back());
+}
+
+TEST_CASE(CapacityOfOne)
+{
+	ring_buffer<int, 1> buffer;
+	buffer.push(1);
+	buffer.push(2);
+
+	CHECK(buffer.full());
+	CHECK_EQUAL(2, buffer.front());
+	CHECK_EQUAL(2, buffer.back());
+}
+
+TEST_CASE(ElementsCanBeChangedInPlace)
+{
+	ring_buffer<int, 2> buffer;
+	buffer.push(1);
+	buffer.push(2);
+	buffer.push(3);
+
+	buffer.front() = 20;
+	buffer.back() += 10;
+	CHECK_EQUAL(20, buffer[0]);
+	CHECK_EQUAL(13, buffer[1]);
+}
+
+TEST_CASE(NeverAllocates)
+{
+	AllocationScope allocationScope;
+
+	ring_buffer<int, 64> buffer;
+	for (int i = 0; i < 100000; ++i)
+		buffer.push(i);
+	buffer.clear();
+
+	CHECK_EQUAL(0u, allocationScope.getAllocationCount());
+}
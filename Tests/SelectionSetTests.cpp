@@ -0,0 +1,178 @@
+#include "TestHarness.h"
+#include "AllocationTracker.h"
+#include "SelectionSet.h"
+#include <cstdlib>
+#include <vector>
+
+#define ITEMS			10000
+#define OPERATIONS		20000
+
+
+// Selection state of every item, as list-view itself keeps it
+class ReferenceList
+{
+public:
+	explicit ReferenceList(size_t count)
+		: m_selected(count, false) {}
+
+	size_t getItemCount() const { return m_selected.size(); }
+	bool IsSelected(int index) const { return m_selected[index]; }
+	void setSelected(int index, bool bSelected) { m_selected[index] = bSelected; }
+	void Insert(int index) { m_selected.insert(m_selected.begin() + index, false); }
+	void Delete(int index) { m_selected.erase(m_selected.begin() + index); }
+
+	size_t getSelectedCount() const
+	{
+		size_t count = 0;
+		for (auto bSelected : m_selected)
+			count += (bSelected ? 1 : 0);
+		return count;
+	}
+
+	int getLastSelected() const
+	{
+		for (auto i = m_selected.size(); i-- > 0; )
+		{
+			if (m_selected[i])
+				return static_cast<int>(i);
+		}
+		return -1;
+	}
+
+private:
+	std::vector<bool> m_selected;
+};
+
+static void checkSame(const ReferenceList& list, const SelectionSet& selection)
+{
+	CHECK_EQUAL(list.getSelectedCount(), selection.getCount());
+	if (selection.getCount() > 0)
+		CHECK_EQUAL(list.getLastSelected(), selection.getLast());
+}
+
+TEST_CASE(StartsInvalidAndClearMakesItValid)
+{
+	SelectionSet selection;
+	CHECK(!selection.IsValid());
+
+	selection.Clear();
+	CHECK(selection.IsValid());
+	CHECK_EQUAL(0u, selection.getCount());
+
+	selection.Select(3);
+	selection.Invalidate();
+	CHECK(!selection.IsValid());
+	selection.Clear();
+	CHECK(!selection.Contains(3));
+}
+
+TEST_CASE(SelectAndDeselectAreIdempotent)
+{
+	SelectionSet selection;
+	selection.Clear();
+
+	selection.Select(5);
+	selection.Select(5);
+	selection.Select(1);
+	CHECK_EQUAL(2u, selection.getCount());
+	CHECK_EQUAL(5, selection.getLast());
+
+	selection.Deselect(7);
+	selection.Deselect(5);
+	selection.Deselect(5);
+	CHECK_EQUAL(1u, selection.getCount());
+	CHECK(selection.Contains(1));
+	CHECK(!selection.Contains(5));
+}
+
+TEST_CASE(InsertAndDeleteShiftFollowingItems)
+{
+	SelectionSet selection;
+	selection.Clear();
+	selection.Select(2);
+	selection.Select(4);
+	selection.Select(6);
+
+	// Inserted at a selected index, that item moves up
+	selection.OnInserted(4);
+	CHECK(selection.Contains(2));
+	CHECK(!selection.Contains(4));
+	CHECK(selection.Contains(5));
+	CHECK(selection.Contains(7));
+
+	// Deleting a selected item drops it, and items after it move down
+	selection.OnDeleted(5);
+	CHECK_EQUAL(2u, selection.getCount());
+	CHECK(selection.Contains(2));
+	CHECK(selection.Contains(6));
+
+	// Deleting an unselected item only moves those after it
+	selection.OnDeleted(0);
+	CHECK(selection.Contains(1));
+	CHECK(selection.Contains(5));
+}
+
+TEST_CASE(MatchesListOverRandomChanges)
+{
+	ReferenceList list(ITEMS);
+	SelectionSet selection;
+	selection.Clear();
+	srand(1);
+
+	for (int i = 0; i < OPERATIONS; ++i)
+	{
+		auto index = rand() % static_cast<int>(list.getItemCount());
+		switch (rand() % 6)
+		{
+			case 0:
+			case 1:
+				list.setSelected(index, true);
+				selection.Select(index);
+				break;
+
+			case 2:
+			case 3:
+				list.setSelected(index, false);
+				selection.Deselect(index);
+				break;
+
+			case 4:
+				list.Insert(index);
+				selection.OnInserted(index);
+				break;
+
+			default:
+				list.Delete(index);
+				selection.OnDeleted(index);
+				break;
+		}
+
+		if (i % 1000 == 0)
+			checkSame(list, selection);
+	}
+
+	checkSame(list, selection);
+	for (int index = 0; index < static_cast<int>(list.getItemCount()); ++index)
+		CHECK_EQUAL(list.IsSelected(index), selection.Contains(index));
+}
+
+TEST_CASE(ReselectingAfterClearDoesNotAllocate)
+{
+	SelectionSet selection;
+	selection.Clear();
+	for (int index = 0; index < ITEMS; ++index)
+		selection.Select(index);
+
+	// NOTE: Capacity is kept, as a user selects and deselects all icons again and again
+	AllocationScope allocationScope;
+	for (int pass = 0; pass < 3; ++pass)
+	{
+		selection.Clear();
+		for (int index = ITEMS; index-- > 0; )
+			selection.Select(index);
+		selection.OnInserted(0);
+		selection.OnDeleted(0);
+	}
+	CHECK_EQUAL(0u, allocationScope.getAllocationCount());
+	CHECK_EQUAL(static_cast<size_t>(ITEMS), selection.getCount());		// NOTE: Inserted item was never selected
+}
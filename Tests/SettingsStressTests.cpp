@@ -0,0 +1,76 @@
+#include "TestHarness.h"
+#include "Settings.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#define STRESS_READERS		4
+#define STRESS_WRITES		200000
+
+
+// Menu threads write settings while hot paths read them, as in the shell
+// NOTE: Meant to be run under ThreadSanitizer as well, see 'PELLUCIDICONS_SANITIZE'
+TEST_CASE(ReadersSeeConsistentSnapshotsWhileWritersRun)
+{
+	Settings::setInSetting(Settings::In::secs5);
+	Settings::setRestoreWhenSetting(Settings::RestoreWhen::mousedMoved);
+	Settings::setToSetting(Settings::To::fullTransparency);
+	Settings::setIsEnabled(true);
+
+	std::atomic<bool> bWriting(true);
+	std::atomic<uint64_t> cReads(0);
+	std::atomic<uint64_t> cInvalid(0);
+
+	std::vector<std::thread> readers;
+	for (int i = 0; i < STRESS_READERS; ++i)
+	{
+		readers.emplace_back([&]()
+		{
+			uint64_t cLocalReads = 0, cLocalInvalid = 0;
+			while (bWriting.load(std::memory_order_relaxed))
+			{
+				auto snapshot = Settings::getSnapshot();
+				if (static_cast<int>(snapshot.in) > static_cast<int>(Settings::In::mins2) ||
+					static_cast<int>(snapshot.restoreWhen) > static_cast<int>(Settings::RestoreWhen::mousedEntersHotZone) ||
+					static_cast<int>(snapshot.to) > static_cast<int>(Settings::To::hoverReveal))
+				{
+					++cLocalInvalid;
+				}
+				++cLocalReads;
+			}
+
+			cReads.fetch_add(cLocalReads);
+			cInvalid.fetch_add(cLocalInvalid);
+		});
+	}
+
+	// NOTE: Each writer owns one field, so an update lost to another writer shows in final values
+	auto start = std::chrono::steady_clock::now();
+	std::thread writers[] =
+	{
+		std::thread([]() { for (int i = 1; i <= STRESS_WRITES; ++i) Settings::setInSetting(static_cast<Settings::In>(i % 6)); }),
+		std::thread([]() { for (int i = 1; i <= STRESS_WRITES; ++i) Settings::setRestoreWhenSetting(static_cast<Settings::RestoreWhen>(i % 4)); }),
+		std::thread([]() { for (int i = 1; i <= STRESS_WRITES; ++i) Settings::setToSetting(static_cast<Settings::To>(i % 3)); }),
+		std::thread([]() { for (int i = 1; i <= STRESS_WRITES; ++i) Settings::setIsEnabled(i % 2 != 0); })
+	};
+	for (auto& writer : writers)
+		writer.join();
+	bWriting.store(false);
+	for (auto& reader : readers)
+		reader.join();
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	CHECK_EQUAL(0u, cInvalid.load());
+	CHECK(cReads.load() > 0);
+
+	auto snapshot = Settings::getSnapshot();
+	CHECK(snapshot.in == static_cast<Settings::In>(STRESS_WRITES % 6));
+	CHECK(snapshot.restoreWhen == static_cast<Settings::RestoreWhen>(STRESS_WRITES % 4));
+	CHECK(snapshot.to == static_cast<Settings::To>(STRESS_WRITES % 3));
+	CHECK(snapshot.isEnabled == (STRESS_WRITES % 2 != 0));
+
+	printf("%d readers: %.1f M snapshot reads/s while %d writers made %d writes each\n",
+		STRESS_READERS, cReads.load() / elapsed / 1e6, static_cast<int>(sizeof(writers) / sizeof(writers[0])), STRESS_WRITES);
+}
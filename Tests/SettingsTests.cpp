@@ -0,0 +1,109 @@
+#include "TestHarness.h"
+#include "IniSettingsStore.h"
+#include "Settings.h"
+#include <cstdio>
+#include <string>
+#ifdef __linux__
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+
+// Number of file descriptors open in this process, zero where that can't be told
+static size_t getOpenHandleCount()
+{
+	size_t count = 0;
+#ifdef __linux__
+	auto pDir = opendir("/proc/self/fd");
+	if (!pDir)
+		return 0;
+
+	while (readdir(pDir) != nullptr)
+		++count;
+	closedir(pDir);
+#endif
+
+	return count;
+}
+
+static std::string getTempPath(const char *pszName)
+{
+#ifdef __linux__
+	return std::string("/tmp/") + pszName + "." + std::to_string(getpid()) + ".ini";
+#else
+	return std::string(pszName) + ".ini";
+#endif
+}
+
+TEST_CASE(SnapshotRoundTripsThroughPacking)
+{
+	Settings::Snapshot snapshot = { Settings::In::mins2, Settings::RestoreWhen::mousedEntersHotZone, Settings::To::hoverReveal, false };
+	auto unpacked = Settings::Snapshot::unpack(snapshot.pack());
+
+	CHECK(unpacked.in == snapshot.in);
+	CHECK(unpacked.restoreWhen == snapshot.restoreWhen);
+	CHECK(unpacked.to == snapshot.to);
+	CHECK(unpacked.isEnabled == snapshot.isEnabled);
+}
+
+TEST_CASE(IniStoreReadsBackWhatWasWritten)
+{
+	auto path = getTempPath("SettingsTests");
+	static const wchar_t *const s_names[] = { L"In", L"RestoreWhen", L"To", L"Enabled" };
+	{
+		IniSettingsStore store(path);
+		uint32_t values[] = { 3, 2, 1, 0 };
+		CHECK(store.WriteValues(s_names, values, 4));
+	}
+
+	// Values not in store are left as they were
+	static const wchar_t *const s_moreNames[] = { L"In", L"RestoreWhen", L"To", L"Enabled", L"Missing" };
+	IniSettingsStore store(path);
+	uint32_t values[] = { 0, 0, 0, 1, 42 };
+	CHECK(store.ReadValues(s_moreNames, values, 5));
+	CHECK_EQUAL(3u, values[0]);
+	CHECK_EQUAL(2u, values[1]);
+	CHECK_EQUAL(1u, values[2]);
+	CHECK_EQUAL(0u, values[3]);
+	CHECK_EQUAL(42u, values[4]);
+
+	remove(path.c_str());
+}
+
+TEST_CASE(HandleCountStaysFlat)
+{
+	auto path = getTempPath("SettingsHandles");
+	IniSettingsStore store(path);
+	static const wchar_t *const s_names[] = { L"In", L"RestoreWhen", L"To", L"Enabled" };
+	uint32_t values[] = { 0, 0, 0, 1 };
+	store.ReadValues(s_names, values, 4);
+	Settings::ForceSettingsRefreshFromRegistry();
+
+	auto cHandles = getOpenHandleCount();
+	for (int i = 0; i < 1000; ++i)
+	{
+		values[0] = i % 6;
+		store.WriteValues(s_names, values, 4);
+		store.ReadValues(s_names, values, 4);
+
+		Settings::ForceSettingsRefreshFromRegistry();
+		Settings::getSnapshot();
+	}
+	Settings::Close();
+	CHECK_EQUAL(cHandles, getOpenHandleCount());
+
+	remove(path.c_str());
+}
+
+TEST_CASE(SnapshotIsReadFromStoreOnlyOnRefresh)
+{
+	Settings::ForceSettingsRefreshFromRegistry();
+	auto version = Settings::getStoreVersion();
+
+	for (int i = 0; i < 1000; ++i)
+		Settings::getSnapshot();
+	CHECK_EQUAL(version, Settings::getStoreVersion());
+
+	Settings::ForceSettingsRefreshFromRegistry();
+	CHECK(Settings::getStoreVersion() != version);
+}
@@ -0,0 +1,263 @@
+#include "TestHarness.h"
+#include "FakePlatform.h"
+#include "ShellAttacher.h"
+
+#define HOURMILLISECS	(60 * 60 * 1000)
+
+
+// Attacher on a fake clock, with attach and detach counted
+struct AttacherFixture
+{
+	AttacherFixture()
+		: timer(clock, &Timer_Callback, this),
+		attacher(locator, clock, timer, &Attach_Callback, &Detach_Callback, this),
+		bAttachFails(false),
+		cAttaches(0),
+		cDetaches(0),
+		pDetachedWindow(nullptr)
+	{
+	}
+
+	static void Timer_Callback(void *pContext)
+	{
+		static_cast<AttacherFixture *>(pContext)->attacher.OnTimer();
+	}
+
+	static bool Attach_Callback(void *pWindow, void *pContext)
+	{
+		auto pThis = static_cast<AttacherFixture *>(pContext);
+		if (pThis->bAttachFails)
+			return false;
+
+		++pThis->cAttaches;
+		return true;
+	}
+
+	static void Detach_Callback(void *pWindow, void *pContext)
+	{
+		auto pThis = static_cast<AttacherFixture *>(pContext);
+		++pThis->cDetaches;
+		pThis->pDetachedWindow = pWindow;
+	}
+
+	FakeClock clock;
+	FakeTimer timer;
+	FakeLocator locator;
+	ShellAttacher attacher;
+	bool bAttachFails;
+	int cAttaches;
+	int cDetaches;
+	void *pDetachedWindow;
+};
+
+static int s_window1, s_window2;		// Stand-ins for window handles
+
+TEST_CASE(AttachesAtOnceWhenWindowIsThere)
+{
+	AttacherFixture fixture;
+	fixture.locator.setWindow(&s_window1);
+	fixture.attacher.Start();
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::searching);
+	CHECK_EQUAL(0, fixture.cAttaches);		// NOTE: Not on caller's thread
+
+	fixture.clock.Advance(0);
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+	CHECK_EQUAL(static_cast<void *>(&s_window1), fixture.attacher.getWindow());
+	CHECK_EQUAL(1, fixture.cAttaches);
+	CHECK_EQUAL(1u, fixture.locator.getCallCount());
+	CHECK_EQUAL(0u, fixture.attacher.getLastAttachMillisecs());
+
+	// Starting again does nothing
+	fixture.attacher.Start();
+	fixture.clock.Advance(0);
+	CHECK_EQUAL(1, fixture.cAttaches);
+}
+
+TEST_CASE(SearchBacksOffUntilWindowAppears)
+{
+	AttacherFixture fixture;
+	fixture.attacher.Start();
+
+	// Attempts at 0, 50, 150, 350, ... until delay reaches its cap
+	uint32_t expectedDelay = SHELLATTACHER_FIRSTRETRYMILLISECS;
+	fixture.clock.Advance(0);
+	for (int i = 0; i < 10; ++i)
+	{
+		CHECK(fixture.timer.IsArmed());
+		CHECK_EQUAL(fixture.clock.Now() + expectedDelay, fixture.timer.getDue());
+		fixture.clock.AdvanceTo(fixture.timer.getDue());
+		expectedDelay = (expectedDelay < SHELLATTACHER_MAXRETRYMILLISECS / 2 ? expectedDelay * 2 : SHELLATTACHER_MAXRETRYMILLISECS);
+	}
+	CHECK_EQUAL(11u, fixture.attacher.getAttemptCount());
+	CHECK_EQUAL(static_cast<uint32_t>(SHELLATTACHER_MAXRETRYMILLISECS), fixture.attacher.getRetryDelay());
+	CHECK_EQUAL(0u, fixture.locator.getCallCount());
+
+	auto searchMillisecs = fixture.clock.Now();
+	fixture.locator.setWindow(&s_window1);
+	fixture.clock.AdvanceTo(fixture.timer.getDue());
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+	CHECK_EQUAL(searchMillisecs + SHELLATTACHER_MAXRETRYMILLISECS, fixture.attacher.getLastAttachMillisecs());
+}
+
+TEST_CASE(FailedAttachIsRetried)
+{
+	AttacherFixture fixture;
+	fixture.locator.setWindow(&s_window1);
+	fixture.bAttachFails = true;
+	fixture.attacher.Start();
+	fixture.clock.Advance(0);
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::searching);
+	CHECK(fixture.timer.IsArmed());
+
+	fixture.bAttachFails = false;
+	fixture.clock.Advance(SHELLATTACHER_FIRSTRETRYMILLISECS);
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+	CHECK_EQUAL(1, fixture.cAttaches);
+}
+
+TEST_CASE(HungWindowThreadIsRetried)
+{
+	AttacherFixture fixture;
+	fixture.locator.setWindow(&s_window1);
+	fixture.locator.setAnswer(FakeLocator::Answer::never);
+	fixture.attacher.Start();
+	fixture.clock.Advance(1000);
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::searching);
+	CHECK_EQUAL(0, fixture.cAttaches);
+
+	fixture.locator.setAnswer(FakeLocator::Answer::inTime);
+	fixture.clock.AdvanceTo(fixture.timer.getDue());
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+}
+
+TEST_CASE(LateAnswersAttachOnlyOnce)
+{
+	AttacherFixture fixture;
+	fixture.locator.setWindow(&s_window1);
+	fixture.locator.setAnswer(FakeLocator::Answer::late);
+	fixture.attacher.Start();
+	fixture.clock.Advance(0);
+
+	// Window's thread did attach, though search thinks it didn't and tries again
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+	CHECK(fixture.timer.IsArmed());
+
+	// Retry finds it attached and looks no further
+	auto cFinds = fixture.locator.getFindCount();
+	fixture.clock.Advance(HOURMILLISECS);
+	CHECK_EQUAL(cFinds, fixture.locator.getFindCount());
+	CHECK_EQUAL(1, fixture.cAttaches);
+}
+
+TEST_CASE(NothingWakesUpWhileAttached)
+{
+	AttacherFixture fixture;
+	fixture.locator.setWindow(&s_window1);
+	fixture.attacher.Start();
+	fixture.clock.Advance(0);
+
+	auto cFires = fixture.timer.getFireCount();
+	CHECK(!fixture.timer.IsArmed());
+	fixture.clock.Advance(24 * HOURMILLISECS);
+	CHECK_EQUAL(cFires, fixture.timer.getFireCount());
+	CHECK_EQUAL(1u, fixture.locator.getFindCount());
+}
+
+TEST_CASE(DestroyedWindowIsDetachedAndReplaced)
+{
+	AttacherFixture fixture;
+	fixture.locator.setWindow(&s_window1);
+	fixture.attacher.Start();
+	fixture.clock.Advance(0);
+
+	// Another window going is none of our business
+	fixture.attacher.OnWindowDestroyed(&s_window2);
+	CHECK_EQUAL(0, fixture.cDetaches);
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+
+	// Shell replaces its view, so ours is destroyed before new one is there
+	fixture.locator.setWindow(nullptr);
+	fixture.attacher.OnWindowDestroyed(&s_window1);
+	CHECK_EQUAL(1, fixture.cDetaches);
+	CHECK_EQUAL(static_cast<void *>(&s_window1), fixture.pDetachedWindow);
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::searching);
+	CHECK(fixture.attacher.getWindow() == nullptr);
+	CHECK_EQUAL(fixture.clock.Now(), fixture.timer.getDue());		// NOTE: Searched again at once
+
+	fixture.clock.Advance(100);
+	fixture.locator.setWindow(&s_window2);
+	fixture.clock.AdvanceTo(fixture.timer.getDue());
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+	CHECK_EQUAL(static_cast<void *>(&s_window2), fixture.attacher.getWindow());
+	CHECK_EQUAL(2u, fixture.attacher.getAttachCount());
+
+	// Destroyed twice detaches once
+	fixture.attacher.OnWindowDestroyed(&s_window2);
+	fixture.attacher.OnWindowDestroyed(&s_window2);
+	CHECK_EQUAL(2, fixture.cDetaches);
+}
+
+TEST_CASE(SuspendStopsSearchUntilResume)
+{
+	AttacherFixture fixture;
+	fixture.attacher.Start();
+	fixture.clock.Advance(0);
+
+	fixture.attacher.Suspend();
+	CHECK(!fixture.timer.IsArmed());
+	auto cAttempts = fixture.attacher.getAttemptCount();
+	fixture.clock.Advance(HOURMILLISECS);
+	CHECK_EQUAL(cAttempts, fixture.attacher.getAttemptCount());
+
+	// Timer that fired just before suspending does nothing
+	fixture.timer.Fire();
+	CHECK_EQUAL(cAttempts, fixture.attacher.getAttemptCount());
+
+	fixture.locator.setWindow(&s_window1);
+	fixture.attacher.Resume();
+	CHECK_EQUAL(fixture.clock.Now(), fixture.timer.getDue());
+	fixture.clock.Advance(0);
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+
+	// Once attached, there is nothing to resume
+	fixture.attacher.Suspend();
+	fixture.attacher.Resume();
+	CHECK(!fixture.timer.IsArmed());
+}
+
+TEST_CASE(DestroyedWhileSuspendedSearchesOnResume)
+{
+	AttacherFixture fixture;
+	fixture.locator.setWindow(&s_window1);
+	fixture.attacher.Start();
+	fixture.clock.Advance(0);
+
+	fixture.attacher.Suspend();
+	fixture.attacher.OnWindowDestroyed(&s_window1);
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::searching);
+	CHECK(!fixture.timer.IsArmed());
+
+	fixture.attacher.Resume();
+	fixture.clock.Advance(0);
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+}
+
+TEST_CASE(StopAllowsStartingOver)
+{
+	AttacherFixture fixture;
+	fixture.attacher.Start();
+	fixture.clock.Advance(0);
+
+	fixture.attacher.Stop();
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::stopped);
+	CHECK(!fixture.timer.IsArmed());
+
+	fixture.locator.setWindow(&s_window1);
+	fixture.attacher.Start();
+	fixture.clock.Advance(0);
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+
+	// Attached window stays so, as window procedure must not be taken away from under it
+	fixture.attacher.Stop();
+	CHECK(fixture.attacher.getState() == ShellAttacher::State::attached);
+}
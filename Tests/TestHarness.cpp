@@ -0,0 +1,56 @@
+#include "TestHarness.h"
+#include <cstdio>
+
+
+// Static variables
+static struct
+{
+	const char *pszName;
+	TestHarness::TestFunction function;
+} s_cases[TESTHARNESS_MAXCASES];
+static size_t s_cCases = 0;
+static size_t s_cFailedChecks = 0;
+
+
+void TestHarness::Register(const char *pszName, TestFunction function)
+{
+	if (s_cCases == TESTHARNESS_MAXCASES)
+	{
+		fprintf(stderr, "Too many test cases, '%s' is not run\n", pszName);
+		return;
+	}
+
+	s_cases[s_cCases].pszName = pszName;
+	s_cases[s_cCases].function = function;
+	++s_cCases;
+}
+
+void TestHarness::Fail(const char *pszFile, int line, const char *pszExpression)
+{
+	++s_cFailedChecks;
+	fprintf(stderr, "%s(%d): CHECK(%s) failed\n", pszFile, line, pszExpression);
+}
+
+int TestHarness::RunAll()
+{
+	size_t cFailedCases = 0;
+	for (size_t i = 0; i < s_cCases; ++i)
+	{
+		auto cFailedChecks = s_cFailedChecks;
+		s_cases[i].function();
+
+		bool bPassed = (s_cFailedChecks == cFailedChecks);
+		printf("[%s] %s\n", (bPassed ? "  OK  " : " FAIL "), s_cases[i].pszName);
+		if (!bPassed)
+			++cFailedCases;
+	}
+
+	printf("%zu of %zu test cases passed\n", s_cCases - cFailedCases, s_cCases);
+	return (cFailedCases == 0 ? 0 : 1);
+}
+
+
+int main()
+{
+	return TestHarness::RunAll();
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#define TESTHARNESS_MAXCASES		128
+
+
+// Self-registering test cases, so tests need nothing but the standard library
+// NOTE: Registration and checks never allocate, so tests can count allocations of code under them.
+//		 Each test executable runs all cases registered in it, see 'TestHarness.cpp'.
+class TestHarness
+{
+public:
+	typedef void(*TestFunction)();
+
+	static void Register(const char *pszName, TestFunction function);
+	static void Fail(const char *pszFile, int line, const char *pszExpression);
+	static int RunAll();				// Returns process exit code
+};
+
+class TestRegistration
+{
+public:
+	TestRegistration(const char *pszName, TestHarness::TestFunction function)
+	{
+		TestHarness::Register(pszName, function);
+	}
+};
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static TestRegistration testRegistration_##name(#name, &name); \
+	static void name()
+
+// NOTE: Failed check is reported, and test case goes on
+#define CHECK(expression) \
+	((expression) ? (void)0 : TestHarness::Fail(__FILE__, __LINE__, #expression))
+#define CHECK_EQUAL(expected, actual)	CHECK((expected) == (actual))
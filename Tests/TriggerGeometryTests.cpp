@@ -0,0 +1,108 @@
+#include "TestHarness.h"
+#include "TriggerGeometry.h"
+
+
+TEST_CASE(SingleMonitorZoneIsLeftQuarter)
+{
+	TriggerGeometry geometry;
+	Rect monitors[] = { { 0, 0, 1920, 1080 } };
+	CHECK_EQUAL(1u, geometry.Update(monitors, 1));
+
+	Rect expected = { 0, 0, 480, 1080 };
+	CHECK(geometry.getTriggerZone(0) == expected);
+	CHECK(geometry.IsInTriggerZone(0, 0));
+	CHECK(geometry.IsInTriggerZone(479, 1079));
+	CHECK(!geometry.IsInTriggerZone(480, 500));
+	CHECK(!geometry.IsInTriggerZone(100, 1080));
+	CHECK(!geometry.IsInTriggerZone(-1, 500));
+}
+
+TEST_CASE(SideBySideMonitorsEachHaveZone)
+{
+	// Unequal sizes and a primary monitor on right, so left one is at negative coordinates
+	TriggerGeometry geometry;
+	Rect monitors[] = { { 0, 0, 2560, 1440 }, { -1280, 400, 0, 1424 } };
+	CHECK_EQUAL(2u, geometry.Update(monitors, 2));
+
+	CHECK(geometry.IsInTriggerZone(639, 0));
+	CHECK(!geometry.IsInTriggerZone(640, 0));
+	CHECK(geometry.IsInTriggerZone(-1280, 400));
+	CHECK(geometry.IsInTriggerZone(-961, 1423));
+	CHECK(!geometry.IsInTriggerZone(-960, 800));
+	CHECK(!geometry.IsInTriggerZone(-1200, 399));		// Above shorter monitor
+}
+
+TEST_CASE(StackedMonitorsEachHaveZone)
+{
+	TriggerGeometry geometry;
+	Rect monitors[] = { { 0, 0, 1920, 1080 }, { 0, 1080, 1920, 2160 } };
+	geometry.Update(monitors, 2);
+
+	CHECK(geometry.IsInTriggerZone(10, 10));
+	CHECK(geometry.IsInTriggerZone(10, 2000));
+	CHECK(!geometry.IsInTriggerZone(1000, 2000));
+}
+
+TEST_CASE(SpannedDesktopUsesEachMonitorNotWholeWidth)
+{
+	// Three monitors spanned into one desktop, as with a single wide 'SysListView32'
+	TriggerGeometry geometry;
+	Rect monitors[] = { { 0, 0, 1920, 1080 }, { 1920, 0, 3840, 1080 }, { 3840, 0, 5760, 1080 } };
+	geometry.Update(monitors, 3);
+
+	CHECK(geometry.IsInTriggerZone(479, 500));
+	CHECK(!geometry.IsInTriggerZone(1000, 500));		// Inside quarter of whole span, but not of first monitor
+	CHECK(geometry.IsInTriggerZone(1920 + 100, 500));
+	CHECK(geometry.IsInTriggerZone(3840 + 479, 500));
+	CHECK(!geometry.IsInTriggerZone(3840 + 480, 500));
+}
+
+TEST_CASE(OnlyChangedMonitorsAreRebuilt)
+{
+	TriggerGeometry geometry;
+	Rect monitors[] = { { 0, 0, 1920, 1080 }, { 1920, 0, 3840, 1080 } };
+	CHECK_EQUAL(2u, geometry.Update(monitors, 2));
+	CHECK_EQUAL(0u, geometry.Update(monitors, 2));
+
+	// Resolution of second monitor changes
+	monitors[1].right = 1920 + 2560;
+	monitors[1].bottom = 1440;
+	CHECK_EQUAL(1u, geometry.Update(monitors, 2));
+	CHECK(geometry.IsInTriggerZone(1920 + 639, 1200));
+
+	// Monitor unplugged, then plugged back in
+	CHECK_EQUAL(0u, geometry.Update(monitors, 1));
+	CHECK_EQUAL(1u, geometry.getMonitorCount());
+	CHECK(!geometry.IsInTriggerZone(1920 + 10, 10));
+	CHECK_EQUAL(1u, geometry.Update(monitors, 2));
+	CHECK(geometry.IsInTriggerZone(1920 + 10, 10));
+}
+
+TEST_CASE(MarginGrowsZones)
+{
+	TriggerGeometry geometry;
+	Rect monitors[] = { { 0, 0, 1920, 1080 } };
+	geometry.Update(monitors, 1);
+
+	CHECK(!geometry.IsInTriggerZone(485, 500));
+	CHECK(geometry.IsInTriggerZone(485, 500, 8));
+	CHECK(!geometry.IsInTriggerZone(488, 500, 8));
+}
+
+TEST_CASE(ExtraMonitorsAreIgnored)
+{
+	TriggerGeometry geometry;
+	Rect monitors[TRIGGERGEOMETRY_MAXMONITORS + 2];
+	for (int i = 0; i < TRIGGERGEOMETRY_MAXMONITORS + 2; ++i)
+		monitors[i] = Rect{ i * 1000, 0, i * 1000 + 1000, 1000 };
+
+	CHECK_EQUAL(static_cast<size_t>(TRIGGERGEOMETRY_MAXMONITORS), geometry.Update(monitors, TRIGGERGEOMETRY_MAXMONITORS + 2));
+	CHECK(geometry.IsInTriggerZone((TRIGGERGEOMETRY_MAXMONITORS - 1) * 1000, 0));
+	CHECK(!geometry.IsInTriggerZone(TRIGGERGEOMETRY_MAXMONITORS * 1000, 0));
+}
+
+TEST_CASE(NoMonitorsMeansNoZone)
+{
+	TriggerGeometry geometry;
+	CHECK(!geometry.IsInTriggerZone(0, 0));
+}
@@ -0,0 +1,202 @@
+#include "TestHarness.h"
+#include "HeadlessEngine.h"
+#include "VisibilityOracle.h"
+#include <thread>
+#include <vector>
+
+#define FADEMILLISECS	(FADE_FRAMES * FADE_FRAMEMILLISECS)
+#define HOURMILLISECS	(60 * 60 * 1000)
+#define THREADS			4
+#define TOGGLES			10000
+
+
+// Counts and remembers each change called back
+struct ChangeRecorder
+{
+	ChangeRecorder()
+		: cChanges(0),
+		bLastVisible(true)
+	{
+	}
+
+	static void Changed_Callback(bool bVisible, void *pContext)
+	{
+		auto pThis = static_cast<ChangeRecorder *>(pContext);
+		++pThis->cChanges;
+		pThis->bLastVisible = bVisible;
+	}
+
+	int cChanges;
+	bool bLastVisible;
+};
+
+// Engine suspended and resumed by an oracle, as 'PellucidHandlers::Visibility_Changed()' does
+struct SuspendingFixture
+{
+	SuspendingFixture()
+		: oracle(&Changed_Callback, this)
+	{
+		headless.Start();
+	}
+
+	static void Changed_Callback(bool bVisible, void *pContext)
+	{
+		auto& engine = static_cast<SuspendingFixture *>(pContext)->headless.getEngine();
+		if (bVisible)
+			engine.Resume();
+		else
+			engine.Suspend();
+	}
+
+	HeadlessEngine headless;
+	VisibilityOracle oracle;
+};
+
+TEST_CASE(VisibleWhileNoReasonIsLeft)
+{
+	ChangeRecorder recorder;
+	VisibilityOracle oracle(&ChangeRecorder::Changed_Callback, &recorder);
+	CHECK(oracle.IsVisible());
+
+	oracle.Set(VisibilityOracle::reasonSessionLocked, true);
+	CHECK(!oracle.IsVisible());
+	CHECK_EQUAL(1, recorder.cChanges);
+	CHECK(!recorder.bLastVisible);
+
+	// More reasons, or the same one again, change nothing
+	oracle.Set(VisibilityOracle::reasonDisplayOff, true);
+	oracle.Set(VisibilityOracle::reasonSessionLocked, true);
+	CHECK_EQUAL(1, recorder.cChanges);
+	CHECK_EQUAL(static_cast<uint32_t>(VisibilityOracle::reasonSessionLocked | VisibilityOracle::reasonDisplayOff), oracle.getHiddenReasons());
+
+	// Nor does clearing one that isn't set
+	oracle.Set(VisibilityOracle::reasonFullScreen, false);
+	oracle.Set(VisibilityOracle::reasonSessionLocked, false);
+	CHECK(!oracle.IsVisible());
+	CHECK_EQUAL(1, recorder.cChanges);
+
+	oracle.Set(VisibilityOracle::reasonDisplayOff, false);
+	CHECK(oracle.IsVisible());
+	CHECK_EQUAL(2, recorder.cChanges);
+	CHECK(recorder.bLastVisible);
+	CHECK_EQUAL(2u, oracle.getChangeCount());
+}
+
+TEST_CASE(ClearForgetsAllReasons)
+{
+	ChangeRecorder recorder;
+	VisibilityOracle oracle(&ChangeRecorder::Changed_Callback, &recorder);
+
+	oracle.Clear();
+	CHECK_EQUAL(0, recorder.cChanges);
+
+	oracle.Set(VisibilityOracle::reasonFullScreen, true);
+	oracle.Set(VisibilityOracle::reasonSessionDisconnected, true);
+	oracle.Clear();
+	CHECK(oracle.IsVisible());
+	CHECK_EQUAL(0u, oracle.getHiddenReasons());
+	CHECK_EQUAL(2, recorder.cChanges);
+	CHECK(recorder.bLastVisible);
+}
+
+TEST_CASE(ChangesFromManyThreadsAlternate)
+{
+	// NOTE: Each thread toggles its own reason, so callbacks must alternate between hidden and visible
+	ChangeRecorder recorder;
+	struct Alternation
+	{
+		static void Changed_Callback(bool bVisible, void *pContext)
+		{
+			auto pRecorder = static_cast<ChangeRecorder *>(pContext);
+			if (bVisible != pRecorder->bLastVisible)
+				++pRecorder->cChanges;
+			pRecorder->bLastVisible = bVisible;
+		}
+	};
+	VisibilityOracle oracle(&Alternation::Changed_Callback, &recorder);
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < THREADS; ++i)
+	{
+		threads.emplace_back([&oracle, i]()
+		{
+			auto reason = static_cast<VisibilityOracle::Reason>(1 << i);
+			for (int j = 0; j < TOGGLES; ++j)
+				oracle.Set(reason, (j % 2) == 0);
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	CHECK(oracle.IsVisible());
+	CHECK_EQUAL(static_cast<int>(oracle.getChangeCount()), recorder.cChanges);
+	CHECK_EQUAL(0u, oracle.getChangeCount() % 2);
+	CHECK(recorder.bLastVisible);
+}
+
+TEST_CASE(HiddenDesktopWakesNothingUp)
+{
+	SuspendingFixture fixture;
+	auto& idleTimer = fixture.headless.getIdleTimer();
+	auto& frameTimer = fixture.headless.getFrameTimer();
+	CHECK(idleTimer.IsArmed());
+
+	fixture.oracle.Set(VisibilityOracle::reasonSessionLocked, true);
+	CHECK(fixture.headless.getEngine().IsSuspended());
+	CHECK(!idleTimer.IsArmed());
+
+	auto cIdleFires = idleTimer.getFireCount();
+	auto cFrameFires = frameTimer.getFireCount();
+	fixture.headless.Advance(24 * HOURMILLISECS);
+	CHECK_EQUAL(cIdleFires, idleTimer.getFireCount());
+	CHECK_EQUAL(cFrameFires, frameTimer.getFireCount());
+
+	// Activity can't come from a desktop that can't be seen, so it arms nothing either
+	auto cIdleArms = idleTimer.getArmCount();
+	auto cFrameArms = frameTimer.getArmCount();
+	fixture.headless.getEngine().ResetTimer();
+	fixture.headless.getEngine().OnRightButtonDown();
+	CHECK_EQUAL(cIdleArms, idleTimer.getArmCount());
+	CHECK_EQUAL(cFrameArms, frameTimer.getArmCount());
+
+	// Countdown starts over on return
+	fixture.oracle.Set(VisibilityOracle::reasonSessionLocked, false);
+	CHECK(!fixture.headless.getEngine().IsSuspended());
+	CHECK(idleTimer.IsArmed());
+	CHECK_EQUAL(fixture.headless.getClock().Now() + Settings::convertInToMillisecs(fixture.headless.getSettings().in), idleTimer.getDue());
+}
+
+TEST_CASE(HidingMidFadeFinishesIt)
+{
+	SuspendingFixture fixture;
+	auto& frameTimer = fixture.headless.getFrameTimer();
+	fixture.headless.Advance(Settings::convertInToMillisecs(fixture.headless.getSettings().in) + FADEMILLISECS / 2);
+	CHECK(fixture.headless.getEngine().getFadeEngine().IsFading());
+
+	fixture.oracle.Set(VisibilityOracle::reasonDisplayOff, true);
+	CHECK(!frameTimer.IsArmed());
+	CHECK(!fixture.headless.getEngine().getFadeEngine().IsFading());
+	CHECK_EQUAL(OPACITY_HIDDEN, fixture.headless.getOpacity().getOpacity());
+
+	auto cFrameFires = frameTimer.getFireCount();
+	fixture.headless.Advance(HOURMILLISECS);
+	CHECK_EQUAL(cFrameFires, frameTimer.getFireCount());
+}
+
+TEST_CASE(EachHideWakesEngineOnlyOnReturn)
+{
+	SuspendingFixture fixture;
+	auto& idleTimer = fixture.headless.getIdleTimer();
+
+	// Lock, then display off, then unlock, then display on: suspended and resumed once
+	auto cArms = idleTimer.getArmCount();
+	fixture.oracle.Set(VisibilityOracle::reasonSessionLocked, true);
+	fixture.oracle.Set(VisibilityOracle::reasonDisplayOff, true);
+	fixture.oracle.Set(VisibilityOracle::reasonSessionLocked, false);
+	CHECK(fixture.headless.getEngine().IsSuspended());
+	CHECK_EQUAL(cArms, idleTimer.getArmCount());
+
+	fixture.oracle.Set(VisibilityOracle::reasonDisplayOff, false);
+	CHECK_EQUAL(cArms + 1, idleTimer.getArmCount());
+	CHECK_EQUAL(2u, fixture.oracle.getChangeCount());
+}
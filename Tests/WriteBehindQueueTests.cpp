@@ -0,0 +1,114 @@
+#include "TestHarness.h"
+#include "FakePlatform.h"
+#include "WriteBehindQueue.h"
+
+#define DEBOUNCEMILLISECS	500
+
+
+// Write-behind queue on a fake timer, with a backend that counts writes and can be made to fail
+struct WriteBehindFixture
+{
+	FakeClock clock;
+	FakeTimer timer;
+	WriteBehindQueue writeBehind;
+	bool bFailWrites;
+	uint32_t cWrites;
+	uint32_t cFieldWrites;
+	uint32_t writtenMask;
+
+	WriteBehindFixture()
+		: clock(1000),
+		timer(clock, &Timer_Callback, this),
+		writeBehind(timer, DEBOUNCEMILLISECS, &WriteBehind_Flush, this),
+		bFailWrites(false),
+		cWrites(0),
+		cFieldWrites(0),
+		writtenMask(0) {}
+
+	static void Timer_Callback(void *pContext)
+	{
+		static_cast<WriteBehindFixture *>(pContext)->writeBehind.Flush();
+	}
+
+	static bool WriteBehind_Flush(uint32_t dirtyMask, void *pContext)
+	{
+		auto pThis = static_cast<WriteBehindFixture *>(pContext);
+		++pThis->cWrites;
+		if (pThis->bFailWrites)
+			return false;
+
+		for (uint32_t mask = dirtyMask; mask; mask &= mask - 1)
+			++pThis->cFieldWrites;
+		pThis->writtenMask |= dirtyMask;
+		return true;
+	}
+};
+
+TEST_CASE(BurstOfChangesIsWrittenOnce)
+{
+	WriteBehindFixture fixture;
+
+	// As clicking through the menu, one change every 10 ms
+	for (int i = 0; i < 1000; ++i)
+	{
+		fixture.writeBehind.MarkDirty(1u << (i % 4));
+		fixture.clock.Advance(10);
+	}
+	CHECK_EQUAL(0u, fixture.cWrites);
+	CHECK_EQUAL(0xFu, fixture.writeBehind.getUnflushedMask());
+
+	fixture.clock.Advance(DEBOUNCEMILLISECS);
+	CHECK_EQUAL(1u, fixture.cWrites);
+	CHECK_EQUAL(4u, fixture.cFieldWrites);
+	CHECK_EQUAL(0xFu, fixture.writtenMask);
+	CHECK_EQUAL(0u, fixture.writeBehind.getUnflushedMask());
+	CHECK_EQUAL(1u, fixture.writeBehind.getFlushCount());
+}
+
+TEST_CASE(QuietPeriodRestartsWithEachChange)
+{
+	WriteBehindFixture fixture;
+	fixture.writeBehind.MarkDirty(1);
+	fixture.clock.Advance(DEBOUNCEMILLISECS - 1);
+	fixture.writeBehind.MarkDirty(2);
+	fixture.clock.Advance(DEBOUNCEMILLISECS - 1);
+	CHECK_EQUAL(0u, fixture.cWrites);
+
+	fixture.clock.Advance(1);
+	CHECK_EQUAL(1u, fixture.cWrites);
+	CHECK_EQUAL(3u, fixture.writtenMask);
+}
+
+TEST_CASE(FlushWritesAtOnceAndOnlyWhenDirty)
+{
+	WriteBehindFixture fixture;
+	fixture.writeBehind.Flush();
+	CHECK_EQUAL(0u, fixture.cWrites);
+
+	fixture.writeBehind.MarkDirty(4);
+	fixture.writeBehind.Flush();
+	CHECK_EQUAL(1u, fixture.cWrites);
+
+	// Timer finds nothing left to write
+	fixture.clock.Advance(DEBOUNCEMILLISECS);
+	CHECK_EQUAL(1u, fixture.cWrites);
+}
+
+TEST_CASE(FailedWriteKeepsFieldsDirty)
+{
+	WriteBehindFixture fixture;
+	fixture.bFailWrites = true;
+	fixture.writeBehind.MarkDirty(1);
+	fixture.clock.Advance(DEBOUNCEMILLISECS);
+	CHECK_EQUAL(1u, fixture.cWrites);
+	CHECK_EQUAL(1u, fixture.writeBehind.getUnflushedMask());
+	CHECK_EQUAL(0u, fixture.writeBehind.getFlushCount());
+
+	// Written along with next change
+	fixture.bFailWrites = false;
+	fixture.writeBehind.MarkDirty(8);
+	fixture.clock.Advance(DEBOUNCEMILLISECS);
+	CHECK_EQUAL(2u, fixture.cWrites);
+	CHECK_EQUAL(9u, fixture.writtenMask);
+	CHECK_EQUAL(0u, fixture.writeBehind.getUnflushedMask());
+}
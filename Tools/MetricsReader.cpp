@@ -0,0 +1,270 @@
+#include "HeadlessEngine.h"
+#include "Metrics.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#define FADEMILLISECS		(FADE_FRAMES * FADE_FRAMEMILLISECS)
+
+
+// Prints counters, latency percentiles and gauges published by the running extension, or the
+// difference between two snapshots of them
+// NOTE: Usage: 'MetricsReader' for what was counted since shell started,
+//		 'MetricsReader --interval <secs>' for what was counted over next seconds,
+//		 'MetricsReader --save <file>' to keep a snapshot for later,
+//		 'MetricsReader <file> [<later file>]' to print a saved snapshot, or difference of two,
+//		 'MetricsReader --synthesize' to print what a headless engine counts, with no shell at hand.
+//		 Reading the running extension is only possible on Windows, see 'METRICS_SHAREDMEMORYNAME'.
+
+static const char *s_pszCounterNames[] =
+{
+	"MouseMove",
+	"MouseLeave",
+	"DoubleClick",
+	"RightButtonDown",
+	"StyleChanged",
+	"GeometryChanged",
+	"OtherMessage",
+	"AttachAttempt",
+	"TimerWakeup",
+	"VisibilityChanged"
+};
+static_assert(sizeof(s_pszCounterNames) / sizeof(s_pszCounterNames[0]) == Metrics::counterCount, "A counter has no name");
+
+static const char *s_pszHistogramNames[] =
+{
+	"WndProc",
+	"ResetTimer",
+	"KillTimer",
+	"FadeStep",
+	"SettingsRead",
+	"SettingsWrite",
+	"Attach"
+};
+static_assert(sizeof(s_pszHistogramNames) / sizeof(s_pszHistogramNames[0]) == Metrics::histogramCount, "A histogram has no name");
+
+static const char *s_pszGaugeNames[] =
+{
+	"LayeredSurfaceBytes"
+};
+static_assert(sizeof(s_pszGaugeNames) / sizeof(s_pszGaugeNames[0]) == Metrics::gaugeCount, "A gauge has no name");
+
+
+// Live layout of running extension, read only
+class SharedLayout
+{
+public:
+	SharedLayout()
+		: m_pData(nullptr)
+#ifdef _WIN32
+		, m_hMapping(NULL)
+#endif
+	{
+	}
+
+	~SharedLayout()
+	{
+#ifdef _WIN32
+		if (m_pData)
+			UnmapViewOfFile(m_pData);
+		if (m_hMapping)
+			CloseHandle(m_hMapping);
+#endif
+	}
+
+	bool Open()
+	{
+#ifdef _WIN32
+		m_hMapping = OpenFileMapping(FILE_MAP_READ, FALSE, METRICS_SHAREDMEMORYNAME);
+		m_pData = (m_hMapping ? MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, sizeof(Metrics::Layout)) : NULL);
+		return (m_pData != nullptr);
+#else
+		return false;
+#endif
+	}
+
+	const void *getData() const
+	{
+		return m_pData;
+	}
+
+private:
+	void *m_pData;
+#ifdef _WIN32
+	HANDLE m_hMapping;
+#endif
+};
+
+static bool readFile(const char *pszPath, std::vector<uint64_t>& data, size_t& cbData)
+{
+	auto pFile = fopen(pszPath, "rb");
+	if (!pFile)
+		return false;
+
+	// NOTE: Read into 64-bit words, as layout is read in place
+	data.assign(sizeof(Metrics::Layout) / sizeof(uint64_t) + 1, 0);
+	cbData = fread(data.data(), 1, sizeof(Metrics::Layout), pFile);
+	fclose(pFile);
+
+	return (cbData == sizeof(Metrics::Layout));
+}
+
+static bool writeFile(const char *pszPath, const void *pData, size_t cbData)
+{
+	auto pFile = fopen(pszPath, "wb");
+	if (!pFile)
+		return false;
+
+	bool bWritten = (fwrite(pData, 1, cbData, pFile) == cbData);
+	return (fclose(pFile) == 0 && bWritten);
+}
+
+static bool loadSnapshot(const char *pszPath, Metrics::Snapshot& snapshot)
+{
+	std::vector<uint64_t> data;
+	size_t cbData = 0;
+	if (!readFile(pszPath, data, cbData) || !Metrics::TakeSnapshot(data.data(), cbData, snapshot))
+	{
+		fprintf(stderr, "'%s' is not a saved snapshot, or is of another version\n", pszPath);
+		return false;
+	}
+
+	return true;
+}
+
+// Prints snapshot, with rates if it is a difference over given seconds
+static void print(const Metrics::Snapshot& snapshot, double secs)
+{
+	printf("%-24s %14s %14s\n", "Counter", "count", (secs > 0 ? "per sec" : ""));
+	for (int i = 0; i < Metrics::counterCount; ++i)
+	{
+		if (secs > 0)
+			printf("  %-22s %14llu %14.1f\n", s_pszCounterNames[i], static_cast<unsigned long long>(snapshot.counters[i]), snapshot.counters[i] / secs);
+		else
+			printf("  %-22s %14llu\n", s_pszCounterNames[i], static_cast<unsigned long long>(snapshot.counters[i]));
+	}
+
+	// NOTE: Percentiles are lower bounds of their buckets, see 'Metrics::getPercentile()'
+	printf("\n%-24s %10s %10s %10s %10s %10s %10s %10s\n", "Histogram (ns)", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+	for (int i = 0; i < Metrics::histogramCount; ++i)
+	{
+		auto histogram = static_cast<Metrics::Histogram>(i);
+		auto count = snapshot.counts[i];
+		printf("  %-22s %10llu %10llu %10llu %10llu %10llu %10llu %10llu\n", s_pszHistogramNames[i],
+			static_cast<unsigned long long>(count),
+			static_cast<unsigned long long>(count ? snapshot.sums[i] / count : 0),
+			static_cast<unsigned long long>(Metrics::getPercentile(snapshot, histogram, 50)),
+			static_cast<unsigned long long>(Metrics::getPercentile(snapshot, histogram, 90)),
+			static_cast<unsigned long long>(Metrics::getPercentile(snapshot, histogram, 99)),
+			static_cast<unsigned long long>(Metrics::getPercentile(snapshot, histogram, 99.9)),
+			static_cast<unsigned long long>(Metrics::getPercentile(snapshot, histogram, 100)));
+	}
+
+	printf("\n%-24s %14s\n", "Gauge", "value");
+	for (int i = 0; i < Metrics::gaugeCount; ++i)
+		printf("  %-22s %14llu\n", s_pszGaugeNames[i], static_cast<unsigned long long>(snapshot.gauges[i]));
+}
+
+// Headless engine through a few idle fades and restores, with metrics in local memory
+// NOTE: Only engine, fade and timer metrics are counted, as messages are counted by window procedure
+static int synthesize()
+{
+	std::unique_ptr<Metrics::Layout> pLayout(new Metrics::Layout());
+	std::unique_ptr<Metrics::Snapshot> pBefore(new Metrics::Snapshot()), pAfter(new Metrics::Snapshot()), pDifference(new Metrics::Snapshot());
+	Metrics::Attach(pLayout.get(), sizeof(Metrics::Layout));
+	Metrics::TakeSnapshot(pLayout.get(), sizeof(Metrics::Layout), *pBefore);
+
+	HeadlessEngine headless;
+	headless.Start();
+	auto settings = headless.getSettings();
+	for (int i = 0; i < 100; ++i)
+	{
+		headless.Advance(Settings::convertInToMillisecs(settings.in) + FADEMILLISECS);
+		for (int j = 0; j < MOUSEPOS_HISTORYDEPTH; ++j)
+			headless.getEngine().OnMouseMove(100 + j * MOUSEMOVE_DISTANCETHRESHOLD, 100 + i, settings);
+	}
+
+	Metrics::TakeSnapshot(pLayout.get(), sizeof(Metrics::Layout), *pAfter);
+	Metrics::Detach();
+	Metrics::Diff(*pBefore, *pAfter, *pDifference);
+
+	print(*pDifference, 0);
+	return (pDifference->counts[Metrics::histogramFadeStep] > 0 ? 0 : 1);
+}
+
+int main(int argc, char *argv[])
+{
+	std::unique_ptr<Metrics::Snapshot> pBefore(new Metrics::Snapshot()), pAfter(new Metrics::Snapshot());
+	if (argc == 2 && strcmp(argv[1], "--synthesize") == 0)
+		return synthesize();
+
+	// Saved snapshots
+	if (argc >= 2 && argv[1][0] != '-')
+	{
+		if (!loadSnapshot(argv[1], *pBefore))
+			return 1;
+		if (argc < 3)
+		{
+			print(*pBefore, 0);
+			return 0;
+		}
+
+		std::unique_ptr<Metrics::Snapshot> pDifference(new Metrics::Snapshot());
+		if (!loadSnapshot(argv[2], *pAfter))
+			return 1;
+		Metrics::Diff(*pBefore, *pAfter, *pDifference);
+		print(*pDifference, 0);
+		return 0;
+	}
+
+	if (argc != 1 && !(argc == 3 && (strcmp(argv[1], "--interval") == 0 || strcmp(argv[1], "--save") == 0)))
+	{
+		fprintf(stderr, "Usage: %s [--interval <secs> | --save <file> | <file> [<later file>] | --synthesize]\n", argv[0]);
+		return 1;
+	}
+
+	// Running extension
+	SharedLayout shared;
+	if (!shared.Open())
+	{
+		fprintf(stderr, "Extension isn't running, or was built with 'PELLUCIDICONS_NO_METRICS'\n");
+		return 1;
+	}
+
+	if (argc == 3 && strcmp(argv[1], "--save") == 0)
+	{
+		if (!writeFile(argv[2], shared.getData(), sizeof(Metrics::Layout)))
+		{
+			fprintf(stderr, "Can't write '%s'\n", argv[2]);
+			return 1;
+		}
+		return 0;
+	}
+
+	if (!Metrics::TakeSnapshot(shared.getData(), sizeof(Metrics::Layout), *pBefore))
+	{
+		fprintf(stderr, "Extension publishes another version of metrics\n");
+		return 1;
+	}
+	if (argc < 3)
+	{
+		print(*pBefore, 0);
+		return 0;
+	}
+
+	auto secs = atof(argv[2]);
+	std::this_thread::sleep_for(std::chrono::duration<double>(secs));
+	Metrics::TakeSnapshot(shared.getData(), sizeof(Metrics::Layout), *pAfter);
+
+	std::unique_ptr<Metrics::Snapshot> pDifference(new Metrics::Snapshot());
+	Metrics::Diff(*pBefore, *pAfter, *pDifference);
+	print(*pDifference, secs);
+	return 0;
+}
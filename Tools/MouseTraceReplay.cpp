@@ -0,0 +1,223 @@
+#include "AllocationTracker.h"
+#include "HeadlessEngine.h"
+#include "MouseTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Messages recorded by 'ShellWindow_WndProc', as in 'WinUser.h'
+#define MESSAGE_MOUSEMOVE		0x0200
+#define MESSAGE_LBUTTONDBLCLK	0x0203
+#define MESSAGE_RBUTTONDOWN		0x0204
+#define MESSAGE_MOUSELEAVE		0x02A3
+
+#define MILLISECS_PERHOUR		(60.0 * 60.0 * 1000.0)
+#define SYNTHETIC_SEED			1
+
+
+// Replays a recorded mouse trace through the overlay engine on a virtual clock, as fast as it runs,
+// and reports what the session cost per hour of it
+// NOTE: Usage: 'MouseTraceReplay <MouseTrace.bin> [moved|region|hotzone|doubleclick]'
+//		 or 'MouseTraceReplay --synthesize <hours> [...]' for a made up session with no trace at hand.
+//		 Trace file is as recorded to '%LOCALAPPDATA%\PellucidIcons\MouseTrace.bin'.
+
+static bool readFile(const char *pszPath, std::vector<uint8_t>& data)
+{
+	auto pFile = fopen(pszPath, "rb");
+	if (!pFile)
+		return false;
+
+	fseek(pFile, 0, SEEK_END);
+	auto cbFile = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+	if (cbFile <= 0)
+	{
+		fclose(pFile);
+		return false;
+	}
+
+	data.resize(static_cast<size_t>(cbFile));
+	bool bRead = (fread(data.data(), 1, data.size(), pFile) == data.size());
+	fclose(pFile);
+
+	return bRead;
+}
+
+// Bursts of 1000 Hz mouse moves, with pauses, clicks and leaving the desktop in between
+static void synthesize(double hours, std::vector<uint8_t>& data)
+{
+	std::vector<MouseTraceRecord> records;
+	srand(SYNTHETIC_SEED);
+
+	uint64_t time = 0;
+	int x = HEADLESSENGINE_CLIENTWIDTH / 2, y = HEADLESSENGINE_CLIENTHEIGHT / 2;
+	while (time < hours * MILLISECS_PERHOUR)
+	{
+		int cMoves = 500 + rand() % 10000;
+		int dx = rand() % 51 - 25, dy = rand() % 51 - 25;
+		for (int i = 0; i < cMoves; ++i)
+		{
+			if (rand() % 200 == 0)
+				dx = rand() % 51 - 25, dy = rand() % 51 - 25;
+
+			x = std::min(std::max(x + dx, 0), HEADLESSENGINE_CLIENTWIDTH - 1);
+			y = std::min(std::max(y + dy, 0), HEADLESSENGINE_CLIENTHEIGHT - 1);
+			records.push_back(MouseTraceRecord{ ++time, MESSAGE_MOUSEMOVE, x, y });
+		}
+
+		switch (rand() % 8)
+		{
+			case 0: records.push_back(MouseTraceRecord{ time, MESSAGE_RBUTTONDOWN, x, y }); break;
+			case 1: records.push_back(MouseTraceRecord{ time, MESSAGE_LBUTTONDBLCLK, x, y }); break;
+			case 2: records.push_back(MouseTraceRecord{ time, MESSAGE_MOUSELEAVE, 0, 0 }); break;
+			default: break;
+		}
+
+		time += 1000 + rand() % 120000;		// Away from desktop for a while
+	}
+
+	// NOTE: Written through trace writer, so replay reads it exactly as it would a recorded one
+	data.assign(sizeof(MouseTraceHeader) + records.size() * MOUSETRACE_MAXRECORDBYTES, 0);
+	MouseTraceWriter writer;
+	writer.Attach(data.data(), data.size());
+	for (auto& record : records)
+		writer.Append(record.time, record.message, record.x, record.y);
+}
+
+static bool parseRestoreWhen(const char *psz, Settings::RestoreWhen& restoreWhen)
+{
+	static const struct
+	{
+		const char *pszName;
+		Settings::RestoreWhen restoreWhen;
+	} s_restoreWhens[] =
+	{
+		{ "moved", Settings::RestoreWhen::mousedMoved },
+		{ "region", Settings::RestoreWhen::mousedEntersQuarterRegionOnLeft },
+		{ "hotzone", Settings::RestoreWhen::mousedEntersHotZone },
+		{ "doubleclick", Settings::RestoreWhen::doubleClicked }
+	};
+
+	for (auto& entry : s_restoreWhens)
+	{
+		if (strcmp(psz, entry.pszName) == 0)
+		{
+			restoreWhen = entry.restoreWhen;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static uint64_t getPercentile(const std::vector<uint32_t>& sorted, double percentile)
+{
+	if (sorted.empty())
+		return 0;
+
+	auto index = static_cast<size_t>(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<uint8_t> data;
+	int iArg = 1;
+	if (argc >= 3 && strcmp(argv[1], "--synthesize") == 0)
+	{
+		synthesize(atof(argv[2]), data);
+		iArg = 3;
+	}
+	else if (argc >= 2 && readFile(argv[1], data))
+		iArg = 2;
+	else
+	{
+		fprintf(stderr, "Usage: %s <MouseTrace.bin> | --synthesize <hours> [moved|region|hotzone|doubleclick]\n", argv[0]);
+		return 1;
+	}
+
+	auto settings = HeadlessEngine::getDefaultSettings();
+	if (iArg < argc && !parseRestoreWhen(argv[iArg], settings.restoreWhen))
+	{
+		fprintf(stderr, "Unknown restore setting '%s'\n", argv[iArg]);
+		return 1;
+	}
+
+	// First pass finds extent of trace, so nothing is allocated while replaying
+	MouseTraceReader reader(data.data(), data.size());
+	if (!reader.IsValid())
+	{
+		fprintf(stderr, "Not a mouse trace, or trace is of another version\n");
+		return 1;
+	}
+
+	MouseTraceRecord record;
+	size_t cRecords = 0;
+	uint64_t firstTime = 0, lastTime = 0;
+	while (reader.Next(record))
+	{
+		if (cRecords++ == 0)
+			firstTime = record.time;
+		lastTime = record.time;
+	}
+	if (cRecords == 0)
+	{
+		fprintf(stderr, "Trace is empty\n");
+		return 1;
+	}
+
+	HeadlessEngine headless(firstTime);
+	headless.setSettings(settings);
+	headless.getEngine().setTuning(Settings::getRegionHysteresisPixels(), Settings::getRegionDwellMillisecs(), Settings::getActivityQuantumMillisecs());
+	uint32_t packedZone = 0x40400000;	// Left quarter of top quarter, for 'hotzone'
+	headless.getEngine().setHotZones(&packedZone, 1);
+	headless.Start();
+
+	std::vector<uint32_t> nanosecs;
+	nanosecs.reserve(cRecords);
+
+	MouseTraceReader replay(data.data(), data.size());
+	AllocationScope allocationScope;
+	while (replay.Next(record))
+	{
+		headless.AdvanceTo(record.time);
+
+		auto start = std::chrono::steady_clock::now();
+		auto& engine = headless.getEngine();
+		switch (record.message)
+		{
+			case MESSAGE_MOUSEMOVE: engine.OnMouseMove(record.x, record.y, settings); break;
+			case MESSAGE_LBUTTONDBLCLK: engine.OnDoubleClick(settings); break;
+			case MESSAGE_RBUTTONDOWN: engine.OnRightButtonDown(); break;
+			case MESSAGE_MOUSELEAVE: engine.OnMouseLeave(); break;
+			default: break;		// Other buttons and wheel are only passed on
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+
+		nanosecs.push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+	}
+	auto cAllocations = allocationScope.getAllocationCount();
+	std::sort(nanosecs.begin(), nanosecs.end());
+
+	auto hours = (lastTime - firstTime) / MILLISECS_PERHOUR;
+	if (hours <= 0)
+		hours = 1.0 / MILLISECS_PERHOUR;
+	auto& opacity = headless.getOpacity();
+
+	printf("Replayed %zu events over %.2f hours\n", cRecords, hours);
+	printf("  ns/event        p50 %llu, p90 %llu, p99 %llu, p99.9 %llu, max %llu\n",
+		static_cast<unsigned long long>(getPercentile(nanosecs, 50)),
+		static_cast<unsigned long long>(getPercentile(nanosecs, 90)),
+		static_cast<unsigned long long>(getPercentile(nanosecs, 99)),
+		static_cast<unsigned long long>(getPercentile(nanosecs, 99.9)),
+		static_cast<unsigned long long>(nanosecs.back()));
+	printf("  per hour        %.1f events, %.1f idle timer arms, %.1f frame timer arms\n",
+		cRecords / hours, headless.getIdleTimer().getArmCount() / hours, headless.getFrameTimer().getArmCount() / hours);
+	printf("                  %.1f opacity sets, %.1f opacity queries, %.1f fades, %.1f heap allocations\n",
+		opacity.getSetCount() / hours, opacity.getGetCount() / hours, opacity.getFadeCount() / hours, cAllocations / hours);
+
+	return 0;
+}